@@ -0,0 +1,108 @@
+#pragma once
+
+#include "CgiProcess.hpp"
+#include "OutputQueue.hpp"
+
+#include <cstddef>
+#include <string>
+#include <sys/types.h>
+#include <zlib.h>
+
+/**
+ * @class FileGenerator
+ * @brief A range of an open file, read one piece at a time.
+ */
+class FileGenerator : public BodyGenerator
+{
+  public:
+	FileGenerator(int fd, off_t offset, size_t length);
+	~FileGenerator(void);
+
+	ssize_t generate(std::string &out, size_t maxLength);
+
+  private:
+	FileGenerator(FileGenerator const &src);
+	FileGenerator &operator=(FileGenerator const &src);
+
+	int	   fd_;
+	off_t  offset_;
+	size_t length_;
+};
+
+/**
+ * @class GzipGenerator
+ * @brief The body of another generator, compressed with gzip as it is read.
+ *
+ * Every piece of the source is compressed and flushed on its own, so the
+ * pieces can be sent as they come, in chunks. compress() instead compresses
+ * a body already in memory at once.
+ */
+class GzipGenerator : public BodyGenerator
+{
+  public:
+	GzipGenerator(BodyGenerator *source, int level);
+	~GzipGenerator(void);
+
+	ssize_t generate(std::string &out, size_t maxLength);
+
+	static bool compress(std::string const &data, int level, std::string &out);
+
+  private:
+	GzipGenerator(GzipGenerator const &src);
+	GzipGenerator &operator=(GzipGenerator const &src);
+
+	bool deflate_(std::string &out, int flush);
+
+	BodyGenerator *source_;
+	z_stream	   stream_;
+	bool		   isReady_;
+	bool		   isFinished_;
+};
+
+/**
+ * @class ChunkedGenerator
+ * @brief The body of another generator, framed for chunked transfer coding.
+ *
+ * Every piece of the source becomes one chunk, and the end of the source
+ * the last chunk, without trailers.
+ */
+class ChunkedGenerator : public BodyGenerator
+{
+  public:
+	explicit ChunkedGenerator(BodyGenerator *source);
+	~ChunkedGenerator(void);
+
+	ssize_t generate(std::string &out, size_t maxLength);
+
+  private:
+	ChunkedGenerator(ChunkedGenerator const &src);
+	ChunkedGenerator &operator=(ChunkedGenerator const &src);
+
+	BodyGenerator *source_;
+	bool		   isFinished_;
+};
+
+/**
+ * @class CgiGenerator
+ * @brief The output of a running CGI script, taken as it is read.
+ *
+ * Until the script writes more, generate() fails with EAGAIN and the queue
+ * waits. The body ends once the script has exited, with an error if the
+ * script failed. Bytes beyond the length of the body are dropped, and with a
+ * length of 0 the whole output is, for a response made without it.
+ */
+class CgiGenerator : public BodyGenerator
+{
+  public:
+	CgiGenerator(CgiProcess &cgi, size_t length);
+
+	ssize_t generate(std::string &out, size_t maxLength);
+
+  private:
+	CgiGenerator(CgiGenerator const &src);
+	CgiGenerator &operator=(CgiGenerator const &src);
+
+	CgiProcess *cgi_;
+	size_t		length_;
+	bool		isBounded_;
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "CgiProcess.hpp"
+
+#include <cstddef>
+#include <map>
+#include <pthread.h>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+/**
+ * @class CgiPool
+ * @brief Workers preforked for the CGI scripts of the locations with a
+ * cgi_pool directive.
+ *
+ * A worker runs the interpreter on its script once, with a listening Unix
+ * socket of its own as its stdin, and accepts one connection per request.
+ * A request is a line with the length of the environment, the environment as
+ * "NAME=value" strings each ended by a NUL byte, then the CONTENT_LENGTH
+ * bytes of the body. The worker answers with the output of a CGI script in
+ * frames, each a line with its length then its bytes, ends it with an empty
+ * frame, "0\n", and closes the connection. connect() returns a CgiProcess
+ * on such a connection, driven as any other script, which gives the worker
+ * back when deleted.
+ *
+ * The workers of a script are started at its first request, min of them. A
+ * request goes to the idle worker that served the fewest. When the requests
+ * in flight outnumber the workers, so that one would wait in the backlog of
+ * a worker, a worker is added while fewer than max run. Beyond max, requests
+ * wait in the backlog of the least busy worker. A worker beyond min is
+ * stopped once as many workers were not needed at once for idleTimeout
+ * milliseconds, so that the pool does not shrink between the requests of a
+ * steady load. A worker that closed a connection without ending its output
+ * is stopped at once. A worker is retired after maxRequests requests,
+ * which it also finds in its CGI_POOL_REQUESTS variable, and replaced.
+ *
+ * The pool is shared by the threads of the process.
+ */
+class CgiPool
+{
+  public:
+	struct Limits
+	{
+		size_t		  minWorkers;
+		size_t		  maxWorkers;
+		size_t		  maxRequests;
+		unsigned long idleTimeout;
+	};
+
+	CgiPool(void);
+	~CgiPool(void);
+
+	CgiProcess *connect(
+		std::vector<std::string> const &argv,
+		std::vector<std::string> const &env,
+		Limits const				   &limits
+	);
+	void   release(std::string const &key, pid_t worker, bool isLost);
+	size_t getWorkerCount(std::vector<std::string> const &argv) const;
+	void   clear(void);
+
+  private:
+	CgiPool(CgiPool const &src);
+	CgiPool &operator=(CgiPool const &src);
+
+	struct Worker
+	{
+		pid_t		pid;
+		std::string path;
+		size_t		requests;
+		size_t		inFlight;
+	};
+
+	struct Pool
+	{
+		std::vector<std::string>		argv;
+		Limits							limits;
+		std::vector<Worker>				workers;
+		// The last time n + 1 requests were in flight at once, in ms
+		std::vector<unsigned long long> neededAt;
+	};
+
+	typedef std::map<std::string, Pool> PoolMap;
+
+	static std::string getKey_(std::vector<std::string> const &argv);
+	static size_t	   getActiveCount_(Pool const &pool);
+
+	bool	spawn_(Pool &pool);
+	Worker *choose_(Pool &pool);
+	void	stop_(Pool &pool, size_t index);
+	void	shrink_(Pool &pool);
+	void	reap_(Pool &pool);
+
+	PoolMap					pools_;
+	std::vector<pid_t>		stopped_;
+	unsigned long			nextId_;
+	mutable pthread_mutex_t mutex_;
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+class CgiPool;
+class FastCgiClient;
+
+/**
+ * @class CgiProcess
+ * @brief A running CGI script, with the pipes to its stdin and its stdout.
+ *
+ * The parent ends of the pipes are non-blocking, so the body of the request
+ * is written and the output of the script is read a piece at a time, when
+ * the event loop reports them ready. The body is appended to the input as it
+ * arrives, and endInput() tells that the whole body was appended. The output
+ * is kept until the caller takes it with takeOutput(), so it may be sent as
+ * it is read, the caller reading no more while enough is kept. On Linux
+ * the exit of the child is also reported to the event loop, by a pidfd that
+ * becomes readable; elsewhere the child is reaped once it has closed its
+ * stdout.
+ *
+ * wait() instead runs the script to completion, blocking, for callers without
+ * an event loop.
+ *
+ * Rather than starting a script, connect() sends the request to a worker of
+ * a CgiPool, on a Unix socket read and written as the pipes, the output
+ * being received in frames, and the worker is given back to its pool when
+ * the process is destroyed. connectFastCgi()
+ * likewise runs the request on a connection to a FastCGI application, the
+ * input being sent and the output received as FastCGI records, and the
+ * connection is kept for another request once the request ended cleanly.
+ *
+ * A child still running when the process is destroyed is killed and reaped.
+ */
+class CgiProcess
+{
+  public:
+	CgiProcess(void);
+	~CgiProcess(void);
+
+	bool start(
+		std::vector<std::string> const &argv,
+		std::vector<std::string> const &env
+	);
+	bool	connect(std::string const &path);
+	void	setPool(CgiPool *pool, std::string const &key, pid_t worker);
+	bool connectFastCgi(
+		FastCgiClient	  *client,
+		std::string const &address,
+		int				   fd,
+		std::string const &head
+	);
+	void	appendInput(char const *data, size_t length);
+	void	endInput(void);
+	bool	writeInput(void);
+	ssize_t readOutput(void);
+	size_t	takeOutput(std::string &out, size_t maxLength);
+	bool	reap(bool block);
+	bool	wait(void);
+	void	closeInput(void);
+	void	closeOutput(void);
+
+	int				   getInputFd(void) const;
+	int				   getOutputFd(void) const;
+	int				   getPidFd(void) const;
+	size_t			   getInputSize(void) const;
+	bool			   isInputDone(void) const;
+	bool			   isOutputDone(void) const;
+	bool			   hasExited(void) const;
+	bool			   isSuccess(void) const;
+	int				   getExitStatus(void) const;
+	bool			   isFastCgi(void) const;
+	std::string const &getOutput(void) const;
+
+  private:
+	CgiProcess(CgiProcess const &src);
+	CgiProcess &operator=(CgiProcess const &src);
+
+	bool parseRecords_(void);
+	bool parseFrames_(void);
+
+	pid_t					 pid_;
+	int						 inputFd_;
+	int						 outputFd_;
+	int						 pidFd_;
+	std::string				 input_;
+	size_t					 inputOffset_;
+	bool					 isInputEnded_;
+	std::string				 output_;
+	int						 status_;
+	CgiPool					*pool_;
+	std::string				 poolKey_;
+	pid_t					 poolWorker_;
+	FastCgiClient			*fastCgi_;
+	std::string				 fastCgiAddress_;
+	std::string				 records_;
+	bool					 isRequestEnded_;
+};
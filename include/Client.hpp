@@ -1,5 +1,11 @@
 #pragma once
 
+#include "CgiProcess.hpp"
+#include "HttpRequest.hpp"
+#include "OutputQueue.hpp"
+#include "RingBuffer.hpp"
+#include "request_parser/RequestFramer.hpp"
+
 #include <cstddef>
 #include <sstream>
 #include <string>
@@ -9,8 +15,9 @@ class Client
   public:
 	Client(int pollFd);
 	~Client(void);
-	Client(const Client &src);
-	Client &operator=(const Client &rhs);
+
+	// Prepares the Client for a new connection, keeping its buffers
+	void reset(int pollFd);
 
 	/**
 	 * @brief Checks if there is a complete request from the client.
@@ -20,12 +27,32 @@ class Client
 	 *
 	 * @return true if a complete request has been received, false otherwise.
 	 */
-	bool		hasRequestReady(void);
-	std::string extractRequestStr(void);
+	bool		 hasRequestReady(void);
+	HttpRequest *extractRequest(void);
+	// The body of a request is held at the end of its headers, until the
+	// caller chooses to stream it or not
+	bool			   isBodyHeld(void) const;
+	HttpRequest		  *extractHead(void);
+	void			   startBody(bool isStreamed);
+	bool			   isBodyStreamed(void) const;
+	std::vector<char> &getBody(void);
+	void			   clearRequest(void);
+	// Whether bytes of a pipelined request wait in the read buffer
+	bool		 hasBufferedInput(void) const;
+	// Whether bytes of a response wait to be sent
+	bool		 hasPendingOutput(void) const;
+	OutputQueue &getOutput(void);
+	// The CGI script running the current request, and the request, owned by
+	// the client until the response is made
+	void		 setCgi(CgiProcess *cgi, HttpRequest *request);
+	CgiProcess	*getCgi(void);
+	HttpRequest *getCgiRequest(void);
+	void		 clearCgi(void);
 
 	// Getters
 	bool isClosed(void) const;
 	bool isError(void) const;
+	int	 getErrorCode(void) const;
 	bool isChunked(void) const;
 	bool areHeadersRead(void) const;
 	int	 getFd(void) const;
@@ -34,28 +61,22 @@ class Client
 
   private:
 	Client(void);
+	Client(const Client &src);
+	Client &operator=(const Client &rhs);
+
+	bool frameBuffer_(void);
+	void reset_(void);
 
-	void   readClientBuffer_(void);
-	bool   isCompleteRequest_(void);
-	bool   hasSizeIndicator_(void);
-	void   moveExtraCharsToBuffer__(size_t pos);
-	void   reset_(void);
-	bool   handleChunkedEncoding_(size_t bodyStartPos);
-	bool   processChunks_(size_t chunkStart);
-	bool   areHeadersComplete_(void);
-	size_t getBodySize_(void);
-
-	int				  pollFd_;
-	std::stringstream clientBuffer_;
-	std::string		  requestStr_;
-	size_t			  totalBytesReadFromFd_;
-	bool			  isChunked_;
-	bool			  hasCompleteRequest_;
-	bool			  isClosed_;
-	bool			  isError_;
-	bool			  areHeadersRead_;
-	bool			  readingPartialBody_;
-	size_t			  nextReadSize_;
+	int			  pollFd_;
+	RingBuffer	  readBuffer_;
+	RequestFramer framer_;
+	OutputQueue	  output_;
+	CgiProcess	 *cgi_;
+	HttpRequest	 *cgiRequest_;
+	bool		  hasCompleteRequest_;
+	bool		  isClosed_;
+	bool		  isError_;
+	int			  errorCode_;
 };
 
 std::ostream &operator<<(std::ostream &os, const Client &rhs);
@@ -47,7 +47,7 @@ class ConfigParser
 		std::string const			   &filepath,
 		bool						   &isConfigOK
 	);
-	static bool checkAutoIndex(
+	static bool checkSwitch(
 		std::vector<std::string> const &tokens,
 		unsigned int const			   &lineIndex,
 		bool const					   &isTest,
@@ -87,6 +87,14 @@ class ConfigParser
 		std::string const			   &filepath,
 		bool						   &isConfigOK
 	);
+	static bool checkTimeout(
+		std::vector<std::string> const &tokens,
+		unsigned int const			   &lineIndex,
+		bool const					   &isTest,
+		bool const					   &isTestPrint,
+		std::string const			   &filepath,
+		bool						   &isConfigOK
+	);
 	static bool checkRoot(
 		std::vector<std::string> const &tokens,
 		unsigned int const			   &lineIndex,
@@ -95,6 +103,30 @@ class ConfigParser
 		std::string const			   &filepath,
 		bool						   &isConfigOK
 	);
+	static bool checkGzip(
+		std::vector<std::string> const &tokens,
+		unsigned int const			   &lineIndex,
+		bool const					   &isTest,
+		bool const					   &isTestPrint,
+		std::string const			   &filepath,
+		bool						   &isConfigOK
+	);
+	static bool checkCgiPool(
+		std::vector<std::string> const &tokens,
+		unsigned int const			   &lineIndex,
+		bool const					   &isTest,
+		bool const					   &isTestPrint,
+		std::string const			   &filepath,
+		bool						   &isConfigOK
+	);
+	static bool checkFastCgiPass(
+		std::vector<std::string> const &tokens,
+		unsigned int const			   &lineIndex,
+		bool const					   &isTest,
+		bool const					   &isTestPrint,
+		std::string const			   &filepath,
+		bool						   &isConfigOK
+	);
 
   private:
 };
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Client.hpp"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @class ConnectionTable
+ * @brief Slot table holding the Client of every open connection.
+ *
+ * Each slot owns one heap allocated Client that is created on first use and
+ * then reused by the following connections of the slot, so a Client is never
+ * copied nor moved and references to it stay valid while it is open. Closed
+ * slots go to a free list, so acquire() and release() are O(1).
+ *
+ * A slot also remembers the listening Server that accepted its connection,
+ * whose timeouts apply to the connection.
+ *
+ * Every acquire() gives the connection a new id, unique in the table. An id
+ * kept by asynchronous work tells whether its connection is still the one
+ * living in the slot, even when the fd and the slot have been reused.
+ */
+class ConnectionTable
+{
+  public:
+	ConnectionTable(void);
+	~ConnectionTable(void);
+
+	size_t acquire(int fd, size_t server);
+	void   release(size_t slot);
+
+	Client		 &get(size_t slot);
+	unsigned long getId(size_t slot) const;
+	size_t		  getServer(size_t slot) const;
+	bool		  isActive(size_t slot) const;
+	size_t		  getCapacity(void) const;
+	size_t		  getActiveCount(void) const;
+
+  private:
+	ConnectionTable(ConnectionTable const &src);
+	ConnectionTable &operator=(ConnectionTable const &src);
+
+	struct Slot
+	{
+		Client		 *client;
+		unsigned long id;
+		size_t		  server;
+		bool		  active;
+	};
+
+	std::vector<Slot>	slots_;
+	std::vector<size_t> freeSlots_;
+	size_t				activeCount_;
+	unsigned long		nextId_;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <poll.h>
+#include <string>
+#include <vector>
+
+/**
+ * @class EventPoller
+ * @brief Readiness notification backend used by the ServerEngine event loop.
+ *
+ * The EventPoller hides the system call used to wait for I/O readiness. Two
+ * backends are available:
+ * - POLL: portable poll(2). The kernel still scans every registered fd, but
+ *   registration and removal are O(1) thanks to a fd-to-slot table, and only
+ *   the ready fds are handed back to the caller.
+ * - EPOLL: Linux epoll(7). Only ready fds are delivered, so a wakeup costs
+ *   O(ready) instead of O(registered).
+ *
+ * Both backends speak poll(2) event flags (POLLIN, POLLOUT, POLLERR, POLLHUP,
+ * POLLNVAL), so callers do not need to know which one is in use.
+ */
+class EventPoller
+{
+  public:
+	enum Backend
+	{
+		POLL,
+		EPOLL
+	};
+
+	struct Event
+	{
+		int	  fd;
+		short revents;
+	};
+
+	EventPoller(Backend backend = getDefaultBackend());
+	~EventPoller(void);
+
+	bool add(int fd, short events);
+	bool modify(int fd, short events);
+	bool remove(int fd);
+	int	 wait(int timeout);
+
+	Event const &getEvent(size_t index) const;
+	size_t		 getEventCount(void) const;
+	size_t		 getFdCount(void) const;
+	Backend		 getBackend(void) const;
+
+	static Backend	   getDefaultBackend(void);
+	static Backend	   getBackend(std::string const &backend);
+	static std::string getBackendName(Backend const &backend);
+	static bool		   isValidBackend(std::string const &backend);
+
+  private:
+	EventPoller(EventPoller const &src);
+	EventPoller &operator=(EventPoller const &src);
+
+	Backend			   backend_;
+	int				   epollFd_;
+	size_t			   fdCount_;
+	std::vector<Event> readyEvents_;
+	// POLL backend: registered fds and the slot of each fd in pollFds_.
+	std::vector<pollfd> pollFds_;
+	std::vector<long>	pollSlots_;
+
+	void initEpoll_(void);
+	int	 waitPoll_(int timeout);
+	int	 waitEpoll_(int timeout);
+};
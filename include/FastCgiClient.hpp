@@ -0,0 +1,98 @@
+#pragma once
+
+#include "CgiProcess.hpp"
+
+#include <cstddef>
+#include <map>
+#include <pthread.h>
+#include <string>
+#include <sys/socket.h>
+#include <vector>
+
+/**
+ * @class FastCgiClient
+ * @brief The connections to the FastCGI applications of the locations with a
+ * fastcgi_pass directive.
+ *
+ * connect() returns a CgiProcess on a connection to the application, driven
+ * by the event loop as any other script: the FastCGI records of the request,
+ * its parameters then its body, are written as the body arrives, and the
+ * output is decoded from the records as they are read. The connection asks
+ * the application to stay open, and is kept once the request ended cleanly,
+ * to carry the next request to the same address.
+ *
+ * Each connection carries one request at a time, so the requests in flight
+ * to an application are spread over as many connections.
+ *
+ * The addresses are resolved once: a host name by resolve(), before the
+ * event loop runs, since the lookup blocks. An address not resolved ahead
+ * is only taken as a numeric address.
+ *
+ * The connections are shared by the threads of the process.
+ */
+class FastCgiClient
+{
+  public:
+	// The types of the records used, from the FastCGI specification
+	enum RecordType
+	{
+		BEGIN_REQUEST = 1,
+		END_REQUEST = 3,
+		PARAMS = 4,
+		STDIN = 5,
+		STDOUT = 6,
+		STDERR = 7
+	};
+
+	struct Record
+	{
+		RecordType type;
+		size_t	   contentOffset;
+		size_t	   contentLength;
+		size_t	   size;
+	};
+
+	FastCgiClient(void);
+	~FastCgiClient(void);
+
+	bool		resolve(std::string const &address);
+	CgiProcess *connect(
+		std::string const			   &address,
+		std::vector<std::string> const &env
+	);
+	void   release(std::string const &address, int fd);
+	size_t getIdleCount(std::string const &address) const;
+	void   clear(void);
+
+	static void appendRecord(
+		std::string &out,
+		RecordType	 type,
+		char const	*data,
+		size_t		 length
+	);
+	static bool
+	parseRecord(std::string const &data, size_t offset, Record &record);
+
+  private:
+	FastCgiClient(FastCgiClient const &src);
+	FastCgiClient &operator=(FastCgiClient const &src);
+
+	struct Address
+	{
+		sockaddr_storage storage;
+		socklen_t		 length;
+	};
+
+	typedef std::map<std::string, std::vector<int> > IdleMap;
+	typedef std::map<std::string, Address>			 AddressMap;
+
+	static bool
+	lookUp_(std::string const &address, int flags, Address &result);
+	bool findAddress_(std::string const &address, Address &result);
+	int	 open_(std::string const &address);
+	int	 takeIdle_(std::string const &address);
+
+	IdleMap					idle_;
+	AddressMap				addresses_;
+	mutable pthread_mutex_t mutex_;
+};
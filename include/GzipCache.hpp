@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <pthread.h>
+#include <string>
+
+/**
+ * @class GzipCache
+ * @brief Static files compressed with gzip, kept in memory.
+ *
+ * The entries are found by the ETag of the file they were compressed from.
+ * The ETag changes with the inode, the modification time and the size of the
+ * file, so an entry never needs to be checked again: a changed file gets
+ * another ETag, and its old entry is evicted in time. Each version of a file
+ * is thus compressed once, whatever the number of clients.
+ *
+ * The least recently used entries are evicted to keep the compressed bodies
+ * within the byte budget. A file larger than an eighth of the budget is never
+ * cached, and is compressed as it is sent instead.
+ *
+ * The cache is shared by the reactor threads and locked by a mutex. With a
+ * budget of 0 bytes it caches nothing.
+ */
+class GzipCache
+{
+  public:
+	GzipCache(void);
+	~GzipCache(void);
+
+	void configure(size_t maxBytes);
+
+	bool isEnabled(void) const;
+	bool isCacheable(size_t fileSize) const;
+	bool find(std::string const &etag, std::string &body);
+	void insert(std::string const &etag, std::string const &body);
+	void clear(void);
+
+	size_t			   getSize(void) const;
+	size_t			   getBytes(void) const;
+	unsigned long long getHits(void) const;
+	unsigned long long getMisses(void) const;
+
+  private:
+	GzipCache(GzipCache const &src);
+	GzipCache &operator=(GzipCache const &src);
+
+	struct Entry
+	{
+		std::string body;
+		// Position in lru_, whose front is the most recently used ETag
+		std::list<std::string>::iterator position;
+	};
+
+	typedef std::map<std::string, Entry> EntryMap;
+
+	void erase_(EntryMap::iterator it);
+	void clear_(void);
+
+	size_t					maxBytes_;
+	size_t					bytes_;
+	EntryMap				entries_;
+	std::list<std::string>	lru_;
+	unsigned long long		hits_;
+	unsigned long long		misses_;
+	mutable pthread_mutex_t mutex_;
+};
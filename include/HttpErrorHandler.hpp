@@ -1,5 +1,6 @@
 #pragma once
 
+#include "HttpResponse.hpp"
 #include "Server.hpp"
 
 #include <string>
@@ -7,13 +8,14 @@
 class HttpErrorHandler
 {
   public:
-	static std::string
+	static HttpResponse
 	getErrorPage(unsigned int const &statusCode, bool const &keepAlive = true);
-	static std::string getErrorPage(
+	static bool getErrorPage(
 		Server const	  &server,
 		unsigned int const &statusCode,
 		std::string const &rootdir,
-		bool const		  &keepAlive
+		bool const		  &keepAlive,
+		HttpResponse	  &response
 	);
 
 	// handleDefaultErrorResponse_(int errorCode, bool closeConnection = false);
@@ -1,19 +1,52 @@
 #pragma once
 
+#include "CgiPool.hpp"
+#include "CgiProcess.hpp"
+#include "FastCgiClient.hpp"
+#include "GzipCache.hpp"
 #include "HttpRequest.hpp"
+#include "HttpResponse.hpp"
+#include "OpenFileCache.hpp"
+#include "ResponseCache.hpp"
 #include "Server.hpp"
 
 #include <map>
 #include <string>
+#include <utility>
+#include <vector>
+
+// A range of bytes of a file, its first and last offsets included
+typedef std::pair<off_t, off_t> ByteRange;
 
 class HttpMethodHandler
 {
   public:
-	static std::string handleRequest(
+	static HttpResponse handleRequest(
 		const HttpRequest &request,
 		Server const	  &server,
-		std::string const &method
+		std::string const &method,
+		CgiProcess		 **cgi = NULL
+	);
+	static HttpResponse createCgiResponse(
+		CgiProcess const  &cgi,
+		HttpRequest const &request,
+		Server const	  &server
 	);
+	static BodyGenerator *createCgiStreamResponse(
+		CgiProcess		  &cgi,
+		HttpRequest const &request,
+		Server const	  &server,
+		HttpResponse	  &response
+	);
+	static bool
+	isCgiRequest(const HttpRequest &request, Server const &server);
+	static bool
+	isHeavyRequest(const HttpRequest &request, Server const &server);
+	static OpenFileCache &getOpenFileCache(void);
+	static ResponseCache &getResponseCache(void);
+	static GzipCache	 &getGzipCache(void);
+	static CgiPool		 &getCgiPool(void);
+	static FastCgiClient &getFastCgiClient(void);
 
   private:
 	HttpMethodHandler();
@@ -21,12 +54,14 @@ class HttpMethodHandler
 	~HttpMethodHandler();
 	HttpMethodHandler &operator=(HttpMethodHandler const &src);
 
-	static std::string generateAutoIndexPage_(
-		std::string const &root,
-		std::string const &uri,
-		Server const	  &server,
-		bool const		  &keepAlive
-	);
+	static OpenFileCache openFileCache_;
+	static ResponseCache responseCache_;
+	static GzipCache	 gzipCache_;
+	static CgiPool		 cgiPool_;
+	static FastCgiClient fastCgiClient_;
+
+	static std::string
+	generateAutoIndexPage_(std::string const &root, std::string const &uri);
 
 	// clang-format off
 	static bool validateMethod_(
@@ -53,9 +88,38 @@ class HttpMethodHandler
 	static std::string getCgiInterpreter_(
 		std::map<std::string, std::vector<std::string> > const &location
 	);
+	static std::string getFastCgiPass_(
+		std::map<std::string, std::vector<std::string> > const &location
+	);
 	static bool isAutoIndexEnabled_(
 		std::map<std::string, std::vector<std::string> > const &location
 	);
+	static bool isSendfileEnabled_(
+		std::map<std::string, std::vector<std::string> > const &location
+	);
+	static bool isGzipStaticEnabled_(
+		std::map<std::string, std::vector<std::string> > const &location
+	);
+	static bool isGzipEnabled_(
+		std::map<std::string, std::vector<std::string> > const &location
+	);
+	static int getGzipLevel_(
+		std::map<std::string, std::vector<std::string> > const &location,
+		std::string const									  &mimeType,
+		off_t												   length
+	);
+	static void compressResponse_(
+		HttpRequest const									  &request,
+		std::map<std::string, std::vector<std::string> > const &location,
+		HttpResponse										  &response
+	);
+	static bool getCgiPoolLimits_(
+		std::map<std::string, std::vector<std::string> > const &location,
+		CgiPool::Limits										  &limits
+	);
+	static bool isCacheEnabled_(
+		std::map<std::string, std::vector<std::string> > const &location
+	);
 	static std::string findIndexFile_(
 		const std::string									  &filepath,
 		const std::map<std::string, std::vector<std::string> > &location,
@@ -66,70 +130,121 @@ class HttpMethodHandler
 		std::map<std::string, std::vector<std::string> > const &location,
 		Server const										  &server
 	);
+	static HttpResponse createFileGetResponse_(
+		HttpRequest const									  &request,
+		std::string const									  &filepath,
+		std::string const									  &rootdir,
+		Server const										  &server,
+		std::map<std::string, std::vector<std::string> > const &location,
+		std::string const									  &cacheKey
+	);
 	// clang-format on
-
-	static std::string createFileGetResponse_(
-		std::string const &filepath,
-		std::string const &rootdir,
-		Server const	  &server,
-		bool const		  &keepAlive
+	static HttpResponse createRangeResponse_(
+		int							  fd,
+		OpenFileCache::Info const	 &info,
+		std::vector<ByteRange> const &ranges,
+		bool const					 &keepAlive,
+		bool const					 &useSendfile,
+		bool const					 &isGzip
+	);
+	static HttpResponse createGzipResponse_(
+		int						   fd,
+		OpenFileCache::Info const &info,
+		std::string const		  &etag,
+		int						   level,
+		bool const				  &keepAlive
+	);
+	static HttpResponse createNotModifiedResponse_(
+		std::string const		  &etag,
+		OpenFileCache::Info const &info,
+		bool const				  &keepAlive,
+		bool const				  &hasVariants
 	);
 
-	static std::string createFilePostResponse_(
+	static HttpResponse createFilePostResponse_(
 		HttpRequest const &request,
 		const std::string &rootdir,
-		std::string const &redirect,
-		std::string const &uploadpath,
+		HttpResponse const *redirect,
+		std::string const  &uploadpath,
 		Server const	  &server,
 		bool const		  &keepAlive
 	);
 
-	static std::string createDeleteResponse_(
+	static HttpResponse createDeleteResponse_(
 		HttpRequest const &request,
 		const std::string &filepath,
 		const std::string &rootdir,
-		std::string const &redirect,
+		HttpResponse const *redirect,
 		const Server	  &server,
 		bool			   keepAlive
 	);
 
 	// clang-format off
-	static std::string handleRedirection_(
+	static bool handleRedirection_(
 		std::map<std::string, std::vector<std::string> > const &location,
-		bool const											  &keepAlive
+		bool const											  &keepAlive,
+		HttpResponse										  &response
 	); // clang-format on
-	static std::string handleReturnDirective_(
+	static HttpResponse handleReturnDirective_(
 		std::vector<std::string> const &returnDirective,
 		bool const					   &keepAlive
 	);
-	static std::string handleAutoIndex_(
+	static HttpResponse handleAutoIndex_(
 		std::string const &root,
 		std::string const &uri,
 		Server const	  &server,
 		bool const		  &keepAlive
 	);
-	static std::string handleCgiRequest_(
+	static HttpResponse handleCgiRequest_(
 		std::string const &filepath,
 		std::string const &interpreter,
 		HttpRequest const &request,
 		bool const		  &keepAlive,
 		Server const	  &server,
 		std::string const &rootdir,
-		std::string const &redirect = "",
+		CgiProcess		 **cgi,
 		std::string const &uploadpath = ""
 	);
+	static size_t parseCgiHeaders_(
+		std::string const				   &output,
+		bool								isComplete,
+		bool								isStandard,
+		std::map<std::string, std::string> &headers
+	);
+	static HttpResponse createCgiHead_(
+		std::map<std::string, std::string> &cgiHeaders,
+		std::string const				   &body,
+		bool const						   &keepAlive
+	);
+	static HttpResponse parseCgiOutput_(
+		std::string const &output,
+		bool			   isStandard,
+		bool const		  &keepAlive
+	);
 
-	static std::string handleErrorResponse_(
+	static HttpResponse handleErrorResponse_(
 		Server const	  &server,
 		int const		  &errorCode,
 		std::string const &rootdir,
 		bool const		  &keepAlive
 	);
 
-	static std::string
-	handleGetRequest_(const HttpRequest &request, Server const &server);
-	static std::string
-	handlePostRequest_(const HttpRequest &request, Server const &server);
-	static std::string
-	handleDeleteRequest_(const HttpRequest &request, Server const &server);
+	static HttpResponse
+	handleGetRequest_(
+		const HttpRequest &request,
+		Server const	  &server,
+		CgiProcess		 **cgi
+	);
+	static HttpResponse
+	handlePostRequest_(
+		const HttpRequest &request,
+		Server const	  &server,
+		CgiProcess		 **cgi
+	);
+	static HttpResponse
+	handleDeleteRequest_(
+		const HttpRequest &request,
+		Server const	  &server,
+		CgiProcess		 **cgi
+	);
 };
@@ -40,6 +40,8 @@ class HttpRequest
 				 );
 	// clang-format on
 	void setBody(std::vector<char> &newBody);
+	// Takes the body without copying it, newBody gets the previous body
+	void swapBody(std::vector<char> &newBody);
 
 	// Getters
 	const std::string	&getMethod(void) const;
@@ -1,29 +1,81 @@
 #pragma once
 
+#include "OutputQueue.hpp"
+
 #include <map>
 #include <string>
 #include <utility>
 #include <vector>
 
+/**
+ * @class HttpResponse
+ * @brief Status, headers and body of a response, kept apart until sent.
+ *
+ * renderHead() writes the status line and the headers into one buffer sized
+ * up front, and the body stays in its own string, so the two are queued as
+ * separate segments and sent together with writev(2).
+ *
+ * The body may instead be a range of an open file, which the response owns
+ * until it is queued: the file is then sent from the event loop, with
+ * sendfile(2) when useSendfile is set, and never read whole into memory.
+ * A body of several ranges of the file, each after its own bytes in memory,
+ * is made with addBodyPart(), as for a multipart/byteranges response. With
+ * compressBodyFile(), the file is instead compressed with gzip as it is
+ * sent, in chunks.
+ *
+ * A head rendered earlier, such as the one of a cached response, may be set
+ * as is with setRenderedHead(). It then replaces the status line and the
+ * headers, which getHeader() does not see.
+ */
 class HttpResponse
 {
   public:
 	HttpResponse();
+	HttpResponse(HttpResponse const &src);
 	~HttpResponse();
+	HttpResponse &operator=(HttpResponse const &rhs);
 
 	void setStatusCode(int code);
 	void setReasonPhrase(const std::string &phrase);
 	void setHeader(const std::string &key, const std::string &value);
+	void removeHeader(std::string const &key);
 	void setBody(const std::string &body);
+	void swapBody(std::string &body);
+	void setBodyFile(int fd, off_t offset, size_t length, bool useSendfile);
+	void addBodyPart(std::string &data, off_t offset, size_t length);
+	void compressBodyFile(int level);
+	void setRenderedHead(std::string &head);
 
+	int				   getStatusCode() const;
 	std::string const &getHeader(std::string const &key) const;
+	std::string		  &getBody();
 
+	void		renderHead(std::string &head) const;
+	void		moveTo(OutputQueue &output);
 	std::string toString() const;
 
   private:
+	struct BodyPart
+	{
+		std::string data;
+		off_t		offset;
+		size_t		length;
+	};
+
 	int			statusCode_;
 	std::string reasonPhrase_;
 	// vector of pairs as unordered map only introduced with C++11
 	std::vector<std::pair<std::string, std::string> > headers_;
+	std::string										 renderedHead_;
 	std::string										 body_;
+	int												 bodyFd_;
+	off_t											 bodyOffset_;
+	size_t											 bodyLength_;
+	bool											 useSendfile_;
+	int												 gzipLevel_;
+	std::vector<BodyPart>							 parts_;
+
+	void		  closeBodyFile_();
+	BodyGenerator *createBodyGenerator_(int fd) const;
+	std::string	  readBodyFile_(off_t offset, size_t length) const;
 };
@@ -2,6 +2,7 @@
 
 #include "colors.hpp"
 #include <iostream>
+#include <pthread.h>
 #include <sstream>
 #include <string>
 
@@ -17,6 +18,9 @@
  * For debugging purposes to track the flow of the program. [INFO] For general
  * information about the program, useful to the user. [ERROR] For errors in the
  * server, a function crash, or a file not found, etc
+ * NOTE: Each thread builds its messages in its own Logger instance, and the
+ * finished lines are written under a mutex, so the Logger can be used from
+ * the reactor threads.
  */
 class Logger
 {
@@ -37,9 +41,10 @@ class Logger
 
 	static Logger &log(Level const level, bool isError = false)
 	{
-		instance_.prepareLog_(level);
-		instance_.isError_ = isError;
-		return instance_;
+		Logger &instance = getInstance_();
+		instance.prepareLog_(level);
+		instance.isError_ = isError;
+		return instance;
 	}
 
 	template <typename T> Logger &operator<<(T const &message)
@@ -54,10 +59,7 @@ class Logger
 		{
 			this->stream_ << RESET;
 			os(this->stream_);
-			if (this->isError_)
-				std::cerr << this->stream_.str();
-			else
-				std::cout << this->stream_.str();
+			this->write_();
 		}
 		this->stream_.str("");
 		this->stream_.clear();
@@ -74,9 +76,11 @@ class Logger
 		bool const		   isError = false);
 
   private:
-	static Level	   level_;
-	static Logger	   instance_;
-	std::ostringstream stream_;
+	static Level		   level_;
+	static pthread_key_t   instanceKey_;
+	static pthread_once_t  instanceOnce_;
+	static pthread_mutex_t outputMutex_;
+	std::ostringstream	   stream_;
 	Level			   currentLevel_;
 	bool			   isError_;
 
@@ -85,6 +89,13 @@ class Logger
 	Logger &operator=(const Logger &rhs);
 	~Logger(void);
 
+	static Logger &getInstance_(void);
+	static void	   initInstanceKey_(void);
+	static void	   deleteInstance_(void *instance);
+	static void	   lockOutput_(void);
+	static void	   unlockOutput_(void);
+
+	void			  write_(void) const;
 	void			  prepareLog_(Level const &level);
 	std::string const getColor_(Level const &level) const;
 };
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "ConfigValue.hpp"
+#include "EventPoller.hpp"
+
+#include <map>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+/**
+ * @class MasterProcess
+ * @brief Forks and supervises the worker processes.
+ *
+ * The master parses nothing itself: it receives the configuration already
+ * parsed by ServerConfig, forks one worker per slot and waits for them. Each
+ * worker runs its own ReactorPool (a single ServerEngine unless worker_threads
+ * is set), so every worker owns its listening sockets (bound with SO_REUSEPORT,
+ * the kernel balances the new connections between them) and its event loops.
+ *
+ * A worker that dies while the master is running is respawned in the same
+ * slot, at once the first time, then after a delay that doubles on each crash
+ * in a row, a crash being in a row if the worker ran less than
+ * WORKER_STABLE_MS_. After WORKER_CRASH_LIMIT_ crashes in a row the slot is
+ * given up. A worker that fails while initializing its servers (e.g. the port
+ * is already in use) is not respawned, as it would fail again.
+ *
+ * On SIGINT or SIGTERM the master forwards SIGTERM to the workers and waits
+ * until all of them have exited.
+ */
+class MasterProcess
+{
+  public:
+	// clang-format off
+	MasterProcess(
+		std::vector<std::map<std::string, ConfigValue> > const &servers,
+		EventPoller::Backend									backend,
+		unsigned int											workerCount,
+		unsigned int											threadCount
+	);
+	// clang-format on
+	~MasterProcess(void);
+
+	void run(void);
+
+	static int getExitCode(bool isInitFailure);
+
+  private:
+	MasterProcess(void);
+	MasterProcess(MasterProcess const &src);
+	MasterProcess &operator=(MasterProcess const &src);
+
+	struct Worker
+	{
+		pid_t			   pid;
+		unsigned long long startedAt;
+		// When the slot is respawned after a crash, 0 if it is not waiting
+		unsigned long long respawnAt;
+		// The crashes in a row, of workers that had just started
+		unsigned int	   crashes;
+	};
+
+	// clang-format off
+	std::vector<std::map<std::string, ConfigValue> > const &servers_;
+	// clang-format on
+	EventPoller::Backend backend_;
+	unsigned int		 threadCount_;
+	std::vector<Worker>	 workers_;
+	size_t				 aliveWorkers_;
+	size_t				 pendingWorkers_;
+
+	static int const		   WORKER_INIT_FAILURE_ = 2;
+	static unsigned int const  WORKER_CRASH_LIMIT_ = 6;
+	static unsigned long const WORKER_STABLE_MS_ = 10000;
+	static unsigned long const RESPAWN_DELAY_MS_ = 100;
+	static unsigned int const  SUPERVISE_INTERVAL_US_ = 100000;
+
+	bool spawnWorker_(size_t slot);
+	void runWorker_(size_t slot);
+	void superviseWorkers_(void);
+	void reapWorker_(pid_t pid, int status);
+	void respawnWorkers_(void);
+	void stopWorkers_(void);
+	long findWorker_(pid_t pid) const;
+};
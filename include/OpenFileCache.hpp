@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <pthread.h>
+#include <string>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+
+/**
+ * @class OpenFileCache
+ * @brief Open descriptors and metadata of recently served paths.
+ *
+ * Works like the open_file_cache of nginx. A lookup of a cached path costs no
+ * system call until the entry is older than the validity interval: it is then
+ * checked again with stat(2), and reopened if the inode, the size or the
+ * modification time changed. With inotify, where it is available, an entry is
+ * also dropped as soon as its file changes: the event loops watch the
+ * descriptor of getEventFd() and call readEvents() when it is readable, so
+ * lookups make no system call for it. The least recently used entry is
+ * evicted when the cache is full.
+ *
+ * Callers get a duplicate of the cached descriptor, which they own, so an
+ * entry may be evicted while its file is still being sent. The cache is shared
+ * by the reactor threads and locked by a mutex, which is not held while a
+ * missed or outdated file is opened or checked. With a maximum of 0 entries it
+ * caches nothing and every lookup goes to the file system.
+ */
+class OpenFileCache
+{
+  public:
+	struct Info
+	{
+		off_t		size;
+		time_t		mtime;
+		ino_t		inode;
+		bool		isDirectory;
+		std::string mimeType;
+	};
+
+	OpenFileCache(void);
+	~OpenFileCache(void);
+
+	void configure(size_t maxEntries, unsigned long validMs, bool useEvents);
+
+	bool getInfo(std::string const &path, Info &info);
+	int	 open(std::string const &path, Info &info);
+	void invalidate(std::string const &path);
+	void clear(void);
+	int	 getEventFd(void);
+	void readEvents(void);
+
+	size_t			   getSize(void) const;
+	unsigned long long getHits(void) const;
+	unsigned long long getMisses(void) const;
+
+  private:
+	OpenFileCache(OpenFileCache const &src);
+	OpenFileCache &operator=(OpenFileCache const &src);
+
+	struct Entry
+	{
+		Info			   info;
+		int				   fd;
+		dev_t			   device;
+		int				   watch;
+		unsigned long long validatedAt;
+		// Position in lru_, whose front is the most recently used path
+		std::list<std::string>::iterator position;
+	};
+
+	typedef std::map<std::string, Entry> EntryMap;
+	// The paths of the entries of each watch, several for the paths of a
+	// same file
+	typedef std::multimap<int, std::string> WatchMap;
+
+	bool			   lookUp_(std::string const &path, Info &info, int *fd);
+	void			   take_(EntryMap::iterator it, Info &info, int *fd);
+	EntryMap::iterator insert_(
+		std::string const &path,
+		struct stat const &st,
+		int				   fd,
+		int				   watch
+	);
+	void			   erase_(EntryMap::iterator it, int keptWatch = -1);
+	void			   clear_(void);
+	void			   openEvents_(void);
+
+	size_t					maxEntries_;
+	unsigned long			validMs_;
+	bool					useEvents_;
+	int						inotifyFd_;
+	EntryMap				entries_;
+	WatchMap				watches_;
+	std::list<std::string>	lru_;
+	unsigned long long		hits_;
+	unsigned long long		misses_;
+	mutable pthread_mutex_t mutex_;
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <sys/types.h>
+
+/**
+ * @class BodyGenerator
+ * @brief Source of a body produced in pieces, as it is written.
+ */
+class BodyGenerator
+{
+  public:
+	virtual ~BodyGenerator(void);
+
+	/**
+	 * @brief Appends the next piece of the body.
+	 *
+	 * @param out The string to append to.
+	 * @param maxLength The longest piece the queue wants.
+	 * @return The number of bytes appended, 0 at the end of the body or -1 on
+	 * error. -1 with errno set to EAGAIN tells that the next piece is not
+	 * ready yet, the queue then keeps the generator for a later write.
+	 */
+	virtual ssize_t generate(std::string &out, size_t maxLength) = 0;
+};
+
+/**
+ * @class OutputQueue
+ * @brief Bytes waiting to be written to a connection, in order.
+ *
+ * A non-blocking socket takes only what fits in its send buffer, so a large
+ * response is written over several POLLOUT events. The queue keeps the
+ * segments of the responses with the offset of the first unwritten byte, and
+ * writeTo() sends as much as the socket takes with a single writev(2).
+ *
+ * A segment is a block of memory, a range of an open file or a generator.
+ * The last two are read into memory one chunk at a time, just before it is
+ * written, so the head of a response and its body are never joined. On Linux
+ * a file range may instead be sent with sendfile(2), straight from the page
+ * cache.
+ *
+ * One call writes at most MAX_WRITE_ bytes, so a fast client downloading a
+ * large file does not hold the event loop.
+ */
+class OutputQueue
+{
+  public:
+	OutputQueue(void);
+	~OutputQueue(void);
+
+	void	push(std::string &data);
+	void	pushFile(int fd, off_t offset, size_t length, bool useSendfile);
+	void	pushGenerator(BodyGenerator *generator);
+	ssize_t writeTo(int fd);
+	void	clear(void);
+
+	size_t getSize(void) const;
+	bool   isEmpty(void) const;
+
+  private:
+	OutputQueue(OutputQueue const &src);
+	OutputQueue &operator=(OutputQueue const &src);
+
+	static int const	MAX_SEGMENTS_ = 16;
+	static size_t const CHUNK_SIZE_ = 65536;
+	static size_t const MAX_WRITE_ = 2097152;
+
+	struct Segment
+	{
+		enum Kind
+		{
+			MEMORY,
+			FILE,
+			GENERATOR
+		};
+
+		Kind		   kind;
+		std::string	   data;
+		int			   fd;
+		off_t		   offset;
+		size_t		   length;
+		BodyGenerator *generator;
+		bool		   useSendfile;
+	};
+
+	ssize_t writeMemory_(int fd, bool &isFull);
+	ssize_t sendFile_(int fd, size_t maxLength);
+	bool	readChunk_(size_t index);
+	void	pop_(void);
+
+	std::deque<Segment> segments_;
+	size_t				offset_;
+	size_t				size_;
+};
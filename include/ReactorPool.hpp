@@ -0,0 +1,107 @@
+#pragma once
+
+#include "ConfigValue.hpp"
+#include "EventPoller.hpp"
+#include "HttpRequest.hpp"
+#include "HttpResponse.hpp"
+#include "Server.hpp"
+
+#include <deque>
+#include <map>
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+/**
+ * @class ReactorPool
+ * @brief Runs one ServerEngine event loop (reactor) per thread.
+ *
+ * Every reactor owns its listeners (bound with SO_REUSEPORT), its poller and
+ * its connections, so the loops never share a connection. What they share is
+ * read-only: the parsed configuration and the process-wide lookup tables.
+ *
+ * Heavy requests (directory listings) are not run inline. The owning
+ * reactor posts them as a Job in its own deque and wakes up another reactor.
+ * An idle reactor runs the jobs of its own deque first (newest first) and then
+ * steals from the other deques (oldest first). The finished job is handed
+ * back to its owner through the owner's wakeup pipe, and only the owner
+ * writes to the client.
+ *
+ * With a single thread the engine runs in the calling thread, without jobs.
+ */
+class ReactorPool
+{
+  public:
+	struct Job
+	{
+		Job(size_t				owner,
+			int					clientFd,
+			unsigned long		connectionId,
+			HttpRequest const &request,
+			Server const	   *server);
+
+		size_t		  owner;
+		int			  clientFd;
+		unsigned long connectionId;
+		HttpRequest	  request;
+		Server const *server;
+		HttpResponse  response;
+	};
+
+	// clang-format off
+	ReactorPool(
+		std::vector<std::map<std::string, ConfigValue> > const &servers,
+		EventPoller::Backend									backend,
+		unsigned int											threadCount
+	);
+	// clang-format on
+	~ReactorPool(void);
+
+	void run(void);
+	bool hasFailedToStart(void) const;
+
+	void postJob(Job *job);
+	bool runJob(size_t reactor);
+	Job *popCompletedJob(size_t reactor);
+	int	 getWakeupFd(size_t reactor) const;
+	void clearWakeup(size_t reactor);
+
+  private:
+	ReactorPool(void);
+	ReactorPool(ReactorPool const &src);
+	ReactorPool &operator=(ReactorPool const &src);
+
+	struct Reactor
+	{
+		ReactorPool		*pool;
+		size_t			 index;
+		pthread_t		 thread;
+		pthread_mutex_t	 mutex;
+		std::deque<Job *> jobs;
+		std::deque<Job *> completed;
+		int				 wakeupFds[2];
+	};
+
+	// clang-format off
+	std::vector<std::map<std::string, ConfigValue> > const &servers_;
+	// clang-format on
+	EventPoller::Backend	backend_;
+	std::vector<Reactor *>	reactors_;
+	mutable pthread_mutex_t stateMutex_;
+	pthread_cond_t			stateCond_;
+	size_t					runningLoops_;
+	size_t					nextThief_;
+	bool					failed_;
+	bool					initFailed_;
+
+	static long const SIGNAL_POLL_MS_ = 100;
+
+	static void *runReactor_(void *reactor);
+	void		 runLoop_(Reactor &reactor);
+	void		 waitLoops_(void);
+	void		 finishLoop_(void);
+	Job			*takeJob_(size_t reactor);
+	void		 completeJob_(Job *job);
+	void		 wakeup_(size_t reactor);
+	void		 initReactors_(unsigned int threadCount);
+};
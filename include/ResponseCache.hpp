@@ -0,0 +1,92 @@
+#pragma once
+
+#include "HttpResponse.hpp"
+#include "OpenFileCache.hpp"
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <pthread.h>
+#include <string>
+#include <sys/types.h>
+#include <time.h>
+
+/**
+ * @class ResponseCache
+ * @brief Rendered responses of small static files, kept in memory.
+ *
+ * An entry holds the head of a 200 response, without the Date and Connection
+ * headers that change from one request to another, and the whole body. A hit
+ * only appends those two headers, so it costs no lookup of the location and no
+ * formatting of the headers.
+ *
+ * The entries are found by server and URI, and remember the file they were
+ * read from. Every hit checks that file against the OpenFileCache, and drops
+ * the entry if its size, inode or modification time changed. The open file
+ * cache keeps its own entries current, with inotify if it is enabled, so a
+ * file changed by another worker process is not served stale, and a hit costs
+ * no system call while the open file cache holds the file. The least recently
+ * used entries are evicted to keep the sizes of the heads and bodies within
+ * the byte budget. A body larger than an eighth of the budget is never cached,
+ * so one file cannot flush the others.
+ *
+ * The cache is shared by the reactor threads and locked by a mutex. With a
+ * budget of 0 bytes it caches nothing.
+ */
+class ResponseCache
+{
+  public:
+	ResponseCache(void);
+	~ResponseCache(void);
+
+	void configure(size_t maxBytes, OpenFileCache &files);
+
+	bool isEnabled(void) const;
+	bool isCacheable(size_t bodySize) const;
+	bool find(std::string const &key, bool keepAlive, HttpResponse &response);
+	void insert(
+		std::string const  &key,
+		std::string const  &path,
+		int					fd,
+		HttpResponse const &response,
+		std::string const  &body
+	);
+	void invalidate(std::string const &path);
+	void clear(void);
+
+	size_t			   getSize(void) const;
+	size_t			   getBytes(void) const;
+	unsigned long long getHits(void) const;
+	unsigned long long getMisses(void) const;
+	double			   getHitRatio(void) const;
+
+  private:
+	ResponseCache(ResponseCache const &src);
+	ResponseCache &operator=(ResponseCache const &src);
+
+	struct Entry
+	{
+		std::string path;
+		std::string head;
+		std::string body;
+		off_t		size;
+		time_t		mtime;
+		ino_t		inode;
+		// Position in lru_, whose front is the most recently used key
+		std::list<std::string>::iterator position;
+	};
+
+	typedef std::map<std::string, Entry> EntryMap;
+
+	void erase_(EntryMap::iterator it);
+	void clear_(void);
+
+	size_t					maxBytes_;
+	OpenFileCache		   *files_;
+	size_t					bytes_;
+	EntryMap				entries_;
+	std::list<std::string>	lru_;
+	unsigned long long		hits_;
+	unsigned long long		misses_;
+	mutable pthread_mutex_t mutex_;
+};
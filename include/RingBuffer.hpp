@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <sys/types.h>
+#include <vector>
+
+/**
+ * @class RingBuffer
+ * @brief Fixed capacity byte ring used as the read buffer of a connection.
+ *
+ * The storage is allocated on the first read and then reused for the whole
+ * life of its owner, so a connection does not allocate per read. readFrom()
+ * fills all the free space with a single readv(2), even when it wraps around
+ * the end of the storage, and the reader walks the buffered bytes in at most
+ * two contiguous segments with peek() and consume().
+ */
+class RingBuffer
+{
+  public:
+	RingBuffer(size_t capacity);
+	~RingBuffer(void);
+
+	ssize_t		readFrom(int fd);
+	char const *peek(size_t &length) const;
+	void		consume(size_t length);
+	void		clear(void);
+
+	size_t getSize(void) const;
+	size_t getFreeSpace(void) const;
+	bool   isEmpty(void) const;
+
+  private:
+	RingBuffer(void);
+	RingBuffer(RingBuffer const &src);
+	RingBuffer &operator=(RingBuffer const &src);
+
+	std::vector<char> data_;
+	size_t			  capacity_;
+	size_t			  head_;
+	size_t			  size_;
+};
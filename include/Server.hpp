@@ -24,10 +24,18 @@ class Server
 	void closeServer(void);
 	void resetServer(void);
 
+	// Let several workers bind their own listener to the same address
+	static void setReusePort(bool reusePort);
+
 	// Getters
 	unsigned int							 getPort(void) const;
 	std::string								 getIPV4(void) const;
 	unsigned long							 getClientMaxBodySize(void) const;
+	// Connection timeouts, in milliseconds
+	unsigned long getKeepAliveTimeout(void) const;
+	unsigned long getClientHeaderTimeout(void) const;
+	unsigned long getClientBodyTimeout(void) const;
+	unsigned long getSendTimeout(void) const;
 	std::string								 getRoot(void) const;
 	std::vector<std::string>				 getIndex(void) const;
 	std::vector<std::string>				 getServerName(void) const;
@@ -40,7 +48,7 @@ class Server
 	) const;
 
 	// clang-format off
-	std::map<std::string, std::vector<std::string> > const
+	std::map<std::string, std::vector<std::string> > const &
 	getThisLocation(const std::string &location) const;
 	// clang-format on
 
@@ -67,6 +75,10 @@ class Server
 	unsigned short						port_;
 	std::string						   &ipV4_;
 	unsigned long						clientMaxBodySize_;
+	unsigned long						keepAliveTimeout_;
+	unsigned long						clientHeaderTimeout_;
+	unsigned long						clientBodyTimeout_;
+	unsigned long						sendTimeout_;
 	std::string						   &root_;
 	std::vector<std::string>		   &index_;
 	std::vector<std::string>		   &serverName_;
@@ -76,6 +88,7 @@ class Server
 	int				 serverFd_;
 	sockaddr_in		 serverAddr_;
 	static int const BACKLOG_ = 10;
+	static bool		 reusePort_;
 
 	void createSocket_();
 	void bindSocket_();
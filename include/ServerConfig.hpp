@@ -271,6 +271,17 @@ class ServerConfig
      */
     bool isValidLogLevel_(const std::string &logLevel);
 
+    /**
+     * @brief Checks the value of a general directive.
+     * @param directive The directive.
+     * @param value The value to check.
+     * @return True if the value is valid for the directive, false otherwise.
+     */
+    bool isValidGeneralValue_(
+        const std::string &directive,
+        const std::string &value
+    );
+
     /**
      * @brief Checks if the directive is a block directive.
      * @param directive The directive to check.
@@ -301,6 +312,25 @@ class ServerConfig
      */
     bool isServerDirective_(const std::string &directive);
 
+    /**
+     * @brief Checks if the directive is one of the connection timeouts.
+     * @param directive The directive to check.
+     * @return True if the directive is a timeout directive, false otherwise.
+     */
+    bool isTimeoutDirective_(const std::string &directive);
+
+    /**
+     * @brief Sets a timeout directive of a server to its default value.
+     * @param server The server configuration.
+     * @param directive The timeout directive.
+     * @param value The default value, used if the directive is missing.
+     */
+    void setDefaultTimeout_(
+        std::map<std::string, ConfigValue> &server,
+        std::string const &directive,
+        std::string const &value
+    );
+
     /**
      * @brief Handles a server directive.
      * @param tokens Tokens of the directive.
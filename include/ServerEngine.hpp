@@ -2,10 +2,16 @@
 
 #include "Client.hpp"
 #include "ConfigValue.hpp"
+#include "ConnectionTable.hpp"
+#include "EventPoller.hpp"
 #include "HttpRequest.hpp"
+#include "HttpResponse.hpp"
+#include "ReactorPool.hpp"
 #include "Server.hpp"
+#include "TimerWheel.hpp"
 #include "macros.hpp"
 
+#include <csignal>
 #include <cstddef>
 #include <cstring>
 #include <map>
@@ -13,7 +19,10 @@
 #include <string>
 #include <sys/wait.h>
 
-extern bool g_shutdown;
+// The signal that asked for the shutdown, or -1 once a reactor thread failed.
+// The threads go through __atomic_load_n and __atomic_store_n, as a volatile
+// access does not order them.
+extern volatile sig_atomic_t g_shutdown;
 
 /**
  * @class ServerEngine
@@ -21,43 +30,94 @@ extern bool g_shutdown;
  * requests.
  *
  * The ServerEngine class initializes server instances, manages client
- * connections, and processes HTTP requests using the poll system call to
- * monitor file descriptors.
+ * connections, and processes HTTP requests using an EventPoller (poll or
+ * epoll) to monitor file descriptors.
  *
- * It maintains vectors of poll file descriptors and client instances, and
- * provides methods to initialize servers, process poll events, and handle
- * client requests and responses.
+ * It maintains vectors of server and client instances, and provides methods
+ * to initialize servers, process ready events, and handle client requests and
+ * responses.
  *
- * @note The class uses two indices: pollIndex_ to track the current position
- * in the pollFds_ vector and clientIndex_ to track the current position in
- * the clients_ vector. Since the pollFds_ vector contains poll file
- * descriptors for both servers and clients, clientIndex_ is always behind
- * pollIndex_ by the total number of server instances.
+ * @note Every watched file descriptor has an entry in fdTable_, indexed by the
+ * fd itself, that tells whether it is a listening socket or a client and where
+ * its Server or its ConnectionTable slot lives. Ready events are dispatched
+ * through this table in O(1), without scanning the idle connections.
+ *
+ * @note Every connection has at most one timer in a TimerWheel, keyed by its
+ * slot: client_header_timeout until the headers are read, client_body_timeout
+ * between two reads of the body, send_timeout while the response waits for the
+ * socket and keepalive_timeout between two requests. An expired connection is
+ * closed, and the event loop sleeps until the next timer is due.
+ *
+ * @note A CGI script runs in a child process watched by the event loop: the
+ * pipes to its stdin and stdout, and on Linux a pidfd reporting its exit,
+ * have fd table entries pointing to the slot of the client. The script is
+ * started at the end of the headers, and a body with a Content-Length is
+ * streamed to it as it is read, the client being read only while the script
+ * keeps up. Its output is sent as it is read once the head of the response
+ * can be made, the script being read only while the client keeps up, and
+ * send_timeout applies between two reads or writes.
+ *
+ * @note When attached to a ReactorPool, heavy requests are posted as jobs to
+ * the pool and the client waits, unwatched, until the wakeup fd of the engine
+ * delivers the response.
  */
 
 class ServerEngine
 {
   public:
 	// clang-format off
-	ServerEngine(std::vector<std::map<std::string, ConfigValue> > const &servers
+	ServerEngine(
+		std::vector<std::map<std::string, ConfigValue> > const &servers,
+		EventPoller::Backend backend = EventPoller::getDefaultBackend()
 	);
 	// clang-format on
 	~ServerEngine();
-	void		start(void);
-	std::string createResponse(const HttpRequest &request);
+	void		 start(void);
+	HttpResponse
+	createResponse(const HttpRequest &request, CgiProcess **cgi = NULL);
+	void		 attachReactorPool(ReactorPool *pool, size_t reactorIndex);
 
   private:
 	ServerEngine();
 	ServerEngine(ServerEngine const &src);
 	ServerEngine &operator=(ServerEngine const &src);
 
-	unsigned int		numServers_;
-	unsigned int		totalServerInstances_;
-	std::vector<pollfd> pollFds_;
-	std::vector<Server> servers_;
-	std::vector<Client> clients_;
-	size_t				pollIndex_;
-	long long			clientIndex_;
+	enum TimerKind
+	{
+		HEADER_TIMER,
+		BODY_TIMER,
+		SEND_TIMER,
+		KEEPALIVE_TIMER
+	};
+
+	struct FdEntry
+	{
+		enum Type
+		{
+			NONE,
+			LISTENER,
+			CLIENT,
+			WAKEUP,
+			FILE_EVENTS,
+			CGI_INPUT,
+			CGI_OUTPUT,
+			CGI_EXIT
+		};
+
+		Type   type;
+		size_t index;
+	};
+
+	unsigned int		 numServers_;
+	unsigned int		 totalServerInstances_;
+	EventPoller			 poller_;
+	std::vector<Server>	 servers_;
+	ConnectionTable		 connections_;
+	std::vector<FdEntry> fdTable_;
+	TimerWheel			 timers_;
+	ReactorPool			*pool_;
+	size_t				 reactorIndex_;
+	bool				 stealRequested_;
 
 	void initServer_(
 		std::map<std::string, ConfigValue> const &serverConfig,
@@ -65,16 +125,36 @@ class ServerEngine
 		size_t									 &globalServerIndex
 	);
 	void	 initServerPollFds_(void);
-	long int initializePollEvents_(void);
+	long int initializePollEvents_(int timeout);
 	void	 processPollEvents_(void);
-	void	 readClientRequest_(size_t &pollIndex_);
-	void	 processClientRequest_(size_t &pollIndex_);
-	void	 sendResponse_(size_t &pollIndex_, const std::string &response);
-	bool	 isPollFdServer_(int &fd);
-	void	 acceptConnection_(size_t &pollIndex_);
-	void	 restartServer_(size_t &pollIndex_);
-	void	 pollFdError_(size_t &pollIndex_);
-	void	 closeConnection_(size_t &pollIndex_);
+	void	 readClientRequest_(int fd);
+	void	 processClientRequest_(int fd);
+	void	 sendResponse_(int fd, HttpResponse &response);
+	void	 writeClientOutput_(int fd);
+	void	 acceptConnection_(size_t serverIndex);
+	void	 restartServer_(size_t serverIndex);
+	void	 pollFdError_(int fd, short revents);
+	void	 closeConnection_(int fd);
+	bool	 postHeavyRequest_(int fd, HttpRequest const &request);
+	void	 handleWakeup_(void);
+	void	 startCgi_(int fd, CgiProcess *cgi, HttpRequest *request);
+	bool	 streamCgiBody_(int fd);
+	bool	 feedCgiBody_(int fd);
+	void	 updateCgiInput_(size_t slot);
+	void	 watchCgiClient_(size_t slot);
+	bool	 watchCgiFd_(int fd, short events, FdEntry::Type type, size_t slot);
+	void	 unwatchCgiFd_(int fd);
+	void	 unwatchCgi_(size_t slot);
+	void	 handleCgiEvent_(int fd, FdEntry const &entry);
+	void	 sendCgiOutput_(size_t slot);
+	void	 endCgiResponse_(size_t slot);
+	void	 finishCgi_(size_t slot);
+	void	 armTimer_(size_t slot, TimerKind kind);
+	void	 expireTimers_(void);
+
+	void	 setFdEntry_(int fd, FdEntry::Type type, size_t index);
+	FdEntry	 getFdEntry_(int fd) const;
+	Client	&getClient_(int fd);
 
 	int findServer_(std::string const &host, unsigned short const &port);
 };
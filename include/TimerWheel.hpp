@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @class TimerWheel
+ * @brief Hierarchical timing wheel holding one timer per connection slot.
+ *
+ * Time is cut in ticks of TICK_MS_. The wheel has LEVELS_ levels of SLOTS_
+ * slots: level 0 holds the timers due in the next SLOTS_ ticks, level 1 the
+ * ones due in the next SLOTS_^2 ticks, and so on. When level 0 wraps around,
+ * the next slot of level 1 is cascaded (its timers are spread over level 0),
+ * and likewise for the upper levels.
+ *
+ * Timers are intrusive: the node of a timer lives in nodes_, indexed by its
+ * id (the ConnectionTable slot), and is linked in the list of its wheel slot.
+ * So schedule(), cancel() and the expiry of a timer are O(1), and an id has at
+ * most one pending timer: scheduling it again replaces the previous one.
+ *
+ * Each timer carries a caller defined kind, handed back on expiry.
+ */
+class TimerWheel
+{
+  public:
+	struct Expired
+	{
+		size_t id;
+		int	   kind;
+	};
+
+	TimerWheel(void);
+	~TimerWheel(void);
+
+	void schedule(size_t id, unsigned long timeoutMs, int kind);
+	void cancel(size_t id);
+	bool isScheduled(size_t id) const;
+	int	 getKind(size_t id) const;
+	void advance(std::vector<Expired> &expired);
+	int	 getNextTimeout(int maxTimeout) const;
+
+	size_t getCount(void) const;
+
+	static unsigned long long now(void);
+
+  private:
+	TimerWheel(TimerWheel const &src);
+	TimerWheel &operator=(TimerWheel const &src);
+
+	struct Node
+	{
+		long			   prev;
+		long			   next;
+		unsigned long long expiresTick;
+		int				   kind;
+		int				   level;
+		int				   slot;
+	};
+
+	static unsigned long const TICK_MS_ = 10;
+	static int const		   LEVEL_BITS_ = 6;
+	static int const		   SLOTS_ = 1 << LEVEL_BITS_;
+	static int const		   LEVELS_ = 4;
+
+	std::vector<Node>  nodes_;
+	long			   heads_[LEVELS_][SLOTS_];
+	unsigned long long currentTick_;
+	size_t			   count_;
+
+	void link_(size_t id);
+	void unlink_(size_t id);
+	void cascade_(int level);
+};
@@ -5,11 +5,32 @@
 #define DEFAULT_IP		 "0.0.0.0"
 #define DEFAULT_HOST	 "localhost"
 #define QUEUE_SIZE		 1
-#define POLL_TIMEOUT	 10
+// Longest wait of the event loop when no timer is due sooner, so that every
+// reactor thread notices a shutdown
+#define POLL_TIMEOUT_MAX 500
 // Set MAX_REQUEST_SIZE larger than necessary as each server has it's own limit
 // set in the config
 #define MAX_REQUEST_SIZE 10000000
+// Size of the read buffer of each connection, filled by one read per event
+#define CLIENT_BUFFER_SIZE 16384
+// Longest request line and headers, parsed in place in a buffer of this size
+#define MAX_HEADER_SIZE 16384
+// Most bytes of a streamed body waiting to be written to a CGI script, the
+// client is not read while they are
+#define CGI_INPUT_BUFFER_SIZE 65536
+// Most bytes of the output of a CGI script waiting to be sent, the script is
+// not read while they are
+#define CGI_OUTPUT_BUFFER_SIZE 65536
+// Milliseconds a worker of a cgi_pool beyond its minimum stays unneeded
+// before it is stopped
+#define CGI_POOL_IDLE_TIMEOUT 10000
+// Most idle connections kept open to a FastCGI application
+#define FASTCGI_KEEPALIVE_CONNECTIONS 32
+// Capacity of the header array of a parsed request, more headers is a 400
+#define REQUEST_MAX_HEADERS 64
 #define SERVER_NAME		 "webserv/0.5"
+// Most byte ranges served in one response, the whole file is sent for more
+#define MAX_RANGES 16
 
 #define HTTP_ACCEPTED_METHODS {"GET", "POST", "DELETE"}
 
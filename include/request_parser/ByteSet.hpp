@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * @class ByteSet
+ * @brief Set of byte values, with vectorized scanning of buffers.
+ *
+ * span() and find() look for the first byte out of, or in, the set. When the
+ * CPU has them they check 32 bytes per step with AVX2 or 16 with SSE2, and the
+ * bytes left over are checked one at a time in a lookup table. The instruction
+ * set is detected once, at startup.
+ *
+ * The AVX2 kernel classifies every byte by its two nibbles with shuffles, so
+ * it works for any set. SSE2 has no byte shuffle: its kernel compares the
+ * bytes with the ranges of the set and is only used for sets made of at most
+ * MAX_RANGES_ ranges, the others are scanned with the lookup table.
+ */
+class ByteSet
+{
+  public:
+	enum Isa
+	{
+		SCALAR,
+		SSE2,
+		AVX2
+	};
+
+	ByteSet(void);
+	ByteSet(char const *chars);
+	ByteSet(ByteSet const &src);
+	~ByteSet(void);
+	ByteSet &operator=(ByteSet const &rhs);
+
+	ByteSet &add(char const *chars);
+	ByteSet &addRange(unsigned char first, unsigned char last);
+	ByteSet &remove(char const *chars);
+	ByteSet &invert(void);
+
+	bool   contains(char c) const;
+	size_t span(char const *data, size_t length) const;
+	size_t find(char const *data, size_t length) const;
+
+	static Isa	getIsa(void);
+	static Isa	getSupportedIsa(void);
+	static void setIsa(Isa isa);
+
+  private:
+	static int const MAX_RANGES_ = 8;
+
+	bool		  members_[256];
+	// Per low nibble, one bit per high nibble 0-7, then per high nibble 8-15
+	unsigned char nibbles_[2][16];
+	unsigned char ranges_[MAX_RANGES_][2];
+	int			  rangeCount_;
+
+	static Isa isa_;
+
+	void   update_(void);
+	size_t scan_(char const *data, size_t length, bool member) const;
+};
@@ -1,12 +1,14 @@
 #pragma once
 
+#include "request_parser/ByteSet.hpp"
+
 #include <map>
 #include <string>
 
 /* WARNING: change length macros if headers are changed */
 
-#define ACCEPTED_HEADERS_N 8
-#define REPEATABLE_HEADERS_N 20
+#define ACCEPTED_HEADERS_N 13
+#define REPEATABLE_HEADERS_N 21
 #define SEMICOLON_SEPARATED_N 5
 
 extern const std::string acceptedHeaders[ACCEPTED_HEADERS_N];
@@ -14,5 +16,12 @@ extern const std::string repeatableHeaders[REPEATABLE_HEADERS_N];
 extern const std::string semicolonSeparated[SEMICOLON_SEPARATED_N];
 extern const std::string delimeterChars;
 extern const std::map<std::string, std::string> headerAcceptedChars;
+extern const ByteSet							headerNameChars;
+extern const ByteSet							headerValueControlChars;
+extern const ByteSet							uriChars;
+extern const ByteSet							tokenDelimiterChars;
+extern const ByteSet headerForbiddenChars[ACCEPTED_HEADERS_N];
 
 std::map<std::string, std::string> createHeaderAcceptedChars();
+ByteSet							   createHeaderForbiddenChars(int header);
+int								   findAcceptedHeader(std::string const &name);
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "request_parser/SliceParser.hpp"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @class RequestFramer
+ * @brief Resumable state machine finding where an HTTP request ends, parsing
+ * it on the way.
+ *
+ * The framer is fed the bytes of a connection as they arrive, in pieces of
+ * any size. The request line and the headers are copied to a head buffer of
+ * MAX_HEADER_SIZE bytes, which is never reallocated, and each line is parsed
+ * in place by SliceParser as soon as it is complete. The body is copied to a
+ * body buffer. A chunked body is decoded on the way: only the chunk data is
+ * copied, the chunk sizes, extensions and trailers are dropped.
+ *
+ * Every byte is looked at once: the framer keeps its state, the start of the
+ * current header line and what is left of the current body or chunk between
+ * two calls to feed(). It stops right after the end of the request, so the
+ * bytes of a pipelined request are left to the caller. The complete request
+ * is then described by getView() and getBody().
+ *
+ * With setHoldBody(), the framer stops at the end of the headers of a request
+ * with a body, until startBody() is called. The caller may then have the body
+ * streamed: its bytes are appended to the body buffer as usual, but the
+ * caller drains the buffer as it goes, and the body is not limited to
+ * MAX_REQUEST_SIZE.
+ *
+ * Malformed requests throw an HttpException, like RequestParser. Malformed
+ * framing (bad Content-Length, bad chunk size, unsupported Transfer-Encoding),
+ * headers larger than MAX_HEADER_SIZE and requests larger than
+ * MAX_REQUEST_SIZE are 400 errors.
+ */
+class RequestFramer
+{
+  public:
+	enum State
+	{
+		REQUEST_LINE,
+		HEADERS,
+		BODY_HELD,
+		BODY,
+		CHUNK_SIZE,
+		CHUNK_DATA,
+		CHUNK_DATA_END,
+		TRAILERS,
+		COMPLETE
+	};
+
+	RequestFramer(void);
+	~RequestFramer(void);
+
+	size_t feed(char const *data, size_t length);
+	void   reset(void);
+	void   setHoldBody(bool holdBody);
+	void   startBody(bool isStreamed);
+
+	State			   getState(void) const;
+	bool			   isComplete(void) const;
+	bool			   areHeadersRead(void) const;
+	bool			   isChunked(void) const;
+	bool			   isBodyHeld(void) const;
+	bool			   isBodyStreamed(void) const;
+	RequestView const &getView(void) const;
+	std::vector<char> &getBody(void);
+
+  private:
+	RequestFramer(RequestFramer const &src);
+	RequestFramer &operator=(RequestFramer const &src);
+
+	State			  state_;
+	std::vector<char> head_;
+	std::vector<char> body_;
+	RequestView		  view_;
+	size_t			  lineStart_;
+	size_t			  contentLength_;
+	bool			  hasContentLength_;
+	size_t			  bytesLeft_;
+	size_t			  bodyLength_;
+	bool			  holdBody_;
+	bool			  isBodyStreamed_;
+	bool			  isChunked_;
+	bool			  inChunkExtension_;
+	bool			  hasChunkDigit_;
+	size_t			  trailerLineLength_;
+	size_t			  trailerBytes_;
+
+	size_t feedHeaders_(char const *data, size_t length);
+	size_t feedBody_(char const *data, size_t length);
+	size_t feedChunkSize_(char const *data, size_t length);
+	size_t feedChunkDataEnd_(char const *data, size_t length);
+	size_t feedTrailers_(char const *data, size_t length);
+	void   endLine_(void);
+	void   checkHeader_(HeaderSlice const &header);
+	void   checkTransferEncoding_(Slice const &value);
+	void   startBody_(void);
+	void   complete_(void);
+	void   checkSize_(size_t size) const;
+};
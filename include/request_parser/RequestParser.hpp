@@ -1,6 +1,10 @@
 #pragma once
 
 #include "HttpRequest.hpp"
+#include "request_parser/SliceParser.hpp"
+
+#include <string>
+#include <vector>
 
 /* @class RequestParser
  * @brief Parses and validates the syntax of HTTP requests.
@@ -11,15 +15,29 @@
  * the actual content of the fields. For example, a URI might pass all syntax
  * checks but still not correspond to any valid target on the server. On
  * successful parsing, RequestParser returns an HttpRequest object.
+ *
+ * parseRequest() parses a whole request string. createRequest() builds the
+ * request already parsed by SliceParser, as the server does while it frames
+ * the bytes of a connection, so the request is not parsed twice.
  */
 class RequestParser
 {
   public:
-	static HttpRequest parseRequest(std::string str);
+	static HttpRequest	parseRequest(std::string str);
+	static HttpRequest *createRequest(
+		RequestView const &view,
+		std::vector<char> &body
+	);
 
   private:
 	RequestParser(void);
 	~RequestParser(void);
 	RequestParser(const RequestParser &src);
 	RequestParser &operator=(const RequestParser &rhs);
+
+	static void splitHeaderValue_(
+		std::string const		 &name,
+		Slice const				 &value,
+		std::vector<std::string> &values
+	);
 };
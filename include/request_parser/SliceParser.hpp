@@ -0,0 +1,89 @@
+#pragma once
+
+#include "macros.hpp"
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief A run of bytes inside a request buffer. It does not own the bytes.
+ */
+struct Slice
+{
+	char const *data;
+	size_t		length;
+
+	bool		equals(std::string const &str) const;
+	bool		caseEquals(std::string const &str) const;
+	std::string toString(void) const;
+};
+
+/**
+ * @brief A header field as received. id is its index in acceptedHeaders, or
+ * -1 for a header ignored by webserv.
+ */
+struct HeaderSlice
+{
+	Slice name;
+	Slice value;
+	int	  id;
+};
+
+/**
+ * @brief The parts of a request, as views into the bytes it was parsed from.
+ *
+ * The header array has a fixed capacity, so parsing a request allocates
+ * nothing. A view is valid as long as the parsed bytes are left untouched.
+ */
+struct RequestView
+{
+	Slice		method;
+	Slice		uri;
+	Slice		httpVersion;
+	HeaderSlice headers[REQUEST_MAX_HEADERS];
+	size_t		headerCount;
+	Slice		body;
+
+	HeaderSlice const *findHeader(std::string const &name) const;
+};
+
+/**
+ * @class SliceParser
+ * @brief Parses and validates an HTTP request without copying it.
+ *
+ * SliceParser applies the checks of RequestParser to the bytes of a complete
+ * request: start line, header syntax, Host and repeated headers, header tokens
+ * and body. Instead of building strings and maps it only records where each
+ * part starts and ends, in a RequestView. Header names are matched case
+ * insensitively.
+ *
+ * The request can be parsed at once with parseRequest(), or line by line as it
+ * arrives, as RequestFramer does: parseStartLine(), parseHeaderLine() for each
+ * header, checkHeaders() at the end of the headers, and checkBody() once the
+ * body of the view is set. A request with more than REQUEST_MAX_HEADERS
+ * headers is rejected.
+ */
+class SliceParser
+{
+  public:
+	static void
+	parseRequest(char const *data, size_t length, RequestView &view);
+	static void
+	parseStartLine(char const *line, size_t length, RequestView &view);
+	static void
+	parseHeaderLine(char const *line, size_t length, RequestView &view);
+	static void checkHeaders(RequestView const &view);
+	static void checkBody(RequestView const &view);
+
+  private:
+	SliceParser(void);
+	SliceParser(SliceParser const &src);
+	~SliceParser(void);
+	SliceParser &operator=(SliceParser const &rhs);
+
+	static size_t nextLine_(char const *data, size_t length, size_t offset);
+	static size_t lineLength_(char const *line, size_t length);
+	static void	  checkUri_(Slice const &uri);
+	static void	  checkTokens_(HeaderSlice const &header);
+	static int	  findAcceptedHeader_(Slice const &name);
+	static bool	  isRepeatable_(std::string const &name);
+};
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <csignal>
+
 namespace signals
 {
 /* The server handles the following signals:
-SIGINT, SIGQUIT, SIGTERM, SIGPIPE, SIGHUP */
+SIGINT, SIGQUIT, SIGTERM, SIGHUP. SIGPIPE is ignored. */
 void handleSignals(void);
+void getHandledSignals(sigset_t &signals);
 } // namespace signals
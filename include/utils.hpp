@@ -1,5 +1,6 @@
 #pragma once
 
+#include <ctime>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -39,6 +40,13 @@ unsigned short strToUShort(std::string const &str);
 // isValidIPv4 checks if a string is a valid IPv4 address.
 bool		  isValidIPv4(std::string const &str);
 unsigned long stringToULong(std::string const &str);
+// getWorkerCount resolves a worker_processes/worker_threads value: a number,
+// or "auto" for the number of online CPUs. It is at least 1.
+unsigned int getWorkerCount(std::string const &value);
+// isTime checks a timeout value: a number followed by an optional unit, ms, s
+// (the default), m or h. timeToMs converts a valid value to milliseconds.
+bool		  isTime(std::string const &str);
+unsigned long timeToMs(std::string const &str);
 
 bool isURI(std::string const &str);
 bool isURL(std::string const &str);
@@ -48,6 +56,9 @@ std::string			 getFileName(std::string const &path);
 std::string		   readFile(const std::string &filePath);
 std::string		   readErrorPage(const std::string &filePath);
 std::string		   createTimestamp();
+// formatHttpDate writes a time as an HTTP date, parseHttpDate reads one back.
+std::string		   formatHttpDate(time_t time);
+bool			   parseHttpDate(std::string const &str, time_t &time);
 std::string const &getStatusCodeReason(int const &statusCode);
 std::string		   getMimeType(std::string const &filePath);
 
@@ -0,0 +1,225 @@
+#include "BodyGenerators.hpp"
+
+#include <cerrno>
+#include <sstream>
+#include <unistd.h>
+
+// Window bits of a deflate stream with a gzip header and trailer
+#define GZIP_WINDOW_BITS (15 + 16)
+
+/**
+ * @param fd The file descriptor, owned by the generator from now on.
+ * @param offset The offset of the range in the file.
+ * @param length The length of the range.
+ */
+FileGenerator::FileGenerator(int fd, off_t offset, size_t length)
+	: fd_(fd), offset_(offset), length_(length)
+{
+}
+
+FileGenerator::~FileGenerator(void)
+{
+	if (fd_ != -1)
+		close(fd_);
+}
+
+ssize_t FileGenerator::generate(std::string &out, size_t maxLength)
+{
+	if (length_ == 0)
+		return 0;
+	size_t length = length_ < maxLength ? length_ : maxLength;
+	size_t start = out.size();
+	out.resize(start + length);
+	ssize_t bytesRead = pread(fd_, &out[start], length, offset_);
+	out.resize(start + (bytesRead > 0 ? bytesRead : 0));
+	if (bytesRead <= 0)
+	{
+		// The file was truncated since the response was made
+		if (bytesRead == 0)
+			errno = EIO;
+		return -1;
+	}
+	offset_ += bytesRead;
+	length_ -= bytesRead;
+	return bytesRead;
+}
+
+/**
+ * @param source The generator of the uncompressed body, owned by the
+ * generator from now on.
+ * @param level The compression level, from 1 for the fastest to 9 for the
+ * smallest.
+ */
+GzipGenerator::GzipGenerator(BodyGenerator *source, int level)
+	: source_(source), isFinished_(false)
+{
+	stream_.zalloc = Z_NULL;
+	stream_.zfree = Z_NULL;
+	stream_.opaque = Z_NULL;
+	isReady_ = deflateInit2(
+				   &stream_,
+				   level,
+				   Z_DEFLATED,
+				   GZIP_WINDOW_BITS,
+				   8,
+				   Z_DEFAULT_STRATEGY
+			   )
+			   == Z_OK;
+}
+
+GzipGenerator::~GzipGenerator(void)
+{
+	if (isReady_)
+		deflateEnd(&stream_);
+	delete source_;
+}
+
+/**
+ * @brief Compresses the next piece of the source.
+ *
+ * The compressor is flushed after every piece, so what the source produced
+ * so far is sent without waiting for zlib to fill a block: a slow source is
+ * not held back, for a few bytes per piece.
+ */
+ssize_t GzipGenerator::generate(std::string &out, size_t maxLength)
+{
+	if (!isReady_)
+		return -1;
+	if (isFinished_)
+		return 0;
+	size_t		start = out.size();
+	std::string input;
+	ssize_t		generated = source_->generate(input, maxLength);
+	if (generated < 0)
+		return -1;
+	char *data = const_cast<char *>(input.data());
+	stream_.next_in = reinterpret_cast<Bytef *>(data);
+	stream_.avail_in = input.size();
+	if (!deflate_(out, generated == 0 ? Z_FINISH : Z_SYNC_FLUSH))
+		return -1;
+	isFinished_ = generated == 0;
+	return out.size() - start;
+}
+
+/**
+ * @brief Compresses a whole body at once.
+ *
+ * @param data The body.
+ * @param level The compression level, from 1 to 9.
+ * @param out Set to the body compressed with gzip.
+ * @return false if zlib failed.
+ */
+bool GzipGenerator::compress(
+	std::string const &data,
+	int				   level,
+	std::string		  &out
+)
+{
+	z_stream stream;
+	stream.zalloc = Z_NULL;
+	stream.zfree = Z_NULL;
+	stream.opaque = Z_NULL;
+	if (deflateInit2(
+			&stream, level, Z_DEFLATED, GZIP_WINDOW_BITS, 8, Z_DEFAULT_STRATEGY
+		)
+		!= Z_OK)
+		return false;
+	out.resize(deflateBound(&stream, data.size()));
+	stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+	stream.avail_in = data.size();
+	stream.next_out = reinterpret_cast<Bytef *>(&out[0]);
+	stream.avail_out = out.size();
+	bool isDone = deflate(&stream, Z_FINISH) == Z_STREAM_END;
+	out.resize(isDone ? stream.total_out : 0);
+	deflateEnd(&stream);
+	return isDone;
+}
+
+// Runs the compressor on the pending input, appending all it outputs.
+bool GzipGenerator::deflate_(std::string &out, int flush)
+{
+	char buffer[16384];
+	int	 status;
+	do
+	{
+		stream_.next_out = reinterpret_cast<Bytef *>(buffer);
+		stream_.avail_out = sizeof(buffer);
+		status = deflate(&stream_, flush);
+		if (status == Z_STREAM_ERROR)
+			return false;
+		out.append(buffer, sizeof(buffer) - stream_.avail_out);
+	} while (stream_.avail_out == 0);
+	return flush != Z_FINISH || status == Z_STREAM_END;
+}
+
+/**
+ * @param source The generator of the body, owned by the generator from now
+ * on.
+ */
+ChunkedGenerator::ChunkedGenerator(BodyGenerator *source)
+	: source_(source), isFinished_(false)
+{
+}
+
+ChunkedGenerator::~ChunkedGenerator(void)
+{
+	delete source_;
+}
+
+ssize_t ChunkedGenerator::generate(std::string &out, size_t maxLength)
+{
+	if (isFinished_)
+		return 0;
+	std::string piece;
+	ssize_t		generated = source_->generate(piece, maxLength);
+	if (generated < 0)
+		return -1;
+	size_t start = out.size();
+	if (generated == 0)
+	{
+		out.append("0\r\n\r\n", 5);
+		isFinished_ = true;
+		return out.size() - start;
+	}
+	std::ostringstream size;
+	size << std::hex << piece.size();
+	out.append(size.str()).append("\r\n", 2);
+	out.append(piece).append("\r\n", 2);
+	return out.size() - start;
+}
+
+/**
+ * @param cgi The script, which must outlive the generator.
+ * @param length The length of the body, std::string::npos if it has none.
+ */
+CgiGenerator::CgiGenerator(CgiProcess &cgi, size_t length)
+	: cgi_(&cgi), length_(length), isBounded_(length != std::string::npos)
+{
+}
+
+ssize_t CgiGenerator::generate(std::string &out, size_t maxLength)
+{
+	while (!cgi_->getOutput().empty())
+	{
+		size_t start = out.size();
+		size_t taken = cgi_->takeOutput(out, maxLength);
+		if (taken > length_)
+			taken = length_;
+		out.resize(start + taken);
+		length_ -= isBounded_ ? taken : 0;
+		if (taken > 0)
+			return taken;
+	}
+	if (!cgi_->isOutputDone() || !cgi_->hasExited())
+	{
+		errno = EAGAIN;
+		return -1;
+	}
+	// A body shorter than its length would leave the client waiting
+	if (!cgi_->isSuccess() || (isBounded_ && length_ > 0))
+	{
+		errno = EIO;
+		return -1;
+	}
+	return 0;
+}
@@ -0,0 +1,380 @@
+#include "CgiPool.hpp"
+#include "utils.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef LINUX
+#	include <sys/syscall.h>
+#endif
+
+// A worker given all its requests takes no more, and stops once idle
+static bool isRetired(size_t requests, CgiPool::Limits const &limits)
+{
+	return requests >= limits.maxRequests;
+}
+
+// Closes the fds a worker inherits from the server, such as the sockets of
+// its clients, which would otherwise stay open as long as the worker runs.
+static void closeInheritedFds(void)
+{
+#if defined(LINUX) && defined(SYS_close_range)
+	if (syscall(SYS_close_range, STDERR_FILENO + 1, ~0U, 0) == 0)
+		return;
+#endif
+	for (long fd = STDERR_FILENO + 1; fd < sysconf(_SC_OPEN_MAX); ++fd)
+		close(fd);
+}
+
+// A reactor thread blocks the signals the server handles and the server
+// ignores SIGPIPE, neither of which a script expects.
+static void resetSignals(void)
+{
+	sigset_t noSignals;
+	sigemptyset(&noSignals);
+	sigprocmask(SIG_SETMASK, &noSignals, NULL);
+	signal(SIGPIPE, SIG_DFL);
+}
+
+static unsigned long long nowMs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000;
+}
+
+static void waitFor(pid_t pid, int options)
+{
+	while (waitpid(pid, NULL, options) == -1 && errno == EINTR)
+		;
+}
+
+CgiPool::CgiPool(void) : nextId_(0)
+{
+	pthread_mutex_init(&mutex_, NULL);
+}
+
+CgiPool::~CgiPool(void)
+{
+	clear();
+	pthread_mutex_destroy(&mutex_);
+}
+
+/**
+ * @brief Sends a request to a worker of a script, starting the workers of
+ * the script if needed.
+ *
+ * @param argv The interpreter and the script, which identify the pool.
+ * @param env The environment of the request, sent ahead of the body.
+ * @param limits The cgi_pool directive of the location of the script.
+ * @return The connection to the worker, to append the body to and read the
+ * output from, or NULL if no worker could be started or reached.
+ */
+CgiProcess *CgiPool::connect(
+	std::vector<std::string> const &argv,
+	std::vector<std::string> const &env,
+	Limits const				   &limits
+)
+{
+	std::string key = getKey_(argv);
+	pthread_mutex_lock(&mutex_);
+	Pool &pool = pools_[key];
+	pool.argv = argv;
+	pool.limits = limits;
+	reap_(pool);
+	shrink_(pool);
+	while (pool.workers.size() < limits.minWorkers && spawn_(pool))
+		;
+	Worker	   *worker = NULL;
+	CgiProcess *cgi = new CgiProcess();
+	for (size_t tries = 0; tries <= limits.maxWorkers; ++tries)
+	{
+		worker = choose_(pool);
+		if (worker == NULL || cgi->connect(worker->path))
+			break;
+		// A worker that no longer accepts connections died since the last
+		// reap
+		stop_(pool, worker - &pool.workers[0]);
+		worker = NULL;
+	}
+	if (worker == NULL)
+	{
+		pthread_mutex_unlock(&mutex_);
+		delete cgi;
+		return NULL;
+	}
+	cgi->setPool(this, key, worker->pid);
+	++worker->inFlight;
+	size_t inFlight(0);
+	for (size_t i = 0; i < pool.workers.size(); ++i)
+		inFlight += pool.workers[i].inFlight;
+	if (pool.neededAt.size() < limits.maxWorkers)
+		pool.neededAt.resize(limits.maxWorkers, 0);
+	unsigned long long now = nowMs();
+	for (size_t i = 0; i < inFlight && i < pool.neededAt.size(); ++i)
+		pool.neededAt[i] = now;
+	// A retired worker is no longer reachable, so it is never chosen again
+	if (isRetired(++worker->requests, limits))
+		unlink(worker->path.c_str());
+	pthread_mutex_unlock(&mutex_);
+
+	std::string frame;
+	for (size_t i = 0; i < env.size(); ++i)
+		frame.append(env[i]).append(1, '\0');
+	frame.insert(0, ft::toString(frame.size()) + "\n");
+	cgi->appendInput(frame.data(), frame.size());
+	return cgi;
+}
+
+/**
+ * @brief Takes back a worker once the connection of a request is closed.
+ *
+ * A retired worker is stopped once idle, and a worker beyond the minimum of
+ * the pool once it was not needed for the idle timeout.
+ *
+ * @param key The key of the pool of the worker.
+ * @param worker The pid of the worker.
+ * @param isLost Whether the worker closed the connection before ending its
+ * output, having died, in which case it is stopped at once.
+ */
+void CgiPool::release(std::string const &key, pid_t worker, bool isLost)
+{
+	pthread_mutex_lock(&mutex_);
+	PoolMap::iterator it = pools_.find(key);
+	if (it == pools_.end())
+	{
+		pthread_mutex_unlock(&mutex_);
+		return;
+	}
+	Pool &pool = it->second;
+	for (size_t i = pool.workers.size(); i-- > 0;)
+	{
+		Worker &current = pool.workers[i];
+		if (current.pid == worker && current.inFlight > 0)
+			--current.inFlight;
+		bool isIdle = current.inFlight == 0;
+		if ((current.pid == worker && isLost)
+			|| (isRetired(current.requests, pool.limits) && isIdle))
+			stop_(pool, i);
+	}
+	reap_(pool);
+	shrink_(pool);
+	// The replacement of a retired worker is started before it is needed
+	for (size_t active = getActiveCount_(pool);
+		 active < pool.limits.minWorkers && spawn_(pool);)
+		++active;
+	pthread_mutex_unlock(&mutex_);
+}
+
+/**
+ * @brief Gets the number of workers running a script, retired ones included.
+ */
+size_t CgiPool::getWorkerCount(std::vector<std::string> const &argv) const
+{
+	pthread_mutex_lock(&mutex_);
+	PoolMap::const_iterator it = pools_.find(getKey_(argv));
+	size_t count = it == pools_.end() ? 0 : it->second.workers.size();
+	pthread_mutex_unlock(&mutex_);
+	return count;
+}
+
+/**
+ * @brief Kills and reaps all the workers.
+ */
+void CgiPool::clear(void)
+{
+	pthread_mutex_lock(&mutex_);
+	for (PoolMap::iterator it = pools_.begin(); it != pools_.end(); ++it)
+	{
+		std::vector<Worker> &workers = it->second.workers;
+		for (size_t i = 0; i < workers.size(); ++i)
+		{
+			unlink(workers[i].path.c_str());
+			stopped_.push_back(workers[i].pid);
+		}
+	}
+	pools_.clear();
+	for (size_t i = 0; i < stopped_.size(); ++i)
+	{
+		kill(stopped_[i], SIGKILL);
+		waitFor(stopped_[i], 0);
+	}
+	stopped_.clear();
+	pthread_mutex_unlock(&mutex_);
+}
+
+// The interpreter and the script joined, as the key of their pool.
+std::string CgiPool::getKey_(std::vector<std::string> const &argv)
+{
+	std::string key;
+	for (size_t i = 0; i < argv.size(); ++i)
+		key.append(argv[i]).append(1, '\0');
+	return key;
+}
+
+// The workers that still take requests.
+size_t CgiPool::getActiveCount_(Pool const &pool)
+{
+	size_t active(0);
+	for (size_t i = 0; i < pool.workers.size(); ++i)
+		if (!isRetired(pool.workers[i].requests, pool.limits))
+			++active;
+	return active;
+}
+
+// Starts a worker listening on a new socket, which only the worker keeps
+// open.
+bool CgiPool::spawn_(Pool &pool)
+{
+	Worker worker;
+	worker.path = "/tmp/webserv-cgi-" + ft::toString(getpid()) + "-"
+				  + ft::toString(nextId_++) + ".sock";
+	worker.requests = 0;
+	worker.inFlight = 0;
+	sockaddr_un address;
+	std::memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	std::strncpy(
+		address.sun_path, worker.path.c_str(), sizeof(address.sun_path) - 1
+	);
+	// Blocking, as the worker accepts on it, and closed at once in the scripts
+	// the other reactor threads spawn, so that a stopped worker sees it close
+#ifdef LINUX
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+#else
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd != -1 && fcntl(fd, F_SETFD, FD_CLOEXEC) == -1)
+	{
+		close(fd);
+		fd = -1;
+	}
+#endif
+	if (fd == -1)
+		return false;
+	unlink(worker.path.c_str());
+	if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == -1
+		|| listen(fd, SOMAXCONN) == -1)
+	{
+		close(fd);
+		unlink(worker.path.c_str());
+		return false;
+	}
+
+	std::string requests("CGI_POOL_REQUESTS="
+						 + ft::toString(pool.limits.maxRequests));
+	std::vector<char *> args;
+	for (size_t i = 0; i < pool.argv.size(); ++i)
+		args.push_back(const_cast<char *>(pool.argv[i].c_str()));
+	args.push_back(NULL);
+	char *envp[] = {
+		const_cast<char *>("GATEWAY_INTERFACE=CGI/1.1"),
+		const_cast<char *>(requests.c_str()),
+		NULL
+	};
+	worker.pid = fork();
+	if (worker.pid == 0)
+	{
+		dup2(fd, STDIN_FILENO);
+		closeInheritedFds();
+		resetSignals();
+		execve(args[0], &args[0], envp);
+		_exit(EXIT_FAILURE);
+	}
+	close(fd);
+	if (worker.pid == -1)
+	{
+		unlink(worker.path.c_str());
+		return false;
+	}
+	pool.workers.push_back(worker);
+	return true;
+}
+
+// The idle worker that served the fewest, a new worker if the request would
+// wait in a backlog and the pool may grow, or else the least busy worker.
+CgiPool::Worker *CgiPool::choose_(Pool &pool)
+{
+	Worker *best = NULL;
+	size_t	active(0);
+	size_t	inFlight(0);
+	for (size_t i = 0; i < pool.workers.size(); ++i)
+	{
+		Worker &worker = pool.workers[i];
+		if (isRetired(worker.requests, pool.limits))
+			continue;
+		++active;
+		inFlight += worker.inFlight;
+		if (best == NULL || worker.inFlight < best->inFlight
+			|| (worker.inFlight == best->inFlight
+				&& worker.requests < best->requests))
+			best = &worker;
+	}
+	if (inFlight >= active && active < pool.limits.maxWorkers && spawn_(pool))
+		return &pool.workers.back();
+	return best;
+}
+
+// Stops the worker at index, reaped later by reap_.
+void CgiPool::stop_(Pool &pool, size_t index)
+{
+	Worker &worker = pool.workers[index];
+	unlink(worker.path.c_str());
+	kill(worker.pid, SIGTERM);
+	stopped_.push_back(worker.pid);
+	pool.workers.erase(pool.workers.begin() + index);
+}
+
+// Stops idle workers beyond the minimum of the pool, as long as as many
+// workers were not needed at once for the idle timeout.
+void CgiPool::shrink_(Pool &pool)
+{
+	unsigned long long now = nowMs();
+	size_t			   active = getActiveCount_(pool);
+	while (active > pool.limits.minWorkers)
+	{
+		if (active <= pool.neededAt.size()
+			&& now - pool.neededAt[active - 1] < pool.limits.idleTimeout)
+			return;
+		size_t idle = pool.workers.size();
+		for (size_t i = 0; i < pool.workers.size(); ++i)
+			if (pool.workers[i].inFlight == 0
+				&& !isRetired(pool.workers[i].requests, pool.limits))
+				idle = i;
+		if (idle == pool.workers.size())
+			return;
+		stop_(pool, idle);
+		--active;
+	}
+}
+
+// Forgets the workers that exited by themselves and reaps the stopped ones.
+void CgiPool::reap_(Pool &pool)
+{
+	for (size_t i = pool.workers.size(); i-- > 0;)
+	{
+		pid_t pid;
+		while ((pid = waitpid(pool.workers[i].pid, NULL, WNOHANG)) == -1
+			   && errno == EINTR)
+			;
+		if (pid == 0)
+			continue;
+		unlink(pool.workers[i].path.c_str());
+		pool.workers.erase(pool.workers.begin() + i);
+	}
+	for (size_t i = stopped_.size(); i-- > 0;)
+	{
+		pid_t pid;
+		while ((pid = waitpid(stopped_[i], NULL, WNOHANG)) == -1
+			   && errno == EINTR)
+			;
+		if (pid != 0)
+			stopped_.erase(stopped_.begin() + i);
+	}
+}
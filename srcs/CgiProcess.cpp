@@ -0,0 +1,624 @@
+#include "CgiProcess.hpp"
+#include "CgiPool.hpp"
+#include "FastCgiClient.hpp"
+#include "Logger.hpp"
+
+#include <cctype>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef LINUX
+#	include <sys/syscall.h>
+#endif
+
+// Most bytes read from the output of the script at once
+#define CGI_READ_SIZE 16384
+// Longest line with the length of a frame sent by a worker of a pool
+#define CGI_FRAME_LENGTH_MAX 20
+
+// Creates a pipe whose ends are closed in the scripts started meanwhile, so
+// that only the script holds the other ends of its pipes.
+static bool createPipe(int fds[2])
+{
+#ifdef LINUX
+	return pipe2(fds, O_CLOEXEC) == 0;
+#else
+	if (pipe(fds) == -1)
+		return false;
+	fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+	fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+	return true;
+#endif
+}
+
+static bool setNonBlocking(int fd)
+{
+	int flags = fcntl(fd, F_GETFL, 0);
+	return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+// Creates a non-blocking Unix socket, closed at once in the scripts started
+// meanwhile.
+static int openSocket(void)
+{
+#ifdef LINUX
+	return socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+#else
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd != -1
+		&& (fcntl(fd, F_SETFD, FD_CLOEXEC) == -1 || !setNonBlocking(fd)))
+	{
+		close(fd);
+		fd = -1;
+	}
+	return fd;
+#endif
+}
+
+static void closeFd(int &fd)
+{
+	if (fd != -1)
+		close(fd);
+	fd = -1;
+}
+
+CgiProcess::CgiProcess(void)
+	: pid_(-1), inputFd_(-1), outputFd_(-1), pidFd_(-1), inputOffset_(0),
+	  isInputEnded_(false), status_(-1), pool_(NULL), poolWorker_(-1),
+	  fastCgi_(NULL), isRequestEnded_(false)
+{
+}
+
+CgiProcess::~CgiProcess(void)
+{
+	// A worker that closed the connection before ending its output died or
+	// broke the protocol
+	bool isWorkerLost = outputFd_ == -1 && !isRequestEnded_;
+	closeInput();
+	closeOutput();
+	if (pid_ != -1)
+	{
+		kill(pid_, SIGKILL);
+		reap(true);
+	}
+	closeFd(pidFd_);
+	if (pool_ != NULL)
+		pool_->release(poolKey_, poolWorker_, isWorkerLost);
+}
+
+/**
+ * @brief Runs a CGI script in a child process.
+ *
+ * The child is started with posix_spawn rather than fork, so starting it
+ * does not copy the page tables of the server and takes the same time
+ * whatever the memory the server uses. The argument and environment arrays
+ * are built beforehand, and the child only redirects its stdin and stdout
+ * and executes the script.
+ *
+ * @param argv The interpreter or the binary to execute, and its arguments.
+ * @param env The environment of the script, as "NAME=value" strings.
+ * @return false if the pipes or the child could not be created.
+ */
+bool CgiProcess::start(
+	std::vector<std::string> const &argv,
+	std::vector<std::string> const &env
+)
+{
+	std::vector<char *> args;
+	for (size_t i = 0; i < argv.size(); ++i)
+		args.push_back(const_cast<char *>(argv[i].c_str()));
+	args.push_back(NULL);
+	std::vector<char *> envp;
+	for (size_t i = 0; i < env.size(); ++i)
+		envp.push_back(const_cast<char *>(env[i].c_str()));
+	envp.push_back(NULL);
+
+	int inputPipe[2];
+	int outputPipe[2];
+	if (!createPipe(inputPipe))
+		return false;
+	if (!createPipe(outputPipe))
+	{
+		close(inputPipe[0]);
+		close(inputPipe[1]);
+		return false;
+	}
+	inputFd_ = inputPipe[1];
+	outputFd_ = outputPipe[0];
+	pid_ = -1;
+	int error(-1);
+	if (setNonBlocking(inputFd_) && setNonBlocking(outputFd_))
+	{
+		posix_spawn_file_actions_t actions;
+		posix_spawn_file_actions_init(&actions);
+		posix_spawn_file_actions_adddup2(&actions, inputPipe[0], STDIN_FILENO);
+		posix_spawn_file_actions_adddup2(
+			&actions, outputPipe[1], STDOUT_FILENO
+		);
+		// A reactor thread blocks the signals the server handles and the
+		// server ignores SIGPIPE, neither of which a script expects.
+		posix_spawnattr_t attributes;
+		posix_spawnattr_init(&attributes);
+		sigset_t signals;
+		sigemptyset(&signals);
+		posix_spawnattr_setsigmask(&attributes, &signals);
+		sigaddset(&signals, SIGPIPE);
+		posix_spawnattr_setsigdefault(&attributes, &signals);
+		posix_spawnattr_setflags(
+			&attributes, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF
+		);
+		error = posix_spawn(
+			&pid_, args[0], &actions, &attributes, &args[0], &envp[0]
+		);
+		posix_spawnattr_destroy(&attributes);
+		posix_spawn_file_actions_destroy(&actions);
+	}
+	close(inputPipe[0]);
+	close(outputPipe[1]);
+	if (error == -1 || error == EAGAIN || error == ENOMEM)
+	{
+		pid_ = -1;
+		closeInput();
+		closeOutput();
+		return false;
+	}
+	// A script that cannot be executed is reported as a child that exited
+	// at once with a status of 127, as a shell does: its stdout reads as
+	// closed, and its stdin is closed so that a body is dropped rather than
+	// written to a pipe nobody reads.
+	if (error != 0)
+	{
+		pid_ = -1;
+		status_ = 127 << 8;
+		closeInput();
+		return true;
+	}
+#if defined(LINUX) && defined(SYS_pidfd_open)
+	// Without pidfd support the child is reaped once its stdout is closed
+	pidFd_ = syscall(SYS_pidfd_open, pid_, 0);
+#endif
+	return true;
+}
+
+/**
+ * @brief Connects to a worker listening on a Unix socket, which stands for
+ * both the stdin and the stdout of a script.
+ *
+ * There is no child to wait for: the output comes in frames, and the script
+ * is done once the worker sends the frame that ends it. A connection closed
+ * before, by a worker that died, counts as a failure.
+ *
+ * @param path The path of the socket of the worker.
+ * @return false if the worker could not be reached.
+ */
+bool CgiProcess::connect(std::string const &path)
+{
+	sockaddr_un address;
+	std::memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+	// A worker whose backlog is full fails the connection rather than block
+	inputFd_ = openSocket();
+	if (inputFd_ == -1)
+		return false;
+	if (::connect(
+			   inputFd_, reinterpret_cast<sockaddr *>(&address), sizeof(address)
+		   ) == -1
+		|| (outputFd_ = fcntl(inputFd_, F_DUPFD_CLOEXEC, 0)) == -1)
+	{
+		closeInput();
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Gives the worker back to its pool when the process is destroyed.
+ */
+void CgiProcess::setPool(CgiPool *pool, std::string const &key, pid_t worker)
+{
+	pool_ = pool;
+	poolKey_ = key;
+	poolWorker_ = worker;
+}
+
+/**
+ * @brief Runs a request on a connection to a FastCGI application.
+ *
+ * The request is done once the application ends it, and succeeds if the
+ * application completed it with a status of 0.
+ *
+ * @param client The client the connection is given back to.
+ * @param address The address of the application.
+ * @param fd The connection, owned by the process from now on.
+ * @param head The records starting the request, up to its parameters.
+ * @return false if the connection could not be duplicated for the output.
+ */
+bool CgiProcess::connectFastCgi(
+	FastCgiClient	  *client,
+	std::string const &address,
+	int				   fd,
+	std::string const &head
+)
+{
+	fastCgi_ = client;
+	fastCgiAddress_ = address;
+	inputFd_ = fd;
+	outputFd_ = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+	input_ = head;
+	return outputFd_ != -1;
+}
+
+/**
+ * @brief Appends a piece of the body to the bytes waiting to be written to
+ * the stdin of the script. A script no longer reading its stdin gets nothing.
+ */
+void CgiProcess::appendInput(char const *data, size_t length)
+{
+	if (inputFd_ == -1 || isInputEnded_ || length == 0)
+		return;
+	// The written bytes are dropped before the buffer grows
+	if (inputOffset_ > 0 && inputOffset_ >= input_.size() / 2)
+	{
+		input_.erase(0, inputOffset_);
+		inputOffset_ = 0;
+	}
+	if (fastCgi_ != NULL)
+		FastCgiClient::appendRecord(
+			input_, FastCgiClient::STDIN, data, length
+		);
+	else
+		input_.append(data, length);
+}
+
+/**
+ * @brief Tells that the whole body was appended to the input.
+ */
+void CgiProcess::endInput(void)
+{
+	// An empty record ends the body of a FastCGI request
+	if (fastCgi_ != NULL && inputFd_ != -1 && !isInputEnded_)
+		FastCgiClient::appendRecord(input_, FastCgiClient::STDIN, NULL, 0);
+	isInputEnded_ = true;
+}
+
+/**
+ * @brief Writes what the stdin of the script takes of the input.
+ *
+ * The input is done once the whole body is written, or when the script stops
+ * reading it. The caller then closes the stdin with closeInput().
+ *
+ * @return false if the write failed for another reason than a full pipe.
+ */
+bool CgiProcess::writeInput(void)
+{
+	if (inputFd_ == -1 || getInputSize() == 0)
+		return true;
+	ssize_t written = write(
+		inputFd_, input_.data() + inputOffset_, input_.size() - inputOffset_
+	);
+	if (written >= 0)
+		inputOffset_ += written;
+	else if (errno != EAGAIN && errno != EWOULDBLOCK)
+	{
+		// A script that exits without reading its whole body is not an error
+		bool isPipeClosed = errno == EPIPE;
+		input_.clear();
+		inputOffset_ = 0;
+		isInputEnded_ = true;
+		return isPipeClosed;
+	}
+	if (inputOffset_ == input_.size())
+	{
+		input_.clear();
+		inputOffset_ = 0;
+	}
+	return true;
+}
+
+/**
+ * @brief Reads what the script wrote to its stdout.
+ *
+ * @return The number of bytes read, 0 at the end of the output, or -1 with
+ * errno set, EAGAIN if nothing is ready.
+ */
+ssize_t CgiProcess::readOutput(void)
+{
+	if (outputFd_ == -1)
+		return 0;
+	if (fastCgi_ == NULL && pool_ == NULL)
+	{
+		size_t start = output_.size();
+		output_.resize(start + CGI_READ_SIZE);
+		ssize_t bytesRead = read(outputFd_, &output_[start], CGI_READ_SIZE);
+		output_.resize(start + (bytesRead > 0 ? bytesRead : 0));
+		return bytesRead;
+	}
+
+	// The end of the request reads as the end of the output
+	if (isRequestEnded_)
+		return 0;
+	size_t start = records_.size();
+	records_.resize(start + CGI_READ_SIZE);
+	ssize_t bytesRead = read(outputFd_, &records_[start], CGI_READ_SIZE);
+	records_.resize(start + (bytesRead > 0 ? bytesRead : 0));
+	if (bytesRead <= 0)
+		return bytesRead;
+	size_t outputSize = output_.size();
+	if (!(fastCgi_ != NULL ? parseRecords_() : parseFrames_()))
+	{
+		errno = EPROTO;
+		return -1;
+	}
+	if (isRequestEnded_)
+		return 0;
+	if (output_.size() == outputSize)
+	{
+		errno = EAGAIN;
+		return -1;
+	}
+	return output_.size() - outputSize;
+}
+
+/**
+ * @brief Moves the first bytes of the output read so far to out.
+ *
+ * @param out The string to append to.
+ * @param maxLength The most bytes to take.
+ * @return The number of bytes taken.
+ */
+size_t CgiProcess::takeOutput(std::string &out, size_t maxLength)
+{
+	size_t length = output_.size() < maxLength ? output_.size() : maxLength;
+	if (length == output_.size() && out.empty())
+		out.swap(output_);
+	else
+	{
+		out.append(output_, 0, length);
+		output_.erase(0, length);
+	}
+	return length;
+}
+
+/**
+ * @brief Collects the exit status of the script.
+ *
+ * @param block Whether to wait for the script to exit.
+ * @return true if the script has exited.
+ */
+bool CgiProcess::reap(bool block)
+{
+	if (pid_ == -1)
+		return true;
+	int	  status;
+	pid_t pid;
+	do
+		pid = waitpid(pid_, &status, block ? 0 : WNOHANG);
+	while (pid == -1 && errno == EINTR);
+	if (pid == 0)
+		return false;
+	status_ = pid == pid_ ? status : -1;
+	pid_ = -1;
+	closeFd(pidFd_);
+	return true;
+}
+
+/**
+ * @brief Runs the script to completion, blocking.
+ *
+ * The whole body must have been appended to the input.
+ *
+ * @return false if the body could not be written or the output read.
+ */
+bool CgiProcess::wait(void)
+{
+	bool isOk(true);
+	while (outputFd_ != -1)
+	{
+		if (isInputDone())
+			closeInput();
+		pollfd fds[2] = {
+			{outputFd_, POLLIN, 0},
+			{inputFd_, POLLOUT, 0}
+		};
+		if (poll(fds, inputFd_ == -1 ? 1 : 2, -1) == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			isOk = false;
+			break;
+		}
+		if (fds[1].revents != 0 && !writeInput())
+			isOk = false;
+		if (fds[0].revents == 0)
+			continue;
+		ssize_t bytesRead = readOutput();
+		if (bytesRead == 0
+			|| (bytesRead < 0 && errno != EAGAIN && errno != EINTR))
+		{
+			isOk = isOk && bytesRead == 0;
+			closeOutput();
+		}
+	}
+	closeInput();
+	closeOutput();
+	reap(true);
+	return isOk;
+}
+
+void CgiProcess::closeInput(void)
+{
+	// The socket of a worker stays open for the output, so the end of the
+	// input is told by a shutdown
+	if (pool_ != NULL && inputFd_ != -1)
+		shutdown(inputFd_, SHUT_WR);
+	closeFd(inputFd_);
+}
+
+void CgiProcess::closeOutput(void)
+{
+	// A connection is reused once the application ended the request, read
+	// the whole body and the input end is no longer watched
+	bool isReusable = fastCgi_ != NULL && outputFd_ != -1 && isRequestEnded_
+					  && records_.empty() && inputFd_ == -1 && isInputEnded_
+					  && getInputSize() == 0;
+	if (isReusable)
+	{
+		fastCgi_->release(fastCgiAddress_, outputFd_);
+		outputFd_ = -1;
+	}
+	closeFd(outputFd_);
+}
+
+int CgiProcess::getInputFd(void) const
+{
+	return inputFd_;
+}
+
+int CgiProcess::getOutputFd(void) const
+{
+	return outputFd_;
+}
+
+/**
+ * @brief Gets the fd that becomes readable when the script exits.
+ *
+ * @return The pidfd of the child, or -1 if the system has none.
+ */
+int CgiProcess::getPidFd(void) const
+{
+	return pidFd_;
+}
+
+/**
+ * @brief Gets the number of bytes of the input not yet written.
+ */
+size_t CgiProcess::getInputSize(void) const
+{
+	return input_.size() - inputOffset_;
+}
+
+bool CgiProcess::isInputDone(void) const
+{
+	return inputFd_ == -1 || (isInputEnded_ && getInputSize() == 0);
+}
+
+bool CgiProcess::isOutputDone(void) const
+{
+	return outputFd_ == -1;
+}
+
+bool CgiProcess::hasExited(void) const
+{
+	return pid_ == -1;
+}
+
+/**
+ * @brief Tells whether the script exited with a status of 0.
+ */
+bool CgiProcess::isSuccess(void) const
+{
+	return status_ != -1 && WIFEXITED(status_) && WEXITSTATUS(status_) == 0;
+}
+
+/**
+ * @brief Gets the exit status of the script, 127 if it could not be executed.
+ *
+ * @return -1 while it runs, or if a signal killed it.
+ */
+int CgiProcess::getExitStatus(void) const
+{
+	return status_ != -1 && WIFEXITED(status_) ? WEXITSTATUS(status_) : -1;
+}
+
+/**
+ * @brief Tells whether the output comes from a FastCGI application.
+ */
+bool CgiProcess::isFastCgi(void) const
+{
+	return fastCgi_ != NULL;
+}
+
+/**
+ * @brief Gets the output read and not taken yet.
+ */
+std::string const &CgiProcess::getOutput(void) const
+{
+	return output_;
+}
+
+// Decodes the records received from a FastCGI application, keeping the
+// content of its stdout as the output. The end of the request sets the
+// status as an exit status.
+bool CgiProcess::parseRecords_(void)
+{
+	size_t				  offset(0);
+	FastCgiClient::Record record;
+	while (!isRequestEnded_
+		   && FastCgiClient::parseRecord(records_, offset, record))
+	{
+		char const *content = records_.data() + record.contentOffset;
+		if (record.type == FastCgiClient::STDOUT)
+			output_.append(content, record.contentLength);
+		else if (record.type == FastCgiClient::STDERR
+				 && record.contentLength > 0)
+			Logger::log(Logger::ERROR)
+				<< "FastCGI: " << std::string(content, record.contentLength)
+				<< std::endl;
+		else if (record.type == FastCgiClient::END_REQUEST
+				 && record.contentLength >= 8)
+		{
+			// Only a completed request has an application status
+			unsigned char const *body
+				= reinterpret_cast<unsigned char const *>(content);
+			status_ = body[4] == 0 ? body[3] << 8 : -1;
+			isRequestEnded_ = true;
+		}
+		offset += record.size;
+	}
+	records_.erase(0, offset);
+	return true;
+}
+
+// Decodes the frames received from a worker of a pool, each a line with its
+// length then its bytes, into the output. The empty frame that ends the
+// output is the success of the script.
+bool CgiProcess::parseFrames_(void)
+{
+	size_t offset(0);
+	while (!isRequestEnded_)
+	{
+		size_t newline = records_.find('\n', offset);
+		if (newline == std::string::npos)
+		{
+			// A length is a few digits
+			if (records_.size() - offset > CGI_FRAME_LENGTH_MAX)
+				return false;
+			break;
+		}
+		char		 *end;
+		char const	 *digits = records_.c_str() + offset;
+		unsigned long length = std::strtoul(digits, &end, 10);
+		if (!std::isdigit(*digits) || end != records_.c_str() + newline)
+			return false;
+		if (records_.size() - newline - 1 < length)
+			break;
+		output_.append(records_, newline + 1, length);
+		offset = newline + 1 + length;
+		if (length == 0)
+		{
+			status_ = 0;
+			isRequestEnded_ = true;
+		}
+	}
+	records_.erase(0, offset);
+	return true;
+}
@@ -2,6 +2,7 @@
 #include "HttpException.hpp"
 #include "Logger.hpp"
 #include "macros.hpp"
+#include "request_parser/RequestParser.hpp"
 #include "utils.hpp"
 #include <cerrno>
 #include <cmath>
@@ -14,49 +15,38 @@
 #include <unistd.h>
 #include <vector>
 
-Client::Client(int pollFd) : pollFd_(pollFd)
+Client::Client(int pollFd)
+	: pollFd_(pollFd), readBuffer_(CLIENT_BUFFER_SIZE), cgi_(NULL),
+	  cgiRequest_(NULL)
 {
+	framer_.setHoldBody(true);
 	hasCompleteRequest_ = false;
-	isChunked_ = false;
 	isClosed_ = false;
 	isError_ = false;
-	areHeadersRead_ = false;
-	nextReadSize_ = 1;
-	totalBytesReadFromFd_ = 0;
-	readingPartialBody_ = false;
+	errorCode_ = HTTP_400_CODE;
 }
 
 Client::~Client(void)
 {
 	reset_();
+	clearCgi();
 }
 
-Client::Client(const Client &src)
-{
-	*this = src;
-}
-
-Client &Client::operator=(const Client &rhs)
+/**
+ * @brief Prepares the Client for a new connection on the same slot.
+ *
+ * @param pollFd The file descriptor of the new connection.
+ */
+void Client::reset(int pollFd)
 {
-	Logger::log(Logger::DEBUG)
-		<< "Client copy operator init. rhs:" << rhs << std::endl;
-
-	pollFd_ = rhs.pollFd_;
-	requestStr_ = rhs.requestStr_;
-	isChunked_ = rhs.isChunked_;
-	hasCompleteRequest_ = rhs.hasCompleteRequest_;
-	isClosed_ = rhs.isClosed_;
-	isError_ = rhs.isError_;
-	areHeadersRead_ = rhs.areHeadersRead_;
-	nextReadSize_ = rhs.nextReadSize_;
-	totalBytesReadFromFd_ = rhs.totalBytesReadFromFd_;
-	readingPartialBody_ = rhs.readingPartialBody_;
-
-	clientBuffer_.str("");
-	clientBuffer_.clear();
-	clientBuffer_ << rhs.clientBuffer_.str();
-
-	return *this;
+	reset_();
+	clearCgi();
+	readBuffer_.clear();
+	output_.clear();
+	pollFd_ = pollFd;
+	isClosed_ = false;
+	isError_ = false;
+	errorCode_ = HTTP_400_CODE;
 }
 
 /**
@@ -97,28 +87,17 @@ bool Client::hasRequestReady(void)
 		return true;
 	}
 
-	if (totalBytesReadFromFd_ + nextReadSize_ > MAX_REQUEST_SIZE)
-	{
-		std::string debugLine;
-		std::getline(clientBuffer_, debugLine);
-		Logger::log(Logger::DEBUG)
-			<< "hasRequestReady: Client sent request over default buffer size "
-			   "limit."
-			<< std::endl
-			<< "totalBytesReadFromFd_: " << totalBytesReadFromFd_ << std::endl
-			<< "nextReadSize_: " << nextReadSize_ << std::endl;
-		isClosed_ = true;
-		isError_ = true;
-		throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+	// A pipelined request may already be complete in the buffer
+	if (frameBuffer_())
+		return true;
+	if (framer_.isBodyHeld())
 		return false;
-	}
-
-	std::vector<char> buffer(nextReadSize_);
-	long int bytesReadFromFd = read(pollFd_, buffer.data(), buffer.size());
-	totalBytesReadFromFd_ += bytesReadFromFd;
 
+	ssize_t bytesReadFromFd = readBuffer_.readFrom(pollFd_);
 	if (bytesReadFromFd < 0)
 	{
+		if (errno == EAGAIN || errno == EWOULDBLOCK)
+			return false;
 		Logger::log(Logger::ERROR)
 			<< "hasRequestReady:Failed to read from client: ("
 			<< ft::toString(errno) << ") " << strerror(errno) << std::endl;
@@ -126,7 +105,7 @@ bool Client::hasRequestReady(void)
 		isError_ = true;
 		return false;
 	}
-	else if (readingPartialBody_ == false && bytesReadFromFd == 0)
+	else if (bytesReadFromFd == 0)
 	{
 		Logger::log(Logger::DEBUG)
 			<< "hasRequestReady: Client disconnected: " << *this << std::endl;
@@ -134,336 +113,233 @@ bool Client::hasRequestReady(void)
 		hasCompleteRequest_ = true;
 		return false;
 	}
+	Logger::log(Logger::DEBUG) << "hasRequestReady: read " << bytesReadFromFd
+							   << " bytes from the client." << std::endl;
+	return frameBuffer_();
+}
 
-	clientBuffer_.write(buffer.data(), bytesReadFromFd);
-	requestStr_ = clientBuffer_.str();
-
-	if (bytesReadFromFd != (long)nextReadSize_)
+/**
+ * @brief Creates the complete request, parsed while it was framed.
+ *
+ * @return The request, to be deleted by the caller.
+ * @throws HttpException if the client has an error or no complete request.
+ */
+HttpRequest *Client::extractRequest(void)
+{
+	if (isError_ == true)
 	{
-		Logger::log(Logger::DEBUG)
-			<< "hasRequestReady: bytesReadFromFd: " << bytesReadFromFd
-			<< " do not match expected nextReadSize: " << nextReadSize_
+		Logger::log(Logger::DEBUG, true)
+			<< "Attempted to extract request from client with error." << *this
 			<< std::endl;
-		nextReadSize_ = nextReadSize_ - bytesReadFromFd;
-		readingPartialBody_ = true;
-		return false;
+		throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
 	}
-
-	if (readingPartialBody_ == true && bytesReadFromFd == (long)nextReadSize_)
+	if (hasCompleteRequest_ == false || !framer_.isComplete())
 	{
-		Logger::log(Logger::DEBUG)
-			<< "hasRequestReady: Body arrived incomplete and has now been "
-			   "fully read."
+		Logger::log(Logger::DEBUG, true)
+			<< "Attempted to extract request from client not ready." << *this
 			<< std::endl;
-		hasCompleteRequest_ = true;
-		return true;
-	}
-
-	if (requestStr_.length() != totalBytesReadFromFd_)
-	{
-		Logger::log(Logger::DEBUG)
-			<< "hasRequestReady: Read error. requestStr_ length: "
-			<< requestStr_.length()
-			<< " do not match expected totalBytesReadFromFd_: "
-			<< totalBytesReadFromFd_ << std::endl;
-		isClosed_ = true;
-		isError_ = true;
-		return false;
+		throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
 	}
+	HttpRequest *request = RequestParser::createRequest(
+		framer_.getView(), framer_.getBody()
+	);
+	reset_();
+	return request;
+}
 
-	if (areHeadersRead_ == true && nextReadSize_ != 1)
-	{
-		Logger::log(Logger::DEBUG)
-			<< "hasRequestReady: Headers and body read." << std::endl;
-		hasCompleteRequest_ = true;
-		return true;
-	}
+bool Client::isBodyHeld(void) const
+{
+	return framer_.isBodyHeld();
+}
 
-	readClientBuffer_();
-	return hasCompleteRequest_;
+/**
+ * @brief Creates the request from its head while its body is held.
+ *
+ * @return The request without its body, to be deleted by the caller.
+ * @throws HttpException if the head makes an invalid request.
+ */
+HttpRequest *Client::extractHead(void)
+{
+	std::vector<char> noBody;
+	return RequestParser::createRequest(framer_.getView(), noBody);
 }
 
-std::string Client::extractRequestStr(void)
+/**
+ * @brief Frames the body held at the end of the headers.
+ *
+ * @param isStreamed Whether the caller drains the body with getBody() as it
+ * is read, and drops the request with clearRequest() once it is complete.
+ */
+void Client::startBody(bool isStreamed)
 {
-	std::string tmp;
-	if (isError_ == false)
+	try
 	{
-		if (hasCompleteRequest_ == true)
-		{
-			tmp = requestStr_;
-			reset_();
-			return tmp;
-		}
-		else
-		{
-			Logger::log(Logger::DEBUG, true)
-				<< "Attempted to extract request from client not ready."
-				<< *this << std::endl;
-		}
+		framer_.startBody(isStreamed);
 	}
-	else
+	catch (HttpException &e)
 	{
-		Logger::log(Logger::DEBUG, true)
-			<< "Attempted to extract request from client with error." << *this
-			<< std::endl;
-		throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+		isClosed_ = true;
+		isError_ = true;
+		errorCode_ = e.getCode();
+		throw;
 	}
-	Logger::log(Logger::DEBUG, true)
-		<< "extractRequestStr returning empty string." << *this << std::endl;
-
-	return tmp;
 }
 
-int Client::getFd(void) const
+bool Client::isBodyStreamed(void) const
 {
-	return pollFd_;
+	return framer_.isBodyStreamed();
 }
 
-void Client::setIsClosed(bool closed)
+/**
+ * @brief Gets the part of the body read since it was last drained.
+ */
+std::vector<char> &Client::getBody(void)
 {
-	isClosed_ = closed;
+	return framer_.getBody();
 }
 
-bool Client::isClosed(void) const
+/**
+ * @brief Drops the complete request whose body was streamed, keeping the
+ * bytes of a pipelined request.
+ */
+void Client::clearRequest(void)
 {
-	return isClosed_;
+	reset_();
 }
 
-bool Client::isError(void) const
+/**
+ * @brief Keeps the CGI script running the current request.
+ *
+ * @param cgi The running script, deleted by the client.
+ * @param request The request, deleted by the client.
+ */
+void Client::setCgi(CgiProcess *cgi, HttpRequest *request)
 {
-	return isError_;
+	clearCgi();
+	cgi_ = cgi;
+	cgiRequest_ = request;
 }
 
-bool Client::isChunked(void) const
+CgiProcess *Client::getCgi(void)
 {
-	return isChunked_;
+	return cgi_;
 }
 
-bool Client::areHeadersRead(void) const
+HttpRequest *Client::getCgiRequest(void)
 {
-	return areHeadersRead_;
+	return cgiRequest_;
 }
 
 /**
- * @brief Reads data from the client buffer and processes it.
- *
- * Reads lines from the client buffer into the request string and checks if
- * a complete request has been received. Handles both regular and chunked
- * transfer encoding.
+ * @brief Deletes the CGI script and its request, killing a running script.
  */
-void Client::readClientBuffer_(void)
+void Client::clearCgi(void)
 {
-	areHeadersRead_ = areHeadersComplete_();
-
-	if (areHeadersRead_ == true)
-	{
-		Logger::log(Logger::DEBUG)
-			<< "readClientBuffer_:: Headers all read." << std::endl;
-		if (hasSizeIndicator_() == false)
-		{
-			Logger::log(Logger::DEBUG)
-				<< "readClientBuffer_: Client headers complete and no body."
-				<< std::endl;
-			hasCompleteRequest_ = true;
-			return;
-		}
-		else
-		{
-			Logger::log(Logger::DEBUG
-			) << "readClientBuffer_: Client headers complete and contains body."
-			  << std::endl;
-
-			if (isChunked_)
-			{
-				Logger::log(Logger::DEBUG)
-					<< "readClientBuffer_: Client contains chunked encoding."
-					<< std::endl;
-				hasCompleteRequest_
-					= processChunks_(requestStr_.find("\r\n\r\n") + 4);
-			}
-			else
-			{
-				nextReadSize_ = getBodySize_();
-				Logger::log(Logger::DEBUG)
-					<< "readClientBuffer_: Client headers read and "
-					   "nextReadSize_ set to: "
-					<< nextReadSize_ << std::endl;
-			}
-			return;
-		}
-	}
-	else
-	{
-		Logger::log(Logger::DEBUG)
-			<< "readClientBuffer_: Headers still not fully read. Read "
-			<< requestStr_.length() << " bytes from FD." << std::endl;
-		hasCompleteRequest_ = false;
-		return;
-	}
+	delete cgi_;
+	delete cgiRequest_;
+	cgi_ = NULL;
+	cgiRequest_ = NULL;
 }
 
-/**
- * @brief Checks if the headers are complete.
- *
- * Determines if the request string contains a complete set of HTTP headers
- * by checking for the end of headers.
- *
- * @return true if the headers are complete, false otherwise.
- */
-bool Client::areHeadersComplete_(void)
+bool Client::hasBufferedInput(void) const
 {
-	return requestStr_.find("\r\n\r\n") != std::string::npos;
+	return !readBuffer_.isEmpty();
 }
 
-/**
- * @brief Handles the Transfer-Encoding header to determine if the body is fully
- * received.
- *
- * Checks the Transfer-Encoding header to determine if the request uses chunked
- * transfer encoding. If it does, it processes the chunks to determine if the
- * entire body has been received.
- *
- * @param bodyStartPos The position in the request string where the body starts.
- * @return true if the body is fully received, false otherwise.
- */
-bool Client::handleChunkedEncoding_(size_t bodyStartPos)
+bool Client::hasPendingOutput(void) const
 {
-	size_t transferEncodingPos = requestStr_.find("Transfer-Encoding");
-	if (transferEncodingPos == std::string::npos)
-	{
-		transferEncodingPos = requestStr_.find("transfer-encoding");
-	}
-	if (transferEncodingPos != std::string::npos)
-	{
-		if (requestStr_.find("Chunked", transferEncodingPos)
-				!= std::string::npos
-			|| requestStr_.find("chunked", transferEncodingPos)
-				   != std::string::npos)
-		{
-			isChunked_ = true;
-			return processChunks_(bodyStartPos);
-		}
-	}
-	else
-	{
-		Logger::log(Logger::DEBUG)
-			<< "Parsing error with chunked! Fd set to close." << std::endl;
-		isClosed_ = true;
-	}
-	return false;
+	return !output_.isEmpty();
 }
 
-/**
- * @brief Processes the chunks in a chunked transfer encoding request.
- *
- * Iterates through the chunks in the request to determine if the entire body
- * has been received. If the end of the chunks is reached, it moves any extra
- * characters to the buffer and marks the request as complete. The resulting
- * request will contain the original headers and the concatenated body without
- * size indications.
- *
- * @param chunkStart The position in the request string where the first chunk
- * starts.
- * @return true if the body is fully received, false otherwise.
- */
-bool Client::processChunks_(size_t bodyStartPos)
+OutputQueue &Client::getOutput(void)
 {
-	size_t pos = bodyStartPos;
-	while (pos < requestStr_.size())
-	{
-		size_t chunkSizeEnd = requestStr_.find("\r\n", pos);
-		if (chunkSizeEnd == std::string::npos)
-		{
-			return false; // Incomplete chunk size line
-		}
-
-		std::string chunkSizeStr = requestStr_.substr(pos, chunkSizeEnd - pos);
-		size_t		chunkSize;
-		std::istringstream(chunkSizeStr) >> std::hex >> chunkSize;
-		pos = chunkSizeEnd + 2; // Move past the \r\n
+	return output_;
+}
 
-		if (chunkSize == 0)
-		{
-			// Last chunk
-			hasCompleteRequest_ = true;
-			return true;
-		}
+int Client::getFd(void) const
+{
+	return pollFd_;
+}
 
-		if (pos + chunkSize + 2 > requestStr_.size())
-		{
-			return false; // Incomplete chunk data
-		}
+void Client::setIsClosed(bool closed)
+{
+	isClosed_ = closed;
+}
 
-		pos += chunkSize + 2; // Move past the chunk data and \r\n
-	}
+bool Client::isClosed(void) const
+{
+	return isClosed_;
+}
 
-	return false;
+bool Client::isError(void) const
+{
+	return isError_;
 }
 
 /**
- * @brief Checks for the presence of size-indicating headers.
- *
- * Determines if the request contains headers that indicate the presence
- * of a body, such as Content-Length or Transfer-Encoding.
- *
- * @return true if size-indicating headers are present, false otherwise.
+ * @brief Gets the status answering a request that could not be framed.
  */
-bool Client::hasSizeIndicator_(void)
+int Client::getErrorCode(void) const
+{
+	return errorCode_;
+}
+
+bool Client::isChunked(void) const
+{
+	return framer_.isChunked();
+}
+
+bool Client::areHeadersRead(void) const
 {
-	return ft::caseInsensitiveFind(requestStr_, "Content-Length")
-		   || ft::caseInsensitiveFind(requestStr_, "Transfer-Encoding");
+	return framer_.areHeadersRead();
 }
 
 /**
- * @brief Gets the size of the body based on headers.
+ * @brief Feeds the buffered bytes to the request framer, which parses them.
  *
- * Determines the size of the body based on the Content-Length or
- * Transfer-Encoding headers.
+ * The framer takes only the bytes of the current request, so the bytes of a
+ * pipelined request stay in the buffer until the current one has been
+ * extracted. A held body also stays in the buffer until it is started.
  *
- * @return The size of the body.
+ * @return true if the request is complete, false otherwise.
  */
-size_t Client::getBodySize_(void)
+bool Client::frameBuffer_(void)
 {
-	size_t bodySize = 0;
-	if (ft::caseInsensitiveFind(requestStr_, "Content-Length"))
+	try
 	{
-		size_t contentLengthPos = requestStr_.find("Content-Length");
-		if (contentLengthPos == std::string::npos)
+		while (!framer_.isComplete() && !framer_.isBodyHeld()
+			   && !readBuffer_.isEmpty())
 		{
-			contentLengthPos = requestStr_.find("content-length");
+			size_t		length;
+			char const *data = readBuffer_.peek(length);
+			readBuffer_.consume(framer_.feed(data, length));
 		}
-		size_t contentLengthEndPos = requestStr_.find("\r\n", contentLengthPos);
-		std::string contentLengthStr = requestStr_.substr(
-			contentLengthPos + 15, contentLengthEndPos - (contentLengthPos + 15)
-		);
-		bodySize = std::atoi(contentLengthStr.c_str());
 	}
-	else if (ft::caseInsensitiveFind(requestStr_, "Transfer-Encoding"))
+	catch (HttpException &e)
 	{
-		// Handle chunked transfer encoding
-		bodySize = std::string::npos; // Indicate chunked encoding
+		Logger::log(Logger::DEBUG)
+			<< "frameBuffer_: Invalid request framing: " << e.what()
+			<< std::endl;
+		isClosed_ = true;
+		isError_ = true;
+		errorCode_ = e.getCode();
+		throw;
 	}
-	return bodySize;
+	hasCompleteRequest_ = framer_.isComplete();
+	return hasCompleteRequest_;
 }
 
 /**
  * @brief Resets the state of the Client object. Necessary after response has
  * been sent to client.
  *
- * Clears the request string and client buffer, and resets state variables
- * to their initial values.
+ * Clears the framed request and resets state variables to their initial
+ * values. The read buffer is kept, as it may hold the next request.
  */
 void Client::reset_(void)
 {
-	requestStr_.clear();
-	clientBuffer_.str("");
-	clientBuffer_.clear();
+	framer_.reset();
 	hasCompleteRequest_ = false;
-	isChunked_ = false;
-	areHeadersRead_ = false;
-	nextReadSize_ = 1;
-	totalBytesReadFromFd_ = 0;
-	readingPartialBody_ = false;
 }
 
 std::ostream &operator<<(std::ostream &os, const Client &rhs)
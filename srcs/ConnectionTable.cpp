@@ -0,0 +1,84 @@
+#include "ConnectionTable.hpp"
+
+ConnectionTable::ConnectionTable(void) : activeCount_(0), nextId_(0) {}
+
+ConnectionTable::~ConnectionTable(void)
+{
+	for (size_t i = 0; i < slots_.size(); ++i)
+		delete slots_[i].client;
+}
+
+/**
+ * @brief Takes a slot for a new connection.
+ *
+ * A free slot is reused with its Client, otherwise the table grows by one.
+ *
+ * @param fd The file descriptor of the connection.
+ * @param server The index of the Server that accepted the connection.
+ * @return The slot of the connection.
+ */
+size_t ConnectionTable::acquire(int fd, size_t server)
+{
+	size_t slot;
+	if (!freeSlots_.empty())
+	{
+		slot = freeSlots_.back();
+		freeSlots_.pop_back();
+		slots_[slot].client->reset(fd);
+	}
+	else
+	{
+		Slot newSlot = {new Client(fd), 0, 0, false};
+		slots_.push_back(newSlot);
+		slot = slots_.size() - 1;
+	}
+	slots_[slot].id = ++nextId_;
+	slots_[slot].server = server;
+	slots_[slot].active = true;
+	++activeCount_;
+	return slot;
+}
+
+/**
+ * @brief Gives a slot back to the free list. The fd is not closed.
+ *
+ * @param slot The slot of the closed connection.
+ */
+void ConnectionTable::release(size_t slot)
+{
+	if (slot >= slots_.size() || !slots_[slot].active)
+		return;
+	slots_[slot].active = false;
+	freeSlots_.push_back(slot);
+	--activeCount_;
+}
+
+Client &ConnectionTable::get(size_t slot)
+{
+	return *slots_[slot].client;
+}
+
+unsigned long ConnectionTable::getId(size_t slot) const
+{
+	return slots_[slot].id;
+}
+
+size_t ConnectionTable::getServer(size_t slot) const
+{
+	return slots_[slot].server;
+}
+
+bool ConnectionTable::isActive(size_t slot) const
+{
+	return slot < slots_.size() && slots_[slot].active;
+}
+
+size_t ConnectionTable::getCapacity(void) const
+{
+	return slots_.size();
+}
+
+size_t ConnectionTable::getActiveCount(void) const
+{
+	return activeCount_;
+}
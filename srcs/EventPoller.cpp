@@ -0,0 +1,307 @@
+#include "EventPoller.hpp"
+#include "Logger.hpp"
+#include "ServerException.hpp"
+#include "utils.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#ifdef LINUX
+# include <sys/epoll.h>
+#endif
+
+/**
+ * @brief Constructor for EventPoller.
+ *
+ * If the epoll backend is requested on a system without epoll support, the
+ * poller falls back to poll.
+ *
+ * @param backend The readiness backend to use.
+ */
+EventPoller::EventPoller(Backend backend)
+	: backend_(backend), epollFd_(-1), fdCount_(0)
+{
+#ifndef LINUX
+	if (backend_ == EPOLL)
+	{
+		Logger::log(Logger::INFO)
+			<< "epoll is not available on this system, using poll"
+			<< std::endl;
+		backend_ = POLL;
+	}
+#endif
+	if (backend_ == EPOLL)
+		initEpoll_();
+	Logger::log(Logger::DEBUG) << "Event poller initialized with the "
+							   << getBackendName(backend_) << " backend"
+							   << std::endl;
+}
+
+EventPoller::~EventPoller(void)
+{
+	if (epollFd_ != -1)
+		close(epollFd_);
+}
+
+void EventPoller::initEpoll_(void)
+{
+#ifdef LINUX
+	// Not inherited by the CGI scripts
+	epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+	if (epollFd_ == -1)
+		throw ServerException("Failed to create the epoll instance", errno);
+	readyEvents_.reserve(64);
+#endif
+}
+
+#ifdef LINUX
+static uint32_t toEpollEvents(short events)
+{
+	uint32_t epollEvents(0);
+	if (events & POLLIN)
+		epollEvents |= EPOLLIN;
+	if (events & POLLOUT)
+		epollEvents |= EPOLLOUT;
+	return epollEvents;
+}
+
+static short fromEpollEvents(uint32_t epollEvents)
+{
+	short events(0);
+	if (epollEvents & EPOLLIN)
+		events |= POLLIN;
+	if (epollEvents & EPOLLOUT)
+		events |= POLLOUT;
+	if (epollEvents & EPOLLERR)
+		events |= POLLERR;
+	if (epollEvents & EPOLLHUP)
+		events |= POLLHUP;
+	return events;
+}
+#endif
+
+/**
+ * @brief Registers a file descriptor.
+ *
+ * @param fd The file descriptor to watch.
+ * @param events The poll(2) events to watch for (POLLIN and/or POLLOUT).
+ * @return true on success, false otherwise.
+ */
+bool EventPoller::add(int fd, short events)
+{
+	if (fd < 0)
+		return false;
+#ifdef LINUX
+	if (backend_ == EPOLL)
+	{
+		struct epoll_event event;
+		std::memset(&event, 0, sizeof(event));
+		event.events = toEpollEvents(events);
+		event.data.fd = fd;
+		if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) == -1)
+		{
+			Logger::log(Logger::ERROR)
+				<< "Failed to add fd " << fd << " to epoll: ("
+				<< ft::toString(errno) << ") " << strerror(errno) << std::endl;
+			return false;
+		}
+		++fdCount_;
+		return true;
+	}
+#endif
+	if ((size_t)fd >= pollSlots_.size())
+		pollSlots_.resize(fd + 1, -1);
+	if (pollSlots_[fd] != -1)
+		return false;
+	pollfd pollFd = {fd, events, 0};
+	pollSlots_[fd] = pollFds_.size();
+	pollFds_.push_back(pollFd);
+	++fdCount_;
+	return true;
+}
+
+/**
+ * @brief Changes the events watched on a registered file descriptor.
+ *
+ * @param fd The file descriptor to modify.
+ * @param events The new poll(2) events to watch for.
+ * @return true on success, false otherwise.
+ */
+bool EventPoller::modify(int fd, short events)
+{
+	if (fd < 0)
+		return false;
+#ifdef LINUX
+	if (backend_ == EPOLL)
+	{
+		struct epoll_event event;
+		std::memset(&event, 0, sizeof(event));
+		event.events = toEpollEvents(events);
+		event.data.fd = fd;
+		if (epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &event) == -1)
+		{
+			Logger::log(Logger::ERROR)
+				<< "Failed to modify fd " << fd << " on epoll: ("
+				<< ft::toString(errno) << ") " << strerror(errno) << std::endl;
+			return false;
+		}
+		return true;
+	}
+#endif
+	if ((size_t)fd >= pollSlots_.size() || pollSlots_[fd] == -1)
+		return false;
+	pollFds_[pollSlots_[fd]].events = events;
+	return true;
+}
+
+/**
+ * @brief Unregisters a file descriptor.
+ *
+ * Must be called before the file descriptor is closed. With the poll backend
+ * the last pollfd is moved into the freed slot, so removal is O(1).
+ *
+ * @param fd The file descriptor to remove.
+ * @return true on success, false otherwise.
+ */
+bool EventPoller::remove(int fd)
+{
+	if (fd < 0)
+		return false;
+#ifdef LINUX
+	if (backend_ == EPOLL)
+	{
+		struct epoll_event event;
+		std::memset(&event, 0, sizeof(event));
+		if (epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, &event) == -1)
+		{
+			Logger::log(Logger::DEBUG)
+				<< "Failed to remove fd " << fd << " from epoll: ("
+				<< ft::toString(errno) << ") " << strerror(errno) << std::endl;
+			return false;
+		}
+		--fdCount_;
+		return true;
+	}
+#endif
+	if ((size_t)fd >= pollSlots_.size() || pollSlots_[fd] == -1)
+		return false;
+	size_t slot = pollSlots_[fd];
+	size_t last = pollFds_.size() - 1;
+	if (slot != last)
+	{
+		pollFds_[slot] = pollFds_[last];
+		pollSlots_[pollFds_[slot].fd] = slot;
+	}
+	pollFds_.pop_back();
+	pollSlots_[fd] = -1;
+	--fdCount_;
+	return true;
+}
+
+/**
+ * @brief Waits for events on the registered file descriptors.
+ *
+ * After a successful call, the ready file descriptors can be read with
+ * getEventCount() and getEvent().
+ *
+ * @param timeout The maximum time to wait in milliseconds, -1 to block.
+ * @return The number of ready file descriptors, or -1 on error.
+ */
+int EventPoller::wait(int timeout)
+{
+	readyEvents_.clear();
+	if (backend_ == EPOLL)
+		return waitEpoll_(timeout);
+	return waitPoll_(timeout);
+}
+
+int EventPoller::waitPoll_(int timeout)
+{
+	int pollCount = poll(pollFds_.data(), pollFds_.size(), timeout);
+	if (pollCount <= 0)
+		return pollCount;
+	for (size_t i = 0; i < pollFds_.size()
+					   && readyEvents_.size() < (size_t)pollCount;
+		 ++i)
+	{
+		if (pollFds_[i].revents == 0)
+			continue;
+		Event event = {pollFds_[i].fd, pollFds_[i].revents};
+		readyEvents_.push_back(event);
+	}
+	return readyEvents_.size();
+}
+
+int EventPoller::waitEpoll_(int timeout)
+{
+#ifdef LINUX
+	static int const   maxEvents = 1024;
+	struct epoll_event events[maxEvents];
+
+	int epollCount = epoll_wait(epollFd_, events, maxEvents, timeout);
+	if (epollCount <= 0)
+		return epollCount;
+	for (int i = 0; i < epollCount; ++i)
+	{
+		Event event = {events[i].data.fd, fromEpollEvents(events[i].events)};
+		readyEvents_.push_back(event);
+	}
+	return epollCount;
+#else
+	(void)timeout;
+	return -1;
+#endif
+}
+
+EventPoller::Event const &EventPoller::getEvent(size_t index) const
+{
+	return readyEvents_[index];
+}
+
+size_t EventPoller::getEventCount(void) const
+{
+	return readyEvents_.size();
+}
+
+size_t EventPoller::getFdCount(void) const
+{
+	return fdCount_;
+}
+
+EventPoller::Backend EventPoller::getBackend(void) const
+{
+	return backend_;
+}
+
+EventPoller::Backend EventPoller::getDefaultBackend(void)
+{
+#ifdef LINUX
+	return EPOLL;
+#else
+	return POLL;
+#endif
+}
+
+// getBackend returns the Backend enum value of the string passed as a
+// parameter. If the string is empty or not a valid backend, it will return the
+// default backend for the system.
+EventPoller::Backend EventPoller::getBackend(std::string const &backend)
+{
+	if (backend == "poll")
+		return POLL;
+	else if (backend == "epoll")
+		return EPOLL;
+	return getDefaultBackend();
+}
+
+std::string EventPoller::getBackendName(Backend const &backend)
+{
+	if (backend == EPOLL)
+		return "epoll";
+	return "poll";
+}
+
+bool EventPoller::isValidBackend(std::string const &backend)
+{
+	return backend == "poll" || backend == "epoll";
+}
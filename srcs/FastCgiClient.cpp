@@ -0,0 +1,359 @@
+#include "FastCgiClient.hpp"
+#include "macros.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// The largest content of a record that keeps it aligned on 8 bytes
+#define FASTCGI_MAX_CONTENT 65528
+
+// The length of a name or a value of a parameter, on 1 byte below 128
+static void appendLength(std::string &out, size_t length)
+{
+	if (length > 127)
+	{
+		out.append(1, static_cast<char>(((length >> 24) & 0x7f) | 0x80));
+		out.append(1, static_cast<char>((length >> 16) & 0xff));
+		out.append(1, static_cast<char>((length >> 8) & 0xff));
+	}
+	out.append(1, static_cast<char>(length & 0xff));
+}
+
+// Creates a non-blocking socket, closed at once in the scripts another
+// reactor thread spawns, so that none holds the connection open.
+static int openSocket(int family)
+{
+#ifdef LINUX
+	return socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+#else
+	int fd = socket(family, SOCK_STREAM, 0);
+	int flags = fd == -1 ? -1 : fcntl(fd, F_GETFL, 0);
+	if (flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1
+		|| fcntl(fd, F_SETFD, FD_CLOEXEC) == -1)
+	{
+		if (fd != -1)
+			close(fd);
+		return -1;
+	}
+	return fd;
+#endif
+}
+
+FastCgiClient::FastCgiClient(void)
+{
+	pthread_mutex_init(&mutex_, NULL);
+}
+
+FastCgiClient::~FastCgiClient(void)
+{
+	clear();
+	pthread_mutex_destroy(&mutex_);
+}
+
+/**
+ * @brief Resolves the address of an application, for the connections opened
+ * to it later.
+ *
+ * The lookup of a host name blocks, so it is done before the event loop
+ * runs, once for every fastcgi_pass directive.
+ *
+ * @param address The address of the application, "unix:/path" or
+ * "host:port".
+ * @return false if the address could not be resolved.
+ */
+bool FastCgiClient::resolve(std::string const &address)
+{
+	Address result;
+	if (!lookUp_(address, 0, result))
+		return false;
+	pthread_mutex_lock(&mutex_);
+	addresses_[address] = result;
+	pthread_mutex_unlock(&mutex_);
+	return true;
+}
+
+/**
+ * @brief Starts a request to a FastCGI application, on an idle connection
+ * to its address or a new one.
+ *
+ * @param address The address of the application, "unix:/path" or
+ * "host:port".
+ * @param env The parameters of the request, as "NAME=value" strings, sent
+ * ahead of the body.
+ * @return The request, to append the body to and read the output from, or
+ * NULL if the application could not be reached.
+ */
+CgiProcess *FastCgiClient::connect(
+	std::string const			   &address,
+	std::vector<std::string> const &env
+)
+{
+	int fd = takeIdle_(address);
+	if (fd == -1)
+		fd = open_(address);
+	if (fd == -1)
+		return NULL;
+
+	// A responder whose connection is kept open after the request
+	char const	begin[8] = {0, 1, 1, 0, 0, 0, 0, 0};
+	std::string head;
+	appendRecord(head, BEGIN_REQUEST, begin, sizeof(begin));
+	std::string params;
+	size_t const npos = std::string::npos;
+	for (size_t i = 0; i < env.size(); ++i)
+	{
+		size_t equal = env[i].find('=');
+		if (equal == npos)
+			continue;
+		appendLength(params, equal);
+		appendLength(params, env[i].size() - equal - 1);
+		params.append(env[i], 0, equal).append(env[i], equal + 1, npos);
+	}
+	if (!params.empty())
+		appendRecord(head, PARAMS, params.data(), params.size());
+	appendRecord(head, PARAMS, NULL, 0);
+
+	CgiProcess *cgi = new CgiProcess();
+	if (!cgi->connectFastCgi(this, address, fd, head))
+	{
+		delete cgi;
+		return NULL;
+	}
+	return cgi;
+}
+
+/**
+ * @brief Keeps the connection of a request that ended cleanly, for the next
+ * request to the same address.
+ *
+ * @param address The address the connection was opened to.
+ * @param fd The connection, closed if enough are kept already.
+ */
+void FastCgiClient::release(std::string const &address, int fd)
+{
+	pthread_mutex_lock(&mutex_);
+	std::vector<int> &idle = idle_[address];
+	bool			  isKept = idle.size() < FASTCGI_KEEPALIVE_CONNECTIONS;
+	if (isKept)
+		idle.push_back(fd);
+	pthread_mutex_unlock(&mutex_);
+	if (!isKept)
+		close(fd);
+}
+
+/**
+ * @brief Gets the number of idle connections kept to an address.
+ */
+size_t FastCgiClient::getIdleCount(std::string const &address) const
+{
+	pthread_mutex_lock(&mutex_);
+	IdleMap::const_iterator it = idle_.find(address);
+	size_t					count = it == idle_.end() ? 0 : it->second.size();
+	pthread_mutex_unlock(&mutex_);
+	return count;
+}
+
+/**
+ * @brief Closes all the idle connections.
+ */
+void FastCgiClient::clear(void)
+{
+	pthread_mutex_lock(&mutex_);
+	for (IdleMap::iterator it = idle_.begin(); it != idle_.end(); ++it)
+		for (size_t i = 0; i < it->second.size(); ++i)
+			close(it->second[i]);
+	idle_.clear();
+	pthread_mutex_unlock(&mutex_);
+}
+
+/**
+ * @brief Appends the records of a stream to out, as many as the content
+ * needs, or a single empty record that ends the stream.
+ *
+ * @param out The string to append to.
+ * @param type The type of the records.
+ * @param data The content of the records.
+ * @param length The length of the content.
+ */
+void FastCgiClient::appendRecord(
+	std::string &out,
+	RecordType	 type,
+	char const	*data,
+	size_t		 length
+)
+{
+	size_t offset(0);
+	do
+	{
+		size_t chunk = length - offset < FASTCGI_MAX_CONTENT
+						   ? length - offset
+						   : FASTCGI_MAX_CONTENT;
+		size_t padding = (8 - chunk % 8) % 8;
+		char   header[8] = {
+			  1,
+			  static_cast<char>(type),
+			  0,
+			  1,
+			  static_cast<char>((chunk >> 8) & 0xff),
+			  static_cast<char>(chunk & 0xff),
+			  static_cast<char>(padding),
+			  0
+		};
+		out.append(header, sizeof(header));
+		if (chunk > 0)
+			out.append(data + offset, chunk);
+		out.append(padding, '\0');
+		offset += chunk;
+	} while (offset < length);
+}
+
+/**
+ * @brief Reads the header of the record at offset.
+ *
+ * @param data The bytes received.
+ * @param offset The start of the record.
+ * @param record Set to the type, the content and the size of the record.
+ * @return false if the whole record was not received yet.
+ */
+bool FastCgiClient::parseRecord(
+	std::string const &data,
+	size_t			   offset,
+	Record			  &record
+)
+{
+	if (data.size() - offset < 8)
+		return false;
+	unsigned char const *header
+		= reinterpret_cast<unsigned char const *>(data.data() + offset);
+	record.type = static_cast<RecordType>(header[1]);
+	record.contentOffset = offset + 8;
+	record.contentLength = (header[4] << 8) | header[5];
+	record.size = 8 + record.contentLength + header[6];
+	return data.size() - offset >= record.size;
+}
+
+// Fills result with the socket address of "unix:/path" or "host:port", the
+// host being looked up with the flags of getaddrinfo.
+bool FastCgiClient::lookUp_(
+	std::string const &address,
+	int				   flags,
+	Address			  &result
+)
+{
+	std::memset(&result.storage, 0, sizeof(result.storage));
+	if (address.compare(0, 5, "unix:") == 0)
+	{
+		sockaddr_un *unixAddress
+			= reinterpret_cast<sockaddr_un *>(&result.storage);
+		unixAddress->sun_family = AF_UNIX;
+		std::strncpy(
+			unixAddress->sun_path,
+			address.c_str() + 5,
+			sizeof(unixAddress->sun_path) - 1
+		);
+		result.length = sizeof(sockaddr_un);
+		return true;
+	}
+
+	size_t			 colon = address.rfind(':');
+	struct addrinfo	 hints;
+	struct addrinfo *info;
+	std::memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_NUMERICSERV | flags;
+	if (colon == std::string::npos
+		|| getaddrinfo(
+			   address.substr(0, colon).c_str(),
+			   address.c_str() + colon + 1,
+			   &hints,
+			   &info
+		   ) != 0)
+		return false;
+	std::memcpy(&result.storage, info->ai_addr, info->ai_addrlen);
+	result.length = info->ai_addrlen;
+	freeaddrinfo(info);
+	return true;
+}
+
+// The socket address of an application, resolved ahead by resolve(). An
+// address that was not is only parsed as a numeric one, which does not
+// block, and kept for the next connections.
+bool FastCgiClient::findAddress_(std::string const &address, Address &result)
+{
+	pthread_mutex_lock(&mutex_);
+	AddressMap::const_iterator it = addresses_.find(address);
+	bool					   isFound = it != addresses_.end();
+	if (isFound)
+		result = it->second;
+	pthread_mutex_unlock(&mutex_);
+	if (isFound)
+		return true;
+	if (!lookUp_(address, AI_NUMERICHOST, result))
+		return false;
+	pthread_mutex_lock(&mutex_);
+	addresses_[address] = result;
+	pthread_mutex_unlock(&mutex_);
+	return true;
+}
+
+// Opens a non-blocking connection, still in progress over TCP.
+int FastCgiClient::open_(std::string const &address)
+{
+	Address target;
+	if (!findAddress_(address, target))
+		return -1;
+	int	 family = target.storage.ss_family;
+	int	 fd = openSocket(family);
+	bool isOk = fd != -1;
+	// The records of a streamed body are sent as they come, not delayed to
+	// be merged
+	int noDelay(1);
+	if (isOk && family != AF_UNIX)
+		isOk = setsockopt(
+				   fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay)
+			   )
+			   != -1;
+	// A full backlog fails a Unix connection rather than block
+	if (isOk
+		&& ::connect(
+			   fd, reinterpret_cast<sockaddr *>(&target.storage), target.length
+		   ) == -1)
+		isOk = family != AF_UNIX && errno == EINPROGRESS;
+	if (!isOk && fd != -1)
+	{
+		close(fd);
+		fd = -1;
+	}
+	return fd;
+}
+
+// An idle connection to the address, the ones the application closed
+// meanwhile being dropped.
+int FastCgiClient::takeIdle_(std::string const &address)
+{
+	int fd = -1;
+	pthread_mutex_lock(&mutex_);
+	IdleMap::iterator it = idle_.find(address);
+	while (fd == -1 && it != idle_.end() && !it->second.empty())
+	{
+		fd = it->second.back();
+		it->second.pop_back();
+		char byte;
+		if (recv(fd, &byte, 1, MSG_PEEK | MSG_DONTWAIT) != -1
+			|| (errno != EAGAIN && errno != EWOULDBLOCK))
+		{
+			close(fd);
+			fd = -1;
+		}
+	}
+	pthread_mutex_unlock(&mutex_);
+	return fd;
+}
@@ -0,0 +1,143 @@
+#include "GzipCache.hpp"
+
+GzipCache::GzipCache(void) : maxBytes_(0), bytes_(0), hits_(0), misses_(0)
+{
+	pthread_mutex_init(&mutex_, NULL);
+}
+
+GzipCache::~GzipCache(void)
+{
+	pthread_mutex_destroy(&mutex_);
+}
+
+/**
+ * @brief Sets the budget of the cache, emptying it.
+ *
+ * @param maxBytes The budget of the compressed bodies, 0 to cache nothing.
+ */
+void GzipCache::configure(size_t maxBytes)
+{
+	pthread_mutex_lock(&mutex_);
+	clear_();
+	maxBytes_ = maxBytes;
+	pthread_mutex_unlock(&mutex_);
+}
+
+bool GzipCache::isEnabled(void) const
+{
+	return maxBytes_ > 0;
+}
+
+/**
+ * @brief Tells whether a file of this size is compressed into the cache.
+ */
+bool GzipCache::isCacheable(size_t fileSize) const
+{
+	return fileSize <= maxBytes_ / 8;
+}
+
+/**
+ * @brief Gets the compressed body of a file.
+ *
+ * @param etag The ETag of the file.
+ * @param body Set to a copy of the compressed body.
+ * @return false if the file is not cached, which counts as a miss.
+ */
+bool GzipCache::find(std::string const &etag, std::string &body)
+{
+	if (maxBytes_ == 0)
+		return false;
+	pthread_mutex_lock(&mutex_);
+	EntryMap::iterator it = entries_.find(etag);
+	if (it == entries_.end())
+	{
+		++misses_;
+		pthread_mutex_unlock(&mutex_);
+		return false;
+	}
+	++hits_;
+	lru_.splice(lru_.begin(), lru_, it->second.position);
+	body = it->second.body;
+	pthread_mutex_unlock(&mutex_);
+	return true;
+}
+
+/**
+ * @brief Caches the compressed body of a file after a miss.
+ */
+void GzipCache::insert(std::string const &etag, std::string const &body)
+{
+	if (maxBytes_ == 0 || !isCacheable(body.size()))
+		return;
+	pthread_mutex_lock(&mutex_);
+	EntryMap::iterator it = entries_.find(etag);
+	if (it != entries_.end())
+		erase_(it);
+	while (!lru_.empty() && bytes_ + body.size() > maxBytes_)
+		erase_(entries_.find(lru_.back()));
+	lru_.push_front(etag);
+	Entry &entry = entries_[etag];
+	entry.body = body;
+	entry.position = lru_.begin();
+	bytes_ += body.size();
+	pthread_mutex_unlock(&mutex_);
+}
+
+void GzipCache::clear(void)
+{
+	pthread_mutex_lock(&mutex_);
+	clear_();
+	pthread_mutex_unlock(&mutex_);
+}
+
+size_t GzipCache::getSize(void) const
+{
+	pthread_mutex_lock(&mutex_);
+	size_t size = entries_.size();
+	pthread_mutex_unlock(&mutex_);
+	return size;
+}
+
+/**
+ * @brief Gets the bytes of the compressed bodies in the cache.
+ */
+size_t GzipCache::getBytes(void) const
+{
+	pthread_mutex_lock(&mutex_);
+	size_t bytes = bytes_;
+	pthread_mutex_unlock(&mutex_);
+	return bytes;
+}
+
+unsigned long long GzipCache::getHits(void) const
+{
+	pthread_mutex_lock(&mutex_);
+	unsigned long long hits = hits_;
+	pthread_mutex_unlock(&mutex_);
+	return hits;
+}
+
+/**
+ * @brief Gets the number of cacheable files compressed again.
+ */
+unsigned long long GzipCache::getMisses(void) const
+{
+	pthread_mutex_lock(&mutex_);
+	unsigned long long misses = misses_;
+	pthread_mutex_unlock(&mutex_);
+	return misses;
+}
+
+void GzipCache::erase_(EntryMap::iterator it)
+{
+	bytes_ -= it->second.body.size();
+	lru_.erase(it->second.position);
+	entries_.erase(it);
+}
+
+void GzipCache::clear_(void)
+{
+	entries_.clear();
+	lru_.clear();
+	bytes_ = 0;
+}
@@ -4,15 +4,20 @@
 #include "macros.hpp"
 #include "utils.hpp"
 
-std::string HttpErrorHandler::getErrorPage(
+/**
+ * @brief Creates the error page configured on the server for a status code.
+ *
+ * @return false if the server has no page for the status code.
+ */
+bool HttpErrorHandler::getErrorPage(
 	Server const	   &server,
 	unsigned int const &statusCode,
 	std::string const  &rootdir,
-	bool const		   &keepAlive
+	bool const		   &keepAlive,
+	HttpResponse	   &response
 )
 {
-	HttpResponse response;
-	std::string	 errorURI;
+	std::string errorURI;
 
 	if (server.getErrorPageValue(statusCode, errorURI))
 	{
@@ -29,14 +34,13 @@ std::string HttpErrorHandler::getErrorPage(
 			response.setHeader("Connection", "keep-alive");
 		else
 			response.setHeader("Connection", "close");
-		response.setBody(body);
-
-		return response.toString();
+		response.swapBody(body);
+		return true;
 	}
-	return "";
+	return false;
 }
 
-std::string HttpErrorHandler::getErrorPage(
+HttpResponse HttpErrorHandler::getErrorPage(
 	unsigned int const &statusCode,
 	bool const		   &keepAlive
 )
@@ -76,7 +80,7 @@ std::string HttpErrorHandler::getErrorPage(
 		response.setHeader("Connection", "keep-alive");
 	else
 		response.setHeader("Connection", "close");
-	response.setBody(body);
+	response.swapBody(body);
 
-	return response.toString();
+	return response;
 }
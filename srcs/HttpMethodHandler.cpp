@@ -1,4 +1,5 @@
 #include "HttpMethodHandler.hpp"
+#include "BodyGenerators.hpp"
 #include "HttpErrorHandler.hpp"
 #include "HttpResponse.hpp"
 #include "Logger.hpp"
@@ -7,17 +8,316 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdlib>
 #include <cstring>
 #include <dirent.h>
 #include <fstream>
+#include <iomanip>
+#include <limits>
+#include <strings.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
-std::string HttpMethodHandler::handleRequest(
+OpenFileCache HttpMethodHandler::openFileCache_;
+ResponseCache HttpMethodHandler::responseCache_;
+GzipCache	  HttpMethodHandler::gzipCache_;
+CgiPool		  HttpMethodHandler::cgiPool_;
+FastCgiClient HttpMethodHandler::fastCgiClient_;
+
+/**
+ * @brief Gets the cache of the files served by the handlers.
+ */
+OpenFileCache &HttpMethodHandler::getOpenFileCache(void)
+{
+	return openFileCache_;
+}
+
+/**
+ * @brief Gets the cache of the rendered responses of small static files.
+ */
+ResponseCache &HttpMethodHandler::getResponseCache(void)
+{
+	return responseCache_;
+}
+
+/**
+ * @brief Gets the cache of the static files compressed with gzip.
+ */
+GzipCache &HttpMethodHandler::getGzipCache(void)
+{
+	return gzipCache_;
+}
+
+/**
+ * @brief Gets the workers preforked for the scripts of cgi_pool locations.
+ */
+CgiPool &HttpMethodHandler::getCgiPool(void)
+{
+	return cgiPool_;
+}
+
+/**
+ * @brief Gets the connections to the applications of fastcgi_pass locations.
+ */
+FastCgiClient &HttpMethodHandler::getFastCgiClient(void)
+{
+	return fastCgiClient_;
+}
+
+// Reads a whole file, whose size is the size of data.
+static bool readFile(int fd, std::string &data)
+{
+	size_t done(0);
+	while (done < data.size())
+	{
+		ssize_t bytesRead = pread(fd, &data[done], data.size() - done, done);
+		if (bytesRead <= 0)
+			return false;
+		done += bytesRead;
+	}
+	return true;
+}
+
+// Gets the values of a request header, NULL if it is missing.
+static std::vector<std::string> const *
+findHeader(HttpRequest const &request, std::string const &name)
+{
+	// clang-format off
+	std::map<std::string, std::vector<std::string> > const &headers
+		= request.getHeaders();
+	std::map<std::string, std::vector<std::string> >::const_iterator it
+		= headers.find(name); // clang-format on
+	return it == headers.end() ? NULL : &it->second;
+}
+
+// Gets the length of the body, announced by Content-Length as a streamed
+// body is not read yet.
+static size_t getBodyLength(HttpRequest const &request)
+{
+	std::vector<std::string> const *contentLength
+		= findHeader(request, "Content-Length");
+	if (contentLength == NULL || contentLength->empty())
+		return request.getBody().size();
+	return ft::stringToULong((*contentLength)[0]);
+}
+
+// Gets a header value that may hold commas, such as a date, split with the
+// other list values.
+static std::string joinHeader(std::vector<std::string> const &values)
+{
+	std::string value;
+	for (size_t i = 0; i < values.size(); ++i)
+		value += (i > 0 ? ", " : "") + values[i];
+	return value;
+}
+
+// Tells whether a request carries validators, answered from the metadata.
+static bool isConditional(HttpRequest const &request)
+{
+	return findHeader(request, "If-None-Match") != NULL
+		   || findHeader(request, "If-Modified-Since") != NULL;
+}
+
+// Tells whether a request accepts a gzip encoded response, from the q-values
+// of gzip and of *, the q-value of gzip winning.
+static bool acceptsGzip(HttpRequest const &request)
+{
+	std::vector<std::string> const *codings
+		= findHeader(request, "Accept-Encoding");
+	if (codings == NULL)
+		return false;
+	double gzipWeight(-1);
+	double anyWeight(-1);
+	for (size_t i = 0; i < codings->size(); ++i)
+	{
+		std::string coding = (*codings)[i];
+		double		weight(1);
+		size_t		semicolon = coding.find(';');
+		if (semicolon != std::string::npos)
+		{
+			size_t q = coding.find("q=", semicolon);
+			if (q != std::string::npos)
+				weight = std::strtod(coding.c_str() + q + 2, NULL);
+			coding.erase(semicolon);
+		}
+		ft::trim(coding);
+		if (strcasecmp(coding.c_str(), "gzip") == 0)
+			gzipWeight = weight;
+		else if (coding == "*")
+			anyWeight = weight;
+	}
+	return gzipWeight > 0 || (gzipWeight < 0 && anyWeight > 0);
+}
+
+// The validators change with the content: a file replaced, rewritten or
+// resized gets another inode, modification time or size.
+static std::string createETag(OpenFileCache::Info const &info)
+{
+	std::ostringstream etag;
+	etag << std::hex << '"' << info.inode << '-' << info.mtime << '-'
+		 << info.size << '"';
+	return etag.str();
+}
+
+// Evaluates If-None-Match, or If-Modified-Since without it, as RFC 9110 asks.
+static bool isNotModified(
+	HttpRequest const &request,
+	std::string const &etag,
+	time_t			   mtime
+)
+{
+	std::vector<std::string> const *tags = findHeader(request, "If-None-Match");
+	if (tags != NULL)
+	{
+		for (size_t i = 0; i < tags->size(); ++i)
+		{
+			std::string const &tag = (*tags)[i];
+			// The comparison is weak: W/ is ignored
+			if (tag == "*" || tag == etag
+				|| (tag.compare(0, 2, "W/") == 0 && tag.substr(2) == etag))
+				return true;
+		}
+		return false;
+	}
+	std::vector<std::string> const *date
+		= findHeader(request, "If-Modified-Since");
+	time_t since;
+	return date != NULL && ft::parseHttpDate(joinHeader(*date), since)
+		   && mtime <= since;
+}
+
+// Evaluates If-Range: the ranges are only served from the representation the
+// client already has part of. The comparison is strong.
+static bool isRangeCurrent(
+	HttpRequest const &request,
+	std::string const &etag,
+	time_t			   mtime
+)
+{
+	std::vector<std::string> const *condition = findHeader(request, "If-Range");
+	if (condition == NULL)
+		return true;
+	std::string value = joinHeader(*condition);
+	if (!value.empty() && (value[0] == '"' || value.compare(0, 2, "W/") == 0))
+		return value == etag;
+	time_t date;
+	return ft::parseHttpDate(value, date) && mtime == date;
+}
+
+// Reads the decimal position of a range, at most 18 digits so it fits.
+static bool parsePosition(std::string const &str, off_t &position)
+{
+	if (str.empty() || str.size() > 18 || !ft::isStrOfDigits(str))
+		return false;
+	position = 0;
+	for (size_t i = 0; i < str.size(); ++i)
+		position = position * 10 + (str[i] - '0');
+	return true;
+}
+
+// Adds the part of a range spec that is within the file. Returns false if the
+// spec is invalid.
+static bool parseRangeSpec(
+	std::string const		&spec,
+	off_t					 size,
+	std::vector<ByteRange>	&ranges
+)
+{
+	size_t dash = spec.find('-');
+	if (dash == std::string::npos)
+		return false;
+	off_t first;
+	off_t last;
+	if (dash == 0)
+	{
+		// The last bytes of the file
+		if (!parsePosition(spec.substr(1), last))
+			return false;
+		if (last > 0 && size > 0)
+			ranges.push_back(
+				ByteRange(last < size ? size - last : 0, size - 1)
+			);
+		return true;
+	}
+	if (!parsePosition(spec.substr(0, dash), first))
+		return false;
+	if (dash + 1 == spec.size())
+		last = size - 1;
+	else if (!parsePosition(spec.substr(dash + 1), last) || last < first)
+		return false;
+	if (first < size)
+		ranges.push_back(ByteRange(first, last < size ? last : size - 1));
+	return true;
+}
+
+/**
+ * @brief Gets the byte ranges a GET request asks for.
+ *
+ * An invalid Range header, one with more than MAX_RANGES ranges or ranges
+ * adding up to more than the file, and one failing If-Range, are ignored, as
+ * RFC 9110 allows: the whole file is sent.
+ *
+ * @return 200 to send the whole file, 206 to send the ranges or 416 if none
+ * of them is within the file.
+ */
+static int getRanges(
+	HttpRequest const	   &request,
+	OpenFileCache::Info const &info,
+	std::string const	   &etag,
+	std::vector<ByteRange> &ranges
+)
+{
+	std::vector<std::string> const *specs = findHeader(request, "Range");
+	if (specs == NULL || specs->empty() || specs->size() > MAX_RANGES
+		|| strncasecmp((*specs)[0].c_str(), "bytes=", 6) != 0
+		|| !isRangeCurrent(request, etag, info.mtime))
+		return 200;
+	off_t total(0);
+	for (size_t i = 0; i < specs->size(); ++i)
+	{
+		std::string const &spec
+			= i == 0 ? (*specs)[0].substr(6) : (*specs)[i];
+		if (!parseRangeSpec(spec, info.size, ranges))
+		{
+			ranges.clear();
+			return 200;
+		}
+	}
+	for (size_t i = 0; i < ranges.size(); ++i)
+		total += ranges[i].second - ranges[i].first + 1;
+	if (ranges.empty())
+		return 416;
+	if (ranges.size() > 1 && total > info.size)
+	{
+		ranges.clear();
+		return 200;
+	}
+	return 206;
+}
+
+// Makes the boundaries of the multipart bodies, unique within the process.
+static std::string createBoundary(void)
+{
+	static unsigned long count(0);
+	std::ostringstream	 boundary;
+	boundary << std::setw(20) << std::setfill('0')
+			 << __sync_add_and_fetch(&count, 1);
+	return boundary.str();
+}
+
+/**
+ * @brief Makes the response to a request.
+ *
+ * @param cgi Set to the running CGI script if the request is run by one,
+ * which the caller then drives to make the response with createCgiResponse().
+ * With NULL, a CGI script is run to completion before returning.
+ */
+HttpResponse HttpMethodHandler::handleRequest(
 	HttpRequest const &request,
 	Server const	  &server,
-	std::string const &method
+	std::string const &method,
+	CgiProcess		 **cgi
 )
 {
 	if (method == "GET")
@@ -26,7 +326,7 @@ std::string HttpMethodHandler::handleRequest(
 			<< "Server " << server.getServerIndex() << ": handling \033[32mGET\033[0m request" << std::endl;
 		Logger::log(Logger::DEBUG)
 			<< "Handling GET request: " << request.getUri() << std::endl;
-		return handleGetRequest_(request, server);
+		return handleGetRequest_(request, server, cgi);
 	}
 	else if (method == "POST")
 	{
@@ -34,7 +334,7 @@ std::string HttpMethodHandler::handleRequest(
 			<< "Server " << server.getServerIndex() << ": handling \033[33mPOST\033[0m request" << std::endl;
 		Logger::log(Logger::DEBUG)
 			<< "Handling POST request: " << request.getUri() << std::endl;
-		return handlePostRequest_(request, server);
+		return handlePostRequest_(request, server, cgi);
 	}
 	else if (method == "DELETE")
 	{
@@ -42,19 +342,65 @@ std::string HttpMethodHandler::handleRequest(
 			<< "Server " << server.getServerIndex() << ": handling \033[31mDELETE\033[0m request" << std::endl;
 		Logger::log(Logger::DEBUG)
 			<< "Handling DELETE request: " << request.getUri() << std::endl;
-		return handleDeleteRequest_(request, server);
+		return handleDeleteRequest_(request, server, cgi);
 	}
 	return HttpErrorHandler::getErrorPage(501, true);
 }
 
-std::string HttpMethodHandler::handleGetRequest_(
-	const HttpRequest &request,
+/**
+ * @brief Tells whether a request is run by a CGI script.
+ */
+bool HttpMethodHandler::isCgiRequest(
+	HttpRequest const &request,
 	Server const	  &server
 )
+{
+	std::string uri = request.getUri();
+	return server.isThisLocation(uri)
+		   && isCgiRequest_(server.getThisLocation(uri), uri);
+}
+
+// A directory listing is heavy: it may block the event loop long enough to be
+// worth running on another reactor. A CGI script runs in its own process.
+bool HttpMethodHandler::isHeavyRequest(
+	HttpRequest const &request,
+	Server const	  &server
+)
+{
+	std::string uri = request.getUri();
+	if (!server.isThisLocation(uri))
+		return false;
+
+	// clang-format off
+	std::map<std::string, std::vector<std::string> > const &location
+		= server.getThisLocation(uri); // clang-format on
+	return request.getMethod() == "GET" && isAutoIndexEnabled_(location)
+		   && isDirectory_(getFilePath_(uri, location, server));
+}
+
+HttpResponse HttpMethodHandler::handleGetRequest_(
+	const HttpRequest &request,
+	Server const	  &server,
+	CgiProcess		 **cgi
+)
 {
 	std::string uri = request.getUri();
 	bool		keepAlive = request.getKeepAlive();
 
+	// A cached response was a static file, served the same way to any request
+	// without a body
+	std::string cacheKey;
+	if (responseCache_.isEnabled() && request.getBody().empty()
+		&& !isConditional(request) && findHeader(request, "Range") == NULL)
+	{
+		HttpResponse cached;
+		// The encoding accepted picks the representation with gzip_static
+		cacheKey = ft::toString(server.getServerIndex()) + " " + uri
+				   + (acceptsGzip(request) ? " gzip" : "");
+		if (responseCache_.find(cacheKey, keepAlive, cached))
+			return cached;
+	}
+
 	// clang-format off
 	std::map<std::string, std::vector<std::string> > location; // clang-format on
 
@@ -64,8 +410,8 @@ std::string HttpMethodHandler::handleGetRequest_(
 		return HttpErrorHandler::getErrorPage(404, keepAlive);
 
 	// Check for redirections
-	std::string redirection = handleRedirection_(location, keepAlive);
-	if (!redirection.empty())
+	HttpResponse redirection;
+	if (handleRedirection_(location, keepAlive, redirection))
 		return redirection;
 
 	std::string filepath = getFilePath_(uri, location, server);
@@ -80,34 +426,48 @@ std::string HttpMethodHandler::handleGetRequest_(
 		return handleErrorResponse_(server, 413, rootdir, keepAlive);
 
 	if (isCgiRequest_(location, uri))
-	{
 		return handleCgiRequest_(
 			filepath,
 			getCgiInterpreter_(location),
 			request,
 			keepAlive,
 			server,
-			rootdir
+			rootdir,
+			cgi
 		);
-	}
 	// Check if the request is for a directory and handle autoindex
 	if (isDirectory_(filepath))
 	{
 		if (isAutoIndexEnabled_(location))
-			return handleAutoIndex_(rootdir, uri, server, keepAlive);
+		{
+			HttpResponse response
+				= handleAutoIndex_(rootdir, uri, server, keepAlive);
+			compressResponse_(request, location, response);
+			return response;
+		}
 		// Search for index file in the directory
 		filepath = findIndexFile_(filepath, location, server);
 		if (filepath.empty())
 			return handleErrorResponse_(server, 404, rootdir, keepAlive);
 	}
 
+	if (!isCacheEnabled_(location))
+		cacheKey.clear();
 	// Check if the file exists and return the response
-	return createFileGetResponse_(filepath, rootdir, server, keepAlive);
+	return createFileGetResponse_(
+		request,
+		filepath,
+		rootdir,
+		server,
+		location,
+		cacheKey
+	);
 }
 
-std::string HttpMethodHandler::handlePostRequest_(
+HttpResponse HttpMethodHandler::handlePostRequest_(
 	const HttpRequest &request,
-	Server const	  &server
+	Server const	  &server,
+	CgiProcess		 **cgi
 )
 {
 	std::string uri = request.getUri();
@@ -122,7 +482,10 @@ std::string HttpMethodHandler::handlePostRequest_(
 		return HttpErrorHandler::getErrorPage(404, keepAlive);
 
 	// Check for redirections
-	std::string redirect = handleRedirection_(location, keepAlive);
+	HttpResponse		redirection;
+	HttpResponse const *redirect
+		= handleRedirection_(location, keepAlive, redirection) ? &redirection
+															   : NULL;
 
 	std::string rootdir = getRootDir_(location, server);
 	std::string uploadpath = getUploadPath_(location);
@@ -144,7 +507,7 @@ std::string HttpMethodHandler::handlePostRequest_(
 			keepAlive,
 			server,
 			rootdir,
-			redirect,
+			cgi,
 			uploadpath
 		);
 
@@ -153,9 +516,10 @@ std::string HttpMethodHandler::handlePostRequest_(
 	);
 }
 
-std::string HttpMethodHandler::handleDeleteRequest_(
+HttpResponse HttpMethodHandler::handleDeleteRequest_(
 	const HttpRequest &request,
-	Server const	  &server
+	Server const	  &server,
+	CgiProcess		 **cgi
 )
 {
 	std::string uri = request.getUri();
@@ -169,7 +533,10 @@ std::string HttpMethodHandler::handleDeleteRequest_(
 	else
 		return HttpErrorHandler::getErrorPage(404, keepAlive);
 
-	std::string redirect = handleRedirection_(location, keepAlive);
+	HttpResponse		redirection;
+	HttpResponse const *redirect
+		= handleRedirection_(location, keepAlive, redirection) ? &redirection
+															   : NULL;
 
 	std::string rootdir = getRootDir_(location, server);
 
@@ -192,7 +559,7 @@ std::string HttpMethodHandler::handleDeleteRequest_(
 			keepAlive,
 			server,
 			rootdir,
-			redirect
+			cgi
 		);
 
 	return createDeleteResponse_(
@@ -200,35 +567,39 @@ std::string HttpMethodHandler::handleDeleteRequest_(
 	);
 }
 
-std::string HttpMethodHandler::handleErrorResponse_(
+HttpResponse HttpMethodHandler::handleErrorResponse_(
 	Server const	  &server,
 	int const		  &errorCode,
 	std::string const &rootdir,
 	bool const		  &keepAlive
 )
 {
-	std::string errorResponse
-		= HttpErrorHandler::getErrorPage(server, errorCode, rootdir, keepAlive);
-	if (!errorResponse.empty())
-		return errorResponse;
-	else
-		return HttpErrorHandler::getErrorPage(errorCode, keepAlive);
+	HttpResponse errorResponse;
+	if (!HttpErrorHandler::getErrorPage(
+			server, errorCode, rootdir, keepAlive, errorResponse
+		))
+		errorResponse = HttpErrorHandler::getErrorPage(errorCode, keepAlive);
+	return errorResponse;
 }
 
 // clang-format off
-std::string HttpMethodHandler::handleRedirection_(
+bool HttpMethodHandler::handleRedirection_(
 	std::map<std::string, std::vector<std::string> > const &location,
-	bool const											  &keepAlive
+	bool const											  &keepAlive,
+	HttpResponse										  &response
 )
 {
 	std::map<std::string, std::vector<std::string> >::const_iterator it
 		= location.find("return"); // clang-format on
 	if (it != location.end() && !it->second.empty())
-		return handleReturnDirective_(it->second, keepAlive);
-	return "";
+	{
+		response = handleReturnDirective_(it->second, keepAlive);
+		return true;
+	}
+	return false;
 }
 
-std::string HttpMethodHandler::handleReturnDirective_(
+HttpResponse HttpMethodHandler::handleReturnDirective_(
 	std::vector<std::string> const &returnDirective,
 	bool const					   &keepAlive
 )
@@ -262,7 +633,7 @@ std::string HttpMethodHandler::handleReturnDirective_(
 	else
 		response.setHeader("Connection", "close");
 
-	return response.toString();
+	return response;
 }
 
 // clang-format off
@@ -295,10 +666,10 @@ bool HttpMethodHandler::validateBodySize_(
 	//
 	if (it != location.end() && !it->second.empty())
 	{
-		if (request.getBody().size() > ft::stringToULong(it->second[0]))
+		if (getBodyLength(request) > ft::stringToULong(it->second[0]))
 			return false;
 	}
-	else if (request.getBody().size() > server.getClientMaxBodySize())
+	else if (getBodyLength(request) > server.getClientMaxBodySize())
 		return false;
 	return true;
 }
@@ -350,6 +721,9 @@ bool HttpMethodHandler::isCgiRequest_(
 	std::map<std::string, std::vector<std::string> >::const_iterator it
 		= location.find("cgi"); // clang-format on
 
+	// An application behind fastcgi_pass runs all the requests
+	if (!getFastCgiPass_(location).empty())
+		return true;
 	if (it != location.end() && !it->second.empty())
 	{
 		if (it->second.size() == 1 || it->second.size() == 2)
@@ -367,249 +741,552 @@ std::string HttpMethodHandler::getCgiInterpreter_(
 	std::map<std::string, std::vector<std::string> > const &location
 ) // clang-format on
 {
+	if (location.find("cgi") == location.end()
+		|| location.find("cgi")->second.empty())
+		return "";
 	if (location.find("cgi")->second.size() == 1)
 		return location.find("cgi")->second[0]; // binary path
 	return location.find("cgi")->second[1];		// "/usr/bin/python3"
 }
 
-std::string HttpMethodHandler::handleCgiRequest_(
+// The address of the FastCGI application of the location, if any.
+// clang-format off
+std::string HttpMethodHandler::getFastCgiPass_(
+	std::map<std::string, std::vector<std::string> > const &location
+) // clang-format on
+{
+	if (location.find("fastcgi_pass") == location.end()
+		|| location.find("fastcgi_pass")->second.empty())
+		return "";
+	return location.find("fastcgi_pass")->second[0];
+}
+
+/**
+ * @brief Runs the CGI script of a request.
+ *
+ * With cgi set the script is left running with the body of the request as
+ * its input. The caller may append the rest of a streamed body, ends the
+ * input, reads the output and makes the response with createCgiResponse().
+ * Otherwise the script is run to completion here, blocking.
+ *
+ * @param cgi Set to the running script, NULL to wait for the script.
+ * @return The response of the script or an error page, unused if cgi was set
+ * to a running script.
+ */
+HttpResponse HttpMethodHandler::handleCgiRequest_(
 	std::string const &filepath,
 	std::string const &interpreter,
 	HttpRequest const &request,
 	bool const		  &keepAlive,
 	Server const	  &server,
 	std::string const &rootdir,
-	std::string const &redirect,
+	CgiProcess		 **cgi,
 	std::string const &uploadpath
 )
 {
 	Logger::log(Logger::DEBUG) << "Filepath: " << filepath << std::endl;
 	Logger::log(Logger::DEBUG) << "Interpreter: " << interpreter << std::endl;
 
-	int pipefd[2];
-	if (pipe(pipefd) == -1)
+	std::vector<std::string> envVariables;
+	envVariables.push_back("GATEWAY_INTERFACE=CGI/1.1");
+	envVariables.push_back("SERVER_PROTOCOL=HTTP/1.1");
+	envVariables.push_back("REQUEST_METHOD=" + request.getMethod());
+	envVariables.push_back("SCRIPT_FILENAME=" + filepath);
+	envVariables.push_back("ROOT_DIR=" + rootdir);
+	envVariables.push_back("TARGET_FILE=" + request.getFileName());
+	envVariables.push_back("UPLOAD_PATH=" + uploadpath);
+	envVariables.push_back("DOCUMENT_ROOT=" + rootdir);
+	envVariables.push_back("SCRIPT_NAME=" + request.getUri());
+	envVariables.push_back("QUERY_STRING=" + request.getFileName());
+	envVariables.push_back("SERVER_NAME=" + request.getHost());
+	envVariables.push_back("SERVER_PORT=" + ft::toString(request.getPort()));
+	if (request.hasCookie())
 	{
-		Logger::log(Logger::ERROR) << "Pipe creation failed" << std::endl;
-		return handleErrorResponse_(server, 500, rootdir, keepAlive);
+		envVariables.push_back("COOKIE=" + request.getCookie());
 	}
+	envVariables.push_back(
+		"CONTENT_LENGTH=" + ft::toString(getBodyLength(request))
+	);
+	Logger::log(Logger::DEBUG, true)
+		<< "handleCgiRequest_: full request: " << request << std::endl;
 
-	pid_t pid = fork();
-	if (pid == -1)
+	std::vector<std::string> const *contentType
+		= findHeader(request, "Content-Type");
+	if (contentType != NULL && !contentType->empty())
 	{
-		Logger::log(Logger::ERROR) << "Fork failed" << std::endl;
-		return handleErrorResponse_(server, 500, rootdir, keepAlive);
-	}
-	else if (pid == 0)
-	{
-		// child process
-		dup2(
-			pipefd[0], STDIN_FILENO
-		); // Redirect stdin to the read end of the pipe to receive body from
-		   // parent process
-		close(pipefd[0]);
-
-		std::vector<std::string> envVariables;
-		envVariables.push_back("GATEWAY_INTERFACE=CGI/1.1");
-		envVariables.push_back("SERVER_PROTOCOL=HTTP/1.1");
-		envVariables.push_back("REQUEST_METHOD=" + request.getMethod());
-		envVariables.push_back("SCRIPT_FILENAME=" + filepath);
-		envVariables.push_back("ROOT_DIR=" + rootdir);
-		envVariables.push_back("TARGET_FILE=" + request.getFileName());
-		envVariables.push_back("UPLOAD_PATH=" + uploadpath);
-		if (request.hasCookie())
-		{
-			envVariables.push_back("COOKIE=" + request.getCookie());
-		}
-		envVariables.push_back(
-			"CONTENT_LENGTH=" + ft::toString(request.getBody().size())
-		);
-		Logger::log(Logger::DEBUG, true)
-			<< "handleCgiRequest_: full request: " << request << std::endl;
-
-		// clang-format off
-		std::map<std::string, std::vector<std::string> > headers2
-			= request.getHeaders();
-		std::map<std::string, std::vector<std::string> >::iterator contentTypeIt
-			= headers2.find("Content-Type"); // clang-format on
-		if (contentTypeIt != headers2.end() && !contentTypeIt->second.empty())
+		std::string combinedContentType = (*contentType)[0];
+		for (size_t i = 1; i < contentType->size(); ++i)
 		{
-			std::string combinedContentType = contentTypeIt->second[0];
-			for (size_t i = 1; i < contentTypeIt->second.size(); ++i)
-			{
-				combinedContentType += "; " + contentTypeIt->second[i];
-			}
-			envVariables.push_back("CONTENT_TYPE=" + combinedContentType);
+			combinedContentType += "; " + (*contentType)[i];
 		}
+		envVariables.push_back("CONTENT_TYPE=" + combinedContentType);
+	}
 
-		std::vector<char *> envp;
-		for (std::vector<std::string>::iterator it = envVariables.begin();
-			 it != envVariables.end();
-			 ++it)
-		{
-			envp.push_back(const_cast<char *>(it->c_str()));
-		}
-		envp.push_back(NULL);
-
-		Logger::log(Logger::DEBUG, true)
-			<< "Filepath before argv: " << filepath << std::endl;
-
-		char *argv[]
-			= {const_cast<char *>(interpreter.c_str()),
-			   const_cast<char *>(filepath.c_str()),
-			   NULL};
-
-		dup2(pipefd[1], STDOUT_FILENO);
-
-		if (execve(interpreter.c_str(), argv, &envp[0]) == -1)
-		{
-			Logger::log(Logger::ERROR, true)
-				<< "Failed to execute CGI script: " << filepath << std::endl;
-			close(pipefd[1]);
-		}
+	std::vector<std::string> argv;
+	argv.push_back(interpreter);
+	argv.push_back(filepath);
 
-		close(pipefd[1]);
-		exit(EXIT_FAILURE);
-	}
+	// clang-format off
+	std::map<std::string, std::vector<std::string> > const location
+		= server.getThisLocation(request.getUri()); // clang-format on
+	std::string		fastCgiPass = getFastCgiPass_(location);
+	CgiPool::Limits limits;
+	CgiProcess	   *process = NULL;
+	if (!fastCgiPass.empty())
+		process = fastCgiClient_.connect(fastCgiPass, envVariables);
+	else if (getCgiPoolLimits_(location, limits))
+		process = cgiPool_.connect(argv, envVariables, limits);
 	else
 	{
-		// parent process
-
-		// Write the request body to the pipe for the child process
-		const std::vector<char> &requestBody = request.getBody();
-
-		if (write(pipefd[1], requestBody.data(), requestBody.size()) < 0)
+		process = new CgiProcess();
+		if (!process->start(argv, envVariables))
 		{
-			Logger::log(Logger::ERROR)
-				<< "CGI script execution failed to write" << std::endl;
-			return HttpErrorHandler::getErrorPage(500);
+			delete process;
+			process = NULL;
 		}
-		close(pipefd[1]); // Close the write end of the pipe after writing
-
-		Logger::log(Logger::DEBUG, true)
-			<< "handleCgiRequest_: passing arguments to CGI child, body length:"
-			<< requestBody.size() << std::endl;
+	}
+	if (process == NULL)
+	{
+		Logger::log(Logger::ERROR)
+			<< "Failed to start CGI script: " << filepath << std::endl;
+		return handleErrorResponse_(server, 500, rootdir, keepAlive);
+	}
+	Logger::log(Logger::DEBUG, true)
+		<< "handleCgiRequest_: passing arguments to CGI child, body length:"
+		<< request.getBody().size() << std::endl;
+	std::vector<char> const &body = request.getBody();
+	if (!body.empty())
+		process->appendInput(&body[0], body.size());
+	if (cgi != NULL)
+	{
+		*cgi = process;
+		return HttpResponse();
+	}
+	process->endInput();
 
-		int status;
-		waitpid(pid, &status, 0);
-		if (status != 0)
-		{
-			Logger::log(Logger::ERROR)
-				<< "CGI script execution failed" << std::endl;
-			return HttpErrorHandler::getErrorPage(500);
-		}
+	HttpResponse response;
+	if (!process->wait())
+	{
+		Logger::log(Logger::ERROR)
+			<< "CGI script execution failed to write or read" << std::endl;
+		response = HttpErrorHandler::getErrorPage(500);
+	}
+	else
+		response = createCgiResponse(*process, request, server);
+	delete process;
+	return response;
+}
 
-		if (!redirect.empty())
-			return redirect;
+/**
+ * @brief Makes the response of a CGI script that has exited.
+ *
+ * @param cgi The script, whose whole output was read.
+ * @param request The request run by the script.
+ * @param server The server of the request.
+ * @return The response made of the output of the script, the redirection of
+ * its location or an error page if the script failed.
+ */
+HttpResponse HttpMethodHandler::createCgiResponse(
+	CgiProcess const  &cgi,
+	HttpRequest const &request,
+	Server const	  &server
+)
+{
+	bool keepAlive = request.getKeepAlive();
+	if (!cgi.isSuccess())
+	{
+		Logger::log(Logger::ERROR)
+			<< "CGI script execution failed" << std::endl;
+		return HttpErrorHandler::getErrorPage(500);
+	}
 
-		char			  buffer[1024];
-		std::stringstream output;
-		ssize_t			  bytesRead;
+	// clang-format off
+	std::map<std::string, std::vector<std::string> > location
+		= server.getThisLocation(request.getUri()); // clang-format on
+	// A GET is redirected before its script runs, a POST or a DELETE after
+	HttpResponse redirection;
+	if (request.getMethod() != "GET"
+		&& handleRedirection_(location, keepAlive, redirection))
+		return redirection;
 
-		while ((bytesRead = read(pipefd[0], buffer, sizeof(buffer))) > 0)
-			output.write(buffer, bytesRead);
+	HttpResponse response
+		= parseCgiOutput_(cgi.getOutput(), cgi.isFastCgi(), keepAlive);
+	if (request.getMethod() != "DELETE")
+		compressResponse_(request, location, response);
+	return response;
+}
 
-		if (bytesRead == -1)
-		{
-			Logger::log(Logger::ERROR)
-				<< "CGI script read() execution failed" << std::endl;
-			return HttpErrorHandler::getErrorPage(500);
-		}
+/**
+ * @brief Makes the response of a CGI script still running, once enough of
+ * its output is read.
+ *
+ * The head is made once the block of headers of the script is read or, for
+ * a script writing none, once CGI_OUTPUT_BUFFER_SIZE bytes are, its status
+ * being guessed from them. The rest of the output is the body, sent as it is
+ * read: with the Content-Length of the script if it gives one, in chunks
+ * otherwise, and compressed on the way where gzip applies.
+ *
+ * @param cgi The running script, whose block of headers is taken.
+ * @param request The request run by the script.
+ * @param server The server of the request.
+ * @param response Set to the head of the response, or to a whole response,
+ * as the redirection of a POST, after which the output is dropped.
+ * @return The generator of the body, owned by the caller, or NULL if more
+ * output is needed first.
+ */
+BodyGenerator *HttpMethodHandler::createCgiStreamResponse(
+	CgiProcess		  &cgi,
+	HttpRequest const &request,
+	Server const	  &server,
+	HttpResponse	  &response
+)
+{
+	std::string const &output = cgi.getOutput();
+	bool			   isFull = output.size() >= CGI_OUTPUT_BUFFER_SIZE;
+	std::map<std::string, std::string> cgiHeaders;
+	bool   isComplete = isFull || cgi.isOutputDone();
+	size_t bodyStart
+		= parseCgiHeaders_(output, isComplete, cgi.isFastCgi(), cgiHeaders);
+	if (bodyStart == std::string::npos || (bodyStart == 0 && !isFull))
+		return NULL;
+
+	bool keepAlive = request.getKeepAlive();
+	// clang-format off
+	std::map<std::string, std::vector<std::string> > location
+		= server.getThisLocation(request.getUri()); // clang-format on
+	if (request.getMethod() != "GET"
+		&& handleRedirection_(location, keepAlive, response))
+		return new CgiGenerator(cgi, 0);
+
+	std::string head;
+	cgi.takeOutput(head, bodyStart);
+	size_t length(std::string::npos);
+	try
+	{
+		if (cgiHeaders.find("Content-Length") != cgiHeaders.end())
+			length = ft::stringToULong(cgiHeaders["Content-Length"]);
+	}
+	catch (std::exception &e)
+	{
+		// The body of an invalid length is sent in chunks
+	}
+	response = createCgiHead_(cgiHeaders, output, keepAlive);
+	int level(0);
+	if (request.getMethod() != "DELETE" && response.getStatusCode() == 200
+		&& response.getHeader("Content-Encoding").empty())
+		level = getGzipLevel_(
+			location,
+			response.getHeader("Content-Type"),
+			length == std::string::npos ? std::numeric_limits<off_t>::max()
+										: length
+		);
+	if (level > 0)
+		response.setHeader("Vary", "Accept-Encoding");
+	if (level > 0 && acceptsGzip(request))
+	{
+		response.setHeader("Transfer-Encoding", "chunked");
+		response.setHeader("Content-Encoding", "gzip");
+		return new ChunkedGenerator(
+			new GzipGenerator(new CgiGenerator(cgi, length), level)
+		);
+	}
+	if (length != std::string::npos)
+	{
+		response.setHeader("Content-Length", ft::toString(length));
+		return new CgiGenerator(cgi, length);
+	}
+	response.setHeader("Transfer-Encoding", "chunked");
+	return new ChunkedGenerator(new CgiGenerator(cgi, length));
+}
 
-		close(pipefd[0]); // Close the read end of the pipe after reading
+// Reads a block of standard CGI headers ended by an empty line, as FastCGI
+// applications write, into headers. Returns the offset of the body, 0 if the
+// output starts with no such block, or npos if the block is not complete yet.
+static size_t parseHeaderBlock(
+	std::string const				   &output,
+	bool								isComplete,
+	std::map<std::string, std::string> &headers
+)
+{
+	std::map<std::string, std::string> block;
+	size_t							   lineStart(0);
+	while (true)
+	{
+		size_t lineEnd = output.find('\n', lineStart);
+		if (lineEnd == std::string::npos)
+			return isComplete ? 0 : std::string::npos;
+		std::string line = output.substr(lineStart, lineEnd - lineStart);
+		lineStart = lineEnd + 1;
+		if (!line.empty() && line[line.size() - 1] == '\r')
+			line.erase(line.size() - 1);
+		if (line.empty())
+			break;
+		size_t colonPos = line.find(':');
+		if (colonPos == std::string::npos || colonPos == 0)
+			return 0;
+		std::string value = line.substr(colonPos + 1);
+		block[line.substr(0, colonPos)] = ft::trim(value);
+	}
+	headers.insert(block.begin(), block.end());
+	return lineStart;
+}
 
-		// Check the first line of the output
-		std::string const				   expectedLine = "CGI_HEADERS";
-		std::string const				   expectedEndLine = "CGI_HEADERS_END";
-		std::string						   firstLine;
-		std::map<std::string, std::string> cgiHeaders;
-		std::getline(output, firstLine);
-		if (firstLine == expectedLine)
-		{
-			// Extract the response headers
-			std::string		  line;
-			std::stringstream bodyStream;
-			while (std::getline(output, line) && line != expectedEndLine)
-			{
-				unsigned int colonPos = line.find(':');
-				cgiHeaders[line.substr(0, colonPos)]
-					= line.substr(colonPos + 2);
-			}
-			// Copy the remaining lines to bodyStream
-			while (std::getline(output, line))
-				bodyStream << line << "\n";
-			// Swap bodyStream with output to retain only the body content
-			output.clear();
-			output << bodyStream;
-		}
+// Reads the block of headers at the start of the output of a script, between
+// a CGI_HEADERS and a CGI_HEADERS_END line, into headers. A block not ended
+// by the end of a complete output takes all of it. With isStandard, an output
+// without such a block may start with standard CGI headers instead. Returns
+// the offset of the body, or npos if the block is not complete yet.
+size_t HttpMethodHandler::parseCgiHeaders_(
+	std::string const				   &output,
+	bool								isComplete,
+	bool								isStandard,
+	std::map<std::string, std::string> &headers
+)
+{
+	std::string const expectedLine = "CGI_HEADERS\n";
+	std::string const expectedEndLine = "CGI_HEADERS_END";
+	if (output.compare(0, expectedLine.size(), expectedLine) != 0)
+	{
+		bool isPrefix = output.size() < expectedLine.size()
+						&& expectedLine.compare(0, output.size(), output) == 0;
+		if (isPrefix && !isComplete)
+			return std::string::npos;
+		return isStandard ? parseHeaderBlock(output, isComplete, headers) : 0;
+	}
+	// Extract the response headers
+	size_t bodyStart = expectedLine.size();
+	while (bodyStart < output.size())
+	{
+		size_t lineEnd = output.find('\n', bodyStart);
+		if (lineEnd == std::string::npos && !isComplete)
+			return std::string::npos;
+		if (lineEnd == std::string::npos)
+			lineEnd = output.size();
+		std::string line = output.substr(bodyStart, lineEnd - bodyStart);
+		bodyStart = std::min(lineEnd + 1, output.size());
+		if (ft::trim(line) == expectedEndLine)
+			return bodyStart;
+		size_t colonPos = line.find(':');
+		if (colonPos == std::string::npos)
+			continue;
+		std::string value = line.substr(colonPos + 1);
+		headers[line.substr(0, colonPos)] = ft::trim(value);
+	}
+	return isComplete ? bodyStart : std::string::npos;
+}
 
-		Logger::log(Logger::DEBUG)
-			<< "CGI Output: " << output.str() << std::endl;
+// Makes the head of the response of a script from its headers and the start
+// of its body, without a length.
+HttpResponse HttpMethodHandler::createCgiHead_(
+	std::map<std::string, std::string> &cgiHeaders,
+	std::string const				   &body,
+	bool const						   &keepAlive
+)
+{
+	Logger::log(Logger::DEBUG) << "CGI Output: " << body << std::endl;
 
-		HttpResponse response;
-		if (output.str().find("400") != std::string::npos)
-		{
-			response.setStatusCode(400);
-			response.setReasonPhrase("Bad Request");
-		}
-		else if (output.str().find("415") != std::string::npos)
-		{
-			response.setStatusCode(415);
-			response.setReasonPhrase("Unsupported Media Type");
-		}
-		else
-		{
-			response.setStatusCode(200);
-			response.setReasonPhrase("OK");
-		}
+	HttpResponse response;
+	if (body.find("400") != std::string::npos)
+	{
+		response.setStatusCode(400);
+		response.setReasonPhrase("Bad Request");
+	}
+	else if (body.find("415") != std::string::npos)
+	{
+		response.setStatusCode(415);
+		response.setReasonPhrase("Unsupported Media Type");
+	}
+	else
+	{
+		response.setStatusCode(200);
+		response.setReasonPhrase("OK");
+	}
 
-		if (!cgiHeaders.empty()
-			&& cgiHeaders.find("Status") != cgiHeaders.end())
+	if (!cgiHeaders.empty() && cgiHeaders.find("Status") != cgiHeaders.end())
+	{
+		// The code may be followed by a reason, as in "Status: 404 Not Found"
+		std::string statusLine = cgiHeaders["Status"];
+		statusLine = ft::trim(statusLine);
+		statusLine = statusLine.substr(0, statusLine.find(' '));
+		if (statusLine.size() == 3 && ft::isStrOfDigits(statusLine))
 		{
-			std::string statusLine = cgiHeaders["Status"];
-			statusLine = ft::trim(statusLine);
 			int statusCode = ft::strToUShort(statusLine);
 			response.setStatusCode(statusCode);
 			response.setReasonPhrase(ft::getStatusCodeReason(statusCode));
 		}
+		cgiHeaders.erase("Status");
+	}
 
-		response.setHeader("Server", SERVER_NAME);
-		response.setHeader("Date", ft::createTimestamp());
+	response.setHeader("Server", SERVER_NAME);
+	response.setHeader("Date", ft::createTimestamp());
+	if (cgiHeaders.find("Content-Type") == cgiHeaders.end())
 		response.setHeader("Content-Type", "text/html; charset=UTF-8");
-		response.setHeader("Content-Length", ft::toString(output.str().size()));
-		if (keepAlive)
-			response.setHeader("Connection", "keep-alive");
-		else
-			response.setHeader("Connection", "close");
+	cgiHeaders.erase("Content-Length");
+	if (keepAlive)
+		response.setHeader("Connection", "keep-alive");
+	else
+		response.setHeader("Connection", "close");
 
-		if (!cgiHeaders.empty())
+	if (!cgiHeaders.empty())
+	{
+		Logger::log(Logger::DEBUG) << "CGI Headers: " << std::endl;
+		for (std::map<std::string, std::string>::const_iterator it
+			 = cgiHeaders.begin();
+			 it != cgiHeaders.end();
+			 ++it)
 		{
-			Logger::log(Logger::DEBUG) << "CGI Headers: " << std::endl;
-			for (std::map<std::string, std::string>::const_iterator it
-				 = cgiHeaders.begin();
-				 it != cgiHeaders.end();
-				 ++it)
-			{
-				response.setHeader(it->first, it->second);
-				Logger::log(Logger::DEBUG)
-					<< it->first << ": " << it->second << std::endl;
-			}
+			response.setHeader(it->first, it->second);
+			Logger::log(Logger::DEBUG)
+				<< it->first << ": " << it->second << std::endl;
 		}
+	}
 
-		response.setBody(output.str());
+	Logger::log(Logger::DEBUG)
+		<< "Handling CGI: responding " << response.getStatusCode()
+		<< std::endl;
 
-		Logger::log(Logger::DEBUG) << "Handling CGI: responding:\n"
-								   << response.toString() << std::endl;
+	return response;
+}
 
-		return response.toString();
-	}
+// Makes a response of the whole output of a script, which may start with a
+// block of headers.
+HttpResponse HttpMethodHandler::parseCgiOutput_(
+	std::string const &output,
+	bool			   isStandard,
+	bool const		  &keepAlive
+)
+{
+	std::map<std::string, std::string> cgiHeaders;
+	size_t bodyStart = parseCgiHeaders_(output, true, isStandard, cgiHeaders);
+	std::string body = output.substr(bodyStart);
+
+	HttpResponse response = createCgiHead_(cgiHeaders, body, keepAlive);
+	response.setHeader("Content-Length", ft::toString(body.size()));
+	response.swapBody(body);
+	return response;
 }
 
 bool HttpMethodHandler::isDirectory_(std::string const &filepath)
 {
-	struct stat fileStat;
-	if (stat(filepath.c_str(), &fileStat) == 0)
-		return S_ISDIR(fileStat.st_mode);
-	return false;
+	OpenFileCache::Info info;
+	return openFileCache_.getInfo(filepath, info) && info.isDirectory;
+}
+
+// clang-format off
+bool HttpMethodHandler::isSendfileEnabled_(
+	const std::map<std::string, std::vector<std::string> > &location
+) // clang-format on
+{
+	return location.find("sendfile") == location.end()
+		   || location.at("sendfile").empty()
+		   || location.at("sendfile")[0] == "on";
+}
+
+// clang-format off
+bool HttpMethodHandler::isGzipStaticEnabled_(
+	const std::map<std::string, std::vector<std::string> > &location
+) // clang-format on
+{
+	return location.find("gzip_static") != location.end()
+		   && !location.at("gzip_static").empty()
+		   && location.at("gzip_static")[0] == "on";
+}
+
+// clang-format off
+bool HttpMethodHandler::isGzipEnabled_(
+	const std::map<std::string, std::vector<std::string> > &location
+) // clang-format on
+{
+	return location.find("gzip") != location.end()
+		   && !location.at("gzip").empty() && location.at("gzip")[0] == "on";
+}
+
+// The workers of the location, if its scripts are served by a pool.
+// clang-format off
+bool HttpMethodHandler::getCgiPoolLimits_(
+	const std::map<std::string, std::vector<std::string> > &location,
+	CgiPool::Limits										  &limits
+) // clang-format on
+{
+	// clang-format off
+	std::map<std::string, std::vector<std::string> >::const_iterator it
+		= location.find("cgi_pool"); // clang-format on
+	if (it == location.end() || it->second.size() != 3)
+		return false;
+	limits.minWorkers = ft::stringToULong(it->second[0]);
+	limits.maxWorkers = ft::stringToULong(it->second[1]);
+	limits.maxRequests = ft::stringToULong(it->second[2]);
+	limits.idleTimeout = CGI_POOL_IDLE_TIMEOUT;
+	return true;
+}
+
+// The compression level for a body of this type and length, or 0 if gzip
+// leaves it alone: text/html is always compressed, as with nginx.
+// clang-format off
+int HttpMethodHandler::getGzipLevel_(
+	const std::map<std::string, std::vector<std::string> > &location,
+	std::string const &mimeType,
+	off_t			   length
+) // clang-format on
+{
+	if (!isGzipEnabled_(location))
+		return 0;
+	// clang-format off
+	std::map<std::string, std::vector<std::string> >::const_iterator it
+		= location.find("gzip_min_length"); // clang-format on
+	if (it != location.end() && !it->second.empty()
+		&& length < static_cast<off_t>(ft::stringToULong(it->second[0])))
+		return 0;
+	std::string type = mimeType.substr(0, mimeType.find(';'));
+	ft::trim(type);
+	bool isListed = type == "text/html";
+	it = location.find("gzip_types");
+	for (size_t i = 0; it != location.end() && i < it->second.size(); ++i)
+		isListed = isListed || it->second[i] == "*"
+				   || strcasecmp(it->second[i].c_str(), type.c_str()) == 0;
+	if (!isListed)
+		return 0;
+	it = location.find("gzip_comp_level");
+	if (it == location.end() || it->second.empty())
+		return 1;
+	return std::atoi(it->second[0].c_str());
+}
+
+// Compresses a body in memory, such as a listing or the output of a CGI, for
+// the clients accepting gzip.
+// clang-format off
+void HttpMethodHandler::compressResponse_(
+	HttpRequest const &request,
+	std::map<std::string, std::vector<std::string> > const &location,
+	HttpResponse &response
+) // clang-format on
+{
+	if (response.getStatusCode() != 200
+		|| !response.getHeader("Content-Encoding").empty())
+		return;
+	int level = getGzipLevel_(
+		location, response.getHeader("Content-Type"), response.getBody().size()
+	);
+	if (level == 0)
+		return;
+	response.setHeader("Vary", "Accept-Encoding");
+	std::string body;
+	if (!acceptsGzip(request)
+		|| !GzipGenerator::compress(response.getBody(), level, body))
+		return;
+	response.removeHeader("Content-Length");
+	response.setHeader("Content-Length", ft::toString(body.size()));
+	response.swapBody(body);
+	response.setHeader("Content-Encoding", "gzip");
+}
+
+// clang-format off
+bool HttpMethodHandler::isCacheEnabled_(
+	const std::map<std::string, std::vector<std::string> > &location
+) // clang-format on
+{
+	return location.find("cache") == location.end()
+		   || location.at("cache").empty() || location.at("cache")[0] == "on";
 }
 
 // clang-format off
@@ -621,7 +1298,7 @@ bool HttpMethodHandler::isAutoIndexEnabled_(
 		   && location.at("autoindex")[0] == "on";
 }
 
-std::string HttpMethodHandler::handleAutoIndex_(
+HttpResponse HttpMethodHandler::handleAutoIndex_(
 	std::string const &root,
 	std::string const &uri,
 	Server const	  &server,
@@ -631,7 +1308,9 @@ std::string HttpMethodHandler::handleAutoIndex_(
 	Logger::log(Logger::DEBUG)
 		<< "Handling auto index on: " << root << uri << std::endl;
 
-	std::string body = generateAutoIndexPage_(root, uri, server, keepAlive);
+	std::string body = generateAutoIndexPage_(root, uri);
+	if (body.empty())
+		return handleErrorResponse_(server, 405, root, keepAlive);
 
 	HttpResponse response;
 	response.setStatusCode(200);
@@ -644,15 +1323,14 @@ std::string HttpMethodHandler::handleAutoIndex_(
 		response.setHeader("Connection", "keep-alive");
 	else
 		response.setHeader("Connection", "close");
-	response.setBody(body);
-	return response.toString();
+	response.swapBody(body);
+	return response;
 }
 
+// Lists the directory, or returns an empty page if it cannot be opened.
 std::string HttpMethodHandler::generateAutoIndexPage_(
 	std::string const &root,
-	std::string const &uri,
-	Server const	  &server,
-	bool const		  &keepAlive
+	std::string const &uri
 )
 {
 	std::stringstream html;
@@ -669,7 +1347,7 @@ std::string HttpMethodHandler::generateAutoIndexPage_(
 	{
 		Logger::log(Logger::ERROR)
 			<< "Failed to open directory: " << root + uri << std::endl;
-		return handleErrorResponse_(server, 405, root, keepAlive);
+		return "";
 	}
 
 	struct dirent *entry;
@@ -718,14 +1396,13 @@ std::string HttpMethodHandler::findIndexFile_(
 			  ? location.at("index")
 			  : server.getIndex();
 
-	struct stat fileStat;
+	OpenFileCache::Info info;
 	for (std::vector<std::string>::const_iterator it = indexFiles.begin();
 		 it != indexFiles.end();
 		 ++it)
 	{
 		std::string indexFilePath = filepath + "/" + *it;
-		if (stat(indexFilePath.c_str(), &fileStat) == 0
-			&& S_ISREG(fileStat.st_mode))
+		if (openFileCache_.getInfo(indexFilePath, info) && !info.isDirectory)
 		{
 			return indexFilePath;
 		}
@@ -733,54 +1410,293 @@ std::string HttpMethodHandler::findIndexFile_(
 	return "";
 }
 
-std::string HttpMethodHandler::createFileGetResponse_(
+// The body is the open file, sent from the event loop: the file is never
+// read into memory here, unless the response is cached under cacheKey. A
+// conditional request is answered from the metadata first, and the file is
+// not opened for a 304.
+//
+// With gzip_static, the file.gz sibling built ahead of time is sent instead
+// to the clients accepting gzip, as is. Without one, gzip compresses the
+// file for them, but for a range request, which is served from the file.
+// clang-format off
+HttpResponse HttpMethodHandler::createFileGetResponse_(
+	HttpRequest const &request,
 	std::string const &filepath,
 	std::string const &rootdir,
 	Server const	  &server,
-	bool const		  &keepAlive
+	std::map<std::string, std::vector<std::string> > const &location,
+	std::string const &cacheKey
+) // clang-format on
+{
+	HttpResponse		response;
+	OpenFileCache::Info info;
+	bool				keepAlive = request.getKeepAlive();
+	bool				useSendfile = isSendfileEnabled_(location);
+	std::string			servedPath(filepath);
+	bool				hasVariants(false);
+	int					gzipLevel(0);
+
+	if (isGzipStaticEnabled_(location)
+		&& openFileCache_.getInfo(filepath + ".gz", info) && !info.isDirectory)
+	{
+		hasVariants = true;
+		if (acceptsGzip(request))
+			servedPath += ".gz";
+	}
+	else if (isGzipEnabled_(location) && openFileCache_.getInfo(filepath, info)
+			 && !info.isDirectory)
+	{
+		gzipLevel = getGzipLevel_(location, info.mimeType, info.size);
+		hasVariants = gzipLevel > 0;
+		if (!acceptsGzip(request) || findHeader(request, "Range") != NULL)
+			gzipLevel = 0;
+	}
+	if (isConditional(request) && openFileCache_.getInfo(servedPath, info)
+		&& !info.isDirectory
+		&& isNotModified(request, createETag(info), info.mtime))
+		return createNotModifiedResponse_(
+			(gzipLevel > 0 ? "W/" : "") + createETag(info),
+			info,
+			keepAlive,
+			hasVariants
+		);
+
+	int fd = openFileCache_.open(servedPath, info);
+
+	if (fd == -1)
+	{
+		Logger::log(Logger::DEBUG)
+			<< "Handling GET: file not found" << std::endl;
+		return handleErrorResponse_(server, 404, rootdir, keepAlive);
+	}
+	Logger::log(Logger::DEBUG) << "Handling GET: file opened" << std::endl;
+
+	std::string etag = createETag(info);
+	if (gzipLevel > 0)
+		return createGzipResponse_(fd, info, etag, gzipLevel, keepAlive);
+	std::vector<ByteRange> ranges;
+	int					   rangeStatus = getRanges(request, info, etag, ranges);
+	bool isGzip = servedPath != filepath;
+	if (isGzip)
+		info.mimeType = ft::getMimeType(filepath);
+	if (rangeStatus == 206)
+		return createRangeResponse_(
+			fd, info, ranges, keepAlive, useSendfile, isGzip
+		);
+	if (rangeStatus == 416)
+	{
+		close(fd);
+		response = handleErrorResponse_(server, 416, rootdir, keepAlive);
+		response.setHeader(
+			"Content-Range", "bytes */" + ft::toString(info.size)
+		);
+		return response;
+	}
+
+	response.setStatusCode(200);
+	response.setReasonPhrase("OK");
+	response.setHeader("Server", SERVER_NAME);
+	response.setHeader("Content-Type", info.mimeType);
+	response.setHeader("Content-Length", ft::toString(info.size));
+	response.setHeader("ETag", etag);
+	response.setHeader("Last-Modified", ft::formatHttpDate(info.mtime));
+	response.setHeader("Accept-Ranges", "bytes");
+	if (isGzip)
+		response.setHeader("Content-Encoding", "gzip");
+	if (hasVariants)
+		response.setHeader("Vary", "Accept-Encoding");
+	if (!cacheKey.empty() && responseCache_.isCacheable(info.size))
+	{
+		std::string body(info.size, '\0');
+		if (readFile(fd, body))
+		{
+			responseCache_.insert(cacheKey, servedPath, fd, response, body);
+			response.swapBody(body);
+			close(fd);
+			fd = -1;
+		}
+	}
+	// Left out of the cached head, which gets them on every hit
+	response.setHeader("Date", ft::createTimestamp());
+	if (keepAlive)
+		response.setHeader("Connection", "keep-alive");
+	else
+		response.setHeader("Connection", "close");
+	if (fd != -1)
+		response.setBodyFile(fd, 0, info.size, useSendfile);
+
+	Logger::log(Logger::DEBUG) << "Handling GET: responding" << std::endl;
+	return response;
+}
+
+// A single range is the body itself. Several ranges make a multipart body,
+// each range after its own part head; the ranges are still sent from the
+// file.
+HttpResponse HttpMethodHandler::createRangeResponse_(
+	int							  fd,
+	OpenFileCache::Info const	 &info,
+	std::vector<ByteRange> const &ranges,
+	bool const					 &keepAlive,
+	bool const					 &useSendfile,
+	bool const					 &isGzip
 )
 {
-	HttpResponse  response;
-	std::ifstream file(filepath.c_str());
+	HttpResponse response;
+	std::string	 size = ft::toString(info.size);
 
-	if (file.is_open())
+	Logger::log(Logger::DEBUG) << "Handling GET: responding " << ranges.size()
+							   << " ranges" << std::endl;
+	response.setStatusCode(206);
+	response.setReasonPhrase(ft::getStatusCodeReason(206));
+	response.setHeader("Server", SERVER_NAME);
+	response.setHeader("Date", ft::createTimestamp());
+	response.setHeader("ETag", createETag(info));
+	response.setHeader("Last-Modified", ft::formatHttpDate(info.mtime));
+	if (isGzip)
 	{
-		Logger::log(Logger::DEBUG) << "Handling GET: file opened" << std::endl;
+		response.setHeader("Content-Encoding", "gzip");
+		response.setHeader("Vary", "Accept-Encoding");
+	}
+	if (ranges.size() == 1)
+	{
+		off_t length = ranges[0].second - ranges[0].first + 1;
+		response.setHeader("Content-Type", info.mimeType);
+		response.setHeader("Content-Length", ft::toString(length));
+		response.setHeader(
+			"Content-Range",
+			"bytes " + ft::toString(ranges[0].first) + "-"
+				+ ft::toString(ranges[0].second) + "/" + size
+		);
+		response.setBodyFile(fd, ranges[0].first, length, useSendfile);
+	}
+	else
+	{
+		std::string boundary = createBoundary();
+		std::vector<std::string> heads(ranges.size());
+		off_t					 length(0);
+		for (size_t i = 0; i < ranges.size(); ++i)
+		{
+			heads[i] = "\r\n--" + boundary + "\r\nContent-Type: "
+					   + info.mimeType + "\r\nContent-Range: bytes "
+					   + ft::toString(ranges[i].first) + "-"
+					   + ft::toString(ranges[i].second) + "/" + size
+					   + "\r\n\r\n";
+			length += heads[i].size() + ranges[i].second - ranges[i].first + 1;
+		}
+		std::string closing = "\r\n--" + boundary + "--\r\n";
+		length += closing.size();
+		response.setHeader(
+			"Content-Type", "multipart/byteranges; boundary=" + boundary
+		);
+		response.setHeader("Content-Length", ft::toString(length));
+		response.setBodyFile(fd, 0, 0, useSendfile);
+		for (size_t i = 0; i < ranges.size(); ++i)
+			response.addBodyPart(
+				heads[i],
+				ranges[i].first,
+				ranges[i].second - ranges[i].first + 1
+			);
+		response.addBodyPart(closing, 0, 0);
+	}
+	if (keepAlive)
+		response.setHeader("Connection", "keep-alive");
+	else
+		response.setHeader("Connection", "close");
+	return response;
+}
 
-		std::stringstream buffer;
-		buffer << file.rdbuf();
-		std::string body = buffer.str();
+// The compressed file is another representation, whose ETag is weak. A small
+// file is compressed once, into the gzip cache; a larger one is compressed as
+// it is sent, in chunks.
+HttpResponse HttpMethodHandler::createGzipResponse_(
+	int						   fd,
+	OpenFileCache::Info const &info,
+	std::string const		  &etag,
+	int						   level,
+	bool const				  &keepAlive
+)
+{
+	HttpResponse response;
+	std::string	 body;
+	bool		 isCompressed(false);
 
-		response.setStatusCode(200);
-		response.setReasonPhrase("OK");
-		response.setHeader("Server", SERVER_NAME);
-		response.setHeader("Date", ft::createTimestamp());
-		response.setHeader("Content-Type", ft::getMimeType(filepath));
+	if (gzipCache_.isEnabled() && gzipCache_.isCacheable(info.size))
+	{
+		isCompressed = gzipCache_.find(etag, body);
+		if (!isCompressed)
+		{
+			std::string data(info.size, '\0');
+			isCompressed = readFile(fd, data)
+						   && GzipGenerator::compress(data, level, body);
+			if (isCompressed)
+				gzipCache_.insert(etag, body);
+		}
+	}
+	Logger::log(Logger::DEBUG) << "Handling GET: responding compressed"
+							   << std::endl;
+	response.setStatusCode(200);
+	response.setReasonPhrase("OK");
+	response.setHeader("Server", SERVER_NAME);
+	response.setHeader("Date", ft::createTimestamp());
+	response.setHeader("Content-Type", info.mimeType);
+	if (isCompressed)
 		response.setHeader("Content-Length", ft::toString(body.size()));
-		if (keepAlive)
-			response.setHeader("Connection", "keep-alive");
-		else
-			response.setHeader("Connection", "close");
-		response.setBody(body);
+	else
+		response.setHeader("Transfer-Encoding", "chunked");
+	response.setHeader("Content-Encoding", "gzip");
+	response.setHeader("Vary", "Accept-Encoding");
+	response.setHeader("ETag", "W/" + etag);
+	response.setHeader("Last-Modified", ft::formatHttpDate(info.mtime));
+	if (keepAlive)
+		response.setHeader("Connection", "keep-alive");
+	else
+		response.setHeader("Connection", "close");
+	if (isCompressed)
+	{
+		close(fd);
+		response.swapBody(body);
 	}
 	else
 	{
-		Logger::log(Logger::DEBUG)
-			<< "Handling GET: file not found" << std::endl;
-		return handleErrorResponse_(server, 404, rootdir, keepAlive);
+		response.setBodyFile(fd, 0, info.size, false);
+		response.compressBodyFile(level);
 	}
+	return response;
+}
 
-	Logger::log(Logger::DEBUG) << "Handling GET: responding" << std::endl;
-	return response.toString();
+HttpResponse HttpMethodHandler::createNotModifiedResponse_(
+	std::string const		  &etag,
+	OpenFileCache::Info const &info,
+	bool const				  &keepAlive,
+	bool const				  &hasVariants
+)
+{
+	HttpResponse response;
+
+	Logger::log(Logger::DEBUG)
+		<< "Handling GET: responding not modified" << std::endl;
+	response.setStatusCode(304);
+	response.setReasonPhrase(ft::getStatusCodeReason(304));
+	response.setHeader("Server", SERVER_NAME);
+	response.setHeader("Date", ft::createTimestamp());
+	response.setHeader("ETag", etag);
+	response.setHeader("Last-Modified", ft::formatHttpDate(info.mtime));
+	if (hasVariants)
+		response.setHeader("Vary", "Accept-Encoding");
+	if (keepAlive)
+		response.setHeader("Connection", "keep-alive");
+	else
+		response.setHeader("Connection", "close");
+	return response;
 }
 
-std::string HttpMethodHandler::createFilePostResponse_(
+HttpResponse HttpMethodHandler::createFilePostResponse_(
 	HttpRequest const &request,
 	const std::string &rootdir,
-	std::string const &redirect,
-	std::string const &uploadpath,
-	Server const	  &server,
-	bool const		  &keepAlive
+	HttpResponse const *redirect,
+	std::string const  &uploadpath,
+	Server const	   &server,
+	bool const		   &keepAlive
 )
 {
 	HttpResponse response;
@@ -801,8 +1717,8 @@ std::string HttpMethodHandler::createFilePostResponse_(
 		return handleErrorResponse_(server, 500, rootdir, keepAlive);
 	}
 
-	if (!redirect.empty())
-		return redirect;
+	if (redirect != NULL)
+		return *redirect;
 
 	// Write the request body to the file
 	const std::vector<char> &requestBody = request.getBody();
@@ -816,6 +1732,8 @@ std::string HttpMethodHandler::createFilePostResponse_(
 	}
 
 	outFile.close();
+	openFileCache_.invalidate(uploadpathtmp);
+	responseCache_.invalidate(uploadpathtmp);
 
 	// Generate a success response
 	response.setStatusCode(200);
@@ -829,19 +1747,19 @@ std::string HttpMethodHandler::createFilePostResponse_(
 		response.setHeader("Connection", "keep-alive");
 	else
 		response.setHeader("Connection", "close");
-	response.setBody(responseBody);
+	response.swapBody(responseBody);
 
 	Logger::log(Logger::DEBUG) << "Handling POST: responding" << std::endl;
-	return response.toString();
+	return response;
 }
 
-std::string HttpMethodHandler::createDeleteResponse_(
+HttpResponse HttpMethodHandler::createDeleteResponse_(
 	HttpRequest const &request,
 	const std::string &filepath,
 	const std::string &rootdir,
-	std::string const &redirect,
-	const Server	  &server,
-	bool			   keepAlive
+	HttpResponse const *redirect,
+	const Server	   &server,
+	bool				keepAlive
 )
 {
 	std::string	 body;
@@ -858,9 +1776,11 @@ std::string HttpMethodHandler::createDeleteResponse_(
 
 	if (std::remove(deletePath.c_str()) == 0)
 	{
+		openFileCache_.invalidate(deletePath);
+		responseCache_.invalidate(deletePath);
 		// Check for redirections
-		if (!redirect.empty())
-			return redirect;
+		if (redirect != NULL)
+			return *redirect;
 
 		response.setStatusCode(200);
 		response.setReasonPhrase("OK");
@@ -890,8 +1810,8 @@ std::string HttpMethodHandler::createDeleteResponse_(
 		response.setHeader("Connection", "keep-alive");
 	else
 		response.setHeader("Connection", "close");
-	response.setBody(body);
+	response.swapBody(body);
 
 	Logger::log(Logger::DEBUG) << "Handling DELETE: responding" << std::endl;
-	return response.toString();
+	return response;
 }
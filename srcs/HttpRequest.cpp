@@ -87,6 +87,11 @@ void HttpRequest::setBody(std::vector<char> &newBody)
 	body_ = newBody;
 }
 
+void HttpRequest::swapBody(std::vector<char> &newBody)
+{
+	body_.swap(newBody);
+}
+
 const std::string &HttpRequest::getMethod(void) const
 {
 	return method_;
@@ -1,21 +1,143 @@
 #include "../include/HttpResponse.hpp"
+#include "BodyGenerators.hpp"
 #include "utils.hpp"
 
+#include <fcntl.h>
+#include <unistd.h>
+
 // Might have to change default values
-HttpResponse::HttpResponse() : statusCode_(200), reasonPhrase_("OK") {}
+HttpResponse::HttpResponse()
+	: statusCode_(200), reasonPhrase_("OK"), bodyFd_(-1), bodyOffset_(0),
+	  bodyLength_(0), useSendfile_(false), gzipLevel_(0)
+{
+}
+
+HttpResponse::HttpResponse(HttpResponse const &src) : bodyFd_(-1)
+{
+	*this = src;
+}
+
+// A copy owns a duplicate of the body file, closed on its own.
+HttpResponse &HttpResponse::operator=(HttpResponse const &rhs)
+{
+	if (this != &rhs)
+	{
+		closeBodyFile_();
+		statusCode_ = rhs.statusCode_;
+		reasonPhrase_ = rhs.reasonPhrase_;
+		headers_ = rhs.headers_;
+		renderedHead_ = rhs.renderedHead_;
+		body_ = rhs.body_;
+		if (rhs.bodyFd_ != -1)
+			bodyFd_ = fcntl(rhs.bodyFd_, F_DUPFD_CLOEXEC, 0);
+		bodyOffset_ = rhs.bodyOffset_;
+		bodyLength_ = rhs.bodyLength_;
+		useSendfile_ = rhs.useSendfile_;
+		gzipLevel_ = rhs.gzipLevel_;
+		parts_ = rhs.parts_;
+	}
+	return *this;
+}
 
 void HttpResponse::setBody(const std::string &body)
 {
 	body_ = body;
 }
 
-HttpResponse::~HttpResponse() {}
+void HttpResponse::swapBody(std::string &body)
+{
+	body_.swap(body);
+}
+
+/**
+ * @brief Makes a range of an open file the body of the response.
+ *
+ * @param fd The file descriptor, owned by the response from now on.
+ * @param offset The offset of the range in the file.
+ * @param length The length of the range.
+ * @param useSendfile Whether to send the range with sendfile(2).
+ */
+void HttpResponse::setBodyFile(
+	int	   fd,
+	off_t  offset,
+	size_t length,
+	bool   useSendfile
+)
+{
+	closeBodyFile_();
+	body_.clear();
+	parts_.clear();
+	bodyFd_ = fd;
+	bodyOffset_ = offset;
+	bodyLength_ = length;
+	useSendfile_ = useSendfile;
+	gzipLevel_ = 0;
+}
+
+/**
+ * @brief Adds a part to a body made of ranges of the body file.
+ *
+ * The body file is set first, with setBodyFile(). Its own range is then
+ * ignored: the body is the parts, in order.
+ *
+ * @param data The bytes sent before the range, moved into the response: it
+ * is left empty.
+ * @param offset The offset of the range in the body file.
+ * @param length The length of the range, 0 for the data alone.
+ */
+void HttpResponse::addBodyPart(std::string &data, off_t offset, size_t length)
+{
+	parts_.push_back(BodyPart());
+	parts_.back().data.swap(data);
+	parts_.back().offset = offset;
+	parts_.back().length = length;
+}
+
+/**
+ * @brief Sends the body file compressed with gzip, in chunks.
+ *
+ * The body file is set first, with setBodyFile(). The file is compressed as
+ * it is written, one piece at a time, so the headers should announce the
+ * chunked transfer coding rather than a length.
+ *
+ * @param level The compression level, from 1 to 9.
+ */
+void HttpResponse::compressBodyFile(int level)
+{
+	gzipLevel_ = level;
+}
+
+/**
+ * @brief Sets the whole head, already rendered, in place of the headers.
+ *
+ * @param head The status line, the headers and the blank line, moved into
+ * the response: it is left empty.
+ */
+void HttpResponse::setRenderedHead(std::string &head)
+{
+	renderedHead_.swap(head);
+}
+
+HttpResponse::~HttpResponse()
+{
+	closeBodyFile_();
+}
 
 void HttpResponse::setStatusCode(int code)
 {
 	statusCode_ = code;
 }
 
+int HttpResponse::getStatusCode() const
+{
+	return statusCode_;
+}
+
+std::string &HttpResponse::getBody()
+{
+	return body_;
+}
+
 void HttpResponse::setReasonPhrase(const std::string &phrase)
 {
 	reasonPhrase_ = phrase;
@@ -29,30 +151,151 @@ void HttpResponse::setHeader(const std::string &key, const std::string &value)
 	// headers_[key] = value;
 }
 
-std::string HttpResponse::toString() const
+void HttpResponse::removeHeader(std::string const &key)
 {
-	std::string response;
+	std::vector<std::pair<std::string, std::string> >::iterator it
+		= headers_.begin();
+	while (it != headers_.end())
+	{
+		if (it->first == key)
+			it = headers_.erase(it);
+		else
+			++it;
+	}
+}
 
-	// Start line
-	response += "HTTP/1.1 " + ft::toString(statusCode_) + " " + reasonPhrase_
-				+ "\r\n";
+/**
+ * @brief Renders the status line, the headers and the blank line.
+ *
+ * The length of the head is counted first, so the buffer is allocated once.
+ *
+ * @param head Set to the head of the response.
+ */
+void HttpResponse::renderHead(std::string &head) const
+{
+	if (!renderedHead_.empty())
+	{
+		head = renderedHead_;
+		return;
+	}
+	std::string code = ft::toString(statusCode_);
+	size_t		length = 9 + code.size() + 1 + reasonPhrase_.size() + 2 + 2;
 
-	// Headers
 	std::vector<std::pair<std::string, std::string> >::const_iterator it;
+	for (it = headers_.begin(); it != headers_.end(); ++it)
+		length += it->first.size() + 2 + it->second.size() + 2;
+
+	head.clear();
+	head.reserve(length);
+	head.append("HTTP/1.1 ", 9).append(code).append(1, ' ');
+	head.append(reasonPhrase_).append("\r\n", 2);
 	for (it = headers_.begin(); it != headers_.end(); ++it)
 	{
-		response += it->first + ": " + it->second + "\r\n";
+		head.append(it->first).append(": ", 2);
+		head.append(it->second).append("\r\n", 2);
 	}
+	head.append("\r\n", 2);
+}
 
-	// Blank line
-	response += "\r\n";
+/**
+ * @brief Queues the head and the body of the response as separate segments.
+ *
+ * The body is moved to the queue, the response is left without one.
+ *
+ * @param output The output queue of the connection.
+ */
+void HttpResponse::moveTo(OutputQueue &output)
+{
+	std::string head;
+	if (renderedHead_.empty())
+		renderHead(head);
+	else
+		head.swap(renderedHead_);
+	output.push(head);
+	if (bodyFd_ != -1 && !parts_.empty())
+	{
+		// Every range is queued with its own descriptor
+		for (size_t i = 0; i < parts_.size(); ++i)
+		{
+			output.push(parts_[i].data);
+			if (parts_[i].length > 0)
+				output.pushFile(
+					fcntl(bodyFd_, F_DUPFD_CLOEXEC, 0),
+					parts_[i].offset,
+					parts_[i].length,
+					useSendfile_
+				);
+		}
+		parts_.clear();
+		closeBodyFile_();
+	}
+	else if (bodyFd_ != -1 && gzipLevel_ > 0)
+	{
+		output.pushGenerator(createBodyGenerator_(bodyFd_));
+		bodyFd_ = -1;
+	}
+	else if (bodyFd_ != -1)
+	{
+		output.pushFile(bodyFd_, bodyOffset_, bodyLength_, useSendfile_);
+		bodyFd_ = -1;
+	}
+	else
+		output.push(body_);
+}
 
-	// Body
-	response += body_;
+// The head and the body joined, for the logs and the tests. The server sends
+// them as separate segments instead.
+std::string HttpResponse::toString() const
+{
+	std::string response;
 
+	renderHead(response);
+	if (bodyFd_ == -1)
+		return response + body_;
+	if (gzipLevel_ > 0)
+	{
+		BodyGenerator *generator
+			= createBodyGenerator_(fcntl(bodyFd_, F_DUPFD_CLOEXEC, 0));
+		while (generator->generate(response, 65536) > 0)
+			;
+		delete generator;
+		return response;
+	}
+	if (parts_.empty())
+		return response + readBodyFile_(bodyOffset_, bodyLength_);
+	for (size_t i = 0; i < parts_.size(); ++i)
+	{
+		response += parts_[i].data;
+		response += readBodyFile_(parts_[i].offset, parts_[i].length);
+	}
 	return response;
 }
 
+std::string HttpResponse::readBodyFile_(off_t offset, size_t length) const
+{
+	if (length == 0)
+		return "";
+	std::string body(length, '\0');
+	ssize_t		bytesRead = pread(bodyFd_, &body[0], length, offset);
+	body.resize(bytesRead > 0 ? bytesRead : 0);
+	return body;
+}
+
+// The chunks of the body file compressed with gzip, read from fd.
+BodyGenerator *HttpResponse::createBodyGenerator_(int fd) const
+{
+	return new ChunkedGenerator(new GzipGenerator(
+		new FileGenerator(fd, bodyOffset_, bodyLength_), gzipLevel_
+	));
+}
+
+void HttpResponse::closeBodyFile_()
+{
+	if (bodyFd_ != -1)
+		close(bodyFd_);
+	bodyFd_ = -1;
+}
+
 std::string const &HttpResponse::getHeader(std::string const &key) const
 {
 	std::vector<std::pair<std::string, std::string> >::const_iterator it;
@@ -61,5 +304,6 @@ std::string const &HttpResponse::getHeader(std::string const &key) const
 		if (it->first == key)
 			return it->second;
 	}
-	return headers_.end()->second;
+	static std::string const none;
+	return none;
 }
@@ -0,0 +1,286 @@
+#include "MasterProcess.hpp"
+#include "Logger.hpp"
+#include "ReactorPool.hpp"
+#include "ServerEngine.hpp"
+#include "ServerException.hpp"
+#include "utils.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+static unsigned long long nowMs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<unsigned long long>(ts.tv_sec) * 1000
+		   + ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Constructor for MasterProcess.
+ *
+ * @param servers The parsed server configurations, shared with the workers.
+ * @param backend The event backend used by the workers.
+ * @param workerCount The number of worker processes to keep running.
+ * @param threadCount The number of reactor threads of each worker.
+ */
+MasterProcess::MasterProcess(
+	// clang-format off
+	std::vector<std::map<std::string, ConfigValue> > const &servers,
+	// clang-format on
+	EventPoller::Backend backend,
+	unsigned int		 workerCount,
+	unsigned int		 threadCount
+)
+	: servers_(servers), backend_(backend), threadCount_(threadCount),
+	  aliveWorkers_(0), pendingWorkers_(0)
+{
+	Worker worker;
+	worker.pid = -1;
+	worker.startedAt = 0;
+	worker.respawnAt = 0;
+	worker.crashes = 0;
+	workers_.assign(workerCount > 0 ? workerCount : 1, worker);
+}
+
+MasterProcess::~MasterProcess(void) {}
+
+/**
+ * @brief Starts the workers and supervises them until shutdown.
+ */
+void MasterProcess::run(void)
+{
+	Logger::log(Logger::INFO) << "Master process " << getpid() << " starting "
+							  << workers_.size() << " workers" << std::endl;
+	for (size_t slot = 0; slot < workers_.size(); ++slot)
+	{
+		if (!spawnWorker_(slot))
+		{
+			stopWorkers_();
+			throw ServerException(
+				"Failed to fork the worker[%]", errno, ft::toString(slot)
+			);
+		}
+	}
+	superviseWorkers_();
+	stopWorkers_();
+	Logger::log(Logger::INFO) << "Master process exiting" << std::endl;
+}
+
+/**
+ * @brief Forks a worker process in a slot.
+ *
+ * @param slot The index of the worker.
+ * @return true if the worker was forked, false otherwise.
+ */
+bool MasterProcess::spawnWorker_(size_t slot)
+{
+	// Flush the pending logs, otherwise the worker would print them again
+	std::cout.flush();
+	std::cerr.flush();
+	pid_t pid = fork();
+	if (pid == -1)
+	{
+		Logger::log(Logger::ERROR)
+			<< "Failed to fork the worker[" << slot << "]: ("
+			<< ft::toString(errno) << ") " << strerror(errno) << std::endl;
+		return false;
+	}
+	if (pid == 0)
+		runWorker_(slot);
+	workers_[slot].pid = pid;
+	workers_[slot].startedAt = nowMs();
+	++aliveWorkers_;
+	Logger::log(Logger::DEBUG)
+		<< "Worker[" << slot << "] started with pid " << pid << std::endl;
+	return true;
+}
+
+/**
+ * @brief Body of a worker process, it never returns.
+ *
+ * @param slot The index of the worker.
+ */
+void MasterProcess::runWorker_(size_t slot)
+{
+	int exitCode(EXIT_SUCCESS);
+	try
+	{
+		ReactorPool reactors(servers_, backend_, threadCount_);
+		try
+		{
+			reactors.run();
+		}
+		catch (std::exception &e)
+		{
+			Logger::log(Logger::ERROR)
+				<< "Worker[" << slot << "]: " << e.what() << std::endl;
+			exitCode = getExitCode(reactors.hasFailedToStart());
+		}
+	}
+	catch (std::exception &e)
+	{
+		Logger::log(Logger::ERROR)
+			<< "Worker[" << slot << "]: " << e.what() << std::endl;
+		exitCode = getExitCode(true);
+	}
+	std::exit(exitCode);
+}
+
+/**
+ * @brief Maps the failure of a worker to its exit status.
+ *
+ * @param isInitFailure Whether the worker failed before its event loops ran,
+ * setting up its reactors or binding its listeners, which would fail again.
+ * @return WORKER_INIT_FAILURE_, never respawned, or else EXIT_FAILURE,
+ * respawned after a backoff.
+ */
+int MasterProcess::getExitCode(bool isInitFailure)
+{
+	return isInitFailure ? WORKER_INIT_FAILURE_ : EXIT_FAILURE;
+}
+
+/**
+ * @brief Waits for the workers and respawns the ones that died.
+ *
+ * The wait is polled, so a SIGINT/SIGTERM received by the master is noticed
+ * even though the signal handlers restart interrupted system calls, and so
+ * are the delayed respawns.
+ */
+void MasterProcess::superviseWorkers_(void)
+{
+	while (!g_shutdown && (aliveWorkers_ > 0 || pendingWorkers_ > 0))
+	{
+		respawnWorkers_();
+		int	  status;
+		pid_t pid = aliveWorkers_ > 0 ? waitpid(-1, &status, WNOHANG) : 0;
+		if (pid > 0)
+			reapWorker_(pid, status);
+		else if (pid == 0)
+			usleep(SUPERVISE_INTERVAL_US_);
+		else if (errno != EINTR)
+		{
+			Logger::log(Logger::ERROR)
+				<< "Master failed to wait for the workers: ("
+				<< ft::toString(errno) << ") " << strerror(errno) << std::endl;
+			break;
+		}
+	}
+	if (g_shutdown)
+		Logger::log(Logger::INFO)
+			<< "Signal " << g_shutdown << " received, stopping the workers"
+			<< std::endl;
+	else if (aliveWorkers_ == 0)
+		Logger::log(Logger::ERROR)
+			<< "All workers failed, stopping the master" << std::endl;
+}
+
+/**
+ * @brief Handles the exit of a worker, scheduling its respawn if it crashed.
+ *
+ * @param pid The pid of the exited worker.
+ * @param status The wait status of the worker.
+ */
+void MasterProcess::reapWorker_(pid_t pid, int status)
+{
+	long slot = findWorker_(pid);
+	if (slot == -1)
+		return;
+	Worker &worker = workers_[slot];
+	worker.pid = -1;
+	--aliveWorkers_;
+
+	if (WIFEXITED(status) && WEXITSTATUS(status) == WORKER_INIT_FAILURE_)
+	{
+		Logger::log(Logger::ERROR)
+			<< "Worker[" << slot << "] failed to initialize, not respawning"
+			<< std::endl;
+		return;
+	}
+	unsigned long long now = nowMs();
+	if (now - worker.startedAt >= WORKER_STABLE_MS_)
+		worker.crashes = 0;
+	++worker.crashes;
+	std::string reason
+		= WIFSIGNALED(status)
+			  ? "killed by signal " + ft::toString(WTERMSIG(status))
+			  : "exited with status " + ft::toString(WEXITSTATUS(status));
+	if (worker.crashes > WORKER_CRASH_LIMIT_)
+	{
+		Logger::log(Logger::ERROR)
+			<< "Worker[" << slot << "] (pid " << pid << ") " << reason
+			<< ", crashed " << worker.crashes
+			<< " times in a row, not respawning" << std::endl;
+		return;
+	}
+	unsigned long delay
+		= worker.crashes == 1 ? 0 : RESPAWN_DELAY_MS_ << (worker.crashes - 2);
+	worker.respawnAt = now + delay;
+	++pendingWorkers_;
+	Logger::log(WIFSIGNALED(status) ? Logger::ERROR : Logger::INFO)
+		<< "Worker[" << slot << "] (pid " << pid << ") " << reason
+		<< ", respawning in " << delay << " ms" << std::endl;
+}
+
+/**
+ * @brief Forks the workers whose respawn delay has passed.
+ */
+void MasterProcess::respawnWorkers_(void)
+{
+	if (pendingWorkers_ == 0)
+		return;
+	unsigned long long now = nowMs();
+	for (size_t slot = 0; slot < workers_.size(); ++slot)
+	{
+		if (workers_[slot].respawnAt == 0 || workers_[slot].respawnAt > now)
+			continue;
+		workers_[slot].respawnAt = 0;
+		--pendingWorkers_;
+		spawnWorker_(slot);
+	}
+}
+
+/**
+ * @brief Asks the running workers to shut down and waits for them.
+ */
+void MasterProcess::stopWorkers_(void)
+{
+	for (size_t slot = 0; slot < workers_.size(); ++slot)
+	{
+		if (workers_[slot].pid > 0)
+			kill(workers_[slot].pid, SIGTERM);
+	}
+	for (size_t slot = 0; slot < workers_.size(); ++slot)
+	{
+		if (workers_[slot].pid <= 0)
+			continue;
+		while (waitpid(workers_[slot].pid, NULL, 0) == -1 && errno == EINTR)
+			;
+		Logger::log(Logger::DEBUG)
+			<< "Worker[" << slot << "] stopped" << std::endl;
+		workers_[slot].pid = -1;
+		--aliveWorkers_;
+	}
+}
+
+/**
+ * @brief Finds the slot of a worker.
+ *
+ * @param pid The pid of the worker.
+ * @return The slot of the worker, or -1 if the pid is not a worker.
+ */
+long MasterProcess::findWorker_(pid_t pid) const
+{
+	for (size_t slot = 0; slot < workers_.size(); ++slot)
+	{
+		if (workers_[slot].pid == pid)
+			return slot;
+	}
+	return -1;
+}
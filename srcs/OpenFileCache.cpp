@@ -0,0 +1,392 @@
+#include "OpenFileCache.hpp"
+#include "utils.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef LINUX
+#	include <sys/inotify.h>
+
+// The changes of a file that make its entry stale
+#	define WATCHED_EVENTS                                                     \
+		(IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVE_SELF                 \
+		 | IN_DELETE_SELF)
+#endif
+
+static unsigned long long nowMs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<unsigned long long>(ts.tv_sec) * 1000
+		   + ts.tv_nsec / 1000000;
+}
+
+// Opens a regular file, setting fd, or only stats a directory, leaving fd at
+// -1. Other files are not served.
+static bool openPath(std::string const &path, struct stat &st, int &fd)
+{
+	fd = -1;
+	if (stat(path.c_str(), &st) == -1)
+		return false;
+	if (S_ISDIR(st.st_mode))
+		return true;
+	if (!S_ISREG(st.st_mode))
+		return false;
+	fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd != -1 && fstat(fd, &st) == -1)
+	{
+		close(fd);
+		fd = -1;
+	}
+	return fd != -1;
+}
+
+static void fillInfo(
+	std::string const	  &path,
+	struct stat const	  &st,
+	OpenFileCache::Info &info
+)
+{
+	info.size = st.st_size;
+	info.mtime = st.st_mtime;
+	info.inode = st.st_ino;
+	info.isDirectory = S_ISDIR(st.st_mode);
+	info.mimeType = info.isDirectory ? "" : ft::getMimeType(path);
+}
+
+OpenFileCache::OpenFileCache(void)
+	: maxEntries_(0), validMs_(60000), useEvents_(false), inotifyFd_(-1),
+	  hits_(0), misses_(0)
+{
+	pthread_mutex_init(&mutex_, NULL);
+}
+
+OpenFileCache::~OpenFileCache(void)
+{
+	clear_();
+	if (inotifyFd_ != -1)
+		close(inotifyFd_);
+	pthread_mutex_destroy(&mutex_);
+}
+
+/**
+ * @brief Sets the limits of the cache, emptying it.
+ *
+ * @param maxEntries The most paths kept, 0 to cache nothing.
+ * @param validMs How long an entry is trusted before it is checked again.
+ * @param useEvents Whether to drop the entries of changed files at once, with
+ * inotify. Ignored where inotify is not available.
+ */
+void OpenFileCache::configure(
+	size_t		  maxEntries,
+	unsigned long validMs,
+	bool		  useEvents
+)
+{
+	pthread_mutex_lock(&mutex_);
+	clear_();
+	maxEntries_ = maxEntries;
+	validMs_ = validMs;
+#ifdef LINUX
+	useEvents_ = useEvents;
+#else
+	(void)useEvents;
+#endif
+	pthread_mutex_unlock(&mutex_);
+}
+
+/**
+ * @brief Gets the metadata of a file or a directory.
+ *
+ * @return false if the path is neither a readable regular file nor a
+ * directory.
+ */
+bool OpenFileCache::getInfo(std::string const &path, Info &info)
+{
+	if (maxEntries_ == 0)
+	{
+		struct stat st;
+		if (stat(path.c_str(), &st) == -1
+			|| !(S_ISREG(st.st_mode) || S_ISDIR(st.st_mode)))
+			return false;
+		fillInfo(path, st, info);
+		return true;
+	}
+	return lookUp_(path, info, NULL);
+}
+
+/**
+ * @brief Opens a regular file.
+ *
+ * @param path The path of the file.
+ * @param info Set to the metadata of the file.
+ * @return A file descriptor owned by the caller, or -1 if the path is not a
+ * readable regular file.
+ */
+int OpenFileCache::open(std::string const &path, Info &info)
+{
+	if (maxEntries_ == 0)
+	{
+		struct stat st;
+		int			fd;
+		if (openPath(path, st, fd) && fd != -1)
+			fillInfo(path, st, info);
+		return fd;
+	}
+	int fd(-1);
+	lookUp_(path, info, &fd);
+	return fd;
+}
+
+/**
+ * @brief Drops the entry of a path the server changed itself.
+ */
+void OpenFileCache::invalidate(std::string const &path)
+{
+	pthread_mutex_lock(&mutex_);
+	EntryMap::iterator it = entries_.find(path);
+	if (it != entries_.end())
+		erase_(it);
+	pthread_mutex_unlock(&mutex_);
+}
+
+void OpenFileCache::clear(void)
+{
+	pthread_mutex_lock(&mutex_);
+	clear_();
+	pthread_mutex_unlock(&mutex_);
+}
+
+/**
+ * @brief Gets the descriptor an event loop watches for readEvents(), which
+ * becomes readable when a cached file changes.
+ *
+ * @return -1 if the cache does not use events.
+ */
+int OpenFileCache::getEventFd(void)
+{
+	pthread_mutex_lock(&mutex_);
+	openEvents_();
+	int fd = inotifyFd_;
+	pthread_mutex_unlock(&mutex_);
+	return fd;
+}
+
+/**
+ * @brief Drops the entries of the files changed since the last call.
+ */
+void OpenFileCache::readEvents(void)
+{
+#ifdef LINUX
+	pthread_mutex_lock(&mutex_);
+	int inotifyFd = inotifyFd_;
+	pthread_mutex_unlock(&mutex_);
+	if (inotifyFd == -1)
+		return;
+	char	buffer[4096]
+		__attribute__((aligned(__alignof__(struct inotify_event))));
+	ssize_t length;
+	while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0)
+	{
+		pthread_mutex_lock(&mutex_);
+		for (char *ptr = buffer; ptr < buffer + length;)
+		{
+			struct inotify_event const *event
+				= reinterpret_cast<struct inotify_event const *>(ptr);
+			// Events were lost, so any entry may be stale
+			if (event->mask & IN_Q_OVERFLOW)
+				clear_();
+			WatchMap::iterator it;
+			while ((it = watches_.find(event->wd)) != watches_.end())
+				erase_(entries_.find(it->second));
+			ptr += sizeof(struct inotify_event) + event->len;
+		}
+		pthread_mutex_unlock(&mutex_);
+	}
+#endif
+}
+
+size_t OpenFileCache::getSize(void) const
+{
+	pthread_mutex_lock(&mutex_);
+	size_t size = entries_.size();
+	pthread_mutex_unlock(&mutex_);
+	return size;
+}
+
+unsigned long long OpenFileCache::getHits(void) const
+{
+	pthread_mutex_lock(&mutex_);
+	unsigned long long hits = hits_;
+	pthread_mutex_unlock(&mutex_);
+	return hits;
+}
+
+unsigned long long OpenFileCache::getMisses(void) const
+{
+	pthread_mutex_lock(&mutex_);
+	unsigned long long misses = misses_;
+	pthread_mutex_unlock(&mutex_);
+	return misses;
+}
+
+// Whether an entry still describes the file a path was stat()ed to
+static bool isSameFile(
+	OpenFileCache::Info const &info,
+	dev_t					   device,
+	struct stat const		  &st
+)
+{
+	return st.st_ino == info.inode && st.st_dev == device
+		   && st.st_mtime == info.mtime && st.st_size == info.size;
+}
+
+// Gets the metadata of a path, and a duplicate of its descriptor if fd is not
+// NULL, from its entry or else the file system. The lock is released while
+// the file is checked or opened, so the other threads keep getting their hits;
+// a thread that loaded the same path meanwhile is overridden.
+bool OpenFileCache::lookUp_(std::string const &path, Info &info, int *fd)
+{
+	unsigned long long now = nowMs();
+	pthread_mutex_lock(&mutex_);
+	EntryMap::iterator it = entries_.find(path);
+	if (it != entries_.end() && now - it->second.validatedAt < validMs_)
+	{
+		++hits_;
+		take_(it, info, fd);
+		pthread_mutex_unlock(&mutex_);
+		return true;
+	}
+	bool  isCached = it != entries_.end();
+	Info  cached;
+	dev_t device(0);
+	if (isCached)
+	{
+		cached = it->second.info;
+		device = it->second.device;
+	}
+	openEvents_();
+	int inotifyFd = inotifyFd_;
+	pthread_mutex_unlock(&mutex_);
+
+	struct stat st;
+	if (isCached && stat(path.c_str(), &st) == 0
+		&& isSameFile(cached, device, st))
+	{
+		pthread_mutex_lock(&mutex_);
+		it = entries_.find(path);
+		bool isHit = it != entries_.end()
+					 && isSameFile(it->second.info, it->second.device, st);
+		if (isHit)
+		{
+			++hits_;
+			it->second.validatedAt = now;
+			take_(it, info, fd);
+		}
+		pthread_mutex_unlock(&mutex_);
+		if (isHit)
+			return true;
+	}
+
+	// Watched first, so that a change made while the file is opened is seen
+	int watch(-1);
+#ifdef LINUX
+	if (inotifyFd != -1)
+		watch = inotify_add_watch(inotifyFd, path.c_str(), WATCHED_EVENTS);
+#else
+	(void)inotifyFd;
+#endif
+	int	 newFd;
+	bool isOpen = openPath(path, st, newFd);
+	pthread_mutex_lock(&mutex_);
+	++misses_;
+	it = entries_.find(path);
+	if (it != entries_.end())
+		erase_(it, isOpen ? watch : -1);
+	if (isOpen)
+		take_(insert_(path, st, newFd, watch), info, fd);
+#ifdef LINUX
+	else if (watch != -1 && watches_.count(watch) == 0)
+		inotify_rm_watch(inotifyFd_, watch);
+#endif
+	pthread_mutex_unlock(&mutex_);
+	return isOpen;
+}
+
+// Copies the metadata of an entry, and duplicates its descriptor if fd is not
+// NULL, making it the most recently used.
+void OpenFileCache::take_(EntryMap::iterator it, Info &info, int *fd)
+{
+	info = it->second.info;
+	if (fd != NULL && it->second.fd != -1)
+		*fd = fcntl(it->second.fd, F_DUPFD_CLOEXEC, 0);
+	lru_.splice(lru_.begin(), lru_, it->second.position);
+}
+
+// Adds the entry of an opened path, then evicts the least recently used ones
+// if the cache is full. The new entry comes first, so that an evicted path of
+// the same file does not remove the watch they share.
+OpenFileCache::EntryMap::iterator OpenFileCache::insert_(
+	std::string const &path,
+	struct stat const &st,
+	int				   fd,
+	int				   watch
+)
+{
+	Entry entry;
+	fillInfo(path, st, entry.info);
+	entry.fd = fd;
+	entry.device = st.st_dev;
+	entry.watch = watch;
+	entry.validatedAt = nowMs();
+	lru_.push_front(path);
+	entry.position = lru_.begin();
+	EntryMap::iterator it = entries_.insert(std::make_pair(path, entry)).first;
+	if (watch != -1)
+		watches_.insert(std::make_pair(watch, path));
+	while (entries_.size() > maxEntries_)
+		erase_(entries_.find(lru_.back()));
+	return it;
+}
+
+// Closes an entry and removes its watch unless another entry shares it, or it
+// is keptWatch, which a new entry of the same path is taking over.
+void OpenFileCache::erase_(EntryMap::iterator it, int keptWatch)
+{
+	Entry &entry = it->second;
+	if (entry.fd != -1)
+		close(entry.fd);
+	if (entry.watch != -1)
+	{
+		std::pair<WatchMap::iterator, WatchMap::iterator> range
+			= watches_.equal_range(entry.watch);
+		while (range.first != range.second && range.first->second != it->first)
+			++range.first;
+		if (range.first != range.second)
+			watches_.erase(range.first);
+#ifdef LINUX
+		// The paths of a same file share its watch
+		if (entry.watch != keptWatch && watches_.count(entry.watch) == 0)
+			inotify_rm_watch(inotifyFd_, entry.watch);
+#endif
+	}
+	(void)keptWatch;
+	lru_.erase(entry.position);
+	entries_.erase(it);
+}
+
+void OpenFileCache::clear_(void)
+{
+	while (!entries_.empty())
+		erase_(entries_.begin());
+}
+
+// Starts the inotify instance on first use, after the workers are forked, so
+// that each process reads its own events.
+void OpenFileCache::openEvents_(void)
+{
+#ifdef LINUX
+	if (useEvents_ && maxEntries_ > 0 && inotifyFd_ == -1)
+		inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
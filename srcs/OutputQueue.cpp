@@ -0,0 +1,284 @@
+#include "OutputQueue.hpp"
+
+#include <cerrno>
+#include <sys/uio.h>
+#include <unistd.h>
+#ifdef LINUX
+#	include <sys/sendfile.h>
+#endif
+
+BodyGenerator::~BodyGenerator(void) {}
+
+OutputQueue::OutputQueue(void) : offset_(0), size_(0) {}
+
+OutputQueue::~OutputQueue(void)
+{
+	clear();
+}
+
+/**
+ * @brief Queues data after the segments already waiting.
+ *
+ * @param data The data, moved into the queue: it is left empty.
+ */
+void OutputQueue::push(std::string &data)
+{
+	if (data.empty())
+		return;
+	segments_.push_back(Segment());
+	Segment &segment = segments_.back();
+	segment.kind = Segment::MEMORY;
+	segment.data.swap(data);
+	segment.fd = -1;
+	segment.generator = NULL;
+	segment.useSendfile = false;
+	size_ += segment.data.size();
+}
+
+/**
+ * @brief Queues a range of an open file.
+ *
+ * @param fd The file descriptor, closed by the queue once the range is read.
+ * @param offset The offset of the range in the file.
+ * @param length The length of the range.
+ * @param useSendfile Whether to send the range with sendfile(2), where it is
+ * available, instead of reading it into memory.
+ */
+void OutputQueue::pushFile(int fd, off_t offset, size_t length, bool useSendfile)
+{
+	if (length == 0)
+	{
+		close(fd);
+		return;
+	}
+	segments_.push_back(Segment());
+	Segment &segment = segments_.back();
+	segment.kind = Segment::FILE;
+	segment.fd = fd;
+	segment.offset = offset;
+	segment.length = length;
+	segment.generator = NULL;
+#ifdef LINUX
+	segment.useSendfile = useSendfile;
+#else
+	segment.useSendfile = false;
+	(void)useSendfile;
+#endif
+	size_ += length;
+}
+
+/**
+ * @brief Queues a body produced as it is written.
+ *
+ * @param generator The generator, deleted by the queue at the end of the body.
+ */
+void OutputQueue::pushGenerator(BodyGenerator *generator)
+{
+	segments_.push_back(Segment());
+	Segment &segment = segments_.back();
+	segment.kind = Segment::GENERATOR;
+	segment.fd = -1;
+	segment.generator = generator;
+	segment.useSendfile = false;
+}
+
+/**
+ * @brief Writes as many queued bytes as the file descriptor takes.
+ *
+ * The memory segments at the front are gathered in one writev(2). A file or a
+ * generator met on the way is read into memory first, one chunk at a time,
+ * unless the file is sent with sendfile(2). The written bytes are dropped
+ * from the queue, the others are kept for the next call.
+ *
+ * @param fd The file descriptor to write to.
+ * @return The number of bytes written, or -1 on error, also when a file or a
+ * generator fails, if nothing could be written. errno is then EAGAIN for a
+ * generator not ready yet. 0 is returned, without writing, if there is
+ * nothing left to write.
+ */
+ssize_t OutputQueue::writeTo(int fd)
+{
+	size_t total(0);
+	bool   isFull(false);
+	while (!segments_.empty() && !isFull && total < MAX_WRITE_)
+	{
+		Segment const &front = segments_.front();
+		ssize_t		   written
+			= front.kind == Segment::FILE && front.useSendfile
+				  ? sendFile_(fd, MAX_WRITE_ - total)
+				  : writeMemory_(fd, isFull);
+		if (written <= 0)
+			return total > 0 ? total : written;
+		total += written;
+	}
+	return total;
+}
+
+void OutputQueue::clear(void)
+{
+	while (!segments_.empty())
+		pop_();
+	size_ = 0;
+}
+
+/**
+ * @brief Gets the number of bytes waiting, not counting the generators.
+ */
+size_t OutputQueue::getSize(void) const
+{
+	return size_;
+}
+
+bool OutputQueue::isEmpty(void) const
+{
+	return segments_.empty();
+}
+
+// Writes the memory segments at the front, up to the first file sent with
+// sendfile(2). isFull is set when the file descriptor took only part of them.
+ssize_t OutputQueue::writeMemory_(int fd, bool &isFull)
+{
+	struct iovec vectors[MAX_SEGMENTS_];
+	int			 count(0);
+	size_t		 gathered(0);
+	while (static_cast<size_t>(count) < segments_.size()
+		   && count < MAX_SEGMENTS_)
+	{
+		Segment const &segment = segments_[count];
+		if (segment.kind == Segment::FILE && segment.useSendfile)
+			break;
+		if (segment.kind != Segment::MEMORY)
+		{
+			// Read no more than a chunk ahead of the socket
+			if (gathered >= CHUNK_SIZE_)
+				break;
+			if (!readChunk_(count))
+			{
+				if (count == 0)
+					return -1;
+				break;
+			}
+			// The segment may have ended without adding a chunk
+			continue;
+		}
+		gathered += segment.data.size() - (count == 0 ? offset_ : 0);
+		++count;
+	}
+	if (count == 0)
+		return 0;
+	// Inserting the chunks moved the segments: their data is only pointed to
+	// once they are all read
+	for (int i = 0; i < count; ++i)
+	{
+		size_t skip = i == 0 ? offset_ : 0;
+		vectors[i].iov_base = const_cast<char *>(segments_[i].data.data())
+							  + skip;
+		vectors[i].iov_len = segments_[i].data.size() - skip;
+	}
+	ssize_t written = writev(fd, vectors, count);
+	if (written <= 0)
+		return written;
+	isFull = static_cast<size_t>(written) < gathered;
+	size_ -= written;
+	size_t left = written;
+	while (left > 0)
+	{
+		size_t rest = segments_.front().data.size() - offset_;
+		if (left < rest)
+		{
+			offset_ += left;
+			break;
+		}
+		left -= rest;
+		pop_();
+	}
+	return written;
+}
+
+// Sends up to maxLength bytes of the file range at the front.
+ssize_t OutputQueue::sendFile_(int fd, size_t maxLength)
+{
+#ifdef LINUX
+	Segment &front = segments_.front();
+	size_t	 length = front.length < maxLength ? front.length : maxLength;
+	ssize_t	 sent = sendfile(fd, front.fd, &front.offset, length);
+	if (sent <= 0)
+	{
+		// The file was truncated since the response was made
+		if (sent == 0)
+			errno = EIO;
+		return -1;
+	}
+	front.length -= sent;
+	size_ -= sent;
+	if (front.length == 0)
+		pop_();
+	return sent;
+#else
+	(void)fd;
+	(void)maxLength;
+	return -1;
+#endif
+}
+
+// Reads the next chunk of the file or generator segment at index into a
+// memory segment inserted before it. The segment is dropped at its end.
+bool OutputQueue::readChunk_(size_t index)
+{
+	Segment		chunk;
+	Segment	   &source = segments_[index];
+	std::string data;
+	if (source.kind == Segment::FILE)
+	{
+		size_t length = source.length < CHUNK_SIZE_ ? source.length
+													: CHUNK_SIZE_;
+		data.resize(length);
+		ssize_t bytesRead = pread(source.fd, &data[0], length, source.offset);
+		if (bytesRead <= 0)
+		{
+			// The file was truncated since the response was made
+			if (bytesRead == 0)
+				errno = EIO;
+			return false;
+		}
+		data.resize(bytesRead);
+		source.offset += bytesRead;
+		source.length -= bytesRead;
+		if (source.length == 0)
+		{
+			close(source.fd);
+			segments_.erase(segments_.begin() + index);
+		}
+	}
+	else
+	{
+		ssize_t generated = source.generator->generate(data, CHUNK_SIZE_);
+		if (generated < 0)
+			return false;
+		if (generated == 0)
+		{
+			delete source.generator;
+			segments_.erase(segments_.begin() + index);
+			return true;
+		}
+		size_ += generated;
+	}
+	chunk.kind = Segment::MEMORY;
+	chunk.fd = -1;
+	chunk.generator = NULL;
+	chunk.useSendfile = false;
+	segments_.insert(segments_.begin() + index, chunk)->data.swap(data);
+	return true;
+}
+
+// Drops the segment at the front, releasing what it owns.
+void OutputQueue::pop_(void)
+{
+	Segment &front = segments_.front();
+	if (front.kind == Segment::FILE)
+		close(front.fd);
+	else if (front.kind == Segment::GENERATOR)
+		delete front.generator;
+	segments_.pop_front();
+	offset_ = 0;
+}
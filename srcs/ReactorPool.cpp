@@ -0,0 +1,447 @@
+#include "ReactorPool.hpp"
+#include "HttpErrorHandler.hpp"
+#include "HttpMethodHandler.hpp"
+#include "Logger.hpp"
+#include "ServerEngine.hpp"
+#include "ServerException.hpp"
+#include "signals.hpp"
+#include "utils.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+ReactorPool::Job::Job(
+	size_t			   owner,
+	int				   clientFd,
+	unsigned long	   connectionId,
+	HttpRequest const &request,
+	Server const	  *server
+)
+	: owner(owner), clientFd(clientFd), connectionId(connectionId),
+	  request(request), server(server)
+{
+}
+
+/**
+ * @brief Constructor for ReactorPool.
+ *
+ * @param servers The parsed server configurations, shared by the reactors.
+ * @param backend The event backend used by every reactor.
+ * @param threadCount The number of reactor threads.
+ */
+ReactorPool::ReactorPool(
+	// clang-format off
+	std::vector<std::map<std::string, ConfigValue> > const &servers,
+	// clang-format on
+	EventPoller::Backend backend,
+	unsigned int		 threadCount
+)
+	: servers_(servers), backend_(backend), runningLoops_(0), nextThief_(0),
+	  failed_(false), initFailed_(false)
+{
+	pthread_mutex_init(&stateMutex_, NULL);
+	pthread_cond_init(&stateCond_, NULL);
+	if (threadCount > 1)
+		initReactors_(threadCount);
+}
+
+ReactorPool::~ReactorPool(void)
+{
+	for (size_t i = 0; i < reactors_.size(); ++i)
+	{
+		Reactor *reactor = reactors_[i];
+		for (size_t j = 0; j < reactor->jobs.size(); ++j)
+			delete reactor->jobs[j];
+		for (size_t j = 0; j < reactor->completed.size(); ++j)
+			delete reactor->completed[j];
+		if (reactor->wakeupFds[0] != -1)
+			close(reactor->wakeupFds[0]);
+		if (reactor->wakeupFds[1] != -1)
+			close(reactor->wakeupFds[1]);
+		pthread_mutex_destroy(&reactor->mutex);
+		delete reactor;
+	}
+	pthread_cond_destroy(&stateCond_);
+	pthread_mutex_destroy(&stateMutex_);
+}
+
+/**
+ * @brief Creates the reactors and their non-blocking wakeup pipes.
+ *
+ * @param threadCount The number of reactors.
+ */
+void ReactorPool::initReactors_(unsigned int threadCount)
+{
+	reactors_.reserve(threadCount);
+	for (size_t i = 0; i < threadCount; ++i)
+	{
+		Reactor *reactor = new Reactor();
+		reactor->pool = this;
+		reactor->index = i;
+		reactor->wakeupFds[0] = -1;
+		reactor->wakeupFds[1] = -1;
+		pthread_mutex_init(&reactor->mutex, NULL);
+		reactors_.push_back(reactor);
+		// Not inherited by the CGI scripts another reactor thread spawns
+#ifdef LINUX
+		int created = pipe2(reactor->wakeupFds, O_CLOEXEC | O_NONBLOCK);
+#else
+		int created = pipe(reactor->wakeupFds);
+#endif
+		if (created == -1)
+			throw ServerException(
+				"Failed to create the wakeup pipe of the reactor[%]",
+				errno,
+				ft::toString(i)
+			);
+#ifndef LINUX
+		for (size_t j = 0; j < 2; ++j)
+		{
+			int flags = fcntl(reactor->wakeupFds[j], F_GETFL, 0);
+			if (flags == -1
+				|| fcntl(reactor->wakeupFds[j], F_SETFL, flags | O_NONBLOCK)
+					   == -1
+				|| fcntl(reactor->wakeupFds[j], F_SETFD, FD_CLOEXEC) == -1)
+				throw ServerException(
+					"Failed to set the wakeup pipe flags of the reactor[%]",
+					errno,
+					ft::toString(i)
+				);
+		}
+#endif
+	}
+}
+
+// Reports how well the caches worked, if they were used.
+static void logCaches(void)
+{
+	OpenFileCache &files = HttpMethodHandler::getOpenFileCache();
+	if (files.getHits() + files.getMisses() > 0)
+		Logger::log(Logger::INFO)
+			<< "Open file cache: " << files.getHits() << " hits, "
+			<< files.getMisses() << " misses" << std::endl;
+	ResponseCache &responses = HttpMethodHandler::getResponseCache();
+	if (responses.getHits() + responses.getMisses() > 0)
+		Logger::log(Logger::INFO)
+			<< "Response cache: " << responses.getHits() << " hits, "
+			<< responses.getMisses() << " misses, hit ratio "
+			<< static_cast<int>(responses.getHitRatio() * 100) << "%, "
+			<< responses.getBytes() << " bytes in " << responses.getSize()
+			<< " entries" << std::endl;
+	GzipCache &compressed = HttpMethodHandler::getGzipCache();
+	if (compressed.getHits() + compressed.getMisses() > 0)
+		Logger::log(Logger::INFO)
+			<< "Gzip cache: " << compressed.getHits() << " hits, "
+			<< compressed.getMisses() << " misses, " << compressed.getBytes()
+			<< " bytes in " << compressed.getSize() << " entries" << std::endl;
+}
+
+/**
+ * @brief Runs the reactors until shutdown.
+ *
+ * With one thread the engine runs in the calling thread. Otherwise every
+ * reactor gets its own thread and the calling thread waits for them.
+ */
+void ReactorPool::run(void)
+{
+	if (reactors_.empty())
+	{
+		bool isBound(false);
+		try
+		{
+			ServerEngine engine(servers_, backend_);
+			isBound = true;
+			engine.start();
+		}
+		catch (...)
+		{
+			initFailed_ = !isBound;
+			throw;
+		}
+		logCaches();
+		return;
+	}
+
+	Logger::log(Logger::INFO) << "Starting " << reactors_.size()
+							  << " reactor threads" << std::endl;
+	// The threads inherit the mask, so the signals are handled by this thread
+	// only, never while a reactor holds a lock.
+	sigset_t handledSignals;
+	sigset_t previousSignals;
+	signals::getHandledSignals(handledSignals);
+	pthread_sigmask(SIG_BLOCK, &handledSignals, &previousSignals);
+	runningLoops_ = reactors_.size();
+	size_t started(0);
+	for (; started < reactors_.size(); ++started)
+	{
+		if (pthread_create(
+				&reactors_[started]->thread, NULL, runReactor_, reactors_[started]
+			)
+			!= 0)
+		{
+			Logger::log(Logger::ERROR)
+				<< "Failed to create the reactor thread[" << started << "]"
+				<< std::endl;
+			__atomic_store_n(&g_shutdown, -1, __ATOMIC_SEQ_CST);
+			pthread_mutex_lock(&stateMutex_);
+			failed_ = true;
+			runningLoops_ -= reactors_.size() - started;
+			pthread_cond_broadcast(&stateCond_);
+			pthread_mutex_unlock(&stateMutex_);
+			break;
+		}
+	}
+	pthread_sigmask(SIG_SETMASK, &previousSignals, NULL);
+	waitLoops_();
+	for (size_t i = 0; i < started; ++i)
+		pthread_join(reactors_[i]->thread, NULL);
+	logCaches();
+	if (failed_)
+		throw ServerException("The reactor threads failed to run");
+}
+
+void *ReactorPool::runReactor_(void *reactor)
+{
+	Reactor *self = static_cast<Reactor *>(reactor);
+	self->pool->runLoop_(*self);
+	return NULL;
+}
+
+/**
+ * @brief Body of a reactor thread.
+ *
+ * @param reactor The reactor owned by the calling thread.
+ */
+void ReactorPool::runLoop_(Reactor &reactor)
+{
+	bool isBound(false);
+	try
+	{
+		ServerEngine engine(servers_, backend_);
+		isBound = true;
+		engine.attachReactorPool(this, reactor.index);
+		engine.start();
+		// The engine must outlive the jobs stolen by the other reactors, as
+		// they point to its servers.
+		finishLoop_();
+		return;
+	}
+	catch (std::exception &e)
+	{
+		Logger::log(Logger::ERROR)
+			<< "Reactor[" << reactor.index << "]: " << e.what() << std::endl;
+		pthread_mutex_lock(&stateMutex_);
+		failed_ = true;
+		if (!isBound)
+			initFailed_ = true;
+		pthread_mutex_unlock(&stateMutex_);
+		__atomic_store_n(&g_shutdown, -1, __ATOMIC_SEQ_CST);
+	}
+	finishLoop_();
+}
+
+/**
+ * @brief Whether run() failed because a reactor could not set up its servers
+ * (e.g. bind its listeners), rather than while running.
+ */
+bool ReactorPool::hasFailedToStart(void) const
+{
+	pthread_mutex_lock(&stateMutex_);
+	bool initFailed = initFailed_;
+	pthread_mutex_unlock(&stateMutex_);
+	return initFailed;
+}
+
+/**
+ * @brief Waits in the calling thread until every reactor has left its event
+ * loop, waking them up once a signal asks for the shutdown.
+ *
+ * The signal handler only sets g_shutdown, so the wait is polled.
+ */
+void ReactorPool::waitLoops_(void)
+{
+	bool isWoken(false);
+	pthread_mutex_lock(&stateMutex_);
+	while (runningLoops_ > 0)
+	{
+		int signalNumber = __atomic_load_n(&g_shutdown, __ATOMIC_SEQ_CST);
+		if (signalNumber != 0 && !isWoken)
+		{
+			pthread_mutex_unlock(&stateMutex_);
+			if (signalNumber > 0)
+				Logger::log(Logger::INFO)
+					<< "Signal " << signalNumber
+					<< " received, stopping the reactors" << std::endl;
+			for (size_t i = 0; i < reactors_.size(); ++i)
+				wakeup_(i);
+			isWoken = true;
+			pthread_mutex_lock(&stateMutex_);
+			continue;
+		}
+		struct timespec deadline;
+		clock_gettime(CLOCK_REALTIME, &deadline);
+		deadline.tv_nsec += SIGNAL_POLL_MS_ * 1000000L;
+		deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+		deadline.tv_nsec %= 1000000000L;
+		pthread_cond_timedwait(&stateCond_, &stateMutex_, &deadline);
+	}
+	pthread_mutex_unlock(&stateMutex_);
+}
+
+/**
+ * @brief Waits until every reactor has left its event loop.
+ *
+ * The other reactors are woken up, so they notice the shutdown without waiting
+ * for their next timer.
+ */
+void ReactorPool::finishLoop_(void)
+{
+	for (size_t i = 0; i < reactors_.size(); ++i)
+		wakeup_(i);
+	pthread_mutex_lock(&stateMutex_);
+	--runningLoops_;
+	pthread_cond_broadcast(&stateCond_);
+	while (runningLoops_ > 0)
+		pthread_cond_wait(&stateCond_, &stateMutex_);
+	pthread_mutex_unlock(&stateMutex_);
+}
+
+/**
+ * @brief Queues a heavy job in the deque of its owner.
+ *
+ * Another reactor is woken up, so it can steal the job if it is idle.
+ *
+ * @param job The job, the pool takes its ownership.
+ */
+void ReactorPool::postJob(Job *job)
+{
+	Reactor &owner = *reactors_[job->owner];
+	pthread_mutex_lock(&owner.mutex);
+	owner.jobs.push_back(job);
+	pthread_mutex_unlock(&owner.mutex);
+
+	pthread_mutex_lock(&stateMutex_);
+	size_t thief = nextThief_++ % reactors_.size();
+	if (thief == job->owner)
+		thief = nextThief_++ % reactors_.size();
+	pthread_mutex_unlock(&stateMutex_);
+	wakeup_(thief);
+}
+
+/**
+ * @brief Takes a job for a reactor: its own newest job, or else the oldest job
+ * of another reactor.
+ *
+ * @param reactor The index of the reactor looking for work.
+ * @return The job, or NULL if every deque is empty.
+ */
+ReactorPool::Job *ReactorPool::takeJob_(size_t reactor)
+{
+	Job		*job(NULL);
+	Reactor &self = *reactors_[reactor];
+	pthread_mutex_lock(&self.mutex);
+	if (!self.jobs.empty())
+	{
+		job = self.jobs.back();
+		self.jobs.pop_back();
+	}
+	pthread_mutex_unlock(&self.mutex);
+	for (size_t i = 1; job == NULL && i < reactors_.size(); ++i)
+	{
+		Reactor &victim = *reactors_[(reactor + i) % reactors_.size()];
+		pthread_mutex_lock(&victim.mutex);
+		if (!victim.jobs.empty())
+		{
+			job = victim.jobs.front();
+			victim.jobs.pop_front();
+		}
+		pthread_mutex_unlock(&victim.mutex);
+	}
+	return job;
+}
+
+/**
+ * @brief Runs one pending job, if any, and hands the response to its owner.
+ *
+ * @param reactor The index of the reactor running the job.
+ * @return true if a job was run, false if there was nothing to do.
+ */
+bool ReactorPool::runJob(size_t reactor)
+{
+	Job *job = takeJob_(reactor);
+	if (job == NULL)
+		return false;
+	if (job->owner != reactor)
+		Logger::log(Logger::DEBUG)
+			<< "Reactor[" << reactor << "] stole the job of connection "
+			<< job->connectionId << " from reactor[" << job->owner << "]"
+			<< std::endl;
+	try
+	{
+		job->response = HttpMethodHandler::handleRequest(
+			job->request, *job->server, job->request.getMethod()
+		);
+	}
+	catch (std::exception &e)
+	{
+		Logger::log(Logger::ERROR)
+			<< "Reactor[" << reactor << "]: job failed: " << e.what()
+			<< std::endl;
+		job->response
+			= HttpErrorHandler::getErrorPage(500, job->request.getKeepAlive());
+	}
+	completeJob_(job);
+	return true;
+}
+
+void ReactorPool::completeJob_(Job *job)
+{
+	Reactor &owner = *reactors_[job->owner];
+	pthread_mutex_lock(&owner.mutex);
+	owner.completed.push_back(job);
+	pthread_mutex_unlock(&owner.mutex);
+	wakeup_(job->owner);
+}
+
+/**
+ * @brief Takes a finished job of a reactor.
+ *
+ * @param reactor The index of the owner reactor.
+ * @return The job, to be deleted by the caller, or NULL if there is none.
+ */
+ReactorPool::Job *ReactorPool::popCompletedJob(size_t reactor)
+{
+	Job		*job(NULL);
+	Reactor &self = *reactors_[reactor];
+	pthread_mutex_lock(&self.mutex);
+	if (!self.completed.empty())
+	{
+		job = self.completed.front();
+		self.completed.pop_front();
+	}
+	pthread_mutex_unlock(&self.mutex);
+	return job;
+}
+
+int ReactorPool::getWakeupFd(size_t reactor) const
+{
+	return reactors_[reactor]->wakeupFds[0];
+}
+
+// A full pipe already holds a pending wakeup, so a failed write is ignored.
+void ReactorPool::wakeup_(size_t reactor)
+{
+	char byte(1);
+	if (write(reactors_[reactor]->wakeupFds[1], &byte, 1) == -1)
+		return;
+}
+
+void ReactorPool::clearWakeup(size_t reactor)
+{
+	char buffer[64];
+	while (read(reactors_[reactor]->wakeupFds[0], buffer, sizeof(buffer)) > 0)
+		;
+}
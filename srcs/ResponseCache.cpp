@@ -0,0 +1,251 @@
+#include "ResponseCache.hpp"
+#include "utils.hpp"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+ResponseCache::ResponseCache(void)
+	: maxBytes_(0), files_(NULL), bytes_(0), hits_(0), misses_(0)
+{
+	pthread_mutex_init(&mutex_, NULL);
+}
+
+ResponseCache::~ResponseCache(void)
+{
+	pthread_mutex_destroy(&mutex_);
+}
+
+/**
+ * @brief Sets the limits of the cache, emptying it.
+ *
+ * @param maxBytes The budget of the heads and bodies, 0 to cache nothing.
+ * @param files The cache the files of the entries are checked against.
+ */
+void ResponseCache::configure(size_t maxBytes, OpenFileCache &files)
+{
+	pthread_mutex_lock(&mutex_);
+	clear_();
+	maxBytes_ = maxBytes;
+	files_ = &files;
+	pthread_mutex_unlock(&mutex_);
+}
+
+bool ResponseCache::isEnabled(void) const
+{
+	return maxBytes_ > 0;
+}
+
+/**
+ * @brief Tells whether a body of this size would be cached.
+ */
+bool ResponseCache::isCacheable(size_t bodySize) const
+{
+	return bodySize <= maxBytes_ / 8;
+}
+
+/**
+ * @brief Gets the cached response of a key.
+ *
+ * @param key The server and the URI of the request.
+ * @param keepAlive Whether the connection stays open after the response.
+ * @param response Set to a copy of the cached response, completed with the
+ * Date and Connection headers.
+ * @return false if the key is not cached, or if its file changed.
+ */
+bool ResponseCache::find(
+	std::string const &key,
+	bool			   keepAlive,
+	HttpResponse	  &response
+)
+{
+	if (maxBytes_ == 0)
+		return false;
+	pthread_mutex_lock(&mutex_);
+	EntryMap::iterator it = entries_.find(key);
+	if (it == entries_.end())
+	{
+		pthread_mutex_unlock(&mutex_);
+		return false;
+	}
+	std::string path(it->second.path);
+	pthread_mutex_unlock(&mutex_);
+
+	// Checked without the lock, as a file the open file cache does not hold
+	// is stat()ed
+	OpenFileCache::Info info;
+	bool				isFound = files_->getInfo(path, info);
+	std::string			head;
+	std::string			body;
+	pthread_mutex_lock(&mutex_);
+	it = entries_.find(key);
+	if (it != entries_.end()
+		&& (!isFound || info.size != it->second.size
+			|| info.mtime != it->second.mtime
+			|| info.inode != it->second.inode))
+	{
+		erase_(it);
+		it = entries_.end();
+	}
+	if (it == entries_.end())
+	{
+		pthread_mutex_unlock(&mutex_);
+		return false;
+	}
+	++hits_;
+	lru_.splice(lru_.begin(), lru_, it->second.position);
+	head.reserve(it->second.head.size() + 64);
+	head = it->second.head;
+	body = it->second.body;
+	pthread_mutex_unlock(&mutex_);
+
+	head.append("Date: ").append(ft::createTimestamp()).append("\r\n");
+	head.append(
+		keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n"
+	);
+	head.append("\r\n");
+	response.setStatusCode(200);
+	response.setReasonPhrase("OK");
+	response.setRenderedHead(head);
+	response.swapBody(body);
+	return true;
+}
+
+/**
+ * @brief Caches the response of a key after a miss.
+ *
+ * @param key The server and the URI of the request.
+ * @param path The file the body was read from, checked again later.
+ * @param fd The open file the body was read from.
+ * @param response The response, with every header but Date and Connection.
+ * @param body The content of the file.
+ */
+void ResponseCache::insert(
+	std::string const  &key,
+	std::string const  &path,
+	int					fd,
+	HttpResponse const &response,
+	std::string const  &body
+)
+{
+	struct stat st;
+	if (maxBytes_ == 0 || !isCacheable(body.size()) || fstat(fd, &st) == -1
+		|| static_cast<size_t>(st.st_size) != body.size())
+		return;
+	Entry entry;
+	response.renderHead(entry.head);
+	// The head is completed on every hit
+	entry.head.resize(entry.head.size() - 2);
+	entry.path = path;
+	entry.body = body;
+	entry.size = st.st_size;
+	entry.mtime = st.st_mtime;
+	entry.inode = st.st_ino;
+	size_t entryBytes = entry.head.size() + entry.body.size();
+
+	pthread_mutex_lock(&mutex_);
+	++misses_;
+	EntryMap::iterator it = entries_.find(key);
+	if (it != entries_.end())
+		erase_(it);
+	while (!lru_.empty() && bytes_ + entryBytes > maxBytes_)
+		erase_(entries_.find(lru_.back()));
+	if (bytes_ + entryBytes <= maxBytes_)
+	{
+		lru_.push_front(key);
+		entry.position = lru_.begin();
+		entries_.insert(std::make_pair(key, entry));
+		bytes_ += entryBytes;
+	}
+	pthread_mutex_unlock(&mutex_);
+}
+
+/**
+ * @brief Drops the entries read from a file the server changed itself.
+ */
+void ResponseCache::invalidate(std::string const &path)
+{
+	if (maxBytes_ == 0)
+		return;
+	pthread_mutex_lock(&mutex_);
+	EntryMap::iterator it = entries_.begin();
+	while (it != entries_.end())
+	{
+		EntryMap::iterator next = it;
+		++next;
+		if (it->second.path == path)
+			erase_(it);
+		it = next;
+	}
+	pthread_mutex_unlock(&mutex_);
+}
+
+void ResponseCache::clear(void)
+{
+	pthread_mutex_lock(&mutex_);
+	clear_();
+	pthread_mutex_unlock(&mutex_);
+}
+
+size_t ResponseCache::getSize(void) const
+{
+	pthread_mutex_lock(&mutex_);
+	size_t size = entries_.size();
+	pthread_mutex_unlock(&mutex_);
+	return size;
+}
+
+/**
+ * @brief Gets the bytes of the heads and bodies in the cache.
+ */
+size_t ResponseCache::getBytes(void) const
+{
+	pthread_mutex_lock(&mutex_);
+	size_t bytes = bytes_;
+	pthread_mutex_unlock(&mutex_);
+	return bytes;
+}
+
+unsigned long long ResponseCache::getHits(void) const
+{
+	pthread_mutex_lock(&mutex_);
+	unsigned long long hits = hits_;
+	pthread_mutex_unlock(&mutex_);
+	return hits;
+}
+
+/**
+ * @brief Gets the number of cacheable responses read from their file.
+ */
+unsigned long long ResponseCache::getMisses(void) const
+{
+	pthread_mutex_lock(&mutex_);
+	unsigned long long misses = misses_;
+	pthread_mutex_unlock(&mutex_);
+	return misses;
+}
+
+/**
+ * @brief Gets the share of the cacheable responses served from the cache.
+ */
+double ResponseCache::getHitRatio(void) const
+{
+	pthread_mutex_lock(&mutex_);
+	unsigned long long total = hits_ + misses_;
+	double ratio = total == 0 ? 0 : static_cast<double>(hits_) / total;
+	pthread_mutex_unlock(&mutex_);
+	return ratio;
+}
+
+void ResponseCache::erase_(EntryMap::iterator it)
+{
+	bytes_ -= it->second.head.size() + it->second.body.size();
+	lru_.erase(it->second.position);
+	entries_.erase(it);
+}
+
+void ResponseCache::clear_(void)
+{
+	entries_.clear();
+	lru_.clear();
+	bytes_ = 0;
+}
@@ -0,0 +1,99 @@
+#include "RingBuffer.hpp"
+
+#include <sys/uio.h>
+
+RingBuffer::RingBuffer(size_t capacity)
+	: capacity_(capacity), head_(0), size_(0)
+{
+}
+
+RingBuffer::~RingBuffer(void) {}
+
+/**
+ * @brief Reads as many bytes as fit in the free space of the buffer.
+ *
+ * @param fd The file descriptor to read from.
+ * @return The result of readv(2): the number of bytes read, 0 at end of file
+ * or -1 on error. 0 is also returned, without reading, if the buffer is full.
+ */
+ssize_t RingBuffer::readFrom(int fd)
+{
+	if (size_ == capacity_)
+		return 0;
+	if (data_.empty())
+		data_.resize(capacity_);
+	size_t		 tail = (head_ + size_) % capacity_;
+	struct iovec segments[2];
+	int			 count(1);
+	segments[0].iov_base = &data_[tail];
+	if (tail >= head_)
+	{
+		segments[0].iov_len = capacity_ - tail;
+		if (head_ > 0)
+		{
+			segments[1].iov_base = &data_[0];
+			segments[1].iov_len = head_;
+			count = 2;
+		}
+	}
+	else
+		segments[0].iov_len = head_ - tail;
+	ssize_t bytesRead = readv(fd, segments, count);
+	if (bytesRead > 0)
+		size_ += bytesRead;
+	return bytesRead;
+}
+
+/**
+ * @brief Gets the first contiguous segment of buffered bytes.
+ *
+ * @param length Set to the length of the segment, 0 if the buffer is empty.
+ * @return A pointer to the segment, valid until the next readFrom() or clear().
+ */
+char const *RingBuffer::peek(size_t &length) const
+{
+	length = size_;
+	if (size_ == 0)
+		return NULL;
+	if (head_ + size_ > capacity_)
+		length = capacity_ - head_;
+	return &data_[head_];
+}
+
+/**
+ * @brief Drops bytes from the front of the buffer.
+ *
+ * @param length The number of bytes, at most getSize().
+ */
+void RingBuffer::consume(size_t length)
+{
+	if (length >= size_)
+	{
+		clear();
+		return;
+	}
+	head_ = (head_ + length) % capacity_;
+	size_ -= length;
+}
+
+// Restarts at the beginning of the storage, so the next read is contiguous.
+void RingBuffer::clear(void)
+{
+	head_ = 0;
+	size_ = 0;
+}
+
+size_t RingBuffer::getSize(void) const
+{
+	return size_;
+}
+
+size_t RingBuffer::getFreeSpace(void) const
+{
+	return capacity_ - size_;
+}
+
+bool RingBuffer::isEmpty(void) const
+{
+	return size_ == 0;
+}
@@ -8,6 +8,8 @@
 #include <netdb.h>
 #include <unistd.h>
 
+bool Server::reusePort_ = false;
+
 Server::Server(
 	std::map<std::string, ConfigValue> const &server,
 	unsigned int							  index,
@@ -20,6 +22,16 @@ Server::Server(
 	  clientMaxBodySize_(
 		  ft::stringToULong(server.at("client_max_body_size").getVectorValue(0))
 	  ),
+	  keepAliveTimeout_(
+		  ft::timeToMs(server.at("keepalive_timeout").getVectorValue(0))
+	  ),
+	  clientHeaderTimeout_(
+		  ft::timeToMs(server.at("client_header_timeout").getVectorValue(0))
+	  ),
+	  clientBodyTimeout_(
+		  ft::timeToMs(server.at("client_body_timeout").getVectorValue(0))
+	  ),
+	  sendTimeout_(ft::timeToMs(server.at("send_timeout").getVectorValue(0))),
 	  root_(const_cast<std::string &>(server.at("root").getVectorValue(0))),
 	  index_(
 		  const_cast<std::vector<std::string> &>(server.at("index").getVector())
@@ -34,7 +46,11 @@ Server::Server(
 
 Server::Server(const Server &src)
 	: port_(src.port_), ipV4_(src.ipV4_),
-	  clientMaxBodySize_(src.clientMaxBodySize_), root_(src.root_),
+	  clientMaxBodySize_(src.clientMaxBodySize_),
+	  keepAliveTimeout_(src.keepAliveTimeout_),
+	  clientHeaderTimeout_(src.clientHeaderTimeout_),
+	  clientBodyTimeout_(src.clientBodyTimeout_), sendTimeout_(src.sendTimeout_),
+	  root_(src.root_),
 	  index_(src.index_), serverName_(src.serverName_),
 	  serverConfig_(src.serverConfig_), serverIndex_(src.serverIndex_),
 	  serverFd_(src.serverFd_), serverAddr_(src.serverAddr_)
@@ -48,6 +64,10 @@ Server &Server::operator=(const Server &src)
 		port_ = src.port_;
 		ipV4_ = src.ipV4_;
 		clientMaxBodySize_ = src.clientMaxBodySize_;
+		keepAliveTimeout_ = src.keepAliveTimeout_;
+		clientHeaderTimeout_ = src.clientHeaderTimeout_;
+		clientBodyTimeout_ = src.clientBodyTimeout_;
+		sendTimeout_ = src.sendTimeout_;
 		root_ = src.root_;
 		index_ = src.index_;
 		serverName_ = src.serverName_;
@@ -93,9 +113,21 @@ void Server::resetServer(void)
 	init();
 }
 
+void Server::setReusePort(bool reusePort)
+{
+	reusePort_ = reusePort;
+}
+
 void Server::createSocket_()
 {
+	// Non-blocking, and not inherited by the CGI scripts another reactor
+	// thread spawns
+#ifdef LINUX
+	this->serverFd_
+		= socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+#else
 	this->serverFd_ = socket(AF_INET, SOCK_STREAM, 0);
+#endif
 	if (this->serverFd_ == -1)
 		throw ServerException(
 			"Failed to create socket on the Server[%]",
@@ -105,7 +137,7 @@ void Server::createSocket_()
 
 	try
 	{
-		// Set the socket to non-blocking mode
+#ifndef LINUX
 		int flags = fcntl(serverFd_, F_GETFL, 0);
 		if (flags == -1)
 			throw ServerException(
@@ -113,12 +145,14 @@ void Server::createSocket_()
 				errno,
 				ft::toString(serverIndex_)
 			);
-		if (fcntl(serverFd_, F_SETFL, flags | O_NONBLOCK) == -1)
+		if (fcntl(serverFd_, F_SETFL, flags | O_NONBLOCK) == -1
+			|| fcntl(serverFd_, F_SETFD, FD_CLOEXEC) == -1)
 			throw ServerException(
 				"Failed to set socket flags on the Server[%]",
 				errno,
 				ft::toString(serverIndex_)
 			);
+#endif
 
 		// Set the SO_REUSEADDR option, allowing the server to bind to an
 		// address that is already in use.
@@ -132,6 +166,20 @@ void Server::createSocket_()
 				errno,
 				ft::toString(serverIndex_)
 			);
+#ifdef SO_REUSEPORT
+		// Set the SO_REUSEPORT option when running several workers, each
+		// worker binds its own socket to the same address and the kernel
+		// spreads the incoming connections between them.
+		if (reusePort_
+			&& setsockopt(
+				   serverFd_, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof(optval)
+			   ) == -1)
+			throw ServerException(
+				"Failed to set socket option REUSEPORT on the Server[%]",
+				errno,
+				ft::toString(serverIndex_)
+			);
+#endif
 		// Set the SO_KEEPALIVE option, enabling the server to send keepalive
 		// messages on the connection to detect a dead peer and close the
 		// connection.
@@ -244,6 +292,26 @@ unsigned long Server::getClientMaxBodySize(void) const
 	return clientMaxBodySize_;
 }
 
+unsigned long Server::getKeepAliveTimeout(void) const
+{
+	return keepAliveTimeout_;
+}
+
+unsigned long Server::getClientHeaderTimeout(void) const
+{
+	return clientHeaderTimeout_;
+}
+
+unsigned long Server::getClientBodyTimeout(void) const
+{
+	return clientBodyTimeout_;
+}
+
+unsigned long Server::getSendTimeout(void) const
+{
+	return sendTimeout_;
+}
+
 std::string Server::getRoot(void) const
 {
 	return root_;
@@ -360,7 +428,7 @@ bool Server::getThisLocationValue(
 }
 
 // clang-format off
-std::map<std::string, std::vector<std::string> > const
+std::map<std::string, std::vector<std::string> > const &
 // clang-format on
 Server::getThisLocation(std::string const &location) const
 {
@@ -380,12 +448,11 @@ Server::getThisLocation(std::string const &location) const
 
 		it = serverConfig_.find(tmp);
 	}
+	// clang-format off
+	static std::map<std::string, std::vector<std::string> > const noLocation;
+	// clang-format on
 	if (it == serverConfig_.end())
-	{
-		// clang-format off
-		return std::map<std::string, std::vector<std::string> >();
-		// clang-format on
-	}
+		return noLocation;
 	return it->second.getMap();
 }
 
@@ -2,7 +2,6 @@
 #include "HttpErrorHandler.hpp"
 #include "HttpMethodHandler.hpp"
 #include "Logger.hpp"
-#include "request_parser/RequestParser.hpp"
 #include "utils.hpp"
 
 #include <csignal>
@@ -21,17 +20,21 @@
  * Initializes the ServerEngine with the given server configurations.
  *
  * @param servers A vector of maps containing server configurations.
+ * @param backend The event backend used to wait for I/O readiness.
  */
 ServerEngine::ServerEngine(
 	// clang-format off
-	std::vector<std::map<std::string, ConfigValue> > const &servers
+	std::vector<std::map<std::string, ConfigValue> > const &servers,
 	// clang-format on
+	EventPoller::Backend backend
 )
-	: numServers_(servers.size())
+	: numServers_(servers.size()), poller_(backend), pool_(NULL),
+	  reactorIndex_(0), stealRequested_(false)
 {
 	Logger::log(Logger::INFO)
 		<< "Initializing the Server Engine with " << this->numServers_
-		<< " servers..." << std::endl;
+		<< " servers (" << EventPoller::getBackendName(poller_.getBackend())
+		<< ")..." << std::endl;
 	size_t globalServerIndex(0);
 	for (size_t serverIndex = 0; serverIndex < this->numServers_; ++serverIndex)
 	{
@@ -45,10 +48,6 @@ ServerEngine::ServerEngine(
 		this->initServer_(servers[serverIndex], serverIndex, globalServerIndex);
 	}
 	this->totalServerInstances_ = globalServerIndex;
-
-	pollIndex_ = 0;
-	clients_.clear();
-	clientIndex_ = 0;
 }
 
 /**
@@ -60,13 +59,10 @@ ServerEngine::~ServerEngine()
 {
 	Logger::log(Logger::INFO)
 		<< "Shutting down the server engine." << std::endl;
-	for (size_t i = 0; i < pollFds_.size(); ++i)
+	for (size_t slot = 0; slot < connections_.getCapacity(); ++slot)
 	{
-		if (!this->isPollFdServer_(pollFds_[i].fd) && pollFds_[i].fd != -1)
-		{
-			close(pollFds_[i].fd);
-			pollFds_[i].fd = -1;
-		}
+		if (connections_.isActive(slot) && connections_.get(slot).getFd() != -1)
+			close(connections_.get(slot).getFd());
 	}
 }
 
@@ -102,72 +98,115 @@ void ServerEngine::initServer_(
 /**
  * @brief Restarts a server instance.
  *
- * Closes and reinitializes the server file descriptor, then updates the
- * pollFds_ vector.
+ * Closes and reinitializes the server file descriptor, then registers the new
+ * file descriptor in the poller and the fd table.
  *
- * @param pollIndex_ The index of the server to restart.
+ * @param serverIndex The index of the server to restart.
  */
-void ServerEngine::restartServer_(size_t &pollIndex_)
+void ServerEngine::restartServer_(size_t serverIndex)
 {
 	Logger::log(Logger::INFO)
-		<< "Restarting server[" << pollIndex_ << "]" << std::endl;
-	this->servers_[pollIndex_].resetServer();
-	pollfd serverPollFd = {servers_[pollIndex_].getServerFd(), POLLIN, 0};
-	pollFds_[pollIndex_] = serverPollFd;
+		<< "Restarting server[" << serverIndex << "]" << std::endl;
+	int oldFd = this->servers_[serverIndex].getServerFd();
+	poller_.remove(oldFd);
+	setFdEntry_(oldFd, FdEntry::NONE, 0);
+	this->servers_[serverIndex].resetServer();
+	poller_.add(servers_[serverIndex].getServerFd(), POLLIN);
+	setFdEntry_(
+		servers_[serverIndex].getServerFd(), FdEntry::LISTENER, serverIndex
+	);
 	Logger::log(Logger::INFO)
-		<< "Server[" << pollIndex_ << "] restarted" << std::endl;
+		<< "Server[" << serverIndex << "] restarted" << std::endl;
 }
 
 /**
- * @brief Initializes the pollFds_ vector with server file descriptors.
+ * @brief Registers the server file descriptors in the event poller.
  */
 void ServerEngine::initServerPollFds_(void)
 {
-	pollFds_.clear();
-	pollFds_.reserve(this->totalServerInstances_);
-
 	Logger::log(Logger::DEBUG)
-		<< "Initializing pollFds_ vector with ServerFds" << std::endl;
+		<< "Registering the ServerFds in the event poller" << std::endl;
 
 	for (size_t i = 0; i < this->totalServerInstances_; ++i)
 	{
-		pollfd serverPollFd = {servers_[i].getServerFd(), POLLIN, 0};
-		pollFds_.push_back(serverPollFd);
+		poller_.add(servers_[i].getServerFd(), POLLIN);
+		setFdEntry_(servers_[i].getServerFd(), FdEntry::LISTENER, i);
 	}
 }
 
 /**
- * @brief Checks if a file descriptor belongs to a server.
+ * @brief Records what a file descriptor is used for.
  *
- * @param fd The file descriptor to check.
- * @return true if the file descriptor belongs to a server, false otherwise.
+ * @param fd The file descriptor.
+ * @param type Whether the fd is a listening socket, a client or unused.
+ * @param index The index of the Server or the slot of the Client owning the fd.
  */
-bool ServerEngine::isPollFdServer_(int &fd)
+void ServerEngine::setFdEntry_(int fd, FdEntry::Type type, size_t index)
 {
-	for (size_t i = 0; i < this->totalServerInstances_; ++i)
+	if (fd < 0)
+		return;
+	if ((size_t)fd >= fdTable_.size())
+	{
+		FdEntry empty = {FdEntry::NONE, 0};
+		fdTable_.resize(fd + 1, empty);
+	}
+	fdTable_[fd].type = type;
+	fdTable_[fd].index = index;
+}
+
+/**
+ * @brief Looks up what a file descriptor is used for.
+ *
+ * @param fd The file descriptor.
+ * @return The fd table entry, with type NONE if the fd is not watched.
+ */
+ServerEngine::FdEntry ServerEngine::getFdEntry_(int fd) const
+{
+	if (fd < 0 || (size_t)fd >= fdTable_.size())
 	{
-		if (fd == this->servers_[i].getServerFd())
-			return true;
+		FdEntry empty = {FdEntry::NONE, 0};
+		return empty;
 	}
-	return false;
+	return fdTable_[fd];
+}
+
+/**
+ * @brief Gets the client owning a file descriptor.
+ *
+ * @param fd The client file descriptor, it must be a CLIENT entry.
+ * @return A reference to the client, valid until the connection is closed.
+ */
+Client &ServerEngine::getClient_(int fd)
+{
+	return connections_.get(fdTable_[fd].index);
 }
 
 /**
  * @brief Accepts a new client connection.
  *
- * @param pollIndex_ The index of the server in the pollFds_ vector.
+ * @param serverIndex The index of the listening server in servers_.
  */
-void ServerEngine::acceptConnection_(size_t &pollIndex_)
+void ServerEngine::acceptConnection_(size_t serverIndex)
 {
 	Logger::log(Logger::DEBUG) << "Accepting client connection on the server["
-							   << pollIndex_ << ']' << std::endl;
-	sockaddr_in serverAddr = this->servers_[pollIndex_].getServerAddr();
+							   << serverIndex << ']' << std::endl;
+	sockaddr_in serverAddr = this->servers_[serverIndex].getServerAddr();
 	int			addrLen = sizeof(serverAddr);
-	int			clientFd = accept(
-		this->servers_[pollIndex_].getServerFd(),
+	// The client sockets are not inherited by the CGI scripts
+#ifdef LINUX
+	int clientFd = accept4(
+		this->servers_[serverIndex].getServerFd(),
+		(struct sockaddr *)&serverAddr,
+		(socklen_t *)&addrLen,
+		SOCK_CLOEXEC | SOCK_NONBLOCK
+	);
+#else
+	int clientFd = accept(
+		this->servers_[serverIndex].getServerFd(),
 		(struct sockaddr *)&serverAddr,
 		(socklen_t *)&addrLen
 	);
+#endif
 	if (clientFd < 0)
 	{
 		if (errno != EWOULDBLOCK && errno != EAGAIN)
@@ -180,6 +219,7 @@ void ServerEngine::acceptConnection_(size_t &pollIndex_)
 	}
 	Logger::log(Logger::DEBUG) << "Client connection accepted" << std::endl;
 
+#ifndef LINUX
 	int flags = fcntl(clientFd, F_GETFL, 0);
 	if (flags == -1)
 	{
@@ -189,7 +229,8 @@ void ServerEngine::acceptConnection_(size_t &pollIndex_)
 		close(clientFd);
 		return;
 	}
-	if (fcntl(clientFd, F_SETFL, flags | O_NONBLOCK) == -1)
+	if (fcntl(clientFd, F_SETFL, flags | O_NONBLOCK) == -1
+		|| fcntl(clientFd, F_SETFD, FD_CLOEXEC) == -1)
 	{
 		Logger::log(Logger::ERROR)
 			<< "Failed to set client socket flags: (" << ft::toString(errno)
@@ -199,81 +240,91 @@ void ServerEngine::acceptConnection_(size_t &pollIndex_)
 	}
 	Logger::log(Logger::DEBUG)
 		<< "Client socket set to non-blocking mode" << std::endl;
+#endif
 
-	pollfd clientPollFd = {clientFd, POLLIN, 0};
-	pollFds_.push_back(clientPollFd);
-	Logger::log(Logger::DEBUG) << "Client connection added to pollFds_["
-							   << pollIndex_ << "]" << std::endl;
+	if (!poller_.add(clientFd, POLLIN))
+	{
+		close(clientFd);
+		return;
+	}
+	Logger::log(Logger::DEBUG) << "Client connection Fd[" << clientFd
+							   << "] added to the event poller" << std::endl;
 
-	Client client(clientPollFd.fd);
-	clients_.push_back(client);
+	size_t slot = connections_.acquire(clientFd, serverIndex);
+	setFdEntry_(clientFd, FdEntry::CLIENT, slot);
+	armTimer_(slot, HEADER_TIMER);
 	Logger::log(Logger::DEBUG)
-		<< "Client added to clients_[" << clientIndex_ << "]" << std::endl;
+		<< "Client added to the connection slot " << slot << std::endl;
 }
 
 /**
- * @brief Handles errors on a poll file descriptor.
+ * @brief Handles errors on a watched file descriptor.
  *
  * Logs the error and closes the connection if necessary.
  *
- * @param pollIndex_ The index of the poll file descriptor.
+ * @param fd The file descriptor reporting the error.
+ * @param revents The events reported by the poller.
  */
-void ServerEngine::pollFdError_(size_t &pollIndex_)
+void ServerEngine::pollFdError_(int fd, short revents)
 {
 	std::string error("");
-	if (pollFds_[pollIndex_].revents & POLLERR)
+	if (revents & POLLERR)
 		error += "|POLLERR|";
-	if (pollFds_[pollIndex_].revents & POLLHUP)
+	if (revents & POLLHUP)
 		error += "|POLLHUP|";
-	if (pollFds_[pollIndex_].revents & POLLNVAL)
+	if (revents & POLLNVAL)
 		error += "|POLLNVAL|";
 
 	int			err = errno;
 	std::string errMsg = strerror(err);
 	Logger::log(Logger::DEBUG)
-		<< "Client disconnected improperly: " << error << " on pollFds_["
-		<< pollIndex_ << "]" << ", Fd[" << pollFds_[pollIndex_].fd
+		<< "Client disconnected improperly: " << error << " on Fd[" << fd
 		<< "] , errno: " << err << ", " << errMsg << std::endl;
 
-	if (!this->isPollFdServer_(this->pollFds_[pollIndex_].fd)
+	FdEntry entry = getFdEntry_(fd);
+	if (entry.type == FdEntry::CLIENT
 		&& error.find("POLLNVAL") != std::string::npos)
 	{
 		Logger::log(Logger::DEBUG)
 			<< "pollFdError_: Error is POLLNVAL Closing and deleting client "
-			   "socket: pollFds_["
-			<< pollIndex_ << "]: " << pollFds_[pollIndex_].fd << std::endl;
-		closeConnection_(pollIndex_);
+			   "socket: Fd["
+			<< fd << "]" << std::endl;
+		closeConnection_(fd);
 		return;
 	}
-	else if (!this->isPollFdServer_(this->pollFds_[pollIndex_].fd))
+	else if (entry.type == FdEntry::CLIENT)
 	{
 		Logger::log(Logger::DEBUG)
-			<< "Closing and deleting client socket: pollFds_[" << pollIndex_
-			<< "]: " << pollFds_[pollIndex_].fd << std::endl;
-		closeConnection_(pollIndex_);
+			<< "Closing and deleting client socket: Fd[" << fd << "]"
+			<< std::endl;
+		closeConnection_(fd);
 	}
-	else
-		restartServer_(pollIndex_);
+	else if (entry.type == FdEntry::LISTENER)
+		restartServer_(entry.index);
 }
 
 /**
  * @brief Initializes poll events.
  *
- * Calls the poll function to wait for events on the file descriptors.
+ * Waits on the event poller for events on the file descriptors.
+ *
+ * @param timeout The longest wait in milliseconds, until the next timer.
  */
-long int ServerEngine::initializePollEvents_()
+long int ServerEngine::initializePollEvents_(int timeout)
 {
-	int pollCount = poll(pollFds_.data(), pollFds_.size(), POLL_TIMEOUT);
+	int pollCount = poller_.wait(timeout);
 	if (pollCount == -1)
 	{
-		if (g_shutdown)
+		int signalNumber = __atomic_load_n(&g_shutdown, __ATOMIC_SEQ_CST);
+		if (signalNumber != 0)
 		{
 			Logger::log(Logger::INFO)
-				<< "Shutdown signal received, exiting poll..." << std::endl;
+				<< "Signal " << signalNumber << " received, exiting poll..."
+				<< std::endl;
 			return pollCount;
 		}
 		Logger::log(Logger::ERROR)
-			<< "initializePollEvents: poll() failed: (" << ft::toString(errno)
+			<< "initializePollEvents: wait() failed: (" << ft::toString(errno)
 			<< ") " << strerror(errno) << std::endl;
 		return pollCount;
 	}
@@ -285,24 +336,45 @@ long int ServerEngine::initializePollEvents_()
  *
  * Reads data from the client buffer and processes it.
  *
- * @param pollIndex_ The index of the client in the pollFds_ vector.
+ * @param fd The client file descriptor.
  */
-void ServerEngine::readClientRequest_(size_t &pollIndex_)
+void ServerEngine::readClientRequest_(int fd)
 {
-	Logger::log(Logger::DEBUG) << "Reading client request at pollFds_["
-							   << pollIndex_ << ']' << std::endl;
+	Logger::log(Logger::DEBUG)
+		<< "Reading client request at Fd[" << fd << ']' << std::endl;
 
+	size_t	slot = fdTable_[fd].index;
+	Client &client = getClient_(fd);
+	if (client.getCgi() != NULL)
+	{
+		// POLLIN hides POLLOUT: the output of the script is written too
+		if (feedCgiBody_(fd) && client.hasPendingOutput())
+			writeClientOutput_(fd);
+		return;
+	}
 	try
 	{
-		if (clients_[clientIndex_].hasRequestReady() == false)
+		if (client.hasRequestReady() == false)
 		{
-			if (clients_[clientIndex_].isClosed() == true)
+			if (client.isClosed() == true)
 			{
 				Logger::log(Logger::DEBUG)
-					<< "readClientRequest_: Client disconnected: clients_["
-					<< clientIndex_ << "], " << " pollFds_[" << pollIndex_
+					<< "readClientRequest_: Client disconnected: Fd[" << fd
 					<< "]" << std::endl;
 			}
+			else if (client.isBodyHeld())
+			{
+				// A body not streamed is framed from the bytes already read
+				if (!streamCgiBody_(fd))
+					readClientRequest_(fd);
+				return;
+			}
+			else if (client.areHeadersRead())
+				armTimer_(slot, BODY_TIMER);
+			// The first bytes of a request end the keep-alive wait
+			else if (!timers_.isScheduled(slot)
+					 || timers_.getKind(slot) == KEEPALIVE_TIMER)
+				armTimer_(slot, HEADER_TIMER);
 			return;
 		}
 	}
@@ -310,13 +382,13 @@ void ServerEngine::readClientRequest_(size_t &pollIndex_)
 	{
 		Logger::log(Logger::DEBUG)
 			<< "readClientRequest_: Client.hasRequestReady resulted in error: "
-			<< e.what() << " for pollIndex_:" << pollIndex_ << std::endl;
+			<< e.what() << " for Fd[" << fd << "]" << std::endl;
 	}
 
-	pollFds_[pollIndex_].events = POLLOUT;
-	Logger::log(Logger::DEBUG)
-		<< "Read complete client request at pollFds_[" << pollIndex_
-		<< "] and set it to POLLOUT" << std::endl;
+	poller_.modify(fd, POLLOUT);
+	armTimer_(slot, SEND_TIMER);
+	Logger::log(Logger::DEBUG) << "Read complete client request at Fd[" << fd
+							   << "] and set it to POLLOUT" << std::endl;
 }
 
 /**
@@ -324,34 +396,33 @@ void ServerEngine::readClientRequest_(size_t &pollIndex_)
  *
  * Processes the client request and sends the appropriate response.
  *
- * @param pollIndex_ The index of the client in the pollFds_ vector.
+ * @param fd The client file descriptor.
  */
-void ServerEngine::processClientRequest_(size_t &pollIndex_)
+void ServerEngine::processClientRequest_(int fd)
 {
-	HttpRequest *request = NULL;
-	std::string	 response;
-	if (clients_[clientIndex_].isError() == true
-		|| clients_[clientIndex_].isClosed() == true)
+	HttpRequest	*request = NULL;
+	HttpResponse response;
+	Client		&client = getClient_(fd);
+	if (client.isError() == true || client.isClosed() == true)
 	{
 		Logger::log(Logger::DEBUG)
 			<< "processClientRequest_ got to request with error or closed. "
 			<< std::endl;
-		response = HttpErrorHandler::getErrorPage(400, true);
-		sendResponse_(pollIndex_, response);
+		response = HttpErrorHandler::getErrorPage(client.getErrorCode(), true);
+		sendResponse_(fd, response);
 		return;
 	}
 
 	try
 	{
-		std::string request_str = clients_[clientIndex_].extractRequestStr();
-		request = new HttpRequest(RequestParser::parseRequest(request_str));
+		request = client.extractRequest();
 	}
 	catch (std::exception &e)
 	{
 		response = HttpErrorHandler::getErrorPage(400, true);
 		Logger::log(Logger::DEBUG)
 			<< "Failed to parse the request: " << e.what() << std::endl;
-		sendResponse_(pollIndex_, response);
+		sendResponse_(fd, response);
 		return;
 	}
 
@@ -376,14 +447,25 @@ void ServerEngine::processClientRequest_(size_t &pollIndex_)
 					<< std::endl;
 
 				response = HttpErrorHandler::getErrorPage(400, true);
-				clients_[clientIndex_].setIsClosed(true);
-				sendResponse_(pollIndex_, response);
+				client.setIsClosed(true);
+				sendResponse_(fd, response);
 				delete request;
 				return;
 			}
 		}
-		response = createResponse(*request);
-		sendResponse_(pollIndex_, response);
+		if (pool_ != NULL && postHeavyRequest_(fd, *request))
+		{
+			delete request;
+			return;
+		}
+		CgiProcess *cgi = NULL;
+		response = createResponse(*request, &cgi);
+		if (cgi != NULL)
+		{
+			startCgi_(fd, cgi, request);
+			return;
+		}
+		sendResponse_(fd, response);
 		delete request;
 	}
 }
@@ -391,89 +473,136 @@ void ServerEngine::processClientRequest_(size_t &pollIndex_)
 /**
  * @brief Sends the response to the client.
  *
- * Sends the prepared response to the client.
+ * Queues the head and the body of the response on the client as separate
+ * segments and writes what the socket takes at once. The rest is written by
+ * writeClientOutput_ on the next POLLOUT events.
  *
- * @param pollIndex_ The index of the client in the pollFds_ vector.
- * @param response The response string to be sent to the client.
+ * @param fd The client file descriptor.
+ * @param response The response, whose body is moved to the output queue.
  */
-void ServerEngine::sendResponse_(
-	size_t			  &pollIndex_,
-	const std::string &response
-)
+void ServerEngine::sendResponse_(int fd, HttpResponse &response)
 {
 	Logger::log(Logger::DEBUG) << "Sending response: " << std::endl;
-	int retCode
-		= send(pollFds_[pollIndex_].fd, response.c_str(), response.size(), 0);
+	response.moveTo(getClient_(fd).getOutput());
+	writeClientOutput_(fd);
+}
+
+/**
+ * @brief Writes the pending output of a client.
+ *
+ * While output is pending the client is only watched for POLLOUT, so no new
+ * request is read and the memory of a connection stays bounded. The send
+ * timeout is restarted whenever the client takes some bytes. Once the queue
+ * is drained the connection is closed or waits for its next request.
+ *
+ * @param fd The client file descriptor.
+ */
+void ServerEngine::writeClientOutput_(int fd)
+{
+	Client &client = getClient_(fd);
+	size_t	slot = fdTable_[fd].index;
+	ssize_t written = client.getOutput().writeTo(fd);
 
-	if (retCode < 0)
+	if (written < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
 	{
 		Logger::log(Logger::ERROR)
 			<< "Failed to send response to client: (" << ft::toString(errno)
 			<< ") " << strerror(errno) << std::endl;
 		Logger::log(Logger::DEBUG)
-			<< "Erase clients_[" << clientIndex_ << "], "
-			<< "close and erase pollFds_[" << pollIndex_ << "]" << std::endl;
-		closeConnection_(pollIndex_);
+			<< "Close and erase client Fd[" << fd << "]" << std::endl;
+		closeConnection_(fd);
 	}
-	else if (retCode == 0)
+	else if (client.getCgi() != NULL && client.hasPendingOutput())
+		watchCgiClient_(slot);
+	else if (client.hasPendingOutput())
 	{
+		// A full socket buffer is not a disconnection: wait for POLLOUT
 		Logger::log(Logger::DEBUG)
-			<< "Client disconnected: clients_[" << clientIndex_
-			<< "] disconnected" << std::endl;
+			<< "Fd[" << fd << "] has " << client.getOutput().getSize()
+			<< " bytes left to send" << std::endl;
+		poller_.modify(fd, POLLOUT);
+		if (written > 0)
+			armTimer_(slot, SEND_TIMER);
+	}
+	else if (client.getCgi() != NULL)
+		endCgiResponse_(slot);
+	else if (client.isClosed() || client.isError())
+	{
+		Logger::log(Logger::DEBUG) << "writeClientOutput_: Client is closed "
+									  "or has error. Closing connection."
+								   << std::endl;
+		closeConnection_(fd);
+	}
+	else if (servers_[connections_.getServer(slot)].getKeepAliveTimeout() == 0)
+	{
 		Logger::log(Logger::DEBUG)
-			<< "Erase clients_[" << clientIndex_ << "], "
-			<< "close and erase pollFds_[" << pollIndex_ << "]" << std::endl;
-		closeConnection_(pollIndex_);
+			<< "writeClientOutput_: keep-alive is disabled. Closing connection."
+			<< std::endl;
+		closeConnection_(fd);
 	}
 	else
 	{
-		if (clients_[clientIndex_].isClosed()
-			|| clients_[clientIndex_].isError())
-		{
-			Logger::log(Logger::DEBUG) << "sendResponse_: Client is closed or "
-										  "has error. Closing connection."
-									   << std::endl;
-			closeConnection_(pollIndex_);
-		}
-		else
-		{
-			pollFds_[pollIndex_].events = POLLIN;
-		}
+		poller_.modify(fd, POLLIN);
+		armTimer_(slot, KEEPALIVE_TIMER);
+		// A pipelined request already read will not trigger POLLIN
+		if (client.hasBufferedInput())
+			readClientRequest_(fd);
 	}
 }
 
 /**
  * @brief Processes poll events.
  *
- * Iterates through the pollFds_ vector and handles events for each file
- * descriptor.
+ * Iterates through the ready events reported by the poller and dispatches each
+ * of them through the fd table. Idle connections are never visited.
  */
 void ServerEngine::processPollEvents_()
 {
-	for (pollIndex_ = 0; pollIndex_ < pollFds_.size(); pollIndex_++)
+	for (size_t i = 0; i < poller_.getEventCount(); ++i)
 	{
-		clientIndex_ = pollIndex_ - totalServerInstances_;
-		Logger::log(Logger::DEBUG)
-			<< "clientIndex is set to " << clientIndex_ << std::endl;
+		EventPoller::Event const &event = poller_.getEvent(i);
+		FdEntry					  entry = getFdEntry_(event.fd);
 
-		if (pollFds_[pollIndex_].revents & (POLLERR | POLLHUP | POLLNVAL))
+		// The fd may have been closed while handling a previous event.
+		if (entry.type == FdEntry::NONE)
+			continue;
+		if (entry.type == FdEntry::WAKEUP)
+		{
+			handleWakeup_();
+			continue;
+		}
+		if (entry.type == FdEntry::FILE_EVENTS)
 		{
-			pollFdError_(pollIndex_);
+			HttpMethodHandler::getOpenFileCache().readEvents();
+			continue;
 		}
-		else if (pollFds_[pollIndex_].revents & POLLIN)
+		// A hung up pipe still holds the last output of the script
+		if (entry.type == FdEntry::CGI_INPUT
+			|| entry.type == FdEntry::CGI_OUTPUT
+			|| entry.type == FdEntry::CGI_EXIT)
 		{
-			Logger::log(Logger::DEBUG) << "pollFds_[" << pollIndex_
-									   << "] is ready for read" << std::endl;
-			if (this->isPollFdServer_(pollFds_[pollIndex_].fd))
-				acceptConnection_(pollIndex_);
+			handleCgiEvent_(event.fd, entry);
+			continue;
+		}
+		if (event.revents & (POLLERR | POLLHUP | POLLNVAL))
+		{
+			pollFdError_(event.fd, event.revents);
+		}
+		else if (event.revents & POLLIN)
+		{
+			Logger::log(Logger::DEBUG)
+				<< "Fd[" << event.fd << "] is ready for read" << std::endl;
+			if (entry.type == FdEntry::LISTENER)
+				acceptConnection_(entry.index);
 			else
-			{
-				readClientRequest_(pollIndex_);
-			}
+				readClientRequest_(event.fd);
 		}
-		else if (pollFds_[pollIndex_].revents & POLLOUT)
+		else if (event.revents & POLLOUT && entry.type == FdEntry::CLIENT)
 		{
-			processClientRequest_(pollIndex_);
+			if (getClient_(event.fd).hasPendingOutput())
+				writeClientOutput_(event.fd);
+			else
+				processClientRequest_(event.fd);
 		}
 	}
 }
@@ -481,16 +610,24 @@ void ServerEngine::processPollEvents_()
 /**
  * @brief Starts the server engine.
  *
- * Initializes the server poll file descriptors and enters the main event loop.
+ * Registers the server file descriptors, and the one telling which cached
+ * files changed, and enters the main event loop.
  */
 void ServerEngine::start()
 {
 	Logger::log(Logger::INFO) << "Starting the Server Engine." << std::endl;
 	this->initServerPollFds_();
+	int fileEventFd = HttpMethodHandler::getOpenFileCache().getEventFd();
+	if (fileEventFd != -1 && poller_.add(fileEventFd, POLLIN))
+		setFdEntry_(fileEventFd, FdEntry::FILE_EVENTS, 0);
 
-	while (!g_shutdown)
+	while (!__atomic_load_n(&g_shutdown, __ATOMIC_SEQ_CST))
 	{
-		long int pollEvents = initializePollEvents_();
+		// While jobs are being stolen the loop only peeks at the sockets
+		int		 timeout = stealRequested_
+							   ? 0
+							   : timers_.getNextTimeout(POLL_TIMEOUT_MAX);
+		long int pollEvents = initializePollEvents_(timeout);
 		if (pollEvents > 0)
 		{
 			Logger::log(Logger::DEBUG)
@@ -498,6 +635,517 @@ void ServerEngine::start()
 				<< std::endl;
 			processPollEvents_();
 		}
+		expireTimers_();
+		// An idle reactor runs heavy jobs, one per iteration: its own, or
+		// ones stolen from a busy reactor.
+		if (pool_ != NULL && (pollEvents == 0 || stealRequested_))
+			stealRequested_ = pool_->runJob(reactorIndex_);
+	}
+}
+
+/**
+ * @brief Makes the engine one of the reactors of a ReactorPool.
+ *
+ * @param pool The pool the engine belongs to.
+ * @param reactorIndex The index of the engine in the pool.
+ */
+void ServerEngine::attachReactorPool(ReactorPool *pool, size_t reactorIndex)
+{
+	pool_ = pool;
+	reactorIndex_ = reactorIndex;
+	int wakeupFd = pool_->getWakeupFd(reactorIndex_);
+	poller_.add(wakeupFd, POLLIN);
+	setFdEntry_(wakeupFd, FdEntry::WAKEUP, reactorIndex_);
+}
+
+/**
+ * @brief Posts a CGI or directory listing request to the reactor pool.
+ *
+ * The client is not watched until its response comes back in handleWakeup_.
+ *
+ * @param fd The client file descriptor.
+ * @param request The parsed request.
+ * @return true if the request was posted, false if it must be run inline.
+ */
+bool ServerEngine::postHeavyRequest_(int fd, HttpRequest const &request)
+{
+	int serverIndex = findServer_(request.getHost(), request.getPort());
+	if (serverIndex == -1
+		|| !HttpMethodHandler::isHeavyRequest(request, servers_[serverIndex]))
+		return false;
+
+	ReactorPool::Job *job = new ReactorPool::Job(
+		reactorIndex_,
+		fd,
+		connections_.getId(fdTable_[fd].index),
+		request,
+		&servers_[serverIndex]
+	);
+	poller_.modify(fd, 0);
+	timers_.cancel(fdTable_[fd].index);
+	pool_->postJob(job);
+	Logger::log(Logger::DEBUG)
+		<< "Fd[" << fd << "] posted a job to the reactor pool" << std::endl;
+	return true;
+}
+
+/**
+ * @brief Sends the responses of the finished jobs of this reactor.
+ *
+ * A job whose connection closed in the meantime is dropped, even if its fd
+ * has been reused. A wakeup is also a hint that a job may be waiting to be
+ * stolen.
+ */
+void ServerEngine::handleWakeup_(void)
+{
+	pool_->clearWakeup(reactorIndex_);
+	stealRequested_ = true;
+
+	ReactorPool::Job *job;
+	while ((job = pool_->popCompletedJob(reactorIndex_)) != NULL)
+	{
+		FdEntry entry = getFdEntry_(job->clientFd);
+		if (entry.type == FdEntry::CLIENT
+			&& connections_.getId(entry.index) == job->connectionId)
+			sendResponse_(job->clientFd, job->response);
+		delete job;
+	}
+}
+
+/**
+ * @brief Runs a CGI request as soon as its headers are read, streaming its
+ * body to the script.
+ *
+ * Only a body with a Content-Length is streamed, as the script is told its
+ * length. The other bodies, and the bodies of other requests, are framed
+ * whole.
+ *
+ * @param fd The client file descriptor, whose request body is held.
+ * @return true if the body is streamed, false if it is framed whole.
+ * @throws HttpException if the body is too large to be framed whole.
+ */
+bool ServerEngine::streamCgiBody_(int fd)
+{
+	Client		&client = getClient_(fd);
+	HttpRequest *request = NULL;
+	CgiProcess	*cgi = NULL;
+	if (!client.isChunked())
+	{
+		try
+		{
+			request = client.extractHead();
+		}
+		catch (std::exception &e)
+		{
+			request = NULL;
+		}
+	}
+	if (request != NULL && request->getMethod() == "POST")
+	{
+		int serverIndex = findServer_(request->getHost(), request->getPort());
+		// A request refused by the handler gets its error once framed
+		if (serverIndex != -1
+			&& HttpMethodHandler::isCgiRequest(*request, servers_[serverIndex]))
+			createResponse(*request, &cgi);
+	}
+	if (cgi == NULL)
+	{
+		delete request;
+		client.startBody(false);
+		return false;
+	}
+	Logger::log(Logger::DEBUG)
+		<< "Fd[" << fd << "] streams its body to a CGI script" << std::endl;
+	client.startBody(true);
+	startCgi_(fd, cgi, request);
+	return true;
+}
+
+/**
+ * @brief Moves the body read from a client to its CGI script.
+ *
+ * The client is read only while the input of the script holds less than
+ * CGI_INPUT_BUFFER_SIZE bytes, so a script reading slowly slows the client
+ * down instead of the body piling up in memory.
+ *
+ * @param fd The client file descriptor.
+ * @return false if the connection was closed.
+ */
+bool ServerEngine::feedCgiBody_(int fd)
+{
+	size_t		slot = fdTable_[fd].index;
+	Client	   &client = getClient_(fd);
+	CgiProcess &cgi = *client.getCgi();
+	bool		isComplete(false);
+	try
+	{
+		if (cgi.getInputSize() < CGI_INPUT_BUFFER_SIZE)
+			isComplete = client.hasRequestReady();
+	}
+	catch (std::exception &e)
+	{
+		Logger::log(Logger::DEBUG)
+			<< "feedCgiBody_: failed to read the body: " << e.what()
+			<< std::endl;
+	}
+	if (client.isClosed() || client.isError())
+	{
+		closeConnection_(fd);
+		return false;
+	}
+	std::vector<char> &body = client.getBody();
+	if (!body.empty())
+		cgi.appendInput(&body[0], body.size());
+	body.clear();
+	if (isComplete)
+	{
+		cgi.endInput();
+		client.clearRequest();
+	}
+	updateCgiInput_(slot);
+	watchCgiClient_(slot);
+	return true;
+}
+
+/**
+ * @brief Watches the stdin of the CGI script of a client while some input
+ * waits to be written, and closes it once the input is done.
+ *
+ * @param slot The connection slot of the client.
+ */
+void ServerEngine::updateCgiInput_(size_t slot)
+{
+	CgiProcess &cgi = *connections_.get(slot).getCgi();
+	if (cgi.getInputFd() == -1)
+		return;
+	if (cgi.isInputDone())
+	{
+		unwatchCgiFd_(cgi.getInputFd());
+		cgi.closeInput();
+	}
+	else
+		poller_.modify(cgi.getInputFd(), cgi.getInputSize() > 0 ? POLLOUT : 0);
+}
+
+/**
+ * @brief Watches the client of a CGI script and the stdout of the script
+ * for what they can take.
+ *
+ * The client is read while its body is streamed and the script keeps up,
+ * and written once the response is started, while some output is ready. The
+ * stdout is read while less than CGI_OUTPUT_BUFFER_SIZE bytes of output wait
+ * to be sent, so a slow client slows the script down.
+ *
+ * @param slot The connection slot of the client.
+ */
+void ServerEngine::watchCgiClient_(size_t slot)
+{
+	Client	   &client = connections_.get(slot);
+	CgiProcess &cgi = *client.getCgi();
+	bool		isReading = client.isBodyStreamed()
+					 && cgi.getInputSize() < CGI_INPUT_BUFFER_SIZE;
+	// The response of a script is queued once started, until it is sent
+	bool isWriting = client.hasPendingOutput()
+					 && (client.getOutput().getSize() > 0
+						 || !cgi.getOutput().empty()
+						 || (cgi.isOutputDone() && cgi.hasExited()));
+	poller_.modify(
+		client.getFd(), (isReading ? POLLIN : 0) | (isWriting ? POLLOUT : 0)
+	);
+	if (cgi.getOutputFd() != -1)
+		poller_.modify(
+			cgi.getOutputFd(),
+			cgi.getOutput().size() < CGI_OUTPUT_BUFFER_SIZE ? POLLIN : 0
+		);
+	armTimer_(slot, isReading ? BODY_TIMER : SEND_TIMER);
+}
+
+/**
+ * @brief Waits for the CGI script running the request of a client.
+ *
+ * The pipes of the script and its pidfd are watched along with the client,
+ * which is read for the rest of a streamed body and written once the
+ * response is started.
+ *
+ * @param fd The client file descriptor.
+ * @param cgi The running script, owned by the client from now on.
+ * @param request The request run by the script, owned by the client from now
+ * on.
+ */
+void ServerEngine::startCgi_(int fd, CgiProcess *cgi, HttpRequest *request)
+{
+	size_t	slot = fdTable_[fd].index;
+	Client &client = getClient_(fd);
+	client.setCgi(cgi, request);
+	if (!client.isBodyStreamed())
+		cgi->endInput();
+	// A script that could not be executed has no stdin
+	if ((cgi->getInputFd() == -1
+		 || watchCgiFd_(cgi->getInputFd(), 0, FdEntry::CGI_INPUT, slot))
+		&& watchCgiFd_(cgi->getOutputFd(), POLLIN, FdEntry::CGI_OUTPUT, slot)
+		&& (cgi->getPidFd() == -1
+			|| watchCgiFd_(cgi->getPidFd(), POLLIN, FdEntry::CGI_EXIT, slot)))
+	{
+		Logger::log(Logger::DEBUG)
+			<< "Fd[" << fd << "] waits for its CGI script" << std::endl;
+		if (client.isBodyStreamed())
+			feedCgiBody_(fd);
+		else
+		{
+			updateCgiInput_(slot);
+			watchCgiClient_(slot);
+		}
+		return;
+	}
+	unwatchCgi_(slot);
+	client.clearCgi();
+	HttpResponse response = HttpErrorHandler::getErrorPage(500, true);
+	sendResponse_(fd, response);
+}
+
+/**
+ * @brief Watches a pipe or the pidfd of the CGI script of a client.
+ *
+ * @param fd The file descriptor of the script.
+ * @param events The events to watch.
+ * @param type Which end of the script the fd is.
+ * @param slot The connection slot of the client.
+ * @return false if the poller refused the fd.
+ */
+bool ServerEngine::watchCgiFd_(
+	int			  fd,
+	short		  events,
+	FdEntry::Type type,
+	size_t		  slot
+)
+{
+	if (!poller_.add(fd, events))
+		return false;
+	setFdEntry_(fd, type, slot);
+	return true;
+}
+
+/**
+ * @brief Stops watching a pipe or the pidfd of a CGI script, before the
+ * script closes it.
+ */
+void ServerEngine::unwatchCgiFd_(int fd)
+{
+	if (getFdEntry_(fd).type == FdEntry::NONE)
+		return;
+	poller_.remove(fd);
+	setFdEntry_(fd, FdEntry::NONE, 0);
+}
+
+/**
+ * @brief Stops watching all the fds of the CGI script of a client.
+ *
+ * @param slot The connection slot of the client.
+ */
+void ServerEngine::unwatchCgi_(size_t slot)
+{
+	CgiProcess *cgi = connections_.get(slot).getCgi();
+	if (cgi == NULL)
+		return;
+	unwatchCgiFd_(cgi->getInputFd());
+	unwatchCgiFd_(cgi->getOutputFd());
+	unwatchCgiFd_(cgi->getPidFd());
+}
+
+/**
+ * @brief Feeds the body to a CGI script, reads its output or reaps it.
+ *
+ * @param fd The ready pipe or pidfd.
+ * @param entry The fd table entry of the fd.
+ */
+void ServerEngine::handleCgiEvent_(int fd, FdEntry const &entry)
+{
+	Client	   &client = connections_.get(entry.index);
+	CgiProcess &cgi = *client.getCgi();
+	if (entry.type == FdEntry::CGI_INPUT)
+	{
+		if (!cgi.writeInput())
+			Logger::log(Logger::ERROR)
+				<< "Failed to write the body to the CGI script: ("
+				<< ft::toString(errno) << ") " << strerror(errno) << std::endl;
+		updateCgiInput_(entry.index);
+		// The script made room for more of a streamed body
+		if (client.isBodyStreamed() && !feedCgiBody_(client.getFd()))
+			return;
+	}
+	else if (entry.type == FdEntry::CGI_OUTPUT)
+	{
+		ssize_t bytesRead = cgi.readOutput();
+		if (bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			return;
+		if (bytesRead < 0)
+			Logger::log(Logger::ERROR)
+				<< "Failed to read the output of the CGI script: ("
+				<< ft::toString(errno) << ") " << strerror(errno) << std::endl;
+		if (bytesRead <= 0)
+		{
+			unwatchCgiFd_(fd);
+			cgi.closeOutput();
+			// Without a pidfd the script is reaped once it closes its stdout,
+			// which it does when exiting
+			if (cgi.getPidFd() == -1)
+				cgi.reap(true);
+		}
+	}
+	else
+	{
+		unwatchCgiFd_(fd);
+		cgi.reap(false);
+	}
+	sendCgiOutput_(entry.index);
+}
+
+/**
+ * @brief Sends the output of a CGI script to its client.
+ *
+ * The response is started once the handler can make its head from the
+ * output read so far, and its body is then sent as it is read. A script
+ * exiting before, with a short output, gets its whole response at once
+ * instead, from finishCgi_.
+ *
+ * @param slot The connection slot of the client.
+ */
+void ServerEngine::sendCgiOutput_(size_t slot)
+{
+	Client	   &client = connections_.get(slot);
+	CgiProcess &cgi = *client.getCgi();
+	if (!client.hasPendingOutput())
+	{
+		if (cgi.isOutputDone() && cgi.hasExited())
+		{
+			finishCgi_(slot);
+			return;
+		}
+		HttpRequest const &request = *client.getCgiRequest();
+		int serverIndex = findServer_(request.getHost(), request.getPort());
+		HttpResponse   response;
+		BodyGenerator *body = HttpMethodHandler::createCgiStreamResponse(
+			cgi, request, servers_[serverIndex], response
+		);
+		if (body == NULL)
+		{
+			watchCgiClient_(slot);
+			return;
+		}
+		// The rest of a body the script did not wait for is not read
+		if (client.isBodyStreamed())
+		{
+			response.removeHeader("Connection");
+			response.setHeader("Connection", "close");
+		}
+		Logger::log(Logger::DEBUG) << "Fd[" << client.getFd()
+								   << "] streams the output of its CGI script"
+								   << std::endl;
+		response.moveTo(client.getOutput());
+		client.getOutput().pushGenerator(body);
+	}
+	writeClientOutput_(client.getFd());
+}
+
+/**
+ * @brief Releases the CGI script of a client once its whole output is sent.
+ *
+ * @param slot The connection slot of the client.
+ */
+void ServerEngine::endCgiResponse_(size_t slot)
+{
+	Client &client = connections_.get(slot);
+	unwatchCgi_(slot);
+	if (client.isBodyStreamed())
+		client.setIsClosed(true);
+	client.clearCgi();
+	Logger::log(Logger::DEBUG) << "Fd[" << client.getFd()
+							   << "] sent the output of its CGI script"
+							   << std::endl;
+	writeClientOutput_(client.getFd());
+}
+
+/**
+ * @brief Sends the response of a CGI script once it is complete.
+ *
+ * The response is made when the whole output is read and the script has
+ * exited, for a script whose response was not started.
+ *
+ * @param slot The connection slot of the client.
+ */
+void ServerEngine::finishCgi_(size_t slot)
+{
+	Client	   &client = connections_.get(slot);
+	CgiProcess &cgi = *client.getCgi();
+	unwatchCgi_(slot);
+
+	HttpRequest const &request = *client.getCgiRequest();
+	int serverIndex = findServer_(request.getHost(), request.getPort());
+	HttpResponse response = HttpMethodHandler::createCgiResponse(
+		cgi, request, servers_[serverIndex]
+	);
+	client.clearCgi();
+	// The rest of a body the script did not wait for is not read
+	if (client.isBodyStreamed())
+	{
+		response.removeHeader("Connection");
+		response.setHeader("Connection", "close");
+		client.setIsClosed(true);
+	}
+	Logger::log(Logger::DEBUG) << "Fd[" << client.getFd()
+							   << "] got the output of its CGI script"
+							   << std::endl;
+	sendResponse_(client.getFd(), response);
+}
+
+/**
+ * @brief Arms the timer of a connection with the timeout of its server.
+ *
+ * A timeout of 0 disables the timer.
+ *
+ * @param slot The connection slot.
+ * @param kind Which timeout of the server applies.
+ */
+void ServerEngine::armTimer_(size_t slot, TimerKind kind)
+{
+	Server const &server = servers_[connections_.getServer(slot)];
+	unsigned long timeout(0);
+	if (kind == HEADER_TIMER)
+		timeout = server.getClientHeaderTimeout();
+	else if (kind == BODY_TIMER)
+		timeout = server.getClientBodyTimeout();
+	else if (kind == SEND_TIMER)
+		timeout = server.getSendTimeout();
+	else if (kind == KEEPALIVE_TIMER)
+		timeout = server.getKeepAliveTimeout();
+	if (timeout == 0)
+		timers_.cancel(slot);
+	else
+		timers_.schedule(slot, timeout, kind);
+}
+
+/**
+ * @brief Closes the connections whose timer expired.
+ */
+void ServerEngine::expireTimers_(void)
+{
+	static char const *const timeouts[] = {
+		"client_header_timeout",
+		"client_body_timeout",
+		"send_timeout",
+		"keepalive_timeout"
+	};
+	std::vector<TimerWheel::Expired> expired;
+	timers_.advance(expired);
+	for (size_t i = 0; i < expired.size(); ++i)
+	{
+		if (!connections_.isActive(expired[i].id))
+			continue;
+		int fd = connections_.get(expired[i].id).getFd();
+		Logger::log(Logger::DEBUG)
+			<< "Fd[" << fd << "] reached its " << timeouts[expired[i].kind]
+			<< ", closing the connection" << std::endl;
+		closeConnection_(fd);
 	}
 }
 
@@ -505,9 +1153,12 @@ void ServerEngine::start()
  * @brief Creates an HTTP response based on the request.
  *
  * @param request The HTTP request object.
- * @return The HTTP response as a string.
+ * @param cgi Set to the running CGI script of the request, if any, whose
+ * response is then made by the caller. NULL runs the script to completion.
+ * @return The HTTP response.
  */
-std::string ServerEngine::createResponse(const HttpRequest &request)
+HttpResponse
+ServerEngine::createResponse(const HttpRequest &request, CgiProcess **cgi)
 {
 	int serverIndex = this->findServer_(request.getHost(), request.getPort());
 
@@ -517,7 +1168,7 @@ std::string ServerEngine::createResponse(const HttpRequest &request)
 	std::string method = request.getMethod();
 	if (method == "GET" || method == "POST" || method == "DELETE")
 		return HttpMethodHandler::handleRequest(
-			request, servers_[serverIndex], method
+			request, servers_[serverIndex], method, cgi
 		);
 	else
 		return HttpErrorHandler::getErrorPage(501, true);
@@ -551,43 +1202,40 @@ int ServerEngine::findServer_(
 /**
  * @brief Closes a client connection.
  *
- * Removes the client from the clients_ vector and closes the file descriptor.
+ * Unregisters the file descriptor from the poller, closes it and gives the
+ * slot of the client back to the connection table, in O(1).
  *
- * @param pollIndex_ The index of the client in the pollFds_ vector.
+ * @param fd The client file descriptor.
  */
-void ServerEngine::closeConnection_(size_t &pollIndex_)
+void ServerEngine::closeConnection_(int fd)
 {
-	Logger::log(Logger::DEBUG)
-		<< "closeConnection_ at pollIndex: " << pollIndex_ << std::endl;
-
-	// Check if pollIndex_ is within bounds
-	if (pollIndex_ >= this->pollFds_.size())
-	{
-		Logger::log(Logger::DEBUG)
-			<< "closeConnection: Invalid pollIndex_: " << pollIndex_
-			<< " close() will not be caled" << std::endl;
-		return;
-	}
+	Logger::log(Logger::DEBUG) << "closeConnection_ at Fd[" << fd << "]"
+							   << std::endl;
 
-	// Check if clientIndex_ is within bounds
-	if (this->clientIndex_ >= (long long)this->clients_.size())
+	FdEntry entry = getFdEntry_(fd);
+	if (entry.type != FdEntry::CLIENT || !connections_.isActive(entry.index))
 	{
 		Logger::log(Logger::DEBUG)
-			<< "closeConnection: Invalid clientIndex_: " << this->clientIndex_
+			<< "closeConnection: Fd[" << fd << "] is not a client,"
 			<< " close() will not be called" << std::endl;
 		return;
 	}
 
-	// Erase the client from the clients_ vector
-	this->clients_.erase(this->clients_.begin() + this->clientIndex_);
+	poller_.remove(fd);
+	setFdEntry_(fd, FdEntry::NONE, 0);
+	timers_.cancel(entry.index);
+	// A CGI script still running is killed
+	unwatchCgi_(entry.index);
+	connections_.get(entry.index).clearCgi();
+	connections_.get(entry.index).getOutput().clear();
+	connections_.release(entry.index);
 
 	// Check if the file descriptor is open before closing it
-	int fd = this->pollFds_[pollIndex_].fd;
 	if (fcntl(fd, F_GETFD) != -1 || errno != EBADF)
 	{
 		Logger::log(Logger::DEBUG)
-			<< "closeConnection: Going to call close() on clientIndex_: "
-			<< this->clientIndex_ << std::endl;
+			<< "closeConnection: Going to call close() on Fd[" << fd << "]"
+			<< std::endl;
 		close(fd);
 	}
 	else
@@ -596,7 +1244,4 @@ void ServerEngine::closeConnection_(size_t &pollIndex_)
 									  "already closed or invalid fd: "
 								   << fd << std::endl;
 	}
-
-	// Erase the pollFd from the pollFds_ vector
-	this->pollFds_.erase(this->pollFds_.begin() + pollIndex_);
 }
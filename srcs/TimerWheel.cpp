@@ -0,0 +1,204 @@
+#include "TimerWheel.hpp"
+
+#include <time.h>
+
+TimerWheel::TimerWheel(void) : currentTick_(now() / TICK_MS_), count_(0)
+{
+	for (int level = 0; level < LEVELS_; ++level)
+		for (int slot = 0; slot < SLOTS_; ++slot)
+			heads_[level][slot] = -1;
+}
+
+TimerWheel::~TimerWheel(void) {}
+
+/**
+ * @brief Gets the time of a monotonic clock, unaffected by clock changes.
+ *
+ * @return The current time in milliseconds.
+ */
+unsigned long long TimerWheel::now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<unsigned long long>(ts.tv_sec) * 1000
+		   + ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Arms the timer of an id, replacing its pending timer if any.
+ *
+ * @param id The owner of the timer, usually a connection slot.
+ * @param timeoutMs The delay before the timer expires, rounded up to a tick.
+ * @param kind A caller defined value returned with the expired timer.
+ */
+void TimerWheel::schedule(size_t id, unsigned long timeoutMs, int kind)
+{
+	if (id >= nodes_.size())
+	{
+		Node unused = {-1, -1, 0, 0, -1, 0};
+		nodes_.resize(id + 1, unused);
+	}
+	if (nodes_[id].level != -1)
+		unlink_(id);
+	else
+		++count_;
+	unsigned long long expiresTick = (now() + timeoutMs + TICK_MS_ - 1)
+									 / TICK_MS_;
+	if (expiresTick <= currentTick_)
+		expiresTick = currentTick_ + 1;
+	nodes_[id].expiresTick = expiresTick;
+	nodes_[id].kind = kind;
+	link_(id);
+}
+
+/**
+ * @brief Disarms the timer of an id. Nothing happens if it has none.
+ *
+ * @param id The owner of the timer.
+ */
+void TimerWheel::cancel(size_t id)
+{
+	if (!isScheduled(id))
+		return;
+	unlink_(id);
+	nodes_[id].level = -1;
+	--count_;
+}
+
+bool TimerWheel::isScheduled(size_t id) const
+{
+	return id < nodes_.size() && nodes_[id].level != -1;
+}
+
+int TimerWheel::getKind(size_t id) const
+{
+	return nodes_[id].kind;
+}
+
+size_t TimerWheel::getCount(void) const
+{
+	return count_;
+}
+
+/**
+ * @brief Moves the wheel up to the current time and collects the timers that
+ * expired on the way. An expired timer is no longer scheduled.
+ *
+ * @param expired The vector receiving the expired timers, cleared first.
+ */
+void TimerWheel::advance(std::vector<Expired> &expired)
+{
+	expired.clear();
+	unsigned long long targetTick = now() / TICK_MS_;
+	if (count_ == 0 && targetTick > currentTick_)
+		currentTick_ = targetTick;
+	while (currentTick_ < targetTick && count_ > 0)
+	{
+		++currentTick_;
+		int index = currentTick_ & (SLOTS_ - 1);
+		if (index == 0)
+			cascade_(1);
+		long id;
+		while ((id = heads_[0][index]) != -1)
+		{
+			unlink_(id);
+			nodes_[id].level = -1;
+			--count_;
+			Expired timer = {static_cast<size_t>(id), nodes_[id].kind};
+			expired.push_back(timer);
+		}
+	}
+	if (currentTick_ < targetTick)
+		currentTick_ = targetTick;
+}
+
+/**
+ * @brief Gets how long the event loop may sleep before a timer is due.
+ *
+ * The delay is exact for level 0. For the upper levels it is the time of the
+ * next cascade, after which the delay is computed again.
+ *
+ * @param maxTimeout The delay returned when no timer is due sooner.
+ * @return The delay in milliseconds, between 0 and maxTimeout.
+ */
+int TimerWheel::getNextTimeout(int maxTimeout) const
+{
+	if (count_ == 0)
+		return maxTimeout;
+	unsigned long long dueTick(0);
+	for (int level = 0; level < LEVELS_; ++level)
+	{
+		int				   shift = LEVEL_BITS_ * level;
+		unsigned long long base = currentTick_ >> shift;
+		for (int step = 1; step <= SLOTS_; ++step)
+		{
+			if (heads_[level][(base + step) & (SLOTS_ - 1)] != -1)
+			{
+				unsigned long long tick = (base + step) << shift;
+				if (dueTick == 0 || tick < dueTick)
+					dueTick = tick;
+				break;
+			}
+		}
+	}
+	unsigned long long nowMs = now();
+	if (dueTick * TICK_MS_ <= nowMs)
+		return 0;
+	unsigned long long delay = dueTick * TICK_MS_ - nowMs;
+	if (maxTimeout >= 0 && delay > static_cast<unsigned long long>(maxTimeout))
+		return maxTimeout;
+	return static_cast<int>(delay);
+}
+
+// Puts a node in the slot matching its distance to the current tick. A timer
+// further than the last level is clamped to it.
+void TimerWheel::link_(size_t id)
+{
+	Node			  &node = nodes_[id];
+	unsigned long long delta = node.expiresTick - currentTick_;
+	int				   level(0);
+	while (level < LEVELS_ - 1
+		   && delta >= (1ULL << (LEVEL_BITS_ * (level + 1))))
+		++level;
+	if (delta >= (1ULL << (LEVEL_BITS_ * LEVELS_)))
+		node.expiresTick = currentTick_ + (1ULL << (LEVEL_BITS_ * LEVELS_)) - 1;
+	node.level = level;
+	node.slot = (node.expiresTick >> (LEVEL_BITS_ * level)) & (SLOTS_ - 1);
+	node.prev = -1;
+	node.next = heads_[level][node.slot];
+	if (node.next != -1)
+		nodes_[node.next].prev = id;
+	heads_[level][node.slot] = id;
+}
+
+void TimerWheel::unlink_(size_t id)
+{
+	Node &node = nodes_[id];
+	if (node.prev != -1)
+		nodes_[node.prev].next = node.next;
+	else
+		heads_[node.level][node.slot] = node.next;
+	if (node.next != -1)
+		nodes_[node.next].prev = node.prev;
+	node.prev = -1;
+	node.next = -1;
+}
+
+// Spreads the current slot of a level over the lower levels. The upper level
+// is cascaded first when this level wraps around too.
+void TimerWheel::cascade_(int level)
+{
+	if (level >= LEVELS_)
+		return;
+	int index = (currentTick_ >> (LEVEL_BITS_ * level)) & (SLOTS_ - 1);
+	if (index == 0)
+		cascade_(level + 1);
+	long id = heads_[level][index];
+	heads_[level][index] = -1;
+	while (id != -1)
+	{
+		long next = nodes_[id].next;
+		link_(id);
+		id = next;
+	}
+}
@@ -46,8 +46,10 @@ bool ConfigParser::checkDirective(
 			tokens, lineIndex, isTest, isTestPrint, filepath, isConfigOK
 		);
 
-	else if (tokens[0] == "autoindex")
-		return ConfigParser::checkAutoIndex(
+	else if (tokens[0] == "autoindex" || tokens[0] == "sendfile"
+			 || tokens[0] == "cache" || tokens[0] == "gzip_static"
+			 || tokens[0] == "gzip")
+		return ConfigParser::checkSwitch(
 			tokens, lineIndex, isTest, isTestPrint, filepath, isConfigOK
 		);
 	else if (tokens[0] == "return")
@@ -70,6 +72,26 @@ bool ConfigParser::checkDirective(
 		return ConfigParser::checkRoot(
 			tokens, lineIndex, isTest, isTestPrint, filepath, isConfigOK
 		);
+	else if (tokens[0] == "gzip_types" || tokens[0] == "gzip_min_length"
+			 || tokens[0] == "gzip_comp_level")
+		return ConfigParser::checkGzip(
+			tokens, lineIndex, isTest, isTestPrint, filepath, isConfigOK
+		);
+	else if (tokens[0] == "cgi_pool")
+		return ConfigParser::checkCgiPool(
+			tokens, lineIndex, isTest, isTestPrint, filepath, isConfigOK
+		);
+	else if (tokens[0] == "fastcgi_pass")
+		return ConfigParser::checkFastCgiPass(
+			tokens, lineIndex, isTest, isTestPrint, filepath, isConfigOK
+		);
+	else if (tokens[0] == "keepalive_timeout"
+			 || tokens[0] == "client_header_timeout"
+			 || tokens[0] == "client_body_timeout"
+			 || tokens[0] == "send_timeout")
+		return ConfigParser::checkTimeout(
+			tokens, lineIndex, isTest, isTestPrint, filepath, isConfigOK
+		);
 	return false;
 }
 
@@ -199,7 +221,8 @@ bool ConfigParser::checkLimitExcept(
 	return true;
 }
 
-bool ConfigParser::checkAutoIndex(
+// Check a directive that turns a feature on or off.
+bool ConfigParser::checkSwitch(
 	std::vector<std::string> const &tokens,
 	unsigned int const			   &lineIndex,
 	bool const					   &isTest,
@@ -213,7 +236,7 @@ bool ConfigParser::checkAutoIndex(
 		return true;
 	}
 	ConfigParser::errorHandler(
-		"Invalid value [" + tokens[1] + "] for autoindex directive",
+		"Invalid value [" + tokens[1] + "] for " + tokens[0] + " directive",
 		lineIndex,
 		isTest,
 		isTestPrint,
@@ -437,6 +460,43 @@ bool ConfigParser::checkClientMaxBodySize(
 	}
 }
 
+// Check a timeout directive: a number with an optional unit (ms, s, m, h).
+bool ConfigParser::checkTimeout(
+	std::vector<std::string> const &tokens,
+	unsigned int const			   &lineIndex,
+	bool const					   &isTest,
+	bool const					   &isTestPrint,
+	std::string const			   &filepath,
+	bool						   &isConfigOK
+)
+{
+	if (tokens.size() != 2)
+	{
+		ConfigParser::errorHandler(
+			"Invalid number of arguments for " + tokens[0] + " directive",
+			lineIndex,
+			isTest,
+			isTestPrint,
+			filepath,
+			isConfigOK
+		);
+		return false;
+	}
+	if (!ft::isTime(tokens[1]))
+	{
+		ConfigParser::errorHandler(
+			"Invalid time [" + tokens[1] + "] for " + tokens[0] + " directive",
+			lineIndex,
+			isTest,
+			isTestPrint,
+			filepath,
+			isConfigOK
+		);
+		return false;
+	}
+	return true;
+}
+
 bool ConfigParser::checkRoot(
 	std::vector<std::string> const &tokens,
 	unsigned int const			   &lineIndex,
@@ -475,3 +535,155 @@ bool ConfigParser::checkRoot(
 		return false;
 	}
 }
+
+// Check the settings of the gzip compression: MIME types, or * for any, a
+// length in bytes and a level from 1 to 9.
+bool ConfigParser::checkGzip(
+	std::vector<std::string> const &tokens,
+	unsigned int const			   &lineIndex,
+	bool const					   &isTest,
+	bool const					   &isTestPrint,
+	std::string const			   &filepath,
+	bool						   &isConfigOK
+)
+{
+	if (tokens.size() < 2 || (tokens[0] != "gzip_types" && tokens.size() != 2))
+	{
+		ConfigParser::errorHandler(
+			"Invalid number of arguments for " + tokens[0] + " directive",
+			lineIndex,
+			isTest,
+			isTestPrint,
+			filepath,
+			isConfigOK
+		);
+		return false;
+	}
+	for (size_t i = 1; i < tokens.size(); ++i)
+	{
+		bool isValid;
+		if (tokens[0] == "gzip_types")
+			isValid = tokens[i] == "*"
+					  || tokens[i].find('/') != std::string::npos;
+		else if (tokens[0] == "gzip_comp_level")
+			isValid = tokens[i].size() == 1 && tokens[i] >= "1"
+					  && tokens[i] <= "9";
+		else
+			isValid = ft::isStrOfDigits(tokens[i]);
+		if (!isValid)
+		{
+			ConfigParser::errorHandler(
+				"Invalid value [" + tokens[i] + "] for " + tokens[0]
+					+ " directive",
+				lineIndex,
+				isTest,
+				isTestPrint,
+				filepath,
+				isConfigOK
+			);
+			return false;
+		}
+	}
+	return true;
+}
+
+// Check the workers of a CGI pool: at least one preforked, no fewer than
+// that at most, and at least one request per worker.
+bool ConfigParser::checkCgiPool(
+	std::vector<std::string> const &tokens,
+	unsigned int const			   &lineIndex,
+	bool const					   &isTest,
+	bool const					   &isTestPrint,
+	std::string const			   &filepath,
+	bool						   &isConfigOK
+)
+{
+	if (tokens.size() != 4)
+	{
+		ConfigParser::errorHandler(
+			"Invalid number of arguments for cgi_pool directive",
+			lineIndex,
+			isTest,
+			isTestPrint,
+			filepath,
+			isConfigOK
+		);
+		return false;
+	}
+	for (size_t i = 1; i < tokens.size(); ++i)
+	{
+		if (!ft::isStrOfDigits(tokens[i]) || ft::stringToULong(tokens[i]) == 0)
+		{
+			ConfigParser::errorHandler(
+				"Invalid value [" + tokens[i] + "] for cgi_pool directive",
+				lineIndex,
+				isTest,
+				isTestPrint,
+				filepath,
+				isConfigOK
+			);
+			return false;
+		}
+	}
+	if (ft::stringToULong(tokens[1]) > ft::stringToULong(tokens[2]))
+	{
+		ConfigParser::errorHandler(
+			"Minimum above maximum of workers for cgi_pool directive",
+			lineIndex,
+			isTest,
+			isTestPrint,
+			filepath,
+			isConfigOK
+		);
+		return false;
+	}
+	return true;
+}
+
+// Check the address of a FastCGI application: unix: and the path of a socket,
+// or a host and a port.
+bool ConfigParser::checkFastCgiPass(
+	std::vector<std::string> const &tokens,
+	unsigned int const			   &lineIndex,
+	bool const					   &isTest,
+	bool const					   &isTestPrint,
+	std::string const			   &filepath,
+	bool						   &isConfigOK
+)
+{
+	if (tokens.size() != 2)
+	{
+		ConfigParser::errorHandler(
+			"Invalid number of arguments for fastcgi_pass directive",
+			lineIndex,
+			isTest,
+			isTestPrint,
+			filepath,
+			isConfigOK
+		);
+		return false;
+	}
+	std::string const &address = tokens[1];
+	size_t			   colon = address.rfind(':');
+	bool			   isValid;
+	if (address.compare(0, 5, "unix:") == 0)
+		isValid = address.size() > 5;
+	else
+		isValid = colon != std::string::npos && colon > 0
+				  && ft::isStrOfDigits(address.substr(colon + 1))
+				  && ft::stringToULong(address.substr(colon + 1)) > 0
+				  && ft::stringToULong(address.substr(colon + 1)) <= 65535;
+	if (!isValid)
+	{
+		ConfigParser::errorHandler(
+			"Invalid address [" + address + "] for fastcgi_pass directive",
+			lineIndex,
+			isTest,
+			isTestPrint,
+			filepath,
+			isConfigOK
+		);
+		return false;
+	}
+	return true;
+}
@@ -1,5 +1,6 @@
 #include "ServerConfig.hpp"
 #include "ConfigParser.hpp"
+#include "EventPoller.hpp"
 #include "ServerException.hpp"
 #include "colors.hpp"
 #include "macros.hpp"
@@ -75,8 +76,15 @@ bool ServerConfig::isConfigOK(void) const
 void ServerConfig::initGeneralConfig_(void)
 {
 	generalConfig_["worker_processes"] = "";
+	generalConfig_["worker_threads"] = "";
 	generalConfig_["worker_connections"] = "";
+	generalConfig_["use"] = "";
 	generalConfig_["error_log"] = "info";
+	generalConfig_["open_file_cache"] = "off";
+	generalConfig_["open_file_cache_valid"] = "60s";
+	generalConfig_["open_file_cache_events"] = "off";
+	generalConfig_["response_cache"] = "off";
+	generalConfig_["gzip_cache"] = "16777216";
 }
 
 // Server directives in the configuration file.
@@ -92,6 +100,10 @@ void ServerConfig::initServersConfig_(void)
 	server["root"] = ConfigValue();
 	server["index"] = ConfigValue();
 	server["client_max_body_size"] = ConfigValue();
+	server["keepalive_timeout"] = ConfigValue();
+	server["client_header_timeout"] = ConfigValue();
+	server["client_body_timeout"] = ConfigValue();
+	server["send_timeout"] = ConfigValue();
 	serversConfig_.push_back(server);
 }
 
@@ -105,9 +117,18 @@ void ServerConfig::initLocationConfig_(
 	location["client_max_body_size"] = std::vector<std::string>();
 	location["limit_except"] = std::vector<std::string>();
 	location["autoindex"] = std::vector<std::string>();
+	location["sendfile"] = std::vector<std::string>();
+	location["cache"] = std::vector<std::string>();
+	location["gzip_static"] = std::vector<std::string>();
+	location["gzip"] = std::vector<std::string>();
+	location["gzip_types"] = std::vector<std::string>();
+	location["gzip_min_length"] = std::vector<std::string>();
+	location["gzip_comp_level"] = std::vector<std::string>();
 	location["return"] = std::vector<std::string>();
 	location["upload_store"] = std::vector<std::string>();
 	location["cgi"] = std::vector<std::string>();
+	location["cgi_pool"] = std::vector<std::string>();
+	location["fastcgi_pass"] = std::vector<std::string>();
 }
 
 // Set the host and port in the listen directive. If the argument is a port
@@ -295,6 +316,20 @@ void ServerConfig::parseLocationBlock_(
 				= serversConfig_.back()["client_max_body_size"].getVector();
 		if (location["autoindex"].empty())
 			location["autoindex"] = std::vector<std::string>(1, "off");
+		if (location["sendfile"].empty())
+			location["sendfile"] = std::vector<std::string>(1, "on");
+		if (location["cache"].empty())
+			location["cache"] = std::vector<std::string>(1, "on");
+		if (location["gzip_static"].empty())
+			location["gzip_static"] = std::vector<std::string>(1, "off");
+		if (location["gzip"].empty())
+			location["gzip"] = std::vector<std::string>(1, "off");
+		if (location["gzip_types"].empty())
+			location["gzip_types"] = std::vector<std::string>(1, "text/html");
+		if (location["gzip_min_length"].empty())
+			location["gzip_min_length"] = std::vector<std::string>(1, "20");
+		if (location["gzip_comp_level"].empty())
+			location["gzip_comp_level"] = std::vector<std::string>(1, "1");
 		serversConfig_.back()[uri].setMap(location);
 	}
 	else
@@ -346,8 +381,7 @@ void ServerConfig::handleGeneralDirective_(
 		))
 	{
 		tokens[1].erase(tokens[1].size() - 1);
-		if (ft::isStrOfDigits(tokens[1]) || tokens[1] == "auto"
-			|| (tokens[0] == "error_log" && isValidLogLevel_(tokens[1])))
+		if (isValidGeneralValue_(tokens[0], tokens[1]))
 			generalConfig_[tokens[0]] = tokens[1];
 		else
 			ConfigParser::errorHandler(
@@ -364,8 +398,31 @@ void ServerConfig::handleGeneralDirective_(
 
 bool ServerConfig::isGeneralDirective_(const std::string &directive)
 {
-	return directive == "worker_processes" || directive == "worker_connections"
-		   || directive == "error_log";
+	return directive == "worker_processes" || directive == "worker_threads"
+		   || directive == "worker_connections" || directive == "use"
+		   || directive == "error_log" || directive == "open_file_cache"
+		   || directive == "open_file_cache_valid"
+		   || directive == "open_file_cache_events"
+		   || directive == "response_cache" || directive == "gzip_cache";
+}
+
+bool ServerConfig::isValidGeneralValue_(
+	const std::string &directive,
+	const std::string &value
+)
+{
+	if (directive == "use")
+		return EventPoller::isValidBackend(value);
+	if (directive == "error_log")
+		return isValidLogLevel_(value);
+	if (directive == "open_file_cache" || directive == "response_cache"
+		|| directive == "gzip_cache")
+		return ft::isStrOfDigits(value) || value == "off";
+	if (directive == "open_file_cache_valid")
+		return ft::isTime(value);
+	if (directive == "open_file_cache_events")
+		return value == "on" || value == "off";
+	return ft::isStrOfDigits(value) || value == "auto";
 }
 
 bool ServerConfig::isBlockDirective_(const std::string &directive)
@@ -404,7 +461,14 @@ bool ServerConfig::isServerDirective_(const std::string &directive)
 	return directive == "server_name" || directive == "index"
 		   || directive == "listen" || directive == "root"
 		   || directive == "client_max_body_size" || directive == "error_page"
-		   || directive == "location";
+		   || directive == "location" || isTimeoutDirective_(directive);
+}
+
+bool ServerConfig::isTimeoutDirective_(const std::string &directive)
+{
+	return directive == "keepalive_timeout"
+		   || directive == "client_header_timeout"
+		   || directive == "client_body_timeout" || directive == "send_timeout";
 }
 
 void ServerConfig::handleServerDirective_(
@@ -420,7 +484,8 @@ void ServerConfig::handleServerDirective_(
 		handleMultiValueDirective_(tokens, lineIndex, isTest, isTestPrint);
 	}
 	else if (tokens[0] == "listen" || tokens[0] == "root"
-			 || tokens[0] == "client_max_body_size")
+			 || tokens[0] == "client_max_body_size"
+			 || isTimeoutDirective_(tokens[0]))
 	{
 		handleSingleValueDirective_(tokens, lineIndex, isTest, isTestPrint);
 	}
@@ -487,7 +552,8 @@ void ServerConfig::handleSingleValueDirective_(
 		tokens[1].erase(tokens[1].size() - 1);
 		if (!serversConfig_.empty())
 		{
-			if ((tokens[0] == "client_max_body_size" || tokens[0] == "root")
+			if ((tokens[0] == "client_max_body_size" || tokens[0] == "root"
+				 || isTimeoutDirective_(tokens[0]))
 				&& ConfigParser::checkDirective(
 					tokens,
 					lineIndex,
@@ -846,9 +912,24 @@ void ServerConfig::checkServersConfig_(bool isTest, bool isTestPrint)
 			it->find("client_max_body_size")
 				->second.setVector(std::vector<std::string>(1, "1048576"));
 		}
+		setDefaultTimeout_(*it, "keepalive_timeout", "75s");
+		setDefaultTimeout_(*it, "client_header_timeout", "60s");
+		setDefaultTimeout_(*it, "client_body_timeout", "60s");
+		setDefaultTimeout_(*it, "send_timeout", "60s");
 	}
 }
 
+// The timeouts are optional, a missing one silently takes its default value.
+void ServerConfig::setDefaultTimeout_(
+	std::map<std::string, ConfigValue> &server,
+	std::string const				   &directive,
+	std::string const				   &value
+)
+{
+	if (server[directive].getVector().empty())
+		server[directive].setVector(std::vector<std::string>(1, value));
+}
+
 void ServerConfig::printConfig(void)
 {
 	if (file_.is_open())
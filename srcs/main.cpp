@@ -1,9 +1,15 @@
+#include "HttpMethodHandler.hpp"
 #include "Logger.hpp"
+#include "MasterProcess.hpp"
+#include "ReactorPool.hpp"
+#include "Server.hpp"
 #include "ServerConfig.hpp"
 #include "ServerEngine.hpp"
+#include "ServerException.hpp"
 #include "ServerInput.hpp"
 #include "colors.hpp"
 #include "signals.hpp"
+#include "utils.hpp"
 
 #include <iostream>
 
@@ -44,6 +50,31 @@ static bool isTestMode(ServerInput &input, ServerConfig &config)
 	return false;
 }
 
+// Looks up the applications of the fastcgi_pass directives, which the event
+// loop then connects to without a blocking lookup.
+static void resolveFastCgiApplications(ServerConfig const &config)
+{
+	// clang-format off
+	std::vector<std::map<std::string, ConfigValue> > const &servers
+		= config.getAllServersConfig(); // clang-format on
+	for (size_t i = 0; i < servers.size(); ++i)
+	{
+		std::map<std::string, ConfigValue>::const_iterator it;
+		for (it = servers[i].begin(); it != servers[i].end(); ++it)
+		{
+			if (it->second.getType() != ConfigValue::MAP)
+				continue;
+			std::vector<std::string> pass;
+			if (!it->second.getMapValue("fastcgi_pass", pass) || pass.empty())
+				continue;
+			if (!HttpMethodHandler::getFastCgiClient().resolve(pass[0]))
+				throw ServerException(
+					"Failed to resolve the FastCGI application %", 0, pass[0]
+				);
+		}
+	}
+}
+
 int main(int argc, char *argv[])
 {
 	try
@@ -65,9 +96,51 @@ int main(int argc, char *argv[])
 		Logger::setLevel(config.getGeneralConfigValue("error_log"));
 		// Set the signals handler
 		signals::handleSignals();
-		// Init and start the server(s)
-		ServerEngine engine(config.getAllServersConfig());
-		engine.start();
+		EventPoller::Backend backend
+			= EventPoller::getBackend(config.getGeneralConfigValue("use"));
+		std::string workerProcesses
+			= config.getGeneralConfigValue("worker_processes");
+		unsigned int threadCount
+			= ft::getWorkerCount(config.getGeneralConfigValue("worker_threads"));
+		std::string openFileCache
+			= config.getGeneralConfigValue("open_file_cache");
+		HttpMethodHandler::getOpenFileCache().configure(
+			openFileCache == "off" ? 0 : ft::stringToULong(openFileCache),
+			ft::timeToMs(config.getGeneralConfigValue("open_file_cache_valid")),
+			config.getGeneralConfigValue("open_file_cache_events") == "on"
+		);
+		std::string responseCache
+			= config.getGeneralConfigValue("response_cache");
+		HttpMethodHandler::getResponseCache().configure(
+			responseCache == "off" ? 0 : ft::stringToULong(responseCache),
+			HttpMethodHandler::getOpenFileCache()
+		);
+		std::string gzipCache = config.getGeneralConfigValue("gzip_cache");
+		HttpMethodHandler::getGzipCache().configure(
+			gzipCache == "off" ? 0 : ft::stringToULong(gzipCache)
+		);
+		resolveFastCgiApplications(config);
+		// Every worker process and reactor thread binds its own listeners
+		Server::setReusePort(!workerProcesses.empty() || threadCount > 1);
+		// Without worker_processes, serve from this process. Otherwise this
+		// process becomes the master and the workers serve the requests.
+		if (workerProcesses.empty())
+		{
+			ReactorPool reactors(
+				config.getAllServersConfig(), backend, threadCount
+			);
+			reactors.run();
+		}
+		else
+		{
+			MasterProcess master(
+				config.getAllServersConfig(),
+				backend,
+				ft::getWorkerCount(workerProcesses),
+				threadCount
+			);
+			master.run();
+		}
 	}
 	catch (std::exception &e)
 	{
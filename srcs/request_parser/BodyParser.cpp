@@ -123,8 +123,8 @@ void BodyParser::checkBody_(
 			<< " Actual length: " << body.size() << std::endl;
 		throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
 	}
+	// A chunked body, already decoded, has no Content-Length
 	Logger::log(Logger::DEBUG)
-		<< "checkBody: Body checks passed. Stated content length: "
-		<< (unsigned long)std::atol(headers.at("Content-Length")[0].c_str())
-		<< " Actual length: " << body.size() << std::endl;
+		<< "checkBody: Body checks passed. Actual length: " << body.size()
+		<< std::endl;
 }
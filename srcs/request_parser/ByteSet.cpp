@@ -0,0 +1,317 @@
+#include "request_parser/ByteSet.hpp"
+
+#include <cstring>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#	define BYTESET_X86
+#	include <immintrin.h>
+#endif
+
+#ifdef BYTESET_X86
+
+// Gets a mask of the bytes out of the set, classified by their nibbles: the
+// low nibble picks a row of bits in the tables, the high nibble a bit of the
+// row, and the high bit of the byte one of the two tables.
+__attribute__((target("avx2"))) static inline unsigned int outsideAvx2(
+	__m256i bytes,
+	__m256i lowTable,
+	__m256i highTable
+)
+{
+	__m256i const bits = _mm256_setr_epi8(
+		1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+		1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128
+	);
+	__m256i const nibble = _mm256_set1_epi8(0x0f);
+	__m256i		  low = _mm256_and_si256(bytes, nibble);
+	__m256i high = _mm256_and_si256(_mm256_srli_epi16(bytes, 4), nibble);
+	__m256i rows = _mm256_blendv_epi8(
+		_mm256_shuffle_epi8(lowTable, low),
+		_mm256_shuffle_epi8(highTable, low),
+		bytes
+	);
+	return _mm256_movemask_epi8(_mm256_cmpeq_epi8(
+		_mm256_and_si256(rows, _mm256_shuffle_epi8(bits, high)),
+		_mm256_setzero_si256()
+	));
+}
+
+// The same with 16 bytes, for the buffers shorter than 32 bytes.
+__attribute__((target("avx2"))) static inline unsigned int outsideAvx2(
+	__m128i bytes,
+	__m128i lowTable,
+	__m128i highTable
+)
+{
+	__m128i const bits
+		= _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+	__m128i const nibble = _mm_set1_epi8(0x0f);
+	__m128i		  low = _mm_and_si128(bytes, nibble);
+	__m128i		  high = _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble);
+	__m128i		  rows = _mm_blendv_epi8(
+		 _mm_shuffle_epi8(lowTable, low), _mm_shuffle_epi8(highTable, low), bytes
+	 );
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(
+		_mm_and_si128(rows, _mm_shuffle_epi8(bits, high)), _mm_setzero_si128()
+	));
+}
+
+// Scans 32 bytes per step. Returns the offset of the first byte whose
+// membership is member, length if there is none, or 0 for the buffers shorter
+// than 16 bytes, left to the caller. The last step overlaps the previous one
+// instead of reading past the end of the buffer.
+__attribute__((target("avx2"))) static size_t scanAvx2(
+	unsigned char const nibbles[2][16],
+	char const		   *data,
+	size_t				length,
+	bool				member
+)
+{
+	unsigned int const flip = member ? ~0U : 0U;
+	if (length < 32)
+	{
+		if (length < 16)
+			return 0;
+		__m128i lowTable
+			= _mm_loadu_si128(reinterpret_cast<__m128i const *>(nibbles[0]));
+		__m128i highTable
+			= _mm_loadu_si128(reinterpret_cast<__m128i const *>(nibbles[1]));
+		size_t offsets[2] = {0, length - 16};
+		for (int step = 0; step < 2; ++step)
+		{
+			__m128i bytes = _mm_loadu_si128(
+				reinterpret_cast<__m128i const *>(data + offsets[step])
+			);
+			unsigned int mask
+				= (outsideAvx2(bytes, lowTable, highTable) ^ flip) & 0xffff;
+			if (mask != 0)
+				return offsets[step] + __builtin_ctz(mask);
+		}
+		return length;
+	}
+	__m256i lowTable = _mm256_broadcastsi128_si256(
+		_mm_loadu_si128(reinterpret_cast<__m128i const *>(nibbles[0]))
+	);
+	__m256i highTable = _mm256_broadcastsi128_si256(
+		_mm_loadu_si128(reinterpret_cast<__m128i const *>(nibbles[1]))
+	);
+	size_t i(0);
+	while (true)
+	{
+		__m256i bytes
+			= _mm256_loadu_si256(reinterpret_cast<__m256i const *>(data + i));
+		unsigned int mask = outsideAvx2(bytes, lowTable, highTable) ^ flip;
+		if (mask != 0)
+			return i + __builtin_ctz(mask);
+		if (i + 32 == length)
+			return length;
+		i = i + 64 <= length ? i + 32 : length - 32;
+	}
+}
+
+// Scans 16 bytes per step, comparing them with each range of the set. The
+// result is the one of scanAvx2().
+static size_t scanSse2(
+	unsigned char const ranges[][2],
+	int					rangeCount,
+	char const		   *data,
+	size_t				length,
+	bool				member
+)
+{
+	if (length < 16)
+		return 0;
+	__m128i firsts[8];
+	__m128i lasts[8];
+	for (int r = 0; r < rangeCount; ++r)
+	{
+		firsts[r] = _mm_set1_epi8(static_cast<char>(ranges[r][0]));
+		lasts[r] = _mm_set1_epi8(static_cast<char>(ranges[r][1]));
+	}
+	unsigned int const flip = member ? 0U : 0xffffU;
+	size_t			   i(0);
+	while (true)
+	{
+		__m128i bytes
+			= _mm_loadu_si128(reinterpret_cast<__m128i const *>(data + i));
+		__m128i inside = _mm_setzero_si128();
+		for (int r = 0; r < rangeCount; ++r)
+		{
+			__m128i afterFirst
+				= _mm_cmpeq_epi8(_mm_max_epu8(bytes, firsts[r]), bytes);
+			__m128i beforeLast
+				= _mm_cmpeq_epi8(_mm_min_epu8(bytes, lasts[r]), bytes);
+			inside = _mm_or_si128(inside, _mm_and_si128(afterFirst, beforeLast));
+		}
+		unsigned int mask = _mm_movemask_epi8(inside) ^ flip;
+		if (mask != 0)
+			return i + __builtin_ctz(mask);
+		if (i + 16 == length)
+			return length;
+		i = i + 32 <= length ? i + 16 : length - 16;
+	}
+}
+
+static ByteSet::Isa detectIsa(void)
+{
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return ByteSet::AVX2;
+	return ByteSet::SSE2;
+}
+
+#else
+
+static ByteSet::Isa detectIsa(void)
+{
+	return ByteSet::SCALAR;
+}
+
+#endif
+
+ByteSet::Isa ByteSet::isa_ = detectIsa();
+
+ByteSet::ByteSet(void)
+{
+	std::memset(members_, 0, sizeof(members_));
+	update_();
+}
+
+ByteSet::ByteSet(char const *chars)
+{
+	std::memset(members_, 0, sizeof(members_));
+	add(chars);
+}
+
+ByteSet::ByteSet(ByteSet const &src)
+{
+	*this = src;
+}
+
+ByteSet::~ByteSet(void) {}
+
+ByteSet &ByteSet::operator=(ByteSet const &rhs)
+{
+	if (this != &rhs)
+	{
+		std::memcpy(members_, rhs.members_, sizeof(members_));
+		update_();
+	}
+	return *this;
+}
+
+ByteSet &ByteSet::add(char const *chars)
+{
+	for (; *chars != '\0'; ++chars)
+		members_[static_cast<unsigned char>(*chars)] = true;
+	update_();
+	return *this;
+}
+
+ByteSet &ByteSet::addRange(unsigned char first, unsigned char last)
+{
+	for (int c = first; c <= last; ++c)
+		members_[c] = true;
+	update_();
+	return *this;
+}
+
+ByteSet &ByteSet::remove(char const *chars)
+{
+	for (; *chars != '\0'; ++chars)
+		members_[static_cast<unsigned char>(*chars)] = false;
+	update_();
+	return *this;
+}
+
+ByteSet &ByteSet::invert(void)
+{
+	for (int c = 0; c < 256; ++c)
+		members_[c] = !members_[c];
+	update_();
+	return *this;
+}
+
+bool ByteSet::contains(char c) const
+{
+	return members_[static_cast<unsigned char>(c)];
+}
+
+/**
+ * @brief Gets the length of the leading bytes that are in the set.
+ *
+ * @return The offset of the first byte out of the set, length if there is
+ * none.
+ */
+size_t ByteSet::span(char const *data, size_t length) const
+{
+	return scan_(data, length, false);
+}
+
+/**
+ * @brief Finds the first byte that is in the set.
+ *
+ * @return The offset of the byte, length if there is none.
+ */
+size_t ByteSet::find(char const *data, size_t length) const
+{
+	return scan_(data, length, true);
+}
+
+ByteSet::Isa ByteSet::getIsa(void)
+{
+	return isa_;
+}
+
+ByteSet::Isa ByteSet::getSupportedIsa(void)
+{
+	return detectIsa();
+}
+
+/**
+ * @brief Chooses the kernels used by every set, to compare them. An
+ * instruction set the CPU does not have is replaced by the best one it has.
+ */
+void ByteSet::setIsa(Isa isa)
+{
+	Isa supported = detectIsa();
+	isa_ = isa > supported ? supported : isa;
+}
+
+// Rebuilds the nibble tables and the ranges from the members.
+void ByteSet::update_(void)
+{
+	std::memset(nibbles_, 0, sizeof(nibbles_));
+	rangeCount_ = 0;
+	for (int c = 0; c < 256; ++c)
+	{
+		if (!members_[c])
+			continue;
+		nibbles_[c >> 7][c & 0x0f] |= 1 << ((c >> 4) & 7);
+		if (c > 0 && members_[c - 1])
+			continue;
+		if (rangeCount_ < MAX_RANGES_)
+			ranges_[rangeCount_][0] = c;
+		++rangeCount_;
+		int last = c;
+		while (last < 255 && members_[last + 1])
+			++last;
+		if (rangeCount_ <= MAX_RANGES_)
+			ranges_[rangeCount_ - 1][1] = last;
+	}
+}
+
+// Gets the offset of the first byte whose membership is member.
+size_t ByteSet::scan_(char const *data, size_t length, bool member) const
+{
+	size_t i(0);
+#ifdef BYTESET_X86
+	if (isa_ == AVX2)
+		i = scanAvx2(nibbles_, data, length, member);
+	else if (isa_ == SSE2 && rangeCount_ <= MAX_RANGES_)
+		i = scanSse2(ranges_, rangeCount_, data, length, member);
+#endif
+	while (i < length && members_[static_cast<unsigned char>(data[i])] != member)
+		++i;
+	return i;
+}
@@ -243,49 +243,23 @@ void HeaderParser::checkRawHeaders_(
  */
 bool HeaderParser::isValidHeaderName_(std::string headerName)
 {
-	for (std::string::iterator it = headerName.begin(); it != headerName.end();
-		 ++it)
-	{
-		if (std::isalnum(*it) == 0 && *it != '-' && *it != '_' && *it != '.')
-			return false;
-	}
-	return true;
+	return headerNameChars.span(headerName.data(), headerName.size())
+		   == headerName.size();
 }
 
 /**
  * @brief Checks if the header value contains only allowed characters.
  *
  * This function checks that the header value does not contain control
- * characters and that special characters are properly escaped.
+ * characters.
  *
  * @param headerValue The header value to validate.
  * @return true if the header value is valid, false otherwise.
  */
 bool HeaderParser::isValidHeaderValue_(std::string headerValue)
 {
-	std::string specialChars = "";
-
-	for (std::string::const_iterator it = headerValue.begin();
-		 it != headerValue.end();
-		 ++it)
-	{
-		if (std::iscntrl(*it))
-			return false;
-
-		// Check for unescaped special characters
-		if (specialChars.find(*it) != std::string::npos)
-		{
-			if (it == headerValue.begin())
-			{
-				return false;
-			}
-			else if (*(it - 1) != '\\')
-			{
-				return false;
-			}
-		}
-	}
-	return true;
+	return headerValueControlChars.find(headerValue.data(), headerValue.size())
+		   == headerValue.size();
 }
 
 /**
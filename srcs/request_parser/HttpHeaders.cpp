@@ -13,7 +13,12 @@ const std::string acceptedHeaders[ACCEPTED_HEADERS_N]
 	   "Content-Length",
 	   "Cookie",
 	   "Transfer-Encoding",
-	   "Content-Type"};
+	   "Content-Type",
+	   "If-None-Match",
+	   "If-Modified-Since",
+	   "Range",
+	   "If-Range",
+	   "Accept-Encoding"};
 
 /* Headers allowed to appear more than once per request
  */
@@ -28,6 +33,7 @@ const std::string repeatableHeaders[REPEATABLE_HEADERS_N]
 	   "Content-Encoding",
 	   "Content-Language",
 	   "Expect",
+	   "If-None-Match",
 	   "Pragma",
 	   "Proxy-Authenticate",
 	   "TE",
@@ -61,6 +67,11 @@ std::map<std::string, std::string> createHeaderAcceptedChars()
 	headerAcceptedChars["Content-Type"] = "()<>@,;:\\\"/[]?={} \t";
 	headerAcceptedChars["Cookie"] = "=;,";
 	headerAcceptedChars["Content-Type"] = "=/;";
+	headerAcceptedChars["If-None-Match"] = "\"/";
+	headerAcceptedChars["If-Modified-Since"] = ":";
+	headerAcceptedChars["Range"] = "=";
+	headerAcceptedChars["If-Range"] = "\"/:";
+	headerAcceptedChars["Accept-Encoding"] = ";=";
 	return headerAcceptedChars;
 }
 
@@ -70,3 +81,66 @@ std::map<std::string, std::string> createHeaderAcceptedChars()
  */
 const std::map<std::string, std::string> headerAcceptedChars
 	= createHeaderAcceptedChars();
+
+/* Byte classes of the request syntax, scanned with ByteSet::span() and
+ * ByteSet::find().
+ */
+const ByteSet headerNameChars = ByteSet("-_.")
+									.addRange('0', '9')
+									.addRange('A', 'Z')
+									.addRange('a', 'z');
+const ByteSet headerValueControlChars = ByteSet("\x7f").addRange(0, 31);
+const ByteSet uriChars = ByteSet("-._~:/?#[]@!$&'()*+,;=%")
+							 .addRange('0', '9')
+							 .addRange('A', 'Z')
+							 .addRange('a', 'z');
+const ByteSet tokenDelimiterChars = ByteSet(delimeterChars.c_str());
+
+/* Delimiter characters not tolerated in the tokens of each accepted header,
+ * in the order of acceptedHeaders. The separator of the header is left out,
+ * so a whole header value can be checked at once.
+ */
+const ByteSet headerForbiddenChars[ACCEPTED_HEADERS_N]
+	= {createHeaderForbiddenChars(0),
+	   createHeaderForbiddenChars(1),
+	   createHeaderForbiddenChars(2),
+	   createHeaderForbiddenChars(3),
+	   createHeaderForbiddenChars(4),
+	   createHeaderForbiddenChars(5),
+	   createHeaderForbiddenChars(6),
+	   createHeaderForbiddenChars(7),
+	   createHeaderForbiddenChars(8),
+	   createHeaderForbiddenChars(9),
+	   createHeaderForbiddenChars(10),
+	   createHeaderForbiddenChars(11),
+	   createHeaderForbiddenChars(12)};
+
+ByteSet createHeaderForbiddenChars(int header)
+{
+	std::string const &name = acceptedHeaders[header];
+	ByteSet			   forbidden(tokenDelimiterChars);
+	char const		  *separator = ",";
+	for (int i = 0; i < SEMICOLON_SEPARATED_N; ++i)
+	{
+		if (semicolonSeparated[i] == name)
+			separator = ";";
+	}
+	forbidden.remove(separator);
+	std::map<std::string, std::string>::const_iterator accepted
+		= headerAcceptedChars.find(name);
+	if (accepted != headerAcceptedChars.end())
+		forbidden.remove(accepted->second.c_str());
+	return forbidden;
+}
+
+/* Gets the index of a header in acceptedHeaders, -1 if it is not accepted.
+ */
+int findAcceptedHeader(std::string const &name)
+{
+	for (int i = 0; i < ACCEPTED_HEADERS_N; ++i)
+	{
+		if (acceptedHeaders[i] == name)
+			return i;
+	}
+	return -1;
+}
@@ -0,0 +1,420 @@
+#include "request_parser/RequestFramer.hpp"
+#include "HttpException.hpp"
+#include "Logger.hpp"
+#include "macros.hpp"
+#include "request_parser/HttpHeaders.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <strings.h>
+
+RequestFramer::RequestFramer(void) : holdBody_(false)
+{
+	reset();
+}
+
+RequestFramer::~RequestFramer(void) {}
+
+/**
+ * @brief Prepares the framer for the next request.
+ */
+void RequestFramer::reset(void)
+{
+	state_ = REQUEST_LINE;
+	head_.clear();
+	body_.clear();
+	view_.headerCount = 0;
+	lineStart_ = 0;
+	contentLength_ = 0;
+	hasContentLength_ = false;
+	bytesLeft_ = 0;
+	bodyLength_ = 0;
+	isBodyStreamed_ = false;
+	isChunked_ = false;
+	inChunkExtension_ = false;
+	hasChunkDigit_ = false;
+	trailerLineLength_ = 0;
+	trailerBytes_ = 0;
+}
+
+/**
+ * @brief Frames and parses newly received bytes.
+ *
+ * @param data The bytes following the ones already fed.
+ * @param length The number of bytes.
+ * @return The number of bytes used, less than length only if the request is
+ * complete or its body is held.
+ * @throws HttpException if the request is invalid.
+ */
+size_t RequestFramer::feed(char const *data, size_t length)
+{
+	size_t used(0);
+	while (used < length && state_ != COMPLETE && state_ != BODY_HELD)
+	{
+		if (state_ == REQUEST_LINE || state_ == HEADERS)
+			used += feedHeaders_(data + used, length - used);
+		else if (state_ == BODY || state_ == CHUNK_DATA)
+			used += feedBody_(data + used, length - used);
+		else if (state_ == CHUNK_SIZE)
+			used += feedChunkSize_(data + used, length - used);
+		else if (state_ == CHUNK_DATA_END)
+			used += feedChunkDataEnd_(data + used, length - used);
+		else if (state_ == TRAILERS)
+			used += feedTrailers_(data + used, length - used);
+	}
+	return used;
+}
+
+/**
+ * @brief Makes the framer stop at the end of the headers of the requests with
+ * a body, until startBody() is called.
+ */
+void RequestFramer::setHoldBody(bool holdBody)
+{
+	holdBody_ = holdBody;
+}
+
+/**
+ * @brief Frames the body held at the end of the headers.
+ *
+ * @param isStreamed Whether the caller drains the body buffer as the body is
+ * framed. A streamed body is not limited to MAX_REQUEST_SIZE.
+ * @throws HttpException if the body is too large to be buffered.
+ */
+void RequestFramer::startBody(bool isStreamed)
+{
+	if (state_ != BODY_HELD)
+		return;
+	isBodyStreamed_ = isStreamed;
+	startBody_();
+}
+
+RequestFramer::State RequestFramer::getState(void) const
+{
+	return state_;
+}
+
+bool RequestFramer::isComplete(void) const
+{
+	return state_ == COMPLETE;
+}
+
+bool RequestFramer::areHeadersRead(void) const
+{
+	return state_ != REQUEST_LINE && state_ != HEADERS;
+}
+
+bool RequestFramer::isChunked(void) const
+{
+	return isChunked_;
+}
+
+bool RequestFramer::isBodyHeld(void) const
+{
+	return state_ == BODY_HELD;
+}
+
+bool RequestFramer::isBodyStreamed(void) const
+{
+	return isBodyStreamed_;
+}
+
+/**
+ * @brief Gets the parsed request line and headers, and the body once the
+ * request is complete. The slices point into the buffers of the framer.
+ */
+RequestView const &RequestFramer::getView(void) const
+{
+	return view_;
+}
+
+/**
+ * @brief Gets the body buffer, which the caller may swap out once the request
+ * is complete.
+ */
+std::vector<char> &RequestFramer::getBody(void)
+{
+	return body_;
+}
+
+// Copies the request line and the headers up to the end of the current line.
+// The empty lines preceding the request line are skipped.
+size_t RequestFramer::feedHeaders_(char const *data, size_t length)
+{
+	size_t skipped(0);
+	if (state_ == REQUEST_LINE && head_.size() == lineStart_)
+	{
+		while (skipped < length
+			   && (data[skipped] == '\r' || data[skipped] == '\n'))
+			++skipped;
+		data += skipped;
+		length -= skipped;
+	}
+	char const *newline
+		= static_cast<char const *>(std::memchr(data, '\n', length));
+	size_t lineLength = newline != NULL ? newline - data + 1 : length;
+	if (head_.size() + lineLength > MAX_HEADER_SIZE)
+	{
+		Logger::log(Logger::DEBUG)
+			<< "RequestFramer: headers over the size limit." << std::endl;
+		throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+	}
+	// The parsed lines point into the head buffer, it must never move
+	if (head_.capacity() < MAX_HEADER_SIZE)
+		head_.reserve(MAX_HEADER_SIZE);
+	head_.insert(head_.end(), data, data + lineLength);
+	if (newline != NULL)
+		endLine_();
+	return skipped + lineLength;
+}
+
+// Copies the body, or the data of the current chunk.
+size_t RequestFramer::feedBody_(char const *data, size_t length)
+{
+	if (length > bytesLeft_)
+		length = bytesLeft_;
+	if (!isBodyStreamed_)
+		checkSize_(head_.size() + bodyLength_ + length);
+	body_.insert(body_.end(), data, data + length);
+	bodyLength_ += length;
+	bytesLeft_ -= length;
+	if (bytesLeft_ == 0)
+	{
+		if (state_ == BODY)
+			complete_();
+		else
+			state_ = CHUNK_DATA_END;
+	}
+	return length;
+}
+
+// Reads the hexadecimal size of a chunk, ignoring its extensions.
+size_t RequestFramer::feedChunkSize_(char const *data, size_t length)
+{
+	for (size_t i = 0; i < length; ++i)
+	{
+		char c = data[i];
+		if (c == '\n')
+		{
+			if (!hasChunkDigit_)
+				throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+			Logger::log(Logger::DEBUG)
+				<< "RequestFramer: chunk of " << bytesLeft_ << " bytes"
+				<< std::endl;
+			state_ = bytesLeft_ == 0 ? TRAILERS : CHUNK_DATA;
+			hasChunkDigit_ = false;
+			inChunkExtension_ = false;
+			return i + 1;
+		}
+		if (inChunkExtension_ || c == '\r')
+			continue;
+		if (c == ';' || c == ' ' || c == '\t')
+		{
+			inChunkExtension_ = true;
+			continue;
+		}
+		if (!std::isxdigit(static_cast<unsigned char>(c)))
+			throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+		int digit = std::isdigit(c) ? c - '0' : (std::tolower(c) - 'a' + 10);
+		bytesLeft_ = bytesLeft_ * 16 + digit;
+		hasChunkDigit_ = true;
+		checkSize_(bytesLeft_);
+	}
+	return length;
+}
+
+// Skips the line break closing the data of a chunk.
+size_t RequestFramer::feedChunkDataEnd_(char const *data, size_t length)
+{
+	for (size_t i = 0; i < length; ++i)
+	{
+		if (data[i] == '\n')
+		{
+			state_ = CHUNK_SIZE;
+			return i + 1;
+		}
+		if (data[i] != '\r')
+			throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+	}
+	return length;
+}
+
+// Skips the trailer fields, up to the empty line ending the request.
+size_t RequestFramer::feedTrailers_(char const *data, size_t length)
+{
+	for (size_t i = 0; i < length; ++i)
+	{
+		if (data[i] == '\n')
+		{
+			if (trailerLineLength_ == 0)
+			{
+				complete_();
+				return i + 1;
+			}
+			trailerLineLength_ = 0;
+		}
+		else if (data[i] != '\r')
+			++trailerLineLength_;
+	}
+	trailerBytes_ += length;
+	checkSize_(trailerBytes_);
+	return length;
+}
+
+// Parses the line ended at the end of the head buffer.
+void RequestFramer::endLine_(void)
+{
+	char const *line = &head_[lineStart_];
+	size_t		length = head_.size() - lineStart_;
+	if (state_ == REQUEST_LINE)
+	{
+		SliceParser::parseStartLine(line, length, view_);
+		state_ = HEADERS;
+	}
+	else if (length == 1 || (length == 2 && line[0] == '\r'))
+	{
+		SliceParser::checkHeaders(view_);
+		if (isChunked_ && hasContentLength_)
+		{
+			Logger::log(Logger::DEBUG)
+				<< "RequestFramer: both Transfer-Encoding and Content-Length."
+				<< std::endl;
+			throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+		}
+		if (holdBody_ && (isChunked_ || contentLength_ > 0))
+			state_ = BODY_HELD;
+		else
+			startBody_();
+	}
+	else
+	{
+		SliceParser::parseHeaderLine(line, length, view_);
+		checkHeader_(view_.headers[view_.headerCount - 1]);
+	}
+	lineStart_ = head_.size();
+}
+
+// Looks for the headers framing the body. Chunked is the only transfer coding
+// supported, other codings are not implemented. A repeated Content-Length
+// must repeat the same value.
+void RequestFramer::checkHeader_(HeaderSlice const &header)
+{
+	if (header.id < 0)
+		return;
+	std::string const &name = acceptedHeaders[header.id];
+	Slice const		  &value = header.value;
+	if (name == "Transfer-Encoding")
+		checkTransferEncoding_(value);
+	else if (name == "Content-Length")
+	{
+		if (value.length == 0 || value.length > 18)
+			throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+		size_t contentLength(0);
+		for (size_t i = 0; i < value.length; ++i)
+		{
+			if (!std::isdigit(value.data[i]))
+				throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+			contentLength = contentLength * 10 + (value.data[i] - '0');
+		}
+		if (hasContentLength_ && contentLength != contentLength_)
+		{
+			Logger::log(Logger::DEBUG)
+				<< "RequestFramer: conflicting Content-Length values."
+				<< std::endl;
+			throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+		}
+		hasContentLength_ = true;
+		contentLength_ = contentLength;
+	}
+}
+
+// Reads the comma separated codings of a Transfer-Encoding. Chunked must be
+// the final coding and appear once.
+void RequestFramer::checkTransferEncoding_(Slice const &value)
+{
+	bool   hasCoding(false);
+	size_t start(0);
+	for (size_t end = 0; end <= value.length; ++end)
+	{
+		if (end < value.length && value.data[end] != ',')
+			continue;
+		size_t first(start);
+		size_t last(end);
+		start = end + 1;
+		while (first < last
+			   && (value.data[first] == ' ' || value.data[first] == '\t'))
+			++first;
+		while (last > first
+			   && (value.data[last - 1] == ' ' || value.data[last - 1] == '\t'))
+			--last;
+		if (first == last)
+			continue;
+		hasCoding = true;
+		if (last - first != 7
+			|| strncasecmp(value.data + first, "chunked", 7) != 0)
+		{
+			Logger::log(Logger::DEBUG)
+				<< "RequestFramer: unsupported transfer coding." << std::endl;
+			throw HttpException(HTTP_501_CODE, HTTP_501_REASON);
+		}
+		if (isChunked_)
+		{
+			Logger::log(Logger::DEBUG)
+				<< "RequestFramer: chunked applied more than once."
+				<< std::endl;
+			throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+		}
+		isChunked_ = true;
+	}
+	if (!hasCoding)
+		throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+}
+
+// Chooses how the body is framed once the headers are complete.
+void RequestFramer::startBody_(void)
+{
+	if (isChunked_)
+	{
+		state_ = CHUNK_SIZE;
+		bytesLeft_ = 0;
+	}
+	else if (contentLength_ > 0)
+	{
+		if (!isBodyStreamed_)
+		{
+			checkSize_(head_.size() + contentLength_);
+			// The body grows as it arrives, a client announcing a large body
+			// and sending none does not hold the memory
+			body_.reserve(std::min<size_t>(contentLength_, CLIENT_BUFFER_SIZE));
+		}
+		state_ = BODY;
+		bytesLeft_ = contentLength_;
+	}
+	Logger::log(Logger::DEBUG)
+		<< "RequestFramer: headers read, body is "
+		<< (isChunked_ ? "chunked" : ft::toString(contentLength_) + " bytes")
+		<< std::endl;
+	if (!isChunked_ && contentLength_ == 0)
+		complete_();
+}
+
+// Checks the body of the complete request against its headers.
+void RequestFramer::complete_(void)
+{
+	view_.body.data = body_.empty() ? NULL : &body_[0];
+	view_.body.length = bodyLength_;
+	SliceParser::checkBody(view_);
+	state_ = COMPLETE;
+}
+
+void RequestFramer::checkSize_(size_t size) const
+{
+	if (size > MAX_REQUEST_SIZE)
+	{
+		Logger::log(Logger::DEBUG)
+			<< "RequestFramer: request over the size limit." << std::endl;
+		throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+	}
+}
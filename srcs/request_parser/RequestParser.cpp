@@ -7,6 +7,7 @@
 #include "request_parser/TokenValidator.hpp"
 #include <cctype>
 #include <cstdlib>
+#include <cstring>
 #include <map>
 #include <sstream>
 #include <vector>
@@ -22,11 +23,6 @@ HttpRequest RequestParser::parseRequest(std::string str)
 	// clang-format on
 	std::vector<char> body;
 
-	// Initialize the map with accepted headers
-	// Only create map once, c++98 sucks!
-	if (!headerAcceptedChars.empty())
-		createHeaderAcceptedChars();
-
 	std::istringstream requestStream(str);
 
 	// Print request_string to debug
@@ -49,3 +45,81 @@ HttpRequest RequestParser::parseRequest(std::string str)
 	HttpRequest req(method, httpVersion, uri, headers, body);
 	return req;
 }
+
+/**
+ * @brief Creates a request parsed by SliceParser.
+ *
+ * The accepted headers are stored under their canonical name, their values
+ * split like HeaderParser does. The ignored headers are left out.
+ *
+ * @param view The parsed request line, headers and body.
+ * @param body The body buffer of the view, swapped into the request and left
+ * empty.
+ * @return The request, to be deleted by the caller.
+ */
+HttpRequest *RequestParser::createRequest(
+	RequestView const &view,
+	std::vector<char> &body
+)
+{
+	std::string method(view.method.toString());
+	std::string httpVersion(view.httpVersion.toString());
+	std::string uri(view.uri.toString());
+	// clang-format off
+	std::map<std::string, std::vector<std::string> > headers;
+	// clang-format on
+	std::vector<char> noBody;
+
+	for (size_t i = 0; i < view.headerCount; ++i)
+	{
+		HeaderSlice const &header = view.headers[i];
+		if (header.id >= 0)
+		{
+			std::string const &name = acceptedHeaders[header.id];
+			splitHeaderValue_(name, header.value, headers[name]);
+		}
+	}
+	// Host is the only header allowed an empty value
+	if (headers["Host"].empty())
+		headers["Host"].push_back("");
+
+	HttpRequest *request
+		= new HttpRequest(method, httpVersion, uri, headers, noBody);
+	request->swapBody(body);
+	return request;
+}
+
+// Appends the trimmed, non empty items of a header value, separated by commas
+// or by semicolons for the headers in semicolonSeparated.
+void RequestParser::splitHeaderValue_(
+	std::string const		 &name,
+	Slice const				 &value,
+	std::vector<std::string> &values
+)
+{
+	char separator(',');
+	for (int i = 0; i < SEMICOLON_SEPARATED_N; ++i)
+	{
+		if (semicolonSeparated[i] == name)
+			separator = ';';
+	}
+	char const *item = value.data;
+	char const *end = value.data + value.length;
+	while (item < end)
+	{
+		char const *itemEnd = static_cast<char const *>(
+			std::memchr(item, separator, end - item)
+		);
+		if (itemEnd == NULL)
+			itemEnd = end;
+		char const *first = item;
+		char const *last = itemEnd;
+		while (first < last && (*first == ' ' || *first == '\t'))
+			++first;
+		while (last > first && (last[-1] == ' ' || last[-1] == '\t'))
+			--last;
+		if (first < last)
+			values.push_back(std::string(first, last));
+		item = itemEnd + 1;
+	}
+}
@@ -0,0 +1,402 @@
+#include "request_parser/SliceParser.hpp"
+#include "HttpException.hpp"
+#include "Logger.hpp"
+#include "request_parser/HttpHeaders.hpp"
+
+#include <cctype>
+#include <cstring>
+#include <strings.h>
+
+bool Slice::equals(std::string const &str) const
+{
+	return length == str.size() && std::memcmp(data, str.data(), length) == 0;
+}
+
+bool Slice::caseEquals(std::string const &str) const
+{
+	return length == str.size() && strncasecmp(data, str.data(), length) == 0;
+}
+
+std::string Slice::toString(void) const
+{
+	return std::string(data, length);
+}
+
+/**
+ * @brief Looks for a header by name, case insensitively.
+ *
+ * @param name The name of the header.
+ * @return The first header with this name, NULL if there is none.
+ */
+HeaderSlice const *RequestView::findHeader(std::string const &name) const
+{
+	for (size_t i = 0; i < headerCount; ++i)
+	{
+		if (headers[i].name.caseEquals(name))
+			return &headers[i];
+	}
+	return NULL;
+}
+
+/**
+ * @brief Parses a complete request in place.
+ *
+ * @param data The bytes of the request, the body decoded if it was chunked.
+ * @param length The number of bytes.
+ * @param view Filled with slices of data.
+ * @throws HttpException if the request is malformed.
+ */
+void SliceParser::parseRequest(
+	char const	*data,
+	size_t		 length,
+	RequestView &view
+)
+{
+	size_t offset = nextLine_(data, length, 0);
+	parseStartLine(data, offset, view);
+	while (offset < length)
+	{
+		size_t next = nextLine_(data, length, offset);
+		if (lineLength_(data + offset, next - offset) == 0)
+		{
+			offset = next;
+			break;
+		}
+		parseHeaderLine(data + offset, next - offset, view);
+		offset = next;
+	}
+	checkHeaders(view);
+	view.body.data = data + offset;
+	view.body.length = length - offset;
+	checkBody(view);
+}
+
+/**
+ * @brief Splits the start line in method, URI and version and checks them.
+ * The headers of the view are cleared.
+ *
+ * @param line The start line, its line break included or not.
+ * @param length The length of the line.
+ * @param view Receives the method, URI and version.
+ * @throws HttpException if the start line is malformed, 501 if the version is
+ * not HTTP/1.1.
+ */
+void SliceParser::parseStartLine(
+	char const	*line,
+	size_t		 length,
+	RequestView &view
+)
+{
+	view.headerCount = 0;
+	length = lineLength_(line, length);
+
+	Slice *parts[3] = {&view.method, &view.uri, &view.httpVersion};
+	size_t i(0);
+	for (int part = 0; part < 3; ++part)
+	{
+		while (i < length && std::isspace(line[i]))
+			++i;
+		parts[part]->data = line + i;
+		while (i < length && !std::isspace(line[i]))
+			++i;
+		parts[part]->length = line + i - parts[part]->data;
+		if (parts[part]->length == 0)
+		{
+			Logger::log(Logger::DEBUG)
+				<< "Request start line is malformed: "
+				<< std::string(line, length) << std::endl;
+			throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+		}
+	}
+
+	std::string methods[] = HTTP_ACCEPTED_METHODS;
+	size_t		methodsSize = sizeof(methods) / sizeof(std::string);
+	size_t		m(0);
+	while (m < methodsSize && !view.method.equals(methods[m]))
+		++m;
+	if (m == methodsSize)
+		Logger::log(Logger::DEBUG)
+			<< "Method not found: " << view.method.toString() << std::endl;
+	checkUri_(view.uri);
+	if (!view.httpVersion.equals("HTTP/1.1"))
+	{
+		Logger::log(Logger::DEBUG)
+			<< "HTTP version is not \'HTTP/1.1\': "
+			<< view.httpVersion.toString() << std::endl;
+		throw HttpException(HTTP_501_CODE, HTTP_501_REASON);
+	}
+}
+
+/**
+ * @brief Splits a header line at its colon, checks the syntax of the name and
+ * the value, and adds the header to the view, its value trimmed.
+ *
+ * @param line The header line, its line break included or not. It must not be
+ * empty.
+ * @param length The length of the line.
+ * @param view Receives the header.
+ * @throws HttpException if the header is malformed or if the view is full.
+ */
+void SliceParser::parseHeaderLine(
+	char const	*line,
+	size_t		 length,
+	RequestView &view
+)
+{
+	length = lineLength_(line, length);
+	if (view.headerCount == REQUEST_MAX_HEADERS)
+	{
+		Logger::log(Logger::DEBUG) << "Request has more than "
+								   << REQUEST_MAX_HEADERS << " headers."
+								   << std::endl;
+		throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+	}
+	// The name ends at the first byte that is not a name character, which
+	// must be the colon
+	size_t nameLength = headerNameChars.span(line, length);
+	if (nameLength == length || line[nameLength] != ':')
+	{
+		if (std::memchr(line, ':', length) == NULL)
+			Logger::log(Logger::DEBUG)
+				<< "Header does not contain colon (:). Header: "
+				<< std::string(line, length) << std::endl;
+		else
+			Logger::log(Logger::DEBUG)
+				<< "Header name is malformed. Header: "
+				<< std::string(line, length) << std::endl;
+		throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+	}
+	if (nameLength == 0)
+	{
+		Logger::log(Logger::DEBUG) << "Header name is empty." << std::endl;
+		throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+	}
+	HeaderSlice &header = view.headers[view.headerCount];
+	header.name.data = line;
+	header.name.length = nameLength;
+
+	char const *colon = line + nameLength;
+	char const *start = colon + 1;
+	char const *end = line + length;
+	while (start < end && (*start == ' ' || *start == '\t'))
+		++start;
+	while (end > start && (end[-1] == ' ' || end[-1] == '\t'))
+		--end;
+	header.value.data = start;
+	header.value.length = end - start;
+	if (headerValueControlChars.find(start, end - start) != header.value.length)
+	{
+		Logger::log(Logger::DEBUG)
+			<< "Header value is malformed. Header value: "
+			<< header.value.toString() << std::endl;
+		throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+	}
+	header.id = findAcceptedHeader_(header.name);
+	++view.headerCount;
+}
+
+/**
+ * @brief Checks that the URI is '*', or starts with '/', http:// or https://,
+ * that it has only valid characters and that its percent-encoded characters
+ * are hexadecimal.
+ */
+void SliceParser::checkUri_(Slice const &uri)
+{
+	if (uri.equals("*"))
+		return;
+
+	std::string absolute(uri.data, uri.length < 8 ? uri.length : 8);
+	if (uri.data[0] != '/' && absolute.find("http://") != 0
+		&& absolute.find("https://") != 0)
+	{
+		Logger::log(Logger::DEBUG) << "Uri is not \'*\' and does not start with "
+									  "/, http://, or https://: "
+								   << uri.toString() << std::endl;
+		throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+	}
+
+	if (uriChars.span(uri.data, uri.length) != uri.length)
+	{
+		Logger::log(Logger::DEBUG) << "Uri contains incorrect characters: "
+								   << uri.toString() << std::endl;
+		throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+	}
+	char const *end = uri.data + uri.length;
+	char const *percent = uri.data;
+	while ((percent = static_cast<char const *>(
+				std::memchr(percent, '%', end - percent)
+			))
+		   != NULL)
+	{
+		if (end - percent < 3 || !std::isxdigit(percent[1])
+			|| !std::isxdigit(percent[2]))
+		{
+			Logger::log(Logger::DEBUG)
+				<< "Uri contains non-hex characters after \'%\': "
+				<< uri.toString() << std::endl;
+			throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+		}
+		++percent;
+	}
+}
+
+/**
+ * @brief Checks that the tokens of a header value only use the delimiter
+ * characters tolerated for this header.
+ *
+ * The separator of the tokens and the blanks around them are not delimiters,
+ * so the whole value is checked at once against headerForbiddenChars.
+ */
+void SliceParser::checkTokens_(HeaderSlice const &header)
+{
+	Slice const &value = header.value;
+	size_t		 invalid
+		= headerForbiddenChars[header.id].find(value.data, value.length);
+	if (invalid != value.length)
+	{
+		Logger::log(Logger::DEBUG)
+			<< "Header contains token with invalid delimeter character "
+			   "Header: "
+			<< acceptedHeaders[header.id] << " | value: " << value.toString()
+			<< " | invalid delimeter char: " << value.data[invalid]
+			<< std::endl;
+		throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+	}
+}
+
+/**
+ * @brief Checks the accepted headers together: only Host may be empty, Host
+ * must appear exactly once and only the repeatable headers may appear more
+ * than once. The ignored headers are not checked.
+ */
+void SliceParser::checkHeaders(RequestView const &view)
+{
+	int counts[ACCEPTED_HEADERS_N] = {0};
+	int hostId(-1);
+
+	for (size_t i = 0; i < view.headerCount; ++i)
+	{
+		HeaderSlice const &header = view.headers[i];
+		if (header.id < 0)
+			continue;
+		std::string const &name = acceptedHeaders[header.id];
+		bool			   isHost = name == "Host";
+		if (isHost)
+			hostId = header.id;
+		if (header.value.length == 0 && !isHost)
+		{
+			Logger::log(Logger::DEBUG)
+				<< "Header has emtpy value and is not Host. Header: " << name
+				<< std::endl;
+			throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+		}
+		if (++counts[header.id] > 1 && (isHost || !isRepeatable_(name)))
+		{
+			Logger::log(Logger::DEBUG)
+				<< "Non-repeatable header appears more than once. Header: "
+				<< name << std::endl;
+			throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+		}
+		checkTokens_(header);
+	}
+	if (hostId == -1)
+	{
+		Logger::log(Logger::DEBUG) << "Absent Host header." << std::endl;
+		throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+	}
+}
+
+/**
+ * @brief Checks the body against the method and the headers: GET and DELETE
+ * have no body nor body headers, POST has a Content-Length or a
+ * Transfer-Encoding, and a Content-Length matches the body.
+ */
+void SliceParser::checkBody(RequestView const &view)
+{
+	HeaderSlice const *contentLength = view.findHeader("Content-Length");
+	HeaderSlice const *transferEncoding = view.findHeader("Transfer-Encoding");
+
+	if (view.method.equals("GET") || view.method.equals("DELETE"))
+	{
+		if (contentLength != NULL || transferEncoding != NULL)
+		{
+			Logger::log(Logger::DEBUG)
+				<< "checkBody: GET or DELETE method should not have "
+				   "Content-Length header present. Method:"
+				<< view.method.toString() << std::endl;
+			throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+		}
+		if (view.body.length > 0)
+		{
+			Logger::log(Logger::DEBUG)
+				<< "Body should be empty for GET or DELETE requests."
+				<< std::endl;
+			throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+		}
+		return;
+	}
+	if (!view.method.equals("POST"))
+		return;
+	if (contentLength == NULL && transferEncoding == NULL)
+	{
+		Logger::log(Logger::DEBUG)
+			<< "checkBody: POST method requires Content-Length "
+			   "or Transfer-Encoding header."
+			<< std::endl;
+		throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+	}
+	if (contentLength == NULL)
+		return;
+	unsigned long length(0);
+	for (size_t i = 0; i < contentLength->value.length
+					   && std::isdigit(contentLength->value.data[i]);
+		 ++i)
+		length = length * 10 + (contentLength->value.data[i] - '0');
+	if (length != view.body.length)
+	{
+		Logger::log(Logger::DEBUG)
+			<< "checkBody: Content-Length does not match actual body length. "
+			   "Stated length: "
+			<< length << " Actual length: " << view.body.length << std::endl;
+		throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
+	}
+}
+
+// Gets the offset of the line following the one starting at offset.
+size_t SliceParser::nextLine_(char const *data, size_t length, size_t offset)
+{
+	char const *newline = static_cast<char const *>(
+		std::memchr(data + offset, '\n', length - offset)
+	);
+	return newline != NULL ? newline - data + 1 : length;
+}
+
+// Gets the length of a line without its line break.
+size_t SliceParser::lineLength_(char const *line, size_t length)
+{
+	if (length > 0 && line[length - 1] == '\n')
+		--length;
+	if (length > 0 && line[length - 1] == '\r')
+		--length;
+	return length;
+}
+
+int SliceParser::findAcceptedHeader_(Slice const &name)
+{
+	for (int i = 0; i < ACCEPTED_HEADERS_N; ++i)
+	{
+		if (name.caseEquals(acceptedHeaders[i]))
+			return i;
+	}
+	return -1;
+}
+
+bool SliceParser::isRepeatable_(std::string const &name)
+{
+	for (int i = 0; i < REPEATABLE_HEADERS_N; ++i)
+	{
+		if (repeatableHeaders[i] == name)
+			return true;
+	}
+	return false;
+}
@@ -16,32 +16,30 @@ void TokenValidator::validateTokens(
 	// clang-format off
 	typedef std::map<std::string, std::vector<std::string> > HeadersMap;
 	// clang-format on
-	typedef std::vector<std::string>	TokensVector;
-	typedef std::string::const_iterator CharIterator;
+	typedef std::vector<std::string> TokensVector;
 
 	for (HeadersMap::const_iterator header = headers.begin();
 		 header != headers.end();
 		 ++header)
 	{
+		// A header without tolerated characters may not use any delimiter
+		int			   id = findAcceptedHeader(header->first);
+		ByteSet const &forbidden
+			= id >= 0 ? headerForbiddenChars[id] : tokenDelimiterChars;
 		for (TokensVector::const_iterator token = header->second.begin();
 			 token != header->second.end();
 			 ++token)
 		{
-			for (CharIterator c = token->begin(); c != token->end(); ++c)
+			size_t invalid = forbidden.find(token->data(), token->size());
+			if (invalid != token->size())
 			{
-				// If character is within the delimeter chars and also not
-				// whithin the exceptions allowed for its header
-				if (delimeterChars.find(*c) != std::string::npos
-					&& headerAcceptedChars.find(header->first)->second.find(*c)
-						   == std::string::npos)
-				{
-					Logger::log(Logger::DEBUG)
-						<< "Header contains token with invalid delimeter "
-						   "character Header: "
-						<< header->first << " | failed token: " << *token
-						<< " | invalid delimeter char: " << *c << std::endl;
-					throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
-				}
+				Logger::log(Logger::DEBUG)
+					<< "Header contains token with invalid delimeter "
+					   "character Header: "
+					<< header->first << " | failed token: " << *token
+					<< " | invalid delimeter char: " << (*token)[invalid]
+					<< std::endl;
+				throw HttpException(HTTP_400_CODE, HTTP_400_REASON);
 			}
 		}
 	}
@@ -1,3 +1,3 @@
 #include "ServerEngine.hpp"
 
-bool g_shutdown = false;
+volatile sig_atomic_t g_shutdown = 0;
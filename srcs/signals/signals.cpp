@@ -1,74 +1,45 @@
 #include "signals.hpp"
-#include "Logger.hpp"
 #include "ServerEngine.hpp"
 #include <csignal>
-#include <cstdlib>
-#include <iostream>
 
 namespace signals
 {
 
-static void handleInterrupt(int signal)
+// Only sets the flag, which is safe in a signal handler: the event loops log
+// the shutdown once they see it.
+static void handleShutdown(int signal)
 {
-	if (signal == SIGINT)
-	{
-		std::cout << '\n';
-		Logger::log(Logger::DEBUG)
-			<< "SIGINT received. Exiting..." << std::endl;
-		g_shutdown = true;
-	}
-}
-
-static void handleQuit(int signal)
-{
-	if (signal == SIGQUIT)
-	{
-		Logger::log(Logger::DEBUG)
-			<< "SIGQUIT received. Exiting..." << std::endl;
-		std::exit(signal);
-	}
-}
-
-static void handleTerminate(int signal)
-{
-	if (signal == SIGTERM)
-	{
-		Logger::log(Logger::DEBUG)
-			<< "SIGTERM received. Exiting..." << std::endl;
-		std::exit(signal);
-	}
+	g_shutdown = signal;
 }
 
 // TODO: Implement the SIGHUP signal to change the status from a global
 // variable to restart the config and servers.
 static void handleHangup(int signal)
 {
-	if (signal == SIGHUP)
-	{
-		Logger::log(Logger::DEBUG)
-			<< "SIGHUP received. Reloading the configuration file and "
-			   "restarting the server..."
-			<< std::endl;
-	}
+	(void)signal;
 }
 
-static void handlePipe(int signal)
+void handleSignals(void)
 {
-	if (signal == SIGPIPE)
-	{
-		Logger::log(Logger::DEBUG)
-			<< "SIGPIPE received. Client disconnected unexpectedly."
-			<< std::endl;
-	}
+	std::signal(SIGINT, handleShutdown);
+	std::signal(SIGQUIT, handleShutdown);
+	std::signal(SIGTERM, handleShutdown);
+	std::signal(SIGHUP, handleHangup);
+	// A write to a closed socket or pipe fails with EPIPE instead
+	std::signal(SIGPIPE, SIG_IGN);
 }
 
-void handleSignals(void)
+/**
+ * @brief Gets the signals the reactor threads block, so that they are handled
+ * by the thread waiting for them.
+ */
+void getHandledSignals(sigset_t &signals)
 {
-	std::signal(SIGINT, handleInterrupt);
-	std::signal(SIGQUIT, handleQuit);
-	std::signal(SIGTERM, handleTerminate);
-	std::signal(SIGHUP, handleHangup);
-	std::signal(SIGPIPE, handlePipe);
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGQUIT);
+	sigaddset(&signals, SIGTERM);
+	sigaddset(&signals, SIGHUP);
 }
 
 } // namespace signals
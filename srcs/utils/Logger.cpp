@@ -5,8 +5,11 @@
 
 // The static variable level_ is set to DEBUG by default.
 Logger::Level Logger::level_ = Logger::DEBUG;
-// The static variable instance_ is the instance of the Logger class.
-Logger Logger::instance_;
+// Every thread gets its own instance of the Logger class, stored in the
+// thread-specific instanceKey_. The output mutex keeps the lines whole.
+pthread_key_t	Logger::instanceKey_;
+pthread_once_t	Logger::instanceOnce_ = PTHREAD_ONCE_INIT;
+pthread_mutex_t Logger::outputMutex_ = PTHREAD_MUTEX_INITIALIZER;
 
 // Private constructor, the constructor is private to prevent the creation of
 // multiple instances of the Logger class.
@@ -14,6 +17,54 @@ Logger::Logger(void) : currentLevel_(DEBUG), isError_(false){};
 
 Logger::~Logger(void){};
 
+// getInstance_ returns the Logger instance of the calling thread, creating it
+// on the first log of the thread.
+Logger &Logger::getInstance_(void)
+{
+	pthread_once(&instanceOnce_, initInstanceKey_);
+	Logger *instance = static_cast<Logger *>(pthread_getspecific(instanceKey_));
+	if (instance == NULL)
+	{
+		instance = new Logger();
+		pthread_setspecific(instanceKey_, instance);
+	}
+	return *instance;
+}
+
+// The fork handlers make sure a child process (CGI, worker) never inherits the
+// output mutex locked by another thread.
+void Logger::initInstanceKey_(void)
+{
+	pthread_key_create(&instanceKey_, deleteInstance_);
+	pthread_atfork(lockOutput_, unlockOutput_, unlockOutput_);
+}
+
+void Logger::deleteInstance_(void *instance)
+{
+	delete static_cast<Logger *>(instance);
+}
+
+void Logger::lockOutput_(void)
+{
+	pthread_mutex_lock(&outputMutex_);
+}
+
+void Logger::unlockOutput_(void)
+{
+	pthread_mutex_unlock(&outputMutex_);
+}
+
+// write_ prints the finished message in one piece to stdout or stderr.
+void Logger::write_(void) const
+{
+	lockOutput_();
+	if (this->isError_)
+		std::cerr << this->stream_.str();
+	else
+		std::cout << this->stream_.str();
+	unlockOutput_();
+}
+
 void Logger::setLevel(Level level)
 {
 	level_ = level;
@@ -67,13 +118,13 @@ void Logger::prepareLog_(Level const &level)
 {
 	this->currentLevel_ = level;
 
-	time_t	   rawTime;
-	struct tm *timeInfo;
-	char	   buffTime[32];
+	time_t	  rawTime;
+	struct tm timeInfo;
+	char	  buffTime[32];
 
 	time(&rawTime);
-	timeInfo = localtime(&rawTime);
-	if (strftime(buffTime, sizeof(buffTime), "%T", timeInfo) == 0)
+	if (localtime_r(&rawTime, &timeInfo) == NULL
+		|| strftime(buffTime, sizeof(buffTime), "%T", &timeInfo) == 0)
 		buffTime[0] = '\0';
 
 	std::string const color(this->getColor_(this->currentLevel_));
@@ -4,10 +4,12 @@
 
 #include <climits>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <map>
 #include <vector>
 #include <sstream>
+#include <unistd.h>
 
 namespace ft
 {
@@ -152,6 +154,53 @@ unsigned long stringToULong(std::string const &str)
 	return value;
 }
 
+unsigned int getWorkerCount(std::string const &value)
+{
+	long count(1);
+	if (value == "auto")
+		count = sysconf(_SC_NPROCESSORS_ONLN);
+	else if (!value.empty() && isStrOfDigits(value))
+		count = stringToULong(value);
+	if (count < 1)
+		count = 1;
+	return count;
+}
+
+// Splits a time value into its number and its unit multiplier in ms. Returns
+// 0 if the unit is unknown.
+static unsigned long getTimeUnit_(std::string const &str, std::string &number)
+{
+	size_t unitPos = str.find_first_not_of("0123456789");
+	number = str.substr(0, unitPos);
+	if (unitPos == std::string::npos || str.compare(unitPos, 2, "s") == 0)
+		return 1000;
+	std::string unit = str.substr(unitPos);
+	if (unit == "ms")
+		return 1;
+	if (unit == "m")
+		return 60 * 1000;
+	if (unit == "h")
+		return 60 * 60 * 1000;
+	return 0;
+}
+
+bool isTime(std::string const &str)
+{
+	std::string number;
+	if (getTimeUnit_(str, number) == 0 || number.empty() || number.size() > 9)
+		return false;
+	return true;
+}
+
+unsigned long timeToMs(std::string const &str)
+{
+	std::string	  number;
+	unsigned long unit = getTimeUnit_(str, number);
+	if (unit == 0 || number.empty())
+		throw ServerException("Invalid time value: " + str);
+	return stringToULong(number) * unit;
+}
+
 bool isURI(std::string const &str)
 {
 	if (str.empty())
@@ -174,36 +223,42 @@ bool isURL(std::string const &str)
 	return true;
 }
 
-std::string getMimeType(std::string const &filePath)
+// The lookup tables are built once, before main, and only read afterwards, so
+// they can be shared by the reactor threads without locking.
+static std::map<std::string, std::string> const createMimeTypes_(void)
 {
-	static std::map<std::string, std::string> mimeTypes;
-	if (mimeTypes.empty())
-	{
-		mimeTypes["html"] = "text/html; charset=UTF-8";
-		mimeTypes["htm"] = "text/html; charset=UTF-8";
-		mimeTypes["css"] = "text/css; charset=UTF-8";
-		mimeTypes["js"] = "application/javascript; charset=UTF-8";
-		mimeTypes["json"] = "application/json; charset=UTF-8";
-		mimeTypes["jpg"] = "image/jpeg";
-		mimeTypes["jpeg"] = "image/jpeg";
-		mimeTypes["png"] = "image/png";
-		mimeTypes["gif"] = "image/gif";
-		mimeTypes["txt"] = "text/plain; charset=UTF-8";
-		mimeTypes["xml"] = "application/xml; charset=UTF-8";
-		mimeTypes["pdf"] = "application/pdf";
-		mimeTypes["zip"] = "application/zip";
-		mimeTypes["mp3"] = "audio/mpeg";
-		mimeTypes["mp4"] = "video/mp4";
-		mimeTypes["avi"] = "video/x-msvideo";
-	}
+	std::map<std::string, std::string> mimeTypes;
+	mimeTypes["html"] = "text/html; charset=UTF-8";
+	mimeTypes["htm"] = "text/html; charset=UTF-8";
+	mimeTypes["css"] = "text/css; charset=UTF-8";
+	mimeTypes["js"] = "application/javascript; charset=UTF-8";
+	mimeTypes["json"] = "application/json; charset=UTF-8";
+	mimeTypes["jpg"] = "image/jpeg";
+	mimeTypes["jpeg"] = "image/jpeg";
+	mimeTypes["png"] = "image/png";
+	mimeTypes["gif"] = "image/gif";
+	mimeTypes["txt"] = "text/plain; charset=UTF-8";
+	mimeTypes["xml"] = "application/xml; charset=UTF-8";
+	mimeTypes["pdf"] = "application/pdf";
+	mimeTypes["zip"] = "application/zip";
+	mimeTypes["mp3"] = "audio/mpeg";
+	mimeTypes["mp4"] = "video/mp4";
+	mimeTypes["avi"] = "video/x-msvideo";
+	return mimeTypes;
+}
 
+static std::map<std::string, std::string> const mimeTypes_
+	= createMimeTypes_();
+
+std::string getMimeType(std::string const &filePath)
+{
 	size_t dotPos = filePath.rfind('.');
 	if (dotPos != std::string::npos)
 	{
 		std::string extension = filePath.substr(dotPos + 1);
 		std::map<std::string, std::string>::const_iterator it
-			= mimeTypes.find(extension);
-		if (it != mimeTypes.end())
+			= mimeTypes_.find(extension);
+		if (it != mimeTypes_.end())
 		{
 			return it->second;
 		}
@@ -265,48 +320,75 @@ std::string readErrorPage(const std::string &filePath)
 
 std::string createTimestamp()
 {
-	time_t	   now = time(0);
-	struct tm *tstruct = localtime(&now);
-	if (tstruct == NULL)
+	return formatHttpDate(time(0));
+}
+
+std::string formatHttpDate(time_t time)
+{
+	struct tm tstruct;
+	if (gmtime_r(&time, &tstruct) == NULL)
 	{
-		throw std::runtime_error("Failed to get local time");
+		throw std::runtime_error("Failed to get the time");
 	}
 
 	char buf[80];
-	strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", tstruct);
+	strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tstruct);
 	return std::string(buf);
 }
 
+// Only the IMF-fixdate format is read, the one every current client sends.
+bool parseHttpDate(std::string const &str, time_t &time)
+{
+	struct tm	tstruct;
+	char const *end;
+
+	std::memset(&tstruct, 0, sizeof(tstruct));
+	end = strptime(str.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tstruct);
+	if (end == NULL || *end != '\0')
+		return false;
+	time = timegm(&tstruct);
+	return time != -1;
+}
+
+static std::map<int, std::string> const createHttpStatusCodes_(void)
+{
+	std::map<int, std::string> httpStatusCodes;
+	httpStatusCodes[200] = "OK";
+	httpStatusCodes[201] = "Created";
+	httpStatusCodes[202] = "Accepted";
+	httpStatusCodes[204] = "No Content";
+	httpStatusCodes[206] = "Partial Content";
+	httpStatusCodes[301] = "Moved Permanently";
+	httpStatusCodes[302] = "Found";
+	httpStatusCodes[303] = "See Other";
+	httpStatusCodes[304] = "Not Modified";
+	httpStatusCodes[400] = "Bad Request";
+	httpStatusCodes[401] = "Unauthorized";
+	httpStatusCodes[403] = "Forbidden";
+	httpStatusCodes[404] = "Not Found";
+	httpStatusCodes[405] = "Method Not Allowed";
+	httpStatusCodes[408] = "Request Timeout";
+	httpStatusCodes[411] = "Length Required";
+	httpStatusCodes[413] = "Payload Too Large";
+	httpStatusCodes[414] = "URI Too Long";
+	httpStatusCodes[415] = "Unsupported Media Type";
+	httpStatusCodes[416] = "Range Not Satisfiable";
+	httpStatusCodes[500] = "Internal Server Error";
+	httpStatusCodes[501] = "Not Implemented";
+	httpStatusCodes[505] = "HTTP Version Not Supported";
+	return httpStatusCodes;
+}
+
+static std::map<int, std::string> const httpStatusCodes_
+	= createHttpStatusCodes_();
+
 std::string const &getStatusCodeReason(int const &statusCode)
 {
-	static std::map<int, std::string> httpStatusCodes;
-	if (httpStatusCodes.empty())
-	{
-		httpStatusCodes[200] = "OK";
-		httpStatusCodes[201] = "Created";
-		httpStatusCodes[202] = "Accepted";
-		httpStatusCodes[204] = "No Content";
-		httpStatusCodes[301] = "Moved Permanently";
-		httpStatusCodes[302] = "Found";
-		httpStatusCodes[303] = "See Other";
-		httpStatusCodes[304] = "Not Modified";
-		httpStatusCodes[400] = "Bad Request";
-		httpStatusCodes[401] = "Unauthorized";
-		httpStatusCodes[403] = "Forbidden";
-		httpStatusCodes[404] = "Not Found";
-		httpStatusCodes[405] = "Method Not Allowed";
-		httpStatusCodes[408] = "Request Timeout";
-		httpStatusCodes[411] = "Length Required";
-		httpStatusCodes[413] = "Payload Too Large";
-		httpStatusCodes[414] = "URI Too Long";
-		httpStatusCodes[415] = "Unsupported Media Type";
-		httpStatusCodes[500] = "Internal Server Error";
-		httpStatusCodes[501] = "Not Implemented";
-		httpStatusCodes[505] = "HTTP Version Not Supported";
-	}
-	if (httpStatusCodes.find(statusCode) == httpStatusCodes.end())
-		return httpStatusCodes[500];
-	return httpStatusCodes[statusCode];
+	std::map<int, std::string>::const_iterator it
+		= httpStatusCodes_.find(statusCode);
+	if (it == httpStatusCodes_.end())
+		return httpStatusCodes_.find(500)->second;
+	return it->second;
 }
 
 std::vector<std::string> const initLogLevels(void)
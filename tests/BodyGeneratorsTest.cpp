@@ -0,0 +1,160 @@
+#include "../include/BodyGenerators.hpp"
+#include "test.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include <zlib.h>
+
+static void writeFile(std::string const &path, std::string const &content)
+{
+	std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+	file << content;
+}
+
+static std::string generateAll(BodyGenerator &generator, size_t maxLength)
+{
+	std::string out;
+	ssize_t		generated;
+	while ((generated = generator.generate(out, maxLength)) > 0)
+		;
+	cr_assert(generated == 0);
+	return out;
+}
+
+static std::string gunzip(std::string const &data)
+{
+	z_stream stream;
+	stream.zalloc = Z_NULL;
+	stream.zfree = Z_NULL;
+	stream.opaque = Z_NULL;
+	stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+	stream.avail_in = data.size();
+	cr_assert(inflateInit2(&stream, 15 + 16) == Z_OK);
+	std::string out;
+	char		buffer[4096];
+	int			status;
+	do
+	{
+		stream.next_out = reinterpret_cast<Bytef *>(buffer);
+		stream.avail_out = sizeof(buffer);
+		status = inflate(&stream, Z_NO_FLUSH);
+		out.append(buffer, sizeof(buffer) - stream.avail_out);
+	} while (status == Z_OK);
+	inflateEnd(&stream);
+	cr_assert(status == Z_STREAM_END);
+	return out;
+}
+
+// Decodes a chunked body, checking its framing.
+static std::string unchunk(std::string const &data)
+{
+	std::string out;
+	size_t		pos(0);
+	while (true)
+	{
+		size_t end = data.find("\r\n", pos);
+		cr_assert(end != std::string::npos);
+		size_t size = std::strtoul(data.c_str() + pos, NULL, 16);
+		pos = end + 2;
+		if (size == 0)
+			break;
+		out.append(data, pos, size);
+		pos += size;
+		cr_assert(data.compare(pos, 2, "\r\n") == 0);
+		pos += 2;
+	}
+	cr_assert(data.substr(pos) == "\r\n");
+	return out;
+}
+
+static std::string createText(size_t length)
+{
+	std::string text;
+	while (text.size() < length)
+		text += "<li><a href=\"/file" + ft::toString(text.size() % 97)
+				+ "\">file</a></li>\n";
+	return text.substr(0, length);
+}
+
+Test(BodyGenerators, readsTheFileRange)
+{
+	std::string const path("/tmp/bg_range.txt");
+	writeFile(path, "0123456789");
+	FileGenerator generator(open(path.c_str(), O_RDONLY), 2, 6);
+
+	std::string out;
+	cr_assert(generator.generate(out, 4) == 4 && out == "2345");
+	cr_assert(generator.generate(out, 4) == 2 && out == "234567");
+	cr_assert(generator.generate(out, 4) == 0);
+	std::remove(path.c_str());
+}
+
+Test(BodyGenerators, compressesInChunks)
+{
+	std::string const path("/tmp/bg_gzip.html");
+	std::string const text = createText(300000);
+	writeFile(path, text);
+	ChunkedGenerator generator(new GzipGenerator(
+		new FileGenerator(open(path.c_str(), O_RDONLY), 0, text.size()), 6
+	));
+
+	std::string body = generateAll(generator, 65536);
+	std::string compressed = unchunk(body);
+	cr_assert(compressed.size() < text.size() / 4);
+	cr_assert(gunzip(compressed) == text);
+	std::remove(path.c_str());
+}
+
+Test(BodyGenerators, compressesAtOnce)
+{
+	std::string const text = createText(10000);
+	std::string		  compressed;
+
+	cr_assert(GzipGenerator::compress(text, 9, compressed));
+	cr_assert(compressed.size() < text.size() / 4);
+	cr_assert(gunzip(compressed) == text);
+	cr_assert(GzipGenerator::compress("", 1, compressed));
+	cr_assert(gunzip(compressed).empty());
+}
+
+Test(BodyGenerators, failsOnTruncatedFiles)
+{
+	std::string const path("/tmp/bg_truncated.txt");
+	writeFile(path, "short");
+	ChunkedGenerator generator(new GzipGenerator(
+		new FileGenerator(open(path.c_str(), O_RDONLY), 0, 100), 1
+	));
+
+	std::string out;
+	cr_assert(generator.generate(out, 4096) > 0);
+	cr_assert(generator.generate(out, 4096) == -1);
+	std::remove(path.c_str());
+}
+
+Test(BodyGenerators, streamsTheOutputOfAScript)
+{
+	std::vector<std::string> argv;
+	argv.push_back("/bin/sh");
+	argv.push_back("-c");
+	argv.push_back("sleep 0.2; printf 0123456789");
+	CgiProcess cgi;
+	cr_assert(cgi.start(argv, std::vector<std::string>()));
+	cgi.endInput();
+
+	// Nothing is ready while the script runs
+	CgiGenerator running(cgi, std::string::npos);
+	std::string	 out;
+	cr_assert(running.generate(out, 4096) == -1 && errno == EAGAIN);
+	cr_assert(cgi.wait() && cgi.isSuccess());
+
+	// The bytes beyond the length are dropped
+	CgiGenerator bounded(cgi, 4);
+	cr_assert(generateAll(bounded, 3) == "0123");
+	cr_assert(cgi.getOutput().empty());
+}
@@ -0,0 +1,60 @@
+#include "../include/request_parser/ByteSet.hpp"
+#include "./test.hpp"
+#include <cstdlib>
+#include <string>
+
+// Scans random buffers of every length up to 100 bytes with each instruction
+// set and compares the results with the lookup table.
+static void checkAllIsas(ByteSet const &set)
+{
+	std::string data;
+	std::srand(42);
+	for (size_t length = 0; length < 100; ++length)
+	{
+		data.clear();
+		for (size_t i = 0; i < length; ++i)
+			data += static_cast<char>(std::rand() % 256);
+		// Mostly members, so the scan goes past the first vector
+		for (size_t i = 0; i < length * 3 / 4; ++i)
+			if (!set.contains(data[i]))
+				data[i] = 'a';
+		size_t span(0);
+		while (span < length && set.contains(data[span]))
+			++span;
+		size_t found(0);
+		while (found < length && !set.contains(data[found]))
+			++found;
+		for (int isa = ByteSet::SCALAR; isa <= ByteSet::AVX2; ++isa)
+		{
+			ByteSet::setIsa(static_cast<ByteSet::Isa>(isa));
+			cr_assert(set.span(data.data(), length) == span);
+			cr_assert(set.find(data.data(), length) == found);
+		}
+	}
+	ByteSet::setIsa(ByteSet::getSupportedIsa());
+}
+
+Test(ByteSet, kernelsMatchLookupTable)
+{
+	ByteSet nameChars("-_.");
+	nameChars.addRange('0', '9').addRange('A', 'Z').addRange('a', 'z');
+	checkAllIsas(nameChars);
+
+	// More ranges than the SSE2 kernel handles, and bytes over 0x7f
+	ByteSet scattered("\"(),/:;<=>?@[\\]{}a");
+	scattered.addRange(0xf0, 0xff);
+	checkAllIsas(scattered);
+	checkAllIsas(ByteSet(scattered).invert());
+}
+
+Test(ByteSet, editsMembers)
+{
+	ByteSet set("abc");
+
+	set.remove("b");
+	cr_assert(set.contains('a') && !set.contains('b'));
+	set.invert();
+	cr_assert(set.contains('b') && set.contains('\0') && !set.contains('c'));
+	cr_assert(set.find("ccxc", 4) == 2);
+	cr_assert(set.span("xxxc", 4) == 3);
+}
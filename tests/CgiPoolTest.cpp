@@ -0,0 +1,141 @@
+#include "../include/CgiPool.hpp"
+#include "test.hpp"
+
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// A worker answering with its pid, the number of requests it served and the
+// body of the request, which dies before ending its answer to a body of
+// "die"
+static std::vector<std::string> worker(void)
+{
+	std::vector<std::string> argv;
+	argv.push_back("/usr/bin/python3");
+	argv.push_back("-c");
+	argv.push_back(
+		"import os, socket\n"
+		"listener = socket.socket(fileno=0)\n"
+		"for served in range(1, int(os.environ['CGI_POOL_REQUESTS']) + 1):\n"
+		"    conn, _ = listener.accept()\n"
+		"    with conn, conn.makefile('rb') as f:\n"
+		"        env = f.read(int(f.readline())).decode().split('\\0')\n"
+		"        env = dict(e.split('=', 1) for e in env if e)\n"
+		"        body = f.read(int(env['CONTENT_LENGTH']))\n"
+		"        out = b'%d %d ' % (os.getpid(), served) + body\n"
+		"        if body == b'die':\n"
+		"            conn.sendall(b'%d\\n' % len(out) + out)\n"
+		"            os._exit(1)\n"
+		"        conn.sendall(b'%d\\n%s0\\n' % (len(out), out))\n"
+	);
+	return argv;
+}
+
+static CgiPool::Limits limits(size_t min, size_t max, size_t requests)
+{
+	CgiPool::Limits limits;
+	limits.minWorkers = min;
+	limits.maxWorkers = max;
+	limits.maxRequests = requests;
+	limits.idleTimeout = 200;
+	return limits;
+}
+
+static CgiProcess *
+send(CgiPool &pool, CgiPool::Limits const &limits, std::string const &body)
+{
+	std::vector<std::string> env;
+	env.push_back("CONTENT_LENGTH=" + ft::toString(body.size()));
+	CgiProcess *cgi = pool.connect(worker(), env, limits);
+	if (cgi != NULL)
+	{
+		cgi->appendInput(body.data(), body.size());
+		cgi->endInput();
+	}
+	return cgi;
+}
+
+// The output of a request run to completion: "pid served body"
+static std::string run(CgiProcess *cgi)
+{
+	cr_assert(cgi != NULL);
+	cr_assert(cgi->wait() && cgi->isSuccess());
+	std::string output = cgi->getOutput();
+	delete cgi;
+	return output;
+}
+
+static std::string getPid(std::string const &output)
+{
+	return output.substr(0, output.find(' '));
+}
+
+Test(CgiPool, preforksTheMinimumOfWorkers)
+{
+	CgiPool pool;
+
+	CgiProcess *first = send(pool, limits(2, 2, 100), "first");
+	cr_assert(pool.getWorkerCount(worker()) == 2);
+	std::string output = run(first);
+	cr_assert(output.substr(output.find(' ')) == " 1 first");
+	// The other worker, which served fewer requests, takes the next one
+	cr_assert(
+		getPid(run(send(pool, limits(2, 2, 100), "second"))) != getPid(output)
+	);
+	cr_assert(pool.getWorkerCount(worker()) == 2);
+}
+
+Test(CgiPool, recyclesAWorkerAfterItsRequests)
+{
+	CgiPool pool;
+
+	std::string first = run(send(pool, limits(1, 1, 2), "a"));
+	std::string second = run(send(pool, limits(1, 1, 2), "b"));
+	cr_assert(getPid(first) == getPid(second));
+	cr_assert(second.substr(second.find(' ')) == " 2 b");
+	// The retired worker was replaced
+	std::string third = run(send(pool, limits(1, 1, 2), "c"));
+	cr_assert(getPid(third) != getPid(first));
+	cr_assert(third.substr(third.find(' ')) == " 1 c");
+	cr_assert(pool.getWorkerCount(worker()) == 1);
+}
+
+Test(CgiPool, growsWithTheRequestsInFlight)
+{
+	CgiPool					  pool;
+	std::vector<CgiProcess *> cgis;
+
+	for (int i = 0; i < 3; ++i)
+		cgis.push_back(send(pool, limits(1, 2, 100), ft::toString(i)));
+	// The third request waits for one of the two workers
+	cr_assert(pool.getWorkerCount(worker()) == 2);
+	for (size_t i = 0; i < cgis.size(); ++i)
+	{
+		std::string output = run(cgis[i]);
+		cr_assert(output.substr(output.size() - 1) == ft::toString(i));
+	}
+	// The workers are kept between requests
+	cr_assert(pool.getWorkerCount(worker()) == 2);
+	run(send(pool, limits(1, 2, 100), "next"));
+	cr_assert(pool.getWorkerCount(worker()) == 2);
+	// Once two workers were not needed for the idle timeout, the pool shrinks
+	// back to its minimum
+	usleep(300000);
+	run(send(pool, limits(1, 2, 100), "last"));
+	cr_assert(pool.getWorkerCount(worker()) == 1);
+}
+
+Test(CgiPool, failsTheRequestOfAWorkerThatDied)
+{
+	CgiPool pool;
+
+	// The output sent before the worker died is not a complete response
+	CgiProcess *cgi = send(pool, limits(1, 1, 100), "die");
+	cr_assert(cgi != NULL);
+	cr_assert(cgi->wait() && !cgi->isSuccess());
+	cr_assert(cgi->getOutput().find(" 1 die") != std::string::npos);
+	delete cgi;
+	// Its replacement serves the next request
+	std::string output = run(send(pool, limits(1, 1, 100), "next"));
+	cr_assert(output.substr(output.find(' ')) == " 1 next");
+}
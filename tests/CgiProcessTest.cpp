@@ -0,0 +1,80 @@
+#include "../include/CgiProcess.hpp"
+#include "test.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+static std::vector<std::string> shell(std::string const &command)
+{
+	std::vector<std::string> argv;
+	argv.push_back("/bin/sh");
+	argv.push_back("-c");
+	argv.push_back(command);
+	return argv;
+}
+
+Test(CgiProcess, runsAScriptToCompletion)
+{
+	CgiProcess				 cgi;
+	std::vector<std::string> env(1, "NAME=value");
+
+	cr_assert(cgi.start(shell("cat; echo \"$NAME\""), env));
+	// The body may be appended in pieces
+	cgi.appendInput("bo", 2);
+	cgi.appendInput("dy\n", 3);
+	cgi.endInput();
+	cr_assert(cgi.wait());
+	cr_assert(cgi.isInputDone() && cgi.isOutputDone() && cgi.hasExited());
+	cr_assert(cgi.isSuccess());
+	cr_assert(cgi.getOutput() == "body\nvalue\n");
+}
+
+Test(CgiProcess, feedsABodyLargerThanThePipes)
+{
+	CgiProcess	cgi;
+	std::string input(1 << 20, 'a');
+
+	// The script echoes the body while it is written
+	cr_assert(cgi.start(shell("cat"), std::vector<std::string>()));
+	cgi.appendInput(input.data(), input.size());
+	cgi.endInput();
+	cr_assert(cgi.getInputSize() == input.size());
+	cr_assert(cgi.wait() && cgi.isSuccess());
+	cr_assert(cgi.getOutput() == input);
+}
+
+Test(CgiProcess, reportsAFailedScript)
+{
+	CgiProcess failed;
+	cr_assert(failed.start(shell("exit 3"), std::vector<std::string>()));
+	failed.endInput();
+	cr_assert(failed.wait() && failed.hasExited() && !failed.isSuccess());
+
+	// A script that cannot be executed exits with a failure too
+	CgiProcess				 missing;
+	std::vector<std::string> argv(1, "/nonexistent/interpreter");
+	cr_assert(missing.start(argv, std::vector<std::string>()));
+	missing.endInput();
+	cr_assert(missing.wait() && !missing.isSuccess());
+}
+
+Test(CgiProcess, reportsAScriptThatIsNotExecutable)
+{
+	std::string const path("/tmp/cgi_not_executable.sh");
+	std::ofstream(path.c_str()) << "#!/bin/sh\necho never\n";
+	chmod(path.c_str(), 0644);
+	CgiProcess				 cgi;
+	std::vector<std::string> argv(1, path);
+
+	// Spawned, but it exits at once as a shell reports it, without output
+	cr_assert(cgi.start(argv, std::vector<std::string>()));
+	cgi.appendInput("body", 4);
+	cgi.endInput();
+	cr_assert(cgi.wait() && cgi.hasExited() && cgi.isOutputDone());
+	cr_assert(!cgi.isSuccess() && cgi.getExitStatus() == 127);
+	cr_assert(cgi.getOutput().empty());
+	std::remove(path.c_str());
+}
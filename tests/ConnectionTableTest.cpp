@@ -0,0 +1,42 @@
+#include "../include/ConnectionTable.hpp"
+#include "test.hpp"
+
+Test(ConnectionTable, reusesReleasedSlots)
+{
+	ConnectionTable table;
+	size_t			first = table.acquire(10, 0);
+	size_t			second = table.acquire(11, 0);
+	size_t			third = table.acquire(12, 1);
+
+	cr_assert(first == 0 && second == 1 && third == 2);
+	cr_assert(table.getCapacity() == 3 && table.getActiveCount() == 3);
+	unsigned long secondId = table.getId(second);
+	Client		 *secondClient = &table.get(second);
+	secondClient->setIsClosed(true);
+
+	table.release(second);
+	table.release(second);
+	cr_assert(!table.isActive(second));
+	cr_assert(table.getActiveCount() == 2);
+
+	// The slot comes back with its Client reset for the new connection and a
+	// new id
+	size_t reused = table.acquire(13, 1);
+	cr_assert(reused == second);
+	cr_assert(table.getCapacity() == 3 && table.getActiveCount() == 3);
+	cr_assert(&table.get(reused) == secondClient);
+	cr_assert(table.get(reused).getFd() == 13);
+	cr_assert(!table.get(reused).isClosed());
+	cr_assert(table.getId(reused) != secondId);
+	cr_assert(table.getServer(reused) == 1);
+
+	// The last released slot is the first reused, the table grows only once
+	// all the slots are taken
+	table.release(first);
+	table.release(third);
+	cr_assert(table.acquire(14, 0) == third);
+	cr_assert(table.acquire(15, 0) == first);
+	cr_assert(table.acquire(16, 0) == 3);
+	cr_assert(table.getCapacity() == 4 && table.getActiveCount() == 4);
+	cr_assert(!table.isActive(4));
+}
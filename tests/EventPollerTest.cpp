@@ -0,0 +1,49 @@
+#include "../include/EventPoller.hpp"
+#include "test.hpp"
+
+#include <unistd.h>
+
+Test(EventPoller, pollRemovalMovesTheLastFd)
+{
+	int first[2];
+	int second[2];
+	int third[2];
+	cr_assert(pipe(first) == 0 && pipe(second) == 0 && pipe(third) == 0);
+	EventPoller poller(EventPoller::POLL);
+
+	cr_assert(poller.add(first[0], POLLIN));
+	cr_assert(poller.add(second[0], POLLIN));
+	cr_assert(poller.add(third[0], POLLIN));
+	cr_assert(!poller.add(third[0], POLLIN));
+	cr_assert(poller.getFdCount() == 3);
+
+	// The last fd takes the slot of the first, and is still found by its fd
+	cr_assert(poller.remove(first[0]));
+	cr_assert(!poller.remove(first[0]));
+	cr_assert(poller.getFdCount() == 2);
+	cr_assert(write(first[1], "a", 1) == 1);
+	cr_assert(write(third[1], "c", 1) == 1);
+	cr_assert(poller.wait(0) == 1);
+	cr_assert(poller.getEventCount() == 1);
+	cr_assert(poller.getEvent(0).fd == third[0]);
+	cr_assert(poller.getEvent(0).revents & POLLIN);
+
+	// The moved fd is modified and removed through its new slot
+	cr_assert(poller.modify(third[0], 0));
+	cr_assert(poller.wait(0) == 0);
+	cr_assert(poller.remove(third[0]));
+	cr_assert(!poller.modify(third[0], POLLIN));
+	cr_assert(write(second[1], "b", 1) == 1);
+	cr_assert(poller.wait(0) == 1);
+	cr_assert(poller.getEvent(0).fd == second[0]);
+
+	// A removed fd is registered again at the end
+	cr_assert(poller.add(first[0], POLLIN));
+	cr_assert(poller.getFdCount() == 2);
+	cr_assert(poller.wait(0) == 2);
+
+	int const fds[] = {first[0], first[1], second[0],
+					   second[1], third[0], third[1]};
+	for (size_t i = 0; i < 6; ++i)
+		close(fds[i]);
+}
@@ -0,0 +1,192 @@
+#include "../include/FastCgiClient.hpp"
+#include "test.hpp"
+
+#include <csignal>
+#include <cstring>
+#include <netdb.h>
+#include <string>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+// fastcgi_responder.py listening while in scope, on a Unix socket or on a
+// port of localhost
+class Responder
+{
+  public:
+	Responder(unsigned short port = 0)
+		: path_("/tmp/webserv-fastcgi-test-" + ft::toString(getpid()))
+	{
+		address = port == 0 ? "unix:" + path_
+							: "localhost:" + ft::toString(port);
+		unlink(path_.c_str());
+		pid_ = fork();
+		if (pid_ == 0)
+		{
+			execl(
+				"/usr/bin/python3",
+				"python3",
+				"fastcgi_responder.py",
+				address.c_str(),
+				(char *)NULL
+			);
+			_exit(1);
+		}
+		for (int i = 0; i < 500 && !isListening_(port); ++i)
+			usleep(10000);
+		usleep(10000);
+	}
+	~Responder(void)
+	{
+		kill(pid_, SIGTERM);
+		waitpid(pid_, NULL, 0);
+		unlink(path_.c_str());
+	}
+
+	std::string address;
+
+  private:
+	bool isListening_(unsigned short port) const
+	{
+		struct stat info;
+		if (port == 0)
+			return stat(path_.c_str(), &info) == 0;
+		struct addrinfo	 hints;
+		struct addrinfo *result;
+		std::string		 service = ft::toString(port);
+		std::memset(&hints, 0, sizeof(hints));
+		hints.ai_socktype = SOCK_STREAM;
+		if (getaddrinfo("localhost", service.c_str(), &hints, &result) != 0)
+			return false;
+		int	 fd = socket(result->ai_family, SOCK_STREAM, 0);
+		bool isOk = connect(fd, result->ai_addr, result->ai_addrlen) == 0;
+		close(fd);
+		freeaddrinfo(result);
+		return isOk;
+	}
+
+	std::string path_;
+	pid_t		pid_;
+};
+
+static std::vector<std::string>
+params(std::string const &method, std::string const &query = "")
+{
+	std::vector<std::string> env;
+	env.push_back("REQUEST_METHOD=" + method);
+	env.push_back("QUERY_STRING=" + query);
+	// A value longer than 127 bytes has a 4-byte length
+	env.push_back("LONG=" + std::string(300, 'x'));
+	return env;
+}
+
+// The output of a request run to completion, empty if it failed
+static std::string
+run(FastCgiClient &client,
+	std::string const &address,
+	std::vector<std::string> const &env,
+	std::string const &body)
+{
+	CgiProcess *cgi = client.connect(address, env);
+	cr_assert(cgi != NULL && cgi->isFastCgi());
+	cgi->appendInput(body.data(), body.size());
+	cgi->endInput();
+	bool isOk = cgi->wait() && cgi->isSuccess();
+	std::string output = isOk ? cgi->getOutput() : "";
+	delete cgi;
+	return output;
+}
+
+Test(FastCgiClient, encodesAndParsesRecords)
+{
+	std::string content(70000, 'a');
+	std::string records;
+	FastCgiClient::appendRecord(
+		records, FastCgiClient::STDOUT, content.data(), content.size()
+	);
+	FastCgiClient::appendRecord(records, FastCgiClient::STDOUT, NULL, 0);
+
+	// The content is split in records aligned on 8 bytes
+	FastCgiClient::Record record;
+	std::string			  decoded;
+	size_t				  offset(0);
+	size_t				  count(0);
+	while (FastCgiClient::parseRecord(records, offset, record))
+	{
+		cr_assert(record.type == FastCgiClient::STDOUT);
+		cr_assert(record.size % 8 == 0);
+		decoded.append(records, record.contentOffset, record.contentLength);
+		offset += record.size;
+		++count;
+	}
+	cr_assert(offset == records.size() && count == 3);
+	cr_assert(decoded == content);
+	// A record not received whole is not parsed
+	cr_assert(!FastCgiClient::parseRecord(records.substr(0, 100), 0, record));
+}
+
+Test(FastCgiClient, runsARequest)
+{
+	Responder	  responder;
+	FastCgiClient client;
+
+	std::string output
+		= run(client, responder.address, params("POST"), "hello");
+	cr_assert(
+		output
+		== "Status: 200 OK\r\nContent-Type: text/plain\r\n\r\n"
+		   "method=POST length=5 connection=1 request=1\nhello"
+	);
+}
+
+Test(FastCgiClient, keepsTheConnectionForTheNextRequest)
+{
+	Responder	  responder;
+	FastCgiClient client;
+
+	run(client, responder.address, params("GET"), "");
+	cr_assert(client.getIdleCount(responder.address) == 1);
+	std::string output = run(client, responder.address, params("GET"), "");
+	cr_assert(output.find("connection=1 request=2") != std::string::npos);
+	cr_assert(client.getIdleCount(responder.address) == 1);
+}
+
+Test(FastCgiClient, streamsALargeBodyAndOutput)
+{
+	Responder	  responder;
+	FastCgiClient client;
+	std::string	  body(1 << 20, 'b');
+
+	std::string output = run(client, responder.address, params("POST"), body);
+	cr_assert(output.find("length=1048576 ") != std::string::npos);
+	cr_assert(output.substr(output.size() - body.size()) == body);
+}
+
+Test(FastCgiClient, reportsAFailedRequest)
+{
+	Responder	  responder;
+	FastCgiClient client;
+
+	// A status other than 0 fails the request, the connection stays usable
+	cr_assert(run(client, responder.address, params("GET", "fail"), "") == "");
+	cr_assert(client.getIdleCount(responder.address) == 1);
+
+	// An application that cannot be reached fails the connection
+	cr_assert(client.connect("unix:/nonexistent/app.sock", params("GET"))
+			  == NULL);
+	cr_assert(client.connect("127.0.0.1:notaport", params("GET")) == NULL);
+}
+
+Test(FastCgiClient, resolvesAHostNameAhead)
+{
+	Responder	  responder(20000 + getpid() % 10000);
+	FastCgiClient client;
+
+	// A host name is not looked up on the way to a request, which would block
+	cr_assert(client.connect(responder.address, params("GET")) == NULL);
+	cr_assert(client.resolve(responder.address));
+	std::string output = run(client, responder.address, params("GET"), "");
+	cr_assert(output.find("method=GET length=0") != std::string::npos);
+	cr_assert(!client.resolve("nonexistent.invalid:9000"));
+}
@@ -0,0 +1,53 @@
+#include "../include/GzipCache.hpp"
+#include "test.hpp"
+
+#include <string>
+
+Test(GzipCache, findsTheBodiesByETag)
+{
+	GzipCache	cache;
+	std::string body;
+	cache.configure(4096);
+
+	cr_assert(!cache.find("\"1-2-3\"", body));
+	cache.insert("\"1-2-3\"", "compressed");
+	cr_assert(cache.find("\"1-2-3\"", body) && body == "compressed");
+	// Another version of the file is another entry
+	cr_assert(!cache.find("\"1-4-3\"", body));
+	cr_assert(cache.getHits() == 1 && cache.getMisses() == 2);
+	cr_assert(cache.getSize() == 1 && cache.getBytes() == 10);
+}
+
+Test(GzipCache, keepsWithinTheBudget)
+{
+	GzipCache	cache;
+	std::string body;
+	// Room for eight bodies of 100 bytes
+	cache.configure(800);
+
+	cr_assert(cache.isCacheable(100) && !cache.isCacheable(101));
+	for (int i = 0; i < 8; ++i)
+		cache.insert(ft::toString(i), std::string(100, 'a' + i));
+	cr_assert(cache.getSize() == 8 && cache.getBytes() == 800);
+	cr_assert(cache.find("0", body));
+	// The second body is now the least recently used
+	cache.insert("8", std::string(100, 'z'));
+	cr_assert(cache.getSize() == 8 && cache.getBytes() == 800);
+	cr_assert(cache.find("0", body) && cache.find("8", body));
+	cr_assert(!cache.find("1", body));
+	cache.insert("large", std::string(101, 'l'));
+	cr_assert(!cache.find("large", body));
+	cache.clear();
+	cr_assert(cache.getSize() == 0 && cache.getBytes() == 0);
+}
+
+Test(GzipCache, cachesNothingWhenDisabled)
+{
+	GzipCache	cache;
+	std::string body;
+
+	cr_assert(!cache.isEnabled());
+	cache.insert("\"1-2-3\"", "compressed");
+	cr_assert(!cache.find("\"1-2-3\"", body));
+	cr_assert(cache.getSize() == 0 && cache.getMisses() == 0);
+}
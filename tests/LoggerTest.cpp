@@ -129,3 +129,37 @@ Test(Logger, loggerWithErrorLevel)
 	// Logger::log(Logger::WARN) << "This is a test with warn level" << std::endl;
 	// Logger::log(Logger::ERROR) << "This is a test with error level" << std::endl;
 }
+
+static void *logFromThread(void *)
+{
+	for (int i = 0; i < 100; ++i)
+		Logger::log(Logger::INFO) << "Thread log line " << i << std::endl;
+	return NULL;
+}
+
+Test(Logger, logFromSeveralThreads)
+{
+	std::ostringstream capturedOutput;
+	std::streambuf	  *originalCoutBuffer = std::cout.rdbuf();
+	std::cout.rdbuf(capturedOutput.rdbuf());
+
+	Logger::setLevel(Logger::INFO);
+	pthread_t threads[4];
+	for (int i = 0; i < 4; ++i)
+		pthread_create(&threads[i], NULL, logFromThread, NULL);
+	for (int i = 0; i < 4; ++i)
+		pthread_join(threads[i], NULL);
+	std::cout.rdbuf(originalCoutBuffer);
+
+	// Every line must be whole: one header and one message per line
+	std::istringstream lines(capturedOutput.str());
+	std::string		   line;
+	int				   count(0);
+	while (std::getline(lines, line))
+	{
+		cr_assert(line.find("<WebServ>") == line.rfind("<WebServ>"));
+		cr_assert(line.find("Thread log line ") != std::string::npos);
+		++count;
+	}
+	cr_assert(count == 400);
+}
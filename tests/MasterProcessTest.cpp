@@ -0,0 +1,76 @@
+#include "../include/MasterProcess.hpp"
+#include "../include/ReactorPool.hpp"
+#include "test.hpp"
+
+#include <arpa/inet.h>
+#include <cstdlib>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Holds a port of test.config without SO_REUSEPORT, so the listeners of the
+// servers fail to bind it.
+static int holdPort(unsigned short port)
+{
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	int on(1);
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+	sockaddr_in address = sockaddr_in();
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = htons(port);
+	if (bind(fd, (sockaddr *)&address, sizeof(address)) != 0
+		|| listen(fd, 1) != 0)
+	{
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+// Gets the exit status of a worker whose reactors fail to bind their ports,
+// as MasterProcess::runWorker_ computes it.
+static int exitCodeOfBindFailure(unsigned int threadCount)
+{
+	ServerConfig config("test.config");
+	config.parseFile(false, false);
+	try
+	{
+		ReactorPool reactors(
+			config.getAllServersConfig(), EventPoller::POLL, threadCount
+		);
+		try
+		{
+			reactors.run();
+		}
+		catch (std::exception &e)
+		{
+			return MasterProcess::getExitCode(reactors.hasFailedToStart());
+		}
+	}
+	catch (std::exception &e)
+	{
+		return MasterProcess::getExitCode(true);
+	}
+	return EXIT_SUCCESS;
+}
+
+Test(MasterProcess, mapsFailuresToExitCodes)
+{
+	// An initialization failure is not respawned, a failure of a running
+	// worker is
+	cr_assert(MasterProcess::getExitCode(true) == 2);
+	cr_assert(MasterProcess::getExitCode(false) == EXIT_FAILURE);
+}
+
+Test(MasterProcess, bindFailureIsAnInitFailure)
+{
+	int fd = holdPort(8080);
+	cr_assert(fd != -1);
+
+	cr_assert(exitCodeOfBindFailure(0) == 2);
+	cr_assert(exitCodeOfBindFailure(2) == 2);
+	// The failed reactor threads asked the process to stop
+	g_shutdown = 0;
+	close(fd);
+}
@@ -0,0 +1,172 @@
+#include "../include/OpenFileCache.hpp"
+#include "test.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+static void writeFile(std::string const &path, std::string const &content)
+{
+	std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+	file << content;
+}
+
+static std::string readAll(int fd)
+{
+	std::string data;
+	char		buffer[256];
+	ssize_t		bytesRead;
+	while ((bytesRead = pread(fd, buffer, sizeof(buffer), data.size())) > 0)
+		data.append(buffer, bytesRead);
+	return data;
+}
+
+Test(OpenFileCache, countsHitsAndMisses)
+{
+	std::string const path("/tmp/ofc_hits.html");
+	writeFile(path, "<p>hi</p>");
+	OpenFileCache		cache;
+	OpenFileCache::Info info;
+	cache.configure(4, 60000, false);
+
+	int fd = cache.open(path, info);
+	cr_assert(fd != -1);
+	cr_assert(info.size == 9 && !info.isDirectory);
+	cr_assert(info.mimeType == "text/html; charset=UTF-8");
+	cr_assert(readAll(fd) == "<p>hi</p>");
+	close(fd);
+	cr_assert(cache.getInfo(path, info));
+	fd = cache.open(path, info);
+	cr_assert(fd != -1);
+	close(fd);
+	cr_assert(cache.getMisses() == 1 && cache.getHits() == 2);
+	cr_assert(cache.getInfo("/tmp", info) && info.isDirectory);
+	cr_assert(cache.open("/tmp", info) == -1);
+	cr_assert(!cache.getInfo("/tmp/ofc_missing", info));
+	cr_assert(cache.getSize() == 2);
+	std::remove(path.c_str());
+}
+
+Test(OpenFileCache, evictsTheLeastRecentlyUsed)
+{
+	std::string const paths[3]
+		= {"/tmp/ofc_lru_a.txt", "/tmp/ofc_lru_b.txt", "/tmp/ofc_lru_c.txt"};
+	for (int i = 0; i < 3; ++i)
+		writeFile(paths[i], paths[i]);
+	OpenFileCache		cache;
+	OpenFileCache::Info info;
+	cache.configure(2, 60000, false);
+
+	cr_assert(cache.getInfo(paths[0], info));
+	cr_assert(cache.getInfo(paths[1], info));
+	cr_assert(cache.getInfo(paths[0], info));
+	// b is the least recently used
+	cr_assert(cache.getInfo(paths[2], info));
+	cr_assert(cache.getSize() == 2);
+	unsigned long long misses = cache.getMisses();
+	cr_assert(cache.getInfo(paths[0], info));
+	cr_assert(cache.getMisses() == misses);
+	cr_assert(cache.getInfo(paths[1], info));
+	cr_assert(cache.getMisses() == misses + 1);
+	for (int i = 0; i < 3; ++i)
+		std::remove(paths[i].c_str());
+}
+
+Test(OpenFileCache, descriptorOutlivesTheEntry)
+{
+	std::string const path("/tmp/ofc_owned.txt");
+	writeFile(path, "still readable");
+	OpenFileCache		cache;
+	OpenFileCache::Info info;
+	cache.configure(1, 60000, false);
+
+	int fd = cache.open(path, info);
+	cr_assert(fd != -1);
+	cache.clear();
+	cr_assert(cache.getSize() == 0);
+	cr_assert(readAll(fd) == "still readable");
+	close(fd);
+	std::remove(path.c_str());
+}
+
+Test(OpenFileCache, revalidatesChangedFiles)
+{
+	std::string const path("/tmp/ofc_changed.txt");
+	writeFile(path, "old");
+	OpenFileCache		cache;
+	OpenFileCache::Info info;
+	// Every lookup checks the file again
+	cache.configure(4, 0, false);
+
+	cr_assert(cache.getInfo(path, info) && info.size == 3);
+	writeFile(path, "newer");
+	int fd = cache.open(path, info);
+	cr_assert(fd != -1 && info.size == 5);
+	cr_assert(readAll(fd) == "newer");
+	close(fd);
+	std::remove(path.c_str());
+	cr_assert(!cache.getInfo(path, info));
+	cr_assert(cache.getSize() == 0);
+}
+
+Test(OpenFileCache, dropsChangedFilesOnEvents)
+{
+	std::string const path("/tmp/ofc_events.txt");
+	writeFile(path, "old");
+	OpenFileCache		cache;
+	OpenFileCache::Info info;
+	cache.configure(4, 60000, true);
+
+	cr_assert(cache.getInfo(path, info) && info.size == 3);
+	writeFile(path, "newer");
+#ifdef __linux__
+	// As the event loop does once the descriptor is readable
+	cr_assert(cache.getEventFd() != -1);
+	cache.readEvents();
+	cr_assert(cache.getSize() == 0);
+	cr_assert(cache.getInfo(path, info) && info.size == 5);
+	cr_assert(cache.getMisses() == 2);
+#endif
+	cache.invalidate(path);
+	cr_assert(cache.getSize() == 0);
+	std::remove(path.c_str());
+}
+
+Test(OpenFileCache, keepsWatchingAFileStillCachedByAnotherPath)
+{
+	std::string const path("/tmp/ofc_shared.txt");
+	std::string const link("/tmp/ofc_shared_link.txt");
+	writeFile(path, "old");
+	std::remove(link.c_str());
+	cr_assert(symlink(path.c_str(), link.c_str()) == 0);
+	OpenFileCache		cache;
+	OpenFileCache::Info info;
+	cache.configure(4, 60000, true);
+
+	cr_assert(cache.getInfo(path, info) && cache.getInfo(link, info));
+	cache.invalidate(link);
+	cr_assert(cache.getSize() == 1);
+	writeFile(path, "newer");
+#ifdef __linux__
+	cache.readEvents();
+	cr_assert(cache.getSize() == 0);
+#endif
+	std::remove(link.c_str());
+	std::remove(path.c_str());
+}
+
+Test(OpenFileCache, passesThroughWhenDisabled)
+{
+	std::string const path("/tmp/ofc_off.txt");
+	writeFile(path, "abc");
+	OpenFileCache		cache;
+	OpenFileCache::Info info;
+
+	int fd = cache.open(path, info);
+	cr_assert(fd != -1 && info.size == 3);
+	close(fd);
+	cr_assert(cache.getSize() == 0);
+	cr_assert(cache.getHits() == 0 && cache.getMisses() == 0);
+	std::remove(path.c_str());
+}
@@ -0,0 +1,130 @@
+#include "../include/OutputQueue.hpp"
+#include "test.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+
+// Reads everything buffered in a non-blocking pipe.
+static std::string drain(int fd)
+{
+	std::string data;
+	char		buffer[4096];
+	ssize_t		bytesRead;
+	while ((bytesRead = read(fd, buffer, sizeof(buffer))) > 0)
+		data.append(buffer, bytesRead);
+	return data;
+}
+
+Test(OutputQueue, resumesPartialWrites)
+{
+	int fds[2];
+	cr_assert(pipe(fds) == 0);
+	cr_assert(fcntl(fds[0], F_SETFL, O_NONBLOCK) == 0);
+	cr_assert(fcntl(fds[1], F_SETFL, O_NONBLOCK) == 0);
+	OutputQueue queue;
+	std::string head("HTTP/1.1 200 OK\r\n\r\n");
+	std::string body(200000, 'x');
+	std::string expected(head + body);
+
+	queue.push(head);
+	queue.push(body);
+	cr_assert(head.empty() && body.empty());
+	cr_assert(queue.getSize() == expected.size());
+
+	// The pipe takes less than the whole response at once
+	std::string received;
+	ssize_t		written = queue.writeTo(fds[1]);
+	cr_assert(written > 0 && static_cast<size_t>(written) < expected.size());
+	cr_assert(queue.writeTo(fds[1]) == -1 && errno == EAGAIN);
+	while (!queue.isEmpty())
+	{
+		received += drain(fds[0]);
+		cr_assert(queue.writeTo(fds[1]) > 0);
+	}
+	received += drain(fds[0]);
+	cr_assert(received == expected);
+	cr_assert(queue.writeTo(fds[1]) == 0);
+	close(fds[0]);
+	close(fds[1]);
+}
+
+// Produces count pieces of the same letter.
+class LetterGenerator : public BodyGenerator
+{
+  public:
+	LetterGenerator(char letter, int count) : letter_(letter), count_(count) {}
+
+	ssize_t generate(std::string &out, size_t maxLength)
+	{
+		if (count_ == 0)
+			return 0;
+		--count_;
+		out.append(maxLength < 3 ? maxLength : 3, letter_);
+		return 3;
+	}
+
+  private:
+	char letter_;
+	int	 count_;
+};
+
+Test(OutputQueue, readsFileRangesAndGenerators)
+{
+	int fds[2];
+	cr_assert(pipe(fds) == 0);
+	cr_assert(fcntl(fds[0], F_SETFL, O_NONBLOCK) == 0);
+	FILE *file = std::tmpfile();
+	cr_assert(file != NULL);
+	cr_assert(write(fileno(file), "0123456789", 10) == 10);
+	OutputQueue queue;
+	std::string head("head|");
+
+	queue.push(head);
+	queue.pushFile(dup(fileno(file)), 2, 5, false);
+	queue.pushGenerator(new LetterGenerator('z', 2));
+	// Sent with sendfile(2) on Linux
+	queue.pushFile(dup(fileno(file)), 7, 3, true);
+	cr_assert(queue.getSize() == 13);
+
+	while (!queue.isEmpty())
+		cr_assert(queue.writeTo(fds[1]) >= 0);
+	cr_assert(drain(fds[0]) == "head|23456zzzzzz789");
+	std::fclose(file);
+	close(fds[0]);
+	close(fds[1]);
+}
+
+// A multipart body: reading a range moves the segments gathered before it
+Test(OutputQueue, interleavesMemoryAndFileRanges)
+{
+	int fds[2];
+	cr_assert(pipe(fds) == 0);
+	cr_assert(fcntl(fds[0], F_SETFL, O_NONBLOCK) == 0);
+	FILE *file = std::tmpfile();
+	cr_assert(file != NULL);
+	cr_assert(write(fileno(file), "0123456789", 10) == 10);
+	OutputQueue queue;
+	std::string expected;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		std::string part("\r\n--boundary-long-enough-to-be-on-the-heap-"
+						 + std::string(1, 'a' + i) + "\r\n\r\n");
+		expected += part + std::string("0123456789", 3 * i, 3);
+		queue.push(part);
+		queue.pushFile(dup(fileno(file)), 3 * i, 3, false);
+	}
+	std::string closing("\r\n--boundary--\r\n");
+	expected += closing;
+	queue.push(closing);
+
+	while (!queue.isEmpty())
+		cr_assert(queue.writeTo(fds[1]) >= 0);
+	cr_assert(drain(fds[0]) == expected);
+	std::fclose(file);
+	close(fds[0]);
+	close(fds[1]);
+}
@@ -0,0 +1,67 @@
+/**
+ * Compares RequestParser with SliceParser on the requests of test_requests.
+ * Each request is parsed ITERATIONS times by both parsers and the average
+ * time per request is printed. Run it with `make bench`.
+ */
+#include "../include/HttpRequest.hpp"
+#include "../include/Logger.hpp"
+#include "../include/request_parser/RequestParser.hpp"
+#include "../include/request_parser/SliceParser.hpp"
+#include "../include/utils.hpp"
+#include <cstdio>
+#include <string>
+#include <time.h>
+
+#define ITERATIONS 100000
+
+static std::string const requestFiles[] = {
+	"deleteRequest.txt",
+	"getRequest.txt",
+	"getRequestRoot.txt",
+	"nofileGetRequest.txt",
+	"postRequest.txt",
+	"traceRequest.txt"};
+
+static double nowNs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(void)
+{
+	Logger::setLevel(Logger::INFO);
+	std::printf("%-22s %14s %14s %8s\n", "request", "RequestParser",
+				"SliceParser", "speedup");
+	for (size_t i = 0; i < sizeof(requestFiles) / sizeof(std::string); ++i)
+	{
+		std::string requestStr
+			= ft::readFile("./test_requests/" + requestFiles[i]);
+		size_t		methods(0);
+
+		double start = nowNs();
+		for (int n = 0; n < ITERATIONS; ++n)
+		{
+			HttpRequest request = RequestParser::parseRequest(requestStr);
+			methods += request.getMethod().size();
+		}
+		double copying = (nowNs() - start) / ITERATIONS;
+
+		start = nowNs();
+		for (int n = 0; n < ITERATIONS; ++n)
+		{
+			RequestView view;
+			SliceParser::parseRequest(
+				requestStr.data(), requestStr.size(), view
+			);
+			methods -= view.method.length;
+		}
+		double slicing = (nowNs() - start) / ITERATIONS;
+
+		std::printf("%-22s %11.0f ns %11.0f ns %7.1fx%s\n",
+					requestFiles[i].c_str(), copying, slicing,
+					copying / slicing, methods == 0 ? "" : " (mismatch)");
+	}
+	return 0;
+}
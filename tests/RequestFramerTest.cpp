@@ -0,0 +1,152 @@
+#include "../include/request_parser/RequestFramer.hpp"
+#include "./test.hpp"
+#include <string>
+
+// Feeds a request one byte at a time, as a slow client would send it.
+static size_t feedByBytes(RequestFramer &framer, std::string const &input)
+{
+	size_t used(0);
+	for (size_t i = 0; i < input.size() && !framer.isComplete(); ++i)
+		used += framer.feed(input.data() + i, 1);
+	return used;
+}
+
+// Gets the status a request is rejected with, or 0 if it is accepted.
+static int rejectionOf(std::string const &input)
+{
+	RequestFramer framer;
+	try
+	{
+		framer.feed(input.data(), input.size());
+	}
+	catch (HttpException const &e)
+	{
+		return e.getCode();
+	}
+	return 0;
+}
+
+static std::string bodyOf(RequestFramer &framer)
+{
+	return std::string(framer.getBody().begin(), framer.getBody().end());
+}
+
+Test(RequestFramer, headersSplitBetweenReads)
+{
+	RequestFramer framer;
+	std::string	  input("\r\nGET /a HTTP/1.1\r\nHost: localhost\r\n\r\n");
+
+	cr_assert(feedByBytes(framer, input) == input.size());
+	cr_assert(framer.isComplete());
+	cr_assert(framer.getView().uri.equals("/a"));
+	cr_assert(framer.getView().headerCount == 1);
+	cr_assert(framer.getView().findHeader("host")->value.equals("localhost"));
+}
+
+Test(RequestFramer, contentLengthBodyStopsAtPipelinedRequest)
+{
+	RequestFramer framer;
+	std::string	  first("POST / HTTP/1.1\r\nHost: a\r\ncontent-length: 5\r\n"
+						"\r\nhello");
+	std::string	  input(first + "GET / HTTP/1.1\r\n\r\n");
+
+	cr_assert(framer.feed(input.data(), input.size()) == first.size());
+	cr_assert(framer.isComplete());
+	cr_assert(bodyOf(framer) == "hello");
+	cr_assert(framer.getView().body.length == 5);
+}
+
+Test(RequestFramer, decodesChunkedBody)
+{
+	RequestFramer framer;
+	std::string	  input("POST / HTTP/1.1\r\nHost: a\r\n"
+						"Transfer-Encoding: chunked\r\n\r\n"
+						"7;ext=1\r\nMozilla\r\n9\r\nDeveloper\r\n0\r\n"
+						"X-End: 1\r\n\r\n");
+
+	cr_assert(feedByBytes(framer, input) == input.size());
+	cr_assert(framer.isComplete());
+	cr_assert(framer.isChunked());
+	cr_assert(bodyOf(framer) == "MozillaDeveloper");
+}
+
+Test(RequestFramer, rejectsInvalidRequests)
+{
+	RequestFramer framer;
+	std::string	  input("POST / HTTP/1.1\r\nHost: a\r\n"
+						"Transfer-Encoding: chunked\r\n\r\nzz\r\n");
+
+	cr_assert_throw(framer.feed(input.data(), input.size()), HttpException);
+
+	framer.reset();
+	input = "POST / HTTP/1.1\r\nHost: a\r\nContent-Length: -1\r\n\r\n";
+	cr_assert_throw(framer.feed(input.data(), input.size()), HttpException);
+
+	// Parse errors are found while framing, before the body is read
+	framer.reset();
+	input = "POST / HTTP/1.1\r\nContent-Length: 5\r\n\r\n";
+	cr_assert_throw(framer.feed(input.data(), input.size()), HttpException);
+}
+
+Test(RequestFramer, rejectsAmbiguousFraming)
+{
+	std::string head("POST / HTTP/1.1\r\nHost: a\r\n");
+
+	cr_assert(rejectionOf(head + "Transfer-Encoding: gzip, chunked\r\n\r\n")
+			  == 501);
+	cr_assert(rejectionOf(head + "Transfer-Encoding: chunked, gzip\r\n\r\n")
+			  == 501);
+	cr_assert(rejectionOf(head + "Transfer-Encoding: chunked,chunked\r\n\r\n")
+			  == 400);
+	cr_assert(rejectionOf(head + "Transfer-Encoding: chunked\r\n"
+								 "Content-Length: 5\r\n\r\n")
+			  == 400);
+	cr_assert(rejectionOf(head + "Content-Length: 5\r\n"
+								 "Content-Length: 6\r\n\r\n")
+			  == 400);
+	cr_assert(rejectionOf(head + "Transfer-Encoding:  Chunked \r\n\r\n"
+								 "0\r\n\r\n")
+			  == 0);
+}
+
+Test(RequestFramer, bodyGrowsAsItArrives)
+{
+	RequestFramer framer;
+	std::string	  input("POST / HTTP/1.1\r\nHost: a\r\nContent-Length: 9000000"
+						"\r\n\r\nhello");
+
+	cr_assert(framer.feed(input.data(), input.size()) == input.size());
+	cr_assert(!framer.isComplete() && bodyOf(framer) == "hello");
+	cr_assert(framer.getBody().capacity() <= CLIENT_BUFFER_SIZE);
+}
+
+Test(RequestFramer, holdsAndStreamsTheBody)
+{
+	RequestFramer framer;
+	std::string	  head("POST / HTTP/1.1\r\nHost: a\r\nContent-Length: 20000000"
+					   "\r\n\r\n");
+	std::string	  input(head + "hello");
+
+	framer.setHoldBody(true);
+	cr_assert(framer.feed(input.data(), input.size()) == head.size());
+	cr_assert(framer.isBodyHeld() && framer.areHeadersRead());
+	cr_assert(framer.feed(input.data() + head.size(), 5) == 0);
+
+	// A streamed body is drained by the caller and may exceed the size limit
+	framer.startBody(true);
+	std::string piece(1000000, 'a');
+	for (size_t sent = 0; sent < 20000000; sent += piece.size())
+	{
+		cr_assert(framer.feed(piece.data(), piece.size()) == piece.size());
+		cr_assert(framer.getBody().size() == piece.size());
+		framer.getBody().clear();
+	}
+	cr_assert(framer.isComplete() && framer.isBodyStreamed());
+	cr_assert(framer.getView().body.length == 20000000);
+
+	// Requests without a body are not held
+	framer.reset();
+	input = "GET / HTTP/1.1\r\nHost: a\r\n\r\n";
+	cr_assert(framer.feed(input.data(), input.size()) == input.size());
+	cr_assert(framer.isComplete() && !framer.isBodyStreamed());
+}
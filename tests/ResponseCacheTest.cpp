@@ -0,0 +1,147 @@
+#include "../include/OpenFileCache.hpp"
+#include "../include/ResponseCache.hpp"
+#include "../include/utils.hpp"
+#include "test.hpp"
+
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+static void writeFile(std::string const &path, std::string const &content)
+{
+	std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+	file << content;
+}
+
+// Caches a file as the GET handler does after a miss.
+static void
+insertFile(ResponseCache &cache, std::string const &key, std::string const &path)
+{
+	std::ifstream file(path.c_str(), std::ios::binary);
+	std::string	  body(
+		(std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()
+	);
+	HttpResponse response;
+	response.setHeader("Content-Length", ft::toString(body.size()));
+	int fd = open(path.c_str(), O_RDONLY);
+	cache.insert(key, path, fd, response, body);
+	close(fd);
+}
+
+Test(ResponseCache, completesTheCachedHead)
+{
+	std::string const path("/tmp/rc_hit.txt");
+	writeFile(path, "cached body");
+	OpenFileCache files;
+	ResponseCache cache;
+	HttpResponse  response;
+	cache.configure(4096, files);
+
+	cr_assert(!cache.find("0 /hit", true, response));
+	insertFile(cache, "0 /hit", path);
+	cr_assert(cache.getSize() == 1 && cache.getMisses() == 1);
+	cr_assert(cache.find("0 /hit", false, response));
+	std::string rendered = response.toString();
+	cr_assert(rendered.find("HTTP/1.1 200 OK\r\nContent-Length: 11\r\n") == 0);
+	cr_assert(rendered.find("\r\nDate: ") != std::string::npos);
+	cr_assert(
+		rendered.find("Connection: close\r\n\r\ncached body")
+		!= std::string::npos
+	);
+	cr_assert(cache.getHits() == 1);
+	cr_assert(cache.getHitRatio() == 0.5);
+	cr_assert(cache.getBytes() > 11);
+	std::remove(path.c_str());
+}
+
+Test(ResponseCache, keepsWithinTheBudget)
+{
+	std::string paths[6];
+	for (int i = 0; i < 6; ++i)
+	{
+		paths[i] = std::string("/tmp/rc_lru_") + static_cast<char>('a' + i);
+		writeFile(paths[i], std::string(100, 'a' + i));
+	}
+	OpenFileCache files;
+	ResponseCache cache;
+	HttpResponse  response;
+	// Room for five entries of 138 bytes
+	cache.configure(800, files);
+
+	cr_assert(cache.isCacheable(100) && !cache.isCacheable(101));
+	for (int i = 0; i < 5; ++i)
+		insertFile(cache, paths[i], paths[i]);
+	cr_assert(cache.getSize() == 5 && cache.getBytes() == 690);
+	cr_assert(cache.find(paths[0], true, response));
+	// The second file is now the least recently used
+	insertFile(cache, paths[5], paths[5]);
+	cr_assert(cache.getSize() == 5 && cache.getBytes() <= 800);
+	cr_assert(cache.find(paths[0], true, response));
+	cr_assert(cache.find(paths[5], true, response));
+	cr_assert(!cache.find(paths[1], true, response));
+	for (int i = 0; i < 6; ++i)
+		std::remove(paths[i].c_str());
+}
+
+Test(ResponseCache, dropsChangedFiles)
+{
+	std::string const path("/tmp/rc_changed.txt");
+	writeFile(path, "old");
+	// Without its own entries, the open file cache stat()s the file on
+	// every hit
+	OpenFileCache files;
+	ResponseCache cache;
+	HttpResponse  response;
+	cache.configure(4096, files);
+
+	insertFile(cache, "0 /changed", path);
+	cr_assert(cache.find("0 /changed", true, response));
+	writeFile(path, "newer");
+	cr_assert(!cache.find("0 /changed", true, response));
+	cr_assert(cache.getSize() == 0 && cache.getBytes() == 0);
+
+	insertFile(cache, "0 /changed", path);
+	cache.invalidate(path);
+	cr_assert(cache.getSize() == 0);
+	std::remove(path.c_str());
+}
+
+Test(ResponseCache, dropsFilesTheOpenFileCacheSawChange)
+{
+	std::string const path("/tmp/rc_events.txt");
+	writeFile(path, "old");
+	OpenFileCache		files;
+	OpenFileCache::Info info;
+	ResponseCache		cache;
+	HttpResponse		response;
+	files.configure(4, 60000, true);
+	cache.configure(4096, files);
+
+	cr_assert(files.getInfo(path, info));
+	insertFile(cache, "0 /events", path);
+	cr_assert(cache.find("0 /events", true, response));
+	// As another worker process would
+	writeFile(path, "newer");
+#ifdef __linux__
+	files.readEvents();
+	cr_assert(!cache.find("0 /events", true, response));
+	cr_assert(cache.getSize() == 0);
+#endif
+	std::remove(path.c_str());
+}
+
+Test(ResponseCache, cachesNothingWhenDisabled)
+{
+	std::string const path("/tmp/rc_off.txt");
+	writeFile(path, "abc");
+	ResponseCache cache;
+	HttpResponse  response;
+
+	cr_assert(!cache.isEnabled());
+	insertFile(cache, "0 /off", path);
+	cr_assert(!cache.find("0 /off", true, response));
+	cr_assert(cache.getSize() == 0 && cache.getMisses() == 0);
+	std::remove(path.c_str());
+}
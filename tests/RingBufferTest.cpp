@@ -0,0 +1,37 @@
+#include "../include/RingBuffer.hpp"
+#include "test.hpp"
+
+#include <cstring>
+#include <unistd.h>
+
+Test(RingBuffer, readsAndWrapsAround)
+{
+	int fds[2];
+	cr_assert(pipe(fds) == 0);
+	RingBuffer buffer(8);
+
+	cr_assert(write(fds[1], "abcdef", 6) == 6);
+	cr_assert(buffer.readFrom(fds[0]) == 6);
+	buffer.consume(4);
+	cr_assert(buffer.getSize() == 2);
+
+	// The free space wraps around the end of the storage
+	cr_assert(write(fds[1], "ghijklmn", 8) == 8);
+	cr_assert(buffer.readFrom(fds[0]) == 6);
+	cr_assert(buffer.getFreeSpace() == 0);
+
+	size_t		length;
+	char const *data = buffer.peek(length);
+	cr_assert(length == 4 && std::memcmp(data, "efgh", 4) == 0);
+	buffer.consume(length);
+	data = buffer.peek(length);
+	cr_assert(length == 4 && std::memcmp(data, "ijkl", 4) == 0);
+	buffer.consume(length);
+	cr_assert(buffer.isEmpty());
+
+	cr_assert(buffer.readFrom(fds[0]) == 2);
+	data = buffer.peek(length);
+	cr_assert(length == 2 && std::memcmp(data, "mn", 2) == 0);
+	close(fds[0]);
+	close(fds[1]);
+}
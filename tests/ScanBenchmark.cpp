@@ -0,0 +1,121 @@
+/**
+ * Times SliceParser on the requests of common browsers with each instruction
+ * set of ByteSet, then the raw ByteSet kernels on a 4 KiB header value. Run it
+ * with `make scanbench`.
+ */
+#include "../include/Logger.hpp"
+#include "../include/request_parser/ByteSet.hpp"
+#include "../include/request_parser/HttpHeaders.hpp"
+#include "../include/request_parser/SliceParser.hpp"
+#include <cstdio>
+#include <string>
+#include <time.h>
+
+#define ITERATIONS 200000
+
+static char const *const isaNames[] = {"scalar", "sse2", "avx2"};
+
+static std::string const browsers[][2] = {
+	{"chrome",
+	 "GET /assets/app.js?v=3 HTTP/1.1\r\n"
+	 "Host: www.example.com\r\n"
+	 "Connection: keep-alive\r\n"
+	 "sec-ch-ua: \"Chromium\";v=\"124\", \"Google Chrome\";v=\"124\"\r\n"
+	 "sec-ch-ua-mobile: ?0\r\n"
+	 "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, "
+	 "like Gecko) Chrome/124.0.0.0 Safari/537.36\r\n"
+	 "sec-ch-ua-platform: \"Linux\"\r\n"
+	 "Accept: */*\r\n"
+	 "Sec-Fetch-Site: same-origin\r\n"
+	 "Sec-Fetch-Mode: no-cors\r\n"
+	 "Sec-Fetch-Dest: script\r\n"
+	 "Referer: https://www.example.com/\r\n"
+	 "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+	 "Accept-Language: en-US,en;q=0.9,fr;q=0.8\r\n"
+	 "Cookie: 42Token=3f2a9c1e7b; _ga=GA1.1.1234567890.1700000000; "
+	 "_ga_ABCDEF=GS1.1.1700000000.1.1.1700000100.0.0.0; theme=dark\r\n"
+	 "\r\n"},
+	{"firefox",
+	 "GET /index.html HTTP/1.1\r\n"
+	 "Host: www.example.com\r\n"
+	 "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:125.0) Gecko/20100101 "
+	 "Firefox/125.0\r\n"
+	 "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/"
+	 "avif,image/webp,*/*;q=0.8\r\n"
+	 "Accept-Language: en-US,en;q=0.5\r\n"
+	 "Accept-Encoding: gzip, deflate, br\r\n"
+	 "Connection: keep-alive\r\n"
+	 "Upgrade-Insecure-Requests: 1\r\n"
+	 "Sec-Fetch-Dest: document\r\n"
+	 "Sec-Fetch-Mode: navigate\r\n"
+	 "Sec-Fetch-Site: none\r\n"
+	 "Sec-Fetch-User: ?1\r\n"
+	 "\r\n"},
+	{"safari",
+	 "GET /images/logo.png HTTP/1.1\r\n"
+	 "Host: www.example.com\r\n"
+	 "Accept: image/webp,image/avif,image/png,image/*;q=0.8,*/*;q=0.5\r\n"
+	 "User-Agent: Mozilla/5.0 (Macintosh; Intel Mac OS X 10_15_7) "
+	 "AppleWebKit/605.1.15 (KHTML, like Gecko) Version/17.4 Safari/605.1.15\r\n"
+	 "Accept-Language: en-GB,en;q=0.9\r\n"
+	 "Referer: https://www.example.com/\r\n"
+	 "Accept-Encoding: gzip, deflate, br\r\n"
+	 "Connection: keep-alive\r\n"
+	 "\r\n"},
+	{"curl",
+	 "GET / HTTP/1.1\r\n"
+	 "Host: localhost:8080\r\n"
+	 "User-Agent: curl/8.5.0\r\n"
+	 "Accept: */*\r\n"
+	 "\r\n"}};
+
+static double nowNs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(void)
+{
+	Logger::setLevel(Logger::INFO);
+	int supported = ByteSet::getSupportedIsa();
+
+	std::printf("%-10s", "request");
+	for (int isa = ByteSet::SCALAR; isa <= supported; ++isa)
+		std::printf(" %12s", isaNames[isa]);
+	std::printf("\n");
+	for (size_t b = 0; b < sizeof(browsers) / sizeof(browsers[0]); ++b)
+	{
+		std::string const &request = browsers[b][1];
+		std::printf("%-10s", browsers[b][0].c_str());
+		for (int isa = ByteSet::SCALAR; isa <= supported; ++isa)
+		{
+			ByteSet::setIsa(static_cast<ByteSet::Isa>(isa));
+			RequestView view;
+			double		start = nowNs();
+			for (int n = 0; n < ITERATIONS; ++n)
+				SliceParser::parseRequest(request.data(), request.size(), view);
+			std::printf(" %9.0f ns", (nowNs() - start) / ITERATIONS);
+		}
+		std::printf("\n");
+	}
+
+	std::string value(4096, 'a');
+	std::printf("\n%-10s", "kernel");
+	for (int isa = ByteSet::SCALAR; isa <= supported; ++isa)
+		std::printf(" %12s", isaNames[isa]);
+	std::printf("\n%-10s", "GB/s");
+	for (int isa = ByteSet::SCALAR; isa <= supported; ++isa)
+	{
+		ByteSet::setIsa(static_cast<ByteSet::Isa>(isa));
+		size_t found(0);
+		double start = nowNs();
+		for (int n = 0; n < ITERATIONS; ++n)
+			found += headerValueControlChars.find(value.data(), value.size());
+		double elapsed = nowNs() - start;
+		std::printf(" %12.2f", found / elapsed);
+	}
+	std::printf("\n");
+	return 0;
+}
@@ -57,9 +57,14 @@ Test(ServerConfig, CheckGeneralDirectives)
 			= config.getGeneralConfigValue("worker_processes");
 		std::string workerConnections
 			= config.getGeneralConfigValue("worker_connections");
+		std::string workerThreads
+			= config.getGeneralConfigValue("worker_threads");
+		std::string use = config.getGeneralConfigValue("use");
 		cr_assert(eq(str, errorLog, "debug"));
 		cr_assert(eq(str, workerProcesses, "auto"));
+		cr_assert(eq(str, workerThreads, "2"));
 		cr_assert(eq(str, workerConnections, "1024"));
+		cr_assert(eq(str, use, "epoll"));
 	}
 	catch (std::exception &e)
 	{
@@ -111,6 +116,22 @@ Test(ServerConfig, CheckServerDirectives)
 			   "1000000000")
 		);
 
+		if (!config.getServerConfigValue(0, "keepalive_timeout", value))
+			throw std::runtime_error(
+				"Could not find the key [keepalive_timeout] in the "
+				"server[0] configuration map."
+			);
+		cr_assert(
+			eq(str, const_cast<std::string &>(value.getVectorValue(0)), "30s")
+		);
+
+		if (!config.getServerConfigValue(0, "send_timeout", value))
+			throw std::runtime_error("Could not find the key [send_timeout] in "
+									 "the server[0] configuration map.");
+		cr_assert(
+			eq(str, const_cast<std::string &>(value.getVectorValue(0)), "60s")
+		);
+
 		if (!config.getServerConfigValue(0, "root", value))
 			throw std::runtime_error("Could not find the key [root] in the "
 									 "server[0] configuration map.");
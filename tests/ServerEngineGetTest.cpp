@@ -1,5 +1,6 @@
 #include "test.hpp"
 #include <chrono>
+#include <cstdio>
 #include <criterion/criterion.h>
 #include <fstream>
 #include <sstream>
@@ -23,7 +24,7 @@ Test(ServerEngine, handleGetRequest_FileExists)
 		// serverEngine.start();
 
 		// Call the handleGetRequest_method
-		std::string response = serverEngine.createResponse(request);
+		std::string response = serverEngine.createResponse(request).toString();
 
 		std::cout << "\n\nTest Response:\n" << response << std::endl;
 		// Assert the expected response
@@ -59,7 +60,7 @@ Test(ServerEngine, handleGetRequest_FileNotFound)
 		// serverEngine.start();
 
 		// Call the handleGetRequest_method
-		std::string response = serverEngine.createResponse(request);
+		std::string response = serverEngine.createResponse(request).toString();
 
 		std::cout << "\n\nTest Response:\n" << response << std::endl;
 		// Assert the expected response
@@ -100,7 +101,7 @@ Test(ServerEngine, handleGetRequest_NotImplemented)
 				  << std::endl;
 
 		// Call the handleGetRequest_method
-		std::string response = serverEngine.createResponse(request);
+		std::string response = serverEngine.createResponse(request).toString();
 
 		std::cout << "\n\nTest Response:\n" << response << std::endl;
 		// Assert the expected response
@@ -135,7 +136,7 @@ Test(ServerEngine, handleGetRequest_Root)
 		// serverEngine.start();
 
 		// Call the handleGetRequest_method
-		std::string response = serverEngine.createResponse(request);
+		std::string response = serverEngine.createResponse(request).toString();
 
 		std::cout << "\n\nTest Response:\n" << response << std::endl;
 		// Assert the expected response
@@ -150,3 +151,206 @@ Test(ServerEngine, handleGetRequest_Root)
 	}
 	std::this_thread::sleep_for(std::chrono::seconds(1));
 }
+
+// Test for revalidating a file with its ETag and Last-Modified validators
+Test(ServerEngine, handleGetRequest_NotModified)
+{
+	std::string requestStr = ft::readFile("./test_requests/getRequest.txt");
+	HttpRequest request = RequestParser::parseRequest(requestStr);
+
+	ServerConfig config("test.config");
+	config.parseFile(false, false);
+
+	{
+		ServerEngine serverEngine(config.getAllServersConfig());
+		std::string response = serverEngine.createResponse(request).toString();
+
+		size_t etagPos = response.find("ETag: ");
+		size_t datePos = response.find("Last-Modified: ");
+		cr_assert(etagPos != std::string::npos, "Expected an ETag header");
+		cr_assert(datePos != std::string::npos, "Expected Last-Modified");
+		std::string etag = response.substr(
+			etagPos + 6, response.find("\r\n", etagPos) - etagPos - 6
+		);
+		std::string date = response.substr(
+			datePos + 15, response.find("\r\n", datePos) - datePos - 15
+		);
+
+		// Drop the blank line ending the headers
+		std::string head = requestStr.substr(0, requestStr.size() - 1);
+		std::string const conditions[3] = {
+			"If-None-Match: \"nope\", " + etag + "\r\n",
+			"If-None-Match: W/" + etag + "\r\n",
+			"If-Modified-Since: " + date + "\r\n"
+		};
+		for (int i = 0; i < 3; ++i)
+		{
+			HttpRequest conditional
+				= RequestParser::parseRequest(head + conditions[i] + "\r\n");
+			response = serverEngine.createResponse(conditional).toString();
+			cr_assert(
+				response.find("304 Not Modified") != std::string::npos,
+				"Expected 304 Not Modified response"
+			);
+			cr_assert(
+				response.find("<!DOCTYPE html>") == std::string::npos,
+				"Expected no body in a 304 response"
+			);
+		}
+
+		HttpRequest changed = RequestParser::parseRequest(
+			head + "If-None-Match: \"other\"\r\n"
+			+ "If-Modified-Since: " + date + "\r\n\r\n"
+		);
+		response = serverEngine.createResponse(changed).toString();
+		cr_assert(
+			response.find("200 OK") != std::string::npos,
+			"Expected If-None-Match to take precedence"
+		);
+	}
+}
+
+// Test for serving byte ranges of a file
+Test(ServerEngine, handleGetRequest_Ranges)
+{
+	std::string requestStr = ft::readFile("./test_requests/getRequest.txt");
+	std::string head = requestStr.substr(0, requestStr.size() - 1);
+
+	ServerConfig config("test.config");
+	config.parseFile(false, false);
+
+	{
+		ServerEngine serverEngine(config.getAllServersConfig());
+		HttpRequest	 single
+			= RequestParser::parseRequest(head + "Range: bytes=0-14\r\n\r\n");
+		std::string response = serverEngine.createResponse(single).toString();
+		cr_assert(
+			response.find("206 Partial Content") != std::string::npos,
+			"Expected 206 Partial Content response"
+		);
+		cr_assert(response.find("Content-Length: 15\r\n") != std::string::npos);
+		cr_assert(
+			response.substr(response.size() - 15) == "<!DOCTYPE html>",
+			"Expected the first bytes of the file"
+		);
+
+		HttpRequest multiple = RequestParser::parseRequest(
+			head + "Range: bytes=0-1, -2\r\n\r\n"
+		);
+		response = serverEngine.createResponse(multiple).toString();
+		cr_assert(
+			response.find("multipart/byteranges; boundary=") != std::string::npos,
+			"Expected a multipart/byteranges response"
+		);
+		cr_assert(response.find("Content-Range: bytes 0-1/") != std::string::npos);
+		size_t bodyStart = response.find("\r\n\r\n") + 4;
+		cr_assert(
+			response.find("Content-Length: "
+						  + ft::toString(response.size() - bodyStart))
+			!= std::string::npos,
+			"Expected the length of the multipart body"
+		);
+
+		HttpRequest outside = RequestParser::parseRequest(
+			head + "Range: bytes=99999999-\r\n\r\n"
+		);
+		response = serverEngine.createResponse(outside).toString();
+		cr_assert(
+			response.find("416 Range Not Satisfiable") != std::string::npos,
+			"Expected 416 Range Not Satisfiable response"
+		);
+		cr_assert(response.find("Content-Range: bytes */") != std::string::npos);
+	}
+}
+
+// Test for serving the precompressed sibling of a file with gzip_static
+Test(ServerEngine, handleGetRequest_GzipStatic)
+{
+	std::string requestStr = ft::readFile("./test_requests/getRequest.txt");
+	std::string head = "GET /index.html HTTP/1.1\r\n"
+					   + requestStr.substr(requestStr.find('\n') + 1);
+	head.erase(head.size() - 1);
+	std::string const gzipPath("../www/website/index.html.gz");
+	{
+		std::ofstream file(gzipPath.c_str(), std::ios::binary);
+		file << "not really gzip";
+	}
+
+	ServerConfig config("test.config");
+	config.parseFile(false, false);
+
+	{
+		ServerEngine serverEngine(config.getAllServersConfig());
+		HttpRequest	 gzip = RequestParser::parseRequest(
+			head + "Accept-Encoding: br;q=1, gzip;q=0.5\r\n\r\n"
+		);
+		std::string response = serverEngine.createResponse(gzip).toString();
+		cr_assert(response.find("200 OK") != std::string::npos);
+		cr_assert(
+			response.find("Content-Encoding: gzip\r\n") != std::string::npos
+		);
+		cr_assert(
+			response.find("Vary: Accept-Encoding\r\n") != std::string::npos
+		);
+		cr_assert(
+			response.find("Content-Type: text/html") != std::string::npos
+		);
+		cr_assert(
+			response.substr(response.size() - 15) == "not really gzip",
+			"Expected the body of the .gz file"
+		);
+
+		HttpRequest identity = RequestParser::parseRequest(
+			head + "Accept-Encoding: gzip;q=0, *\r\n\r\n"
+		);
+		response = serverEngine.createResponse(identity).toString();
+		cr_assert(response.find("Content-Encoding") == std::string::npos);
+		cr_assert(
+			response.find("Vary: Accept-Encoding\r\n") != std::string::npos
+		);
+		cr_assert(response.find("<!DOCTYPE html>") != std::string::npos);
+	}
+	std::remove(gzipPath.c_str());
+}
+
+// Test for compressing a file with gzip as it is sent
+Test(ServerEngine, handleGetRequest_Gzip)
+{
+	std::string requestStr = ft::readFile("./test_requests/getRequest.txt");
+	std::string head = "GET /501.html HTTP/1.1\r\n"
+					   + requestStr.substr(requestStr.find('\n') + 1);
+	head.erase(head.size() - 1);
+
+	ServerConfig config("test.config");
+	config.parseFile(false, false);
+
+	{
+		ServerEngine serverEngine(config.getAllServersConfig());
+		HttpRequest	 gzip = RequestParser::parseRequest(
+			head + "Accept-Encoding: gzip, deflate\r\n\r\n"
+		);
+		std::string response = serverEngine.createResponse(gzip).toString();
+		cr_assert(response.find("200 OK") != std::string::npos);
+		cr_assert(
+			response.find("Content-Encoding: gzip\r\n") != std::string::npos
+		);
+		cr_assert(
+			response.find("Transfer-Encoding: chunked\r\n")
+			!= std::string::npos
+		);
+		cr_assert(response.find("Content-Length") == std::string::npos);
+		cr_assert(response.find("ETag: W/\"") != std::string::npos);
+		cr_assert(
+			response.substr(response.size() - 5) == "0\r\n\r\n",
+			"Expected the last chunk"
+		);
+
+		HttpRequest identity = RequestParser::parseRequest(head + "\r\n");
+		response = serverEngine.createResponse(identity).toString();
+		cr_assert(response.find("Content-Encoding") == std::string::npos);
+		cr_assert(
+			response.find("Vary: Accept-Encoding\r\n") != std::string::npos
+		);
+		cr_assert(response.find("<!DOCTYPE html>") != std::string::npos);
+	}
+}
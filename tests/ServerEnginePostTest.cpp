@@ -22,7 +22,7 @@ Test(ServerEngine, handlePostRequest_)
 		// serverEngine.start(); // This line is commented out
 
 		// Call the handlePostRequest_ method
-		std::string response = serverEngine.createResponse(request);
+		std::string response = serverEngine.createResponse(request).toString();
 
 		std::cout << "\n\nTest Response:\n" << response << std::endl;
 		// Assert the expected response
@@ -0,0 +1,76 @@
+#include "../include/request_parser/SliceParser.hpp"
+#include "./test.hpp"
+#include <string>
+
+static std::string const requestFiles[] = {
+	"./test_requests/deleteRequest.txt",
+	"./test_requests/getRequest.txt",
+	"./test_requests/getRequestRoot.txt",
+	"./test_requests/nofileGetRequest.txt",
+	"./test_requests/postRequest.txt",
+	"./test_requests/traceRequest.txt"};
+
+static int parseError(std::string const &requestStr)
+{
+	RequestView view;
+	try
+	{
+		SliceParser::parseRequest(requestStr.data(), requestStr.size(), view);
+	}
+	catch (HttpException &e)
+	{
+		return e.getCode();
+	}
+	return 0;
+}
+
+Test(SliceParser, sameResultAsRequestParser)
+{
+	for (size_t i = 0; i < sizeof(requestFiles) / sizeof(std::string); ++i)
+	{
+		std::string requestStr = ft::readFile(requestFiles[i]);
+		HttpRequest request = RequestParser::parseRequest(requestStr);
+		RequestView view;
+
+		SliceParser::parseRequest(requestStr.data(), requestStr.size(), view);
+		cr_assert(view.method.toString() == request.getMethod());
+		cr_assert(view.uri.toString().find(request.getUri()) == 0);
+		cr_assert(view.httpVersion.toString() == request.getHttpVersion());
+		cr_assert(view.findHeader("Host")->value.toString()
+				  == request.getHeaders().at("Host")[0]);
+		cr_assert(view.body.length == request.getBody().size());
+	}
+}
+
+Test(SliceParser, slicesPointIntoTheRequest)
+{
+	std::string requestStr("POST /up HTTP/1.1\r\nhost: a\r\nX-Any:  b \r\n"
+						   "content-length: 5\r\n\r\nhello");
+	RequestView view;
+
+	SliceParser::parseRequest(requestStr.data(), requestStr.size(), view);
+	cr_assert(view.headerCount == 3);
+	cr_assert(view.uri.data == requestStr.data() + 5);
+	cr_assert(view.headers[1].id == -1);
+	cr_assert(view.headers[1].value.toString() == "b");
+	cr_assert(view.findHeader("Content-Length")->value.equals("5"));
+	cr_assert(view.body.data == requestStr.data() + requestStr.size() - 5);
+}
+
+Test(SliceParser, invalidRequests)
+{
+	std::string tooManyHeaders("GET / HTTP/1.1\r\nHost: a\r\n");
+	for (int i = 0; i < REQUEST_MAX_HEADERS; ++i)
+		tooManyHeaders += "X-Header: value\r\n";
+
+	cr_assert(parseError("GET / HTTP/1.0\r\nHost: a\r\n\r\n") == 501);
+	cr_assert(parseError("GET / HTTP/1.1\r\n\r\n") == 400);
+	cr_assert(parseError("GET / HTTP/1.1\r\nHost: a\r\nHost: b\r\n\r\n") == 400);
+	cr_assert(parseError("GET / HTTP/1.1\r\nHost : a\r\n\r\n") == 400);
+	cr_assert(parseError("GET a HTTP/1.1\r\nHost: a\r\n\r\n") == 400);
+	cr_assert(parseError("GET /%zz HTTP/1.1\r\nHost: a\r\n\r\n") == 400);
+	cr_assert(parseError("GET / HTTP/1.1\r\nHost: a\r\nAccept: a\"b\r\n\r\n")
+			  == 400);
+	cr_assert(parseError("POST / HTTP/1.1\r\nHost: a\r\n\r\nbody") == 400);
+	cr_assert(parseError(tooManyHeaders + "\r\n") == 400);
+}
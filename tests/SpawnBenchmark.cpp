@@ -0,0 +1,111 @@
+/**
+ * Times starting /bin/true and reaping it with fork and execve, as CGI
+ * scripts were started, with posix_spawn, and with CgiProcess, while the
+ * process holds 100 MiB, 1 GiB then 4 GiB of touched memory. The sizes the
+ * machine has no room for are skipped. Run it with `make spawnbench`.
+ */
+#include "../include/CgiProcess.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <spawn.h>
+#include <string>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#define ITERATIONS 20
+
+static size_t const sizesMiB[] = {100, 1024, 4096};
+
+static char *const trueArgv[] = {const_cast<char *>("/bin/true"), NULL};
+static char *const emptyEnvp[] = {NULL};
+
+// Read once the memory was used, so that filling it is not optimized out
+static char volatile sink;
+
+static double nowNs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Whether the size fits in the free memory, leaving some for the children
+static bool hasRoomFor(size_t bytes)
+{
+#ifdef _SC_AVPHYS_PAGES
+	double available = static_cast<double>(sysconf(_SC_AVPHYS_PAGES))
+					   * sysconf(_SC_PAGESIZE);
+	return bytes + (256UL << 20) < available;
+#else
+	(void)bytes;
+	return true;
+#endif
+}
+
+static void runFork(void)
+{
+	pid_t pid = fork();
+	if (pid == 0)
+	{
+		execve(trueArgv[0], trueArgv, emptyEnvp);
+		_exit(EXIT_FAILURE);
+	}
+	waitpid(pid, NULL, 0);
+}
+
+static void runSpawn(void)
+{
+	pid_t pid;
+	if (posix_spawn(&pid, trueArgv[0], NULL, NULL, trueArgv, emptyEnvp) == 0)
+		waitpid(pid, NULL, 0);
+}
+
+static void runCgiProcess(void)
+{
+	CgiProcess cgi;
+	cgi.start(
+		std::vector<std::string>(1, trueArgv[0]), std::vector<std::string>()
+	);
+	cgi.endInput();
+	cgi.wait();
+}
+
+static void printTime(void (*run)(void))
+{
+	double start = nowNs();
+	for (int n = 0; n < ITERATIONS; ++n)
+		run();
+	std::printf(" %9.0f us", (nowNs() - start) / ITERATIONS / 1e3);
+}
+
+int main(void)
+{
+	std::printf(
+		"%-10s %12s %12s %12s\n", "rss", "fork", "posix_spawn", "CgiProcess"
+	);
+	for (size_t i = 0; i < sizeof(sizesMiB) / sizeof(sizesMiB[0]); ++i)
+	{
+		size_t bytes = sizesMiB[i] << 20;
+		char  *memory = NULL;
+		if (hasRoomFor(bytes))
+			memory = static_cast<char *>(std::malloc(bytes));
+		std::printf("%6lu MiB", static_cast<unsigned long>(sizesMiB[i]));
+		if (memory == NULL)
+		{
+			std::printf(" %12s\n", "skipped");
+			continue;
+		}
+		// Every page is written, so that fork has to copy its mapping
+		std::memset(memory, 1, bytes);
+		printTime(runFork);
+		printTime(runSpawn);
+		printTime(runCgiProcess);
+		std::printf("\n");
+		sink = memory[bytes / 2];
+		std::free(memory);
+	}
+	return 0;
+}
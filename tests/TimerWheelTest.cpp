@@ -0,0 +1,61 @@
+#include "../include/TimerWheel.hpp"
+#include "test.hpp"
+
+#include <unistd.h>
+
+Test(TimerWheel, scheduleAndCancel)
+{
+	TimerWheel timers;
+	cr_assert(timers.getNextTimeout(500) == 500);
+
+	timers.schedule(3, 1000, 1);
+	timers.schedule(7, 2000, 2);
+	cr_assert(timers.getCount() == 2);
+	cr_assert(timers.isScheduled(3));
+	cr_assert(timers.getKind(7) == 2);
+
+	// Scheduling again replaces the pending timer of the id
+	timers.schedule(3, 3000, 4);
+	cr_assert(timers.getCount() == 2);
+	cr_assert(timers.getKind(3) == 4);
+
+	timers.cancel(3);
+	timers.cancel(3);
+	cr_assert(!timers.isScheduled(3));
+	cr_assert(timers.getCount() == 1);
+}
+
+Test(TimerWheel, expiresInOrder)
+{
+	TimerWheel						 timers;
+	std::vector<TimerWheel::Expired> expired;
+
+	timers.schedule(0, 20, 1);
+	timers.schedule(1, 5000, 2);
+	int timeout = timers.getNextTimeout(500);
+	cr_assert(timeout > 0 && timeout <= 30);
+
+	usleep(40000);
+	timers.advance(expired);
+	cr_assert(expired.size() == 1);
+	cr_assert(expired[0].id == 0 && expired[0].kind == 1);
+	cr_assert(!timers.isScheduled(0));
+	cr_assert(timers.isScheduled(1));
+	cr_assert(timers.getNextTimeout(10000) <= 5000);
+}
+
+Test(TimerWheel, cascadesLongTimers)
+{
+	TimerWheel						 timers;
+	std::vector<TimerWheel::Expired> expired;
+
+	// Longer than level 0 (640 ms), so the timer is cascaded before expiring
+	timers.schedule(2, 700, 3);
+	while (timers.isScheduled(2))
+	{
+		usleep(timers.getNextTimeout(500) * 1000);
+		timers.advance(expired);
+	}
+	cr_assert(expired.size() == 1);
+	cr_assert(expired[0].id == 2 && expired[0].kind == 3);
+}
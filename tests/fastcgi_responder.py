@@ -0,0 +1,115 @@
+"""A tiny FastCGI responder, the stand-in of an application in the tests.
+
+Usage: python3 fastcgi_responder.py unix:/path | host:port
+
+Answers each request with its method, the length of its body, the number of
+its connection and of the requests the connection carried, then the body.
+The connection stays open when the server asks for it. A request with the
+query string "fail" writes to its stderr and ends with a status of 1.
+"""
+import os
+import socket
+import struct
+import sys
+import threading
+
+BEGIN_REQUEST, END_REQUEST, PARAMS, STDIN, STDOUT, STDERR = 1, 3, 4, 5, 6, 7
+
+
+def read_record(f):
+    header = f.read(8)
+    if len(header) < 8:
+        return None
+    _, kind, request_id, length, padding = struct.unpack(">BBHHB", header[:7])
+    content = f.read(length)
+    f.read(padding)
+    return kind, request_id, content
+
+
+def write_records(conn, kind, request_id, content):
+    for start in range(0, len(content), 65535):
+        chunk = content[start:start + 65535]
+        header = struct.pack(">BBHHBx", 1, kind, request_id, len(chunk), 0)
+        conn.sendall(header + chunk)
+    conn.sendall(struct.pack(">BBHHBx", 1, kind, request_id, 0, 0))
+
+
+def parse_params(data):
+    params, i = {}, 0
+    while i < len(data):
+        lengths = []
+        for _ in range(2):
+            if data[i] >> 7:
+                lengths.append(struct.unpack(">I", data[i:i + 4])[0] & 0x7FFFFFFF)
+                i += 4
+            else:
+                lengths.append(data[i])
+                i += 1
+        name = data[i:i + lengths[0]].decode()
+        i += lengths[0]
+        params[name] = data[i:i + lengths[1]].decode()
+        i += lengths[1]
+    return params
+
+
+def serve(conn, number):
+    with conn, conn.makefile("rb") as f:
+        served = 0
+        while True:
+            params, body, keep = b"", [], False
+            while True:
+                record = read_record(f)
+                if record is None:
+                    return
+                kind, request_id, content = record
+                if kind == BEGIN_REQUEST:
+                    keep = content[2] & 1
+                elif kind == PARAMS:
+                    params += content
+                elif kind == STDIN and not content:
+                    break
+                elif kind == STDIN:
+                    body.append(content)
+            served += 1
+            body = b"".join(body)
+            env = parse_params(params)
+            status = 0
+            if env.get("QUERY_STRING") == "fail":
+                write_records(conn, STDERR, request_id, b"failing on purpose")
+                status = 1
+            head = "Status: 200 OK\r\nContent-Type: text/plain\r\n\r\n"
+            line = "method=%s length=%d connection=%d request=%d\n" % (
+                env.get("REQUEST_METHOD"), len(body), number, served)
+            write_records(conn, STDOUT, request_id, (head + line).encode() + body)
+            end = struct.pack(">IB3x", status, 0)
+            conn.sendall(struct.pack(">BBHHBx", 1, END_REQUEST, request_id, 8, 0) + end)
+            if not keep:
+                return
+
+
+def main():
+    address = sys.argv[1]
+    if address.startswith("unix:"):
+        path = address[5:]
+        if os.path.exists(path):
+            os.unlink(path)
+        listener = socket.socket(socket.AF_UNIX)
+        listener.bind(path)
+    else:
+        host, port = address.rsplit(":", 1)
+        # The first address of the host, the one the server connects to
+        family, _, _, _, sockaddr = socket.getaddrinfo(
+            host, int(port), 0, socket.SOCK_STREAM)[0]
+        listener = socket.socket(family)
+        listener.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        listener.bind(sockaddr)
+    listener.listen(64)
+    number = 0
+    while True:
+        conn, _ = listener.accept()
+        number += 1
+        threading.Thread(target=serve, args=(conn, number), daemon=True).start()
+
+
+if __name__ == "__main__":
+    main()
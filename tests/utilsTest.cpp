@@ -123,3 +123,16 @@ Test(utils, splitWithNewLines)
 	cr_assert(eq(str, result[0], expected[0]));
 	cr_assert(eq(str, result[1], expected[1]));
 }
+
+Test(utils, timeToMs)
+{
+	cr_assert(ft::isTime("75"));
+	cr_assert(ft::isTime("500ms"));
+	cr_assert(!ft::isTime("10x"));
+	cr_assert(!ft::isTime("s"));
+	cr_assert(ft::timeToMs("75") == 75000);
+	cr_assert(ft::timeToMs("75s") == 75000);
+	cr_assert(ft::timeToMs("500ms") == 500);
+	cr_assert(ft::timeToMs("2m") == 120000);
+	cr_assert(ft::timeToMs("1h") == 3600000);
+}